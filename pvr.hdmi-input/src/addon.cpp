@@ -6,12 +6,27 @@
  */
 
 #include "hdmi_client.h"
+#include "log.h"
 #include <kodi/addon-instance/PVR.h>
 #include <kodi/General.h>
 #include <memory>
 
-// Global HDMI client instance
-std::unique_ptr<hdmi_pvr::HdmiClient> g_hdmi_client;
+namespace {
+
+// The capture core logs through its own interface - hand it to Kodi
+void KodiLogSink(hdmi_pvr::LogLevel level, const char* message)
+{
+    AddonLog kodi_level = ADDON_LOG_DEBUG;
+    switch (level) {
+        case hdmi_pvr::LogLevel::Debug: kodi_level = ADDON_LOG_DEBUG; break;
+        case hdmi_pvr::LogLevel::Info: kodi_level = ADDON_LOG_INFO; break;
+        case hdmi_pvr::LogLevel::Warning: kodi_level = ADDON_LOG_WARNING; break;
+        case hdmi_pvr::LogLevel::Error: kodi_level = ADDON_LOG_ERROR; break;
+    }
+    kodi::Log(kodi_level, "%s", message);
+}
+
+} // namespace
 
 class ATTR_DLL_LOCAL CHdmiInputPVR : public kodi::addon::CAddonBase,
                                      public kodi::addon::CInstancePVR
@@ -22,14 +37,28 @@ public:
 
     ADDON_STATUS Create() override
     {
+        hdmi_pvr::SetLogSink(KodiLogSink);
         kodi::Log(ADDON_LOG_INFO, "HDMI Input PVR Client starting...");
         
         try {
-            g_hdmi_client = std::make_unique<hdmi_pvr::HdmiClient>();
-            if (!g_hdmi_client->Initialize()) {
+            m_client = std::make_unique<hdmi_pvr::HdmiClient>();
+            m_client->SetUpdateCallbacks([this]() { TriggerTimerUpdate(); },
+                                              [this]() { TriggerRecordingUpdate(); },
+                                              [this]() {
+                                                  TriggerChannelUpdate();
+                                                  TriggerChannelGroupsUpdate();
+                                              });
+            // Returns once the configuration is loaded - devices start in the background
+            if (!m_client->Initialize()) {
                 kodi::Log(ADDON_LOG_ERROR, "Failed to initialize HDMI client");
                 return ADDON_STATUS_PERMANENT_FAILURE;
             }
+
+            // Channel context menu entries, handled by CallChannelMenuHook()
+            AddMenuHook(kodi::addon::PVRMenuhook(1, 30100, PVR_MENUHOOK_CHANNEL));
+            AddMenuHook(kodi::addon::PVRMenuhook(2, 30101, PVR_MENUHOOK_CHANNEL));
+            AddMenuHook(kodi::addon::PVRMenuhook(3, 30102, PVR_MENUHOOK_CHANNEL));
+            AddMenuHook(kodi::addon::PVRMenuhook(4, 30103, PVR_MENUHOOK_CHANNEL));
             
             kodi::Log(ADDON_LOG_INFO, "HDMI Input PVR Client started successfully");
             return ADDON_STATUS_OK;
@@ -44,9 +73,9 @@ public:
     {
         kodi::Log(ADDON_LOG_INFO, "HDMI Input PVR Client shutting down...");
         
-        if (g_hdmi_client) {
-            g_hdmi_client->Shutdown();
-            g_hdmi_client.reset();
+        if (m_client) {
+            m_client->Shutdown();
+            m_client.reset();
         }
         
         kodi::Log(ADDON_LOG_INFO, "HDMI Input PVR Client shutdown complete");
@@ -54,8 +83,8 @@ public:
 
     ADDON_STATUS SetSetting(const std::string& settingName, const kodi::addon::CSettingValue& settingValue) override
     {
-        if (g_hdmi_client) {
-            return g_hdmi_client->SetSetting(settingName, settingValue) ? ADDON_STATUS_OK : ADDON_STATUS_NEED_RESTART;
+        if (m_client) {
+            return m_client->SetSetting(settingName, settingValue);
         }
         return ADDON_STATUS_OK;
     }
@@ -66,14 +95,15 @@ public:
         capabilities.SetSupportsEPG(true);
         capabilities.SetSupportsTV(true);
         capabilities.SetSupportsRadio(false);
-        capabilities.SetSupportsChannelGroups(false);
-        capabilities.SetSupportsRecordings(false);
-        capabilities.SetSupportsTimers(false);
+        capabilities.SetSupportsChannelGroups(true);
+        capabilities.SetSupportsRecordings(true);
+        capabilities.SetSupportsRecordingsDelete(true);
+        capabilities.SetSupportsTimers(true);
         capabilities.SetSupportsChannelScan(false);
         capabilities.SetSupportsChannelSettings(true);
         capabilities.SetSupportsLastPlayedPosition(false);
         capabilities.SetHandlesInputStream(true);
-        capabilities.SetHandlesDemuxing(true);
+        capabilities.SetHandlesDemuxing(!m_client || m_client->HandlesDemuxing());
         
         return PVR_ERROR_NO_ERROR;
     }
@@ -105,145 +135,340 @@ public:
     // Channel operations
     PVR_ERROR GetChannelsAmount(int& amount) override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
             return PVR_ERROR_SERVER_ERROR;
         }
         
-        amount = g_hdmi_client->GetChannelCount();
+        amount = m_client->GetChannelCount();
         return PVR_ERROR_NO_ERROR;
     }
 
     PVR_ERROR GetChannels(bool radio, kodi::addon::PVRChannelsResultSet& results) override
     {
-        if (!g_hdmi_client || radio) {
+        if (!m_client || radio) {
+            return PVR_ERROR_NO_ERROR;  // No radio channels
+        }
+
+        return m_client->GetChannels(results);
+    }
+
+    // Channel groups - one per capture device
+    PVR_ERROR GetChannelGroupsAmount(int& amount) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->GetChannelGroupsAmount(amount);
+    }
+
+    PVR_ERROR GetChannelGroups(bool radio, kodi::addon::PVRChannelGroupsResultSet& results) override
+    {
+        if (!m_client || radio) {
             return PVR_ERROR_NO_ERROR;  // No radio channels
         }
 
-        return g_hdmi_client->GetChannels(results);
+        return m_client->GetChannelGroups(results);
+    }
+
+    PVR_ERROR GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group,
+                                     kodi::addon::PVRChannelGroupMembersResultSet& results) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->GetChannelGroupMembers(group, results);
     }
 
     // EPG operations
     PVR_ERROR GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results) override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
             return PVR_ERROR_SERVER_ERROR;
         }
 
-        return g_hdmi_client->GetEPGForChannel(channelUid, start, end, results);
+        return m_client->GetEPGForChannel(channelUid, start, end, results);
     }
 
     // Stream operations
     bool OpenLiveStream(const kodi::addon::PVRChannel& channel) override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
             return false;
         }
 
-        return g_hdmi_client->OpenLiveStream(channel);
+        return m_client->OpenLiveStream(channel);
     }
 
     void CloseLiveStream() override
     {
-        if (g_hdmi_client) {
-            g_hdmi_client->CloseLiveStream();
+        if (m_client) {
+            m_client->CloseLiveStream();
         }
     }
 
     int ReadLiveStream(unsigned char* buffer, unsigned int size) override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
+            return -1;
+        }
+
+        return m_client->ReadLiveStream(buffer, size);
+    }
+
+    int64_t SeekLiveStream(int64_t position, int whence) override
+    {
+        if (!m_client) {
             return -1;
         }
 
-        return g_hdmi_client->ReadLiveStream(buffer, size);
+        return m_client->SeekLiveStream(position, whence);
+    }
+
+    int64_t LengthLiveStream() override
+    {
+        if (!m_client) {
+            return -1;
+        }
+
+        return m_client->LengthLiveStream();
+    }
+
+    // Timeshift operations
+    bool CanPauseStream() override
+    {
+        return m_client && m_client->CanPauseStream();
+    }
+
+    bool CanSeekStream() override
+    {
+        return m_client && m_client->CanSeekStream();
+    }
+
+    void PauseStream(bool paused) override
+    {
+        if (m_client) {
+            m_client->PauseStream(paused);
+        }
+    }
+
+    bool IsRealTimeStream() override
+    {
+        return !m_client || m_client->IsRealTimeStream();
+    }
+
+    PVR_ERROR GetStreamTimes(kodi::addon::PVRStreamTimes& times) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->GetStreamTimes(times);
+    }
+
+    PVR_ERROR GetStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->GetStreamProperties(properties,
+            [this](const std::string& name) { return GetCodecByName(name); });
+    }
+
+    // Timer operations
+    PVR_ERROR GetTimerTypes(std::vector<kodi::addon::PVRTimerType>& types) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->GetTimerTypes(types);
+    }
+
+    PVR_ERROR GetTimersAmount(int& amount) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->GetTimersAmount(amount);
+    }
+
+    PVR_ERROR GetTimers(kodi::addon::PVRTimersResultSet& results) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->GetTimers(results);
+    }
+
+    PVR_ERROR AddTimer(const kodi::addon::PVRTimer& timer) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->AddTimer(timer);
+    }
+
+    PVR_ERROR DeleteTimer(const kodi::addon::PVRTimer& timer, bool forceDelete) override
+    {
+        if (!m_client) {
+            return PVR_ERROR_SERVER_ERROR;
+        }
+
+        return m_client->DeleteTimer(timer, forceDelete);
     }
 
-    long long SeekLiveStream(long long position, int whence) override
+    // Recording operations
+    PVR_ERROR GetRecordingsAmount(bool deleted, int& amount) override
     {
-        // Live streams don't support seeking
-        return -1;
+        if (!m_client || deleted) {
+            amount = 0;
+            return PVR_ERROR_NO_ERROR;
+        }
+
+        return m_client->GetRecordingsAmount(amount);
     }
 
-    long long LengthLiveStream() override
+    PVR_ERROR GetRecordings(bool deleted, kodi::addon::PVRRecordingsResultSet& results) override
     {
-        // Live streams have no defined length
-        return -1;
+        if (!m_client || deleted) {
+            return PVR_ERROR_NO_ERROR;  // No undelete support
+        }
+
+        return m_client->GetRecordings(results);
     }
 
-    PVR_ERROR GetStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties) override
+    PVR_ERROR DeleteRecording(const kodi::addon::PVRRecording& recording) override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
             return PVR_ERROR_SERVER_ERROR;
         }
 
-        return g_hdmi_client->GetStreamProperties(properties);
+        return m_client->DeleteRecording(recording);
+    }
+
+    bool OpenRecordedStream(const kodi::addon::PVRRecording& recording) override
+    {
+        if (!m_client) {
+            return false;
+        }
+
+        return m_client->OpenRecordedStream(recording);
+    }
+
+    void CloseRecordedStream() override
+    {
+        if (m_client) {
+            m_client->CloseRecordedStream();
+        }
+    }
+
+    int ReadRecordedStream(unsigned char* buffer, unsigned int size) override
+    {
+        if (!m_client) {
+            return -1;
+        }
+
+        return m_client->ReadRecordedStream(buffer, size);
+    }
+
+    int64_t SeekRecordedStream(int64_t position, int whence) override
+    {
+        if (!m_client) {
+            return -1;
+        }
+
+        return m_client->SeekRecordedStream(position, whence);
+    }
+
+    int64_t LengthRecordedStream() override
+    {
+        if (!m_client) {
+            return -1;
+        }
+
+        return m_client->LengthRecordedStream();
     }
 
     PVR_ERROR GetSignalStatus(int channelUid, kodi::addon::PVRSignalStatus& signalStatus) override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
             return PVR_ERROR_SERVER_ERROR;
         }
 
-        return g_hdmi_client->GetSignalStatus(channelUid, signalStatus);
+        return m_client->GetSignalStatus(channelUid, signalStatus);
     }
 
     // Demux operations for hardware-accelerated streaming
     bool OpenDemuxStream(const kodi::addon::PVRChannel& channel) override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
             return false;
         }
 
-        return g_hdmi_client->OpenDemuxStream(channel);
+        return m_client->OpenDemuxStream(channel);
     }
 
     void CloseDemuxStream() override
     {
-        if (g_hdmi_client) {
-            g_hdmi_client->CloseDemuxStream();
+        if (m_client) {
+            m_client->CloseDemuxStream();
         }
     }
 
     DEMUX_PACKET* DemuxRead() override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
             return nullptr;
         }
 
-        return g_hdmi_client->DemuxRead();
+        return m_client->DemuxRead([this](int size) { return AllocateDemuxPacket(size); });
     }
 
     void DemuxAbort() override
     {
-        if (g_hdmi_client) {
-            g_hdmi_client->DemuxAbort();
+        if (m_client) {
+            m_client->DemuxAbort();
         }
     }
 
     void DemuxFlush() override
     {
-        if (g_hdmi_client) {
-            g_hdmi_client->DemuxFlush();
+        if (m_client) {
+            m_client->DemuxFlush();
         }
     }
 
     void DemuxReset() override
     {
-        if (g_hdmi_client) {
-            g_hdmi_client->DemuxReset();
+        if (m_client) {
+            m_client->DemuxReset();
         }
     }
 
+    bool SeekTime(double time, bool backwards, double& startpts) override
+    {
+        return m_client && m_client->DemuxSeekTime(time, backwards, startpts);
+    }
+
     // Menu hook for HDMI input settings
-    PVR_ERROR CallMenuHook(const kodi::addon::PVRMenuhook& menuhook, const kodi::addon::PVRChannel& channel) override
+    PVR_ERROR CallChannelMenuHook(const kodi::addon::PVRMenuhook& menuhook, const kodi::addon::PVRChannel& channel) override
     {
-        if (!g_hdmi_client) {
+        if (!m_client) {
             return PVR_ERROR_SERVER_ERROR;
         }
 
-        return g_hdmi_client->CallMenuHook(menuhook, channel);
+        return m_client->CallChannelMenuHook(menuhook, channel);
     }
+
+private:
+    // Client of this add-on instance
+    std::unique_ptr<hdmi_pvr::HdmiClient> m_client;
 };
 
 // Kodi addon entry points
@@ -0,0 +1,289 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Capture Pipeline Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "capture_pipeline.h"
+#include "log.h"
+#include <ctime>
+#include <sys/epoll.h>
+
+namespace hdmi_pvr {
+
+CapturePipeline::CapturePipeline(uint32_t index, const std::string& device_path,
+                                 std::shared_ptr<CaptureResources> resources, Reactor* reactor)
+    : m_index(index)
+    , m_device_path(device_path)
+    , m_name(device_path)
+    , m_card_name(device_path)
+    , m_resources(std::move(resources))
+    , m_reactor(reactor) {
+}
+
+CapturePipeline::~CapturePipeline() {
+    Shutdown();
+}
+
+bool CapturePipeline::LoadChannels() {
+    // The device object exists from the start but is only opened by Start()
+    m_device = std::make_unique<V4L2Device>(m_device_path);
+
+    m_channel_manager = std::make_unique<ChannelManager>(m_device.get());
+    m_channel_manager->SetUniqueIdBase(ToChannelUid(0));
+    if (!m_channel_manager->Initialize(GetChannelConfigPath())) {
+        Log(LogLevel::Error, "Failed to initialize channel manager for %s", m_device_path.c_str());
+        return false;
+    }
+
+    m_stream_processor = std::make_unique<StreamProcessor>(m_device.get());
+    m_stream_processor->SetResources(m_resources);
+    m_stream_processor->SetExternalCapture(m_reactor != nullptr);
+
+    // Polled from the owner's event loop rather than one thread per device
+    auto shared_device = std::shared_ptr<V4L2Device>(m_device.get(), [](V4L2Device*){});
+    m_signal_monitor = std::make_unique<SignalMonitor>(shared_device);
+
+    return true;
+}
+
+bool CapturePipeline::Start(uint32_t preallocate_buffers) {
+    std::lock_guard<std::mutex> lock(m_start_mutex);
+    if (m_ready.load()) {
+        return true;
+    }
+    if (!m_device) {
+        return false;
+    }
+
+    std::string device_path = GetDevicePath();
+    if (!m_device->IsOpen() && !m_device->Open()) {
+        Log(LogLevel::Error, "Failed to open V4L2 device: %s", device_path.c_str());
+        return false;
+    }
+
+    if (!m_device->QueryCapabilities()) {
+        Log(LogLevel::Error, "V4L2 device %s does not support required capabilities",
+            device_path.c_str());
+        m_device->Close();
+        return false;
+    }
+
+    if (!m_device->GetCardName().empty()) {
+        std::lock_guard<std::mutex> name_lock(m_name_mutex);
+        m_name = m_device->GetCardName();
+        m_card_name = m_name;
+    }
+    Log(LogLevel::Info, "V4L2 device opened: %s (driver: %s) at %s",
+        m_device->GetCardName().c_str(),
+        m_device->GetDriverName().c_str(),
+        device_path.c_str());
+
+    // Inputs the configuration does not know yet become channels now
+    m_channel_manager->ProbeInputs();
+
+    // A pipeline restarted after Stop() keeps its initialized processor
+    if (!m_stream_processor->IsInitialized() && !m_stream_processor->Initialize()) {
+        Log(LogLevel::Error, "Failed to initialize stream processor for %s", device_path.c_str());
+        m_device->Close();
+        return false;
+    }
+
+    if (!m_signal_monitor->Initialize(m_reactor == nullptr)) {
+        Log(LogLevel::Error, "Failed to initialize signal monitor for %s", device_path.c_str());
+        m_device->Close();
+        return false;
+    }
+
+    if (preallocate_buffers > 0 && !m_device->AllocateBuffers(preallocate_buffers)) {
+        // Not fatal - buffers are mapped again when streaming starts
+        Log(LogLevel::Warning, "Failed to allocate V4L2 buffers");
+    }
+
+    // Edge triggered: each completed buffer and each queued event reports
+    // once. The error vb2 reports while not streaming is ignored.
+    if (m_reactor) {
+        m_device_watch = m_reactor->AddFd(m_device->GetFd(), EPOLLIN | EPOLLPRI | EPOLLET,
+                                          [this](uint32_t events) { OnDeviceEvents(events); });
+        m_signal_timer_interval = m_signal_monitor->GetPollInterval();
+        m_signal_timer = m_reactor->AddTimer(m_signal_timer_interval, [this]() { PollSignal(); });
+        if (m_device_watch == 0 || m_signal_timer == 0) {
+            Log(LogLevel::Error, "Failed to watch capture device %s", device_path.c_str());
+            UnwatchDevice();
+            m_signal_monitor->Shutdown();
+            m_device->Close();
+            return false;
+        }
+    }
+
+    m_ready = true;
+    return true;
+}
+
+void CapturePipeline::Stop() {
+    std::lock_guard<std::mutex> lock(m_start_mutex);
+    if (!m_ready.load()) {
+        return;
+    }
+    m_ready = false;
+    UnwatchDevice();
+
+    // The processor stays initialized with its consumers, settings and demux state
+    m_signal_monitor->Shutdown();
+    m_stream_processor->StopStreaming();
+    m_stream_processor->ReleaseIdleBuffers();
+    m_channel_manager->CancelInputScan();
+    m_device->Close();
+
+    Log(LogLevel::Info, "Capture device %s stopped", GetDevicePath().c_str());
+}
+
+void CapturePipeline::Shutdown() {
+    m_ready = false;
+    UnwatchDevice();
+
+    // Shutdown in reverse order
+    if (m_signal_monitor) {
+        m_signal_monitor->Shutdown();
+        m_signal_monitor.reset();
+    }
+
+    if (m_stream_processor) {
+        m_stream_processor->Shutdown();
+        m_stream_processor.reset();
+    }
+
+    if (m_channel_manager) {
+        m_channel_manager->Shutdown();
+        m_channel_manager.reset();
+    }
+
+    if (m_device) {
+        m_device->Close();
+        m_device.reset();
+    }
+}
+
+std::string CapturePipeline::GetDevicePath() const {
+    std::lock_guard<std::mutex> lock(m_name_mutex);
+    return m_device_path;
+}
+
+bool CapturePipeline::SetDevicePath(const std::string& device_path) {
+    std::lock_guard<std::mutex> start_lock(m_start_mutex);
+    if (m_ready.load() || !m_device || !m_device->SetDevicePath(device_path)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_name_mutex);
+    m_device_path = device_path;
+    m_card_name = device_path;
+    return true;
+}
+
+std::string CapturePipeline::GetName() const {
+    std::lock_guard<std::mutex> lock(m_name_mutex);
+    return m_name;
+}
+
+void CapturePipeline::SetName(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_name_mutex);
+    m_name = name;
+}
+
+std::string CapturePipeline::GetCardName() const {
+    std::lock_guard<std::mutex> lock(m_name_mutex);
+    return m_card_name;
+}
+
+bool CapturePipeline::IsBusy() const {
+    return m_stream_processor && m_stream_processor->IsStreaming();
+}
+
+void CapturePipeline::ReleaseIdleResources() {
+    if (!IsReady() || IsBusy() || m_device->IsStreaming()) {
+        return;
+    }
+
+    m_stream_processor->ReleaseIdleBuffers();
+    if (m_device->GetBufferCount() > 0) {
+        m_device->DeallocateBuffers();
+        Log(LogLevel::Debug, "Released V4L2 buffers of idle device %s", GetDevicePath().c_str());
+    }
+}
+
+void CapturePipeline::UpdateSignalStatus() {
+    if (!IsReady()) {
+        return;
+    }
+
+    m_signal_monitor->UpdateSignalStatus();
+
+    SignalStatus status = m_signal_monitor->GetSignalStatus();
+    uint32_t active_channel = m_channel_manager->GetActiveChannel();
+    if (active_channel > 0) {
+        m_channel_manager->UpdateChannelStatus(active_channel, status);
+    }
+}
+
+void CapturePipeline::RecordTelemetry() {
+    if (!IsReady()) {
+        return;
+    }
+
+    m_telemetry.Record(time(nullptr), m_signal_monitor->GetSignalStatus(),
+                       m_stream_processor->GetFramesProcessed(), m_stream_processor->GetDroppedFrames());
+}
+
+void CapturePipeline::OnDeviceEvents(uint32_t events) {
+    // A source change is picked up right away, then watched closely while
+    // the source settles
+    if ((events & EPOLLPRI) && m_device->DrainEvents()) {
+        m_signal_monitor->RequestBurst();
+        PollSignal();
+    }
+
+    if (events & EPOLLIN) {
+        m_stream_processor->OnFramesReady();
+    }
+}
+
+void CapturePipeline::PollSignal() {
+    // The handlers may fire before Start() has stored the timer id
+    if (!IsReady()) {
+        return;
+    }
+
+    UpdateSignalStatus();
+
+    uint32_t interval = m_signal_monitor->GetPollInterval();
+    if (interval != m_signal_timer_interval && m_reactor->SetTimerInterval(m_signal_timer, interval)) {
+        m_signal_timer_interval = interval;
+    }
+}
+
+void CapturePipeline::UnwatchDevice() {
+    if (!m_reactor) {
+        return;
+    }
+    if (m_device_watch != 0) {
+        m_reactor->Remove(m_device_watch);
+        m_device_watch = 0;
+    }
+    if (m_signal_timer != 0) {
+        m_reactor->Remove(m_signal_timer);
+        m_signal_timer = 0;
+    }
+}
+
+std::string CapturePipeline::GetChannelConfigPath() const {
+    // The first device keeps the file it has always used
+    if (m_index == 0) {
+        return std::string();
+    }
+    return "hdmi_pvr_channels." + std::to_string(m_index) + ".conf";
+}
+
+} // namespace hdmi_pvr
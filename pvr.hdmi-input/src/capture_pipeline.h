@@ -0,0 +1,200 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "types.h"
+#include "v4l2_device.h"
+#include "channel_manager.h"
+#include "stream_processor.h"
+#include "signal_monitor.h"
+#include "capture_resources.h"
+#include "reactor.h"
+#include "signal_telemetry.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace hdmi_pvr {
+
+/**
+ * CapturePipeline bundles everything that serves one capture device: the
+ * V4L2 device, its channels, the stream processor with its capture thread
+ * and frame pool, and the signal monitor.
+ *
+ * Each pipeline publishes its channels with unique ids offset by
+ * index * CHANNEL_UID_STRIDE, so the first device keeps the ids it always
+ * had and channels of different devices never collide.
+ *
+ * Bring-up happens in two steps: LoadChannels() only reads the channel
+ * configuration, so channels can be listed right away, and Start() opens
+ * the hardware later from a background thread or the first stream open.
+ * Stop() takes the hardware down again while channels and stream state
+ * stay, which lets the pipeline move to another device node at runtime.
+ *
+ * Given a reactor, a started pipeline has no thread of its own: the device
+ * descriptor is watched there, and source change events and captured
+ * frames are handled on the reactor thread as the device reports them.
+ * The signal is polled from a reactor timer following the monitor's
+ * adaptive schedule; without a reactor the monitor polls on its own thread.
+ */
+class CapturePipeline {
+public:
+    static constexpr uint32_t CHANNEL_UID_STRIDE = 1000;  ///< Channel numbers stay below this
+
+    /**
+     * @param index Stable position of the device in the configuration
+     * @param device_path V4L2 device node
+     * @param resources Memory budget and statistics shared with other pipelines
+     * @param reactor Event loop serving the device, nullptr for a capture thread
+     */
+    CapturePipeline(uint32_t index, const std::string& device_path,
+                    std::shared_ptr<CaptureResources> resources, Reactor* reactor = nullptr);
+    ~CapturePipeline();
+
+    CapturePipeline(const CapturePipeline&) = delete;
+    CapturePipeline& operator=(const CapturePipeline&) = delete;
+
+    /**
+     * Create the components and load the channel configuration without
+     * touching the hardware
+     * @return false if the channel configuration cannot be loaded
+     */
+    bool LoadChannels();
+
+    /**
+     * Open the device and bring up its components. Concurrent callers wait
+     * for the first one; a failed start can be retried.
+     * @param preallocate_buffers V4L2 buffers to map right away, 0 to map on first use
+     * @return false if the device cannot be used
+     */
+    bool Start(uint32_t preallocate_buffers);
+    void Shutdown();
+
+    /**
+     * Stop capture and close the device, keeping everything Start() needs
+     */
+    void Stop();
+
+    /**
+     * Whether Start() succeeded - device, stream processor and signal
+     * monitor may only be used then
+     */
+    bool IsReady() const { return m_ready.load(); }
+
+    uint32_t GetIndex() const { return m_index; }
+    std::string GetDevicePath() const;
+
+    /**
+     * Point the pipeline at another device node
+     * @param device_path New V4L2 device node
+     * @return false while the pipeline is started
+     */
+    bool SetDevicePath(const std::string& device_path);
+
+    /**
+     * Name of the channel group holding this device's channels
+     */
+    std::string GetName() const;
+    void SetName(const std::string& name);
+
+    /**
+     * Name the device reports, the device path until it has been opened
+     */
+    std::string GetCardName() const;
+
+    V4L2Device& GetDevice() { return *m_device; }
+    ChannelManager& GetChannelManager() { return *m_channel_manager; }
+    StreamProcessor& GetStreamProcessor() { return *m_stream_processor; }
+    SignalMonitor& GetSignalMonitor() { return *m_signal_monitor; }
+    const ChannelManager& GetChannelManager() const { return *m_channel_manager; }
+    const StreamProcessor& GetStreamProcessor() const { return *m_stream_processor; }
+
+    /**
+     * Kodi channel unique id of a local channel number
+     */
+    uint32_t ToChannelUid(uint32_t channel_id) const { return m_index * CHANNEL_UID_STRIDE + channel_id; }
+
+    /**
+     * Local channel number of a Kodi channel unique id
+     */
+    static uint32_t ToChannelId(uint32_t channel_uid) { return channel_uid % CHANNEL_UID_STRIDE; }
+
+    /**
+     * Pipeline index a Kodi channel unique id belongs to
+     */
+    static uint32_t ToPipelineIndex(uint32_t channel_uid) { return channel_uid / CHANNEL_UID_STRIDE; }
+
+    /**
+     * Whether this pipeline is capturing (live, warm standby or recording)
+     */
+    bool IsBusy() const;
+
+    /**
+     * Give the frame pool and V4L2 buffers back while the device is idle
+     */
+    void ReleaseIdleResources();
+
+    /**
+     * Poll the signal and record it on the active channel
+     */
+    void UpdateSignalStatus();
+
+    /**
+     * Add the last polled signal and the capture counters to the telemetry,
+     * called once a second so idle seconds are recorded too
+     */
+    void RecordTelemetry();
+
+    const SignalTelemetry& GetTelemetry() const { return m_telemetry; }
+
+private:
+    uint32_t m_index;
+    std::string m_device_path;
+    std::string m_name;
+    std::string m_card_name;
+    mutable std::mutex m_name_mutex;  ///< Guards names and path, which change at runtime
+    std::shared_ptr<CaptureResources> m_resources;
+    Reactor* m_reactor;
+    int m_device_watch = 0;  ///< Reactor handler of the open device
+    int m_signal_timer = 0;  ///< Reactor timer polling the signal
+    uint32_t m_signal_timer_interval = 0;  ///< Reactor thread only
+    std::mutex m_start_mutex;
+    std::atomic<bool> m_ready{false};
+
+    std::unique_ptr<V4L2Device> m_device;
+    std::unique_ptr<ChannelManager> m_channel_manager;
+    std::unique_ptr<StreamProcessor> m_stream_processor;
+    std::unique_ptr<SignalMonitor> m_signal_monitor;
+    SignalTelemetry m_telemetry;
+
+    /**
+     * Channel configuration file of this device
+     */
+    std::string GetChannelConfigPath() const;
+
+    /**
+     * Handle readiness of the device descriptor on the reactor thread
+     * @param events EPOLL* events reported for the descriptor
+     */
+    void OnDeviceEvents(uint32_t events);
+
+    /**
+     * Poll the signal from the reactor timer and re-arm it with the
+     * monitor's next interval
+     */
+    void PollSignal();
+
+    /**
+     * Remove the device and its timer from the reactor, waiting for a
+     * callback in progress
+     */
+    void UnwatchDevice();
+};
+
+} // namespace hdmi_pvr
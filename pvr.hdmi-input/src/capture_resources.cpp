@@ -0,0 +1,47 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Shared Capture Resources Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "capture_resources.h"
+#include <algorithm>
+
+namespace hdmi_pvr {
+
+void MemoryBudget::SetLimit(size_t limit) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_limit = limit;
+}
+
+size_t MemoryBudget::GetLimit() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_limit;
+}
+
+size_t MemoryBudget::GetUsed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_used;
+}
+
+size_t MemoryBudget::Acquire(size_t minimum, size_t requested) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t granted = requested;
+    if (m_limit > 0) {
+        size_t available = m_limit > m_used ? m_limit - m_used : 0;
+        granted = std::max(std::min(requested, available), std::min(minimum, requested));
+    }
+
+    m_used += granted;
+    return granted;
+}
+
+void MemoryBudget::Release(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_used -= std::min(bytes, m_used);
+}
+
+} // namespace hdmi_pvr
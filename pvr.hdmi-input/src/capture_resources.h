@@ -0,0 +1,75 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace hdmi_pvr {
+
+/**
+ * MemoryBudget caps the frame memory of all capture pipelines together.
+ *
+ * Pipelines charge their frame pool against the budget when they start
+ * streaming and give it back once they are idle, so the memory held scales
+ * with the number of inputs in use rather than the number of inputs present.
+ * Thread-safe.
+ */
+class MemoryBudget {
+public:
+    /**
+     * @param limit Total bytes, 0 for no limit
+     */
+    explicit MemoryBudget(size_t limit = 0) : m_limit(limit) {}
+
+    void SetLimit(size_t limit);
+    size_t GetLimit() const;
+    size_t GetUsed() const;
+
+    /**
+     * Charge an allocation
+     * @param minimum Bytes needed to work at all - always granted, even over the limit
+     * @param requested Bytes wanted
+     * @return Bytes granted, between minimum and requested
+     */
+    size_t Acquire(size_t minimum, size_t requested);
+
+    /**
+     * Return a charge made by Acquire()
+     * @param bytes Bytes granted by Acquire()
+     */
+    void Release(size_t bytes);
+
+private:
+    mutable std::mutex m_mutex;
+    size_t m_limit;
+    size_t m_used = 0;
+};
+
+/**
+ * Capture counters summed over all pipelines
+ */
+struct CaptureStatistics {
+    std::atomic<uint64_t> frames_captured{0};
+    std::atomic<uint64_t> bytes_captured{0};
+    std::atomic<uint64_t> bytes_copied{0};  ///< Out of driver buffers, dropped frames included
+    std::atomic<uint64_t> frames_dropped{0};
+    std::atomic<uint64_t> duplicate_frames{0};
+};
+
+/**
+ * State shared by every capture pipeline of one client
+ */
+struct CaptureResources {
+    MemoryBudget budget;
+    CaptureStatistics stats;
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,86 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace hdmi_pvr {
+
+/**
+ * Where StreamProcessor takes its frames from.
+ *
+ * V4L2Device is the real one. SyntheticSource and ReplaySource stand in for
+ * it so the pipeline can be driven - and measured - without HDMI hardware.
+ * The source is configured by its owner before streaming starts; the
+ * processor only starts/stops it and pulls frames, SignalMonitor polls its
+ * signal state.
+ *
+ * Timestamps are CLOCK_MONOTONIC microseconds, like V4L2 buffer timestamps.
+ */
+class CaptureSource {
+public:
+    virtual ~CaptureSource() = default;
+
+    virtual bool IsOpen() const { return true; }
+
+    // Streaming control
+    virtual bool StartStreaming() = 0;
+    virtual bool StopStreaming() = 0;
+
+    // Negotiated format of the frames that follow
+    virtual VideoFormat GetConfiguredFormat() const = 0;
+    virtual uint32_t GetFrameSize() const = 0;
+    virtual uint32_t GetBytesPerLine() const = 0;
+    virtual uint32_t GetBufferCount() const = 0;
+
+    /**
+     * Wait up to timeout_ms for the next frame and copy it into buffer,
+     * growing it when needed
+     */
+    virtual bool CaptureFrame(VideoBuffer& buffer, uint32_t timeout_ms = 1000) = 0;
+
+    /**
+     * Wait up to timeout_ms for the next frame and copy it into dest
+     * @return false on timeout, error or a frame larger than capacity
+     */
+    virtual bool CaptureFrameInto(uint8_t* dest, size_t capacity, size_t& frame_size,
+                                  uint64_t& timestamp, uint32_t timeout_ms = 1000) = 0;
+
+    /**
+     * Driver sequence number of the frame captured last - gaps are frames
+     * the source lost
+     */
+    virtual uint64_t GetLastSequence() const = 0;
+
+    virtual bool CheckSignalPresent() = 0;
+
+    /**
+     * Signal state of the input, as polled by SignalMonitor
+     */
+    virtual SignalStatus GetSignalStatus() = 0;
+
+    /**
+     * Measure the timings at the input, for sources that can
+     */
+    virtual bool DetectInputFormat(VideoFormat& /*format*/) { return false; }
+
+    /**
+     * Descriptor that polls readable when a frame is ready, for event
+     * loops; -1 if the source can only be pulled with a timeout
+     */
+    virtual int GetFd() const { return -1; }
+
+    // Cropping, for sources that support it
+    virtual bool GetCropBounds(CropRect& /*bounds*/) { return false; }
+    virtual bool GetCropRect(CropRect& /*rect*/) { return false; }
+    virtual bool SetCropRect(CropRect& /*rect*/) { return false; }
+};
+
+} // namespace hdmi_pvr
@@ -1,12 +1,13 @@
 #include "channel_manager.h"
 #include "v4l2_device.h"
-#include <kodi/General.h>
+#include "log.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <set>
 
 namespace hdmi_pvr {
 
@@ -122,10 +123,112 @@ bool ChannelSettings::SaveToFile(const std::string& config_path) const {
     return true;
 }
 
+// ChannelTable Implementation
+const InputSource* ChannelTable::FindInput(uint32_t input_id) const {
+    auto it = std::lower_bound(inputs.begin(), inputs.end(), input_id,
+        [](const InputSource& input, uint32_t id) { return input.input_id < id; });
+    return (it != inputs.end() && it->input_id == input_id) ? &*it : nullptr;
+}
+
+InputSource* ChannelTable::FindInput(uint32_t input_id) {
+    return const_cast<InputSource*>(static_cast<const ChannelTable*>(this)->FindInput(input_id));
+}
+
+const InputSource* ChannelTable::FindChannel(uint32_t channel_number) const {
+    auto it = std::lower_bound(channels.begin(), channels.end(), channel_number,
+        [](const std::pair<uint32_t, size_t>& channel, uint32_t number) { return channel.first < number; });
+    return (it != channels.end() && it->first == channel_number) ? &inputs[it->second] : nullptr;
+}
+
+const SignalStatus* ChannelTable::FindStatus(uint32_t channel_number) const {
+    auto it = std::lower_bound(status.begin(), status.end(), channel_number,
+        [](const ChannelStatusEntry& entry, uint32_t number) { return entry.channel_number < number; });
+    return (it != status.end() && it->channel_number == channel_number) ? &it->status : nullptr;
+}
+
+uint64_t ChannelTable::GetStatusVersion(uint32_t channel_number) const {
+    auto it = std::lower_bound(status.begin(), status.end(), channel_number,
+        [](const ChannelStatusEntry& entry, uint32_t number) { return entry.channel_number < number; });
+    return (it != status.end() && it->channel_number == channel_number) ? it->version : 0;
+}
+
+bool ChannelTable::IsStatusChange(uint32_t channel_number, const SignalStatus& signal_status) const {
+    const SignalStatus* old_status = FindStatus(channel_number);
+    if (!old_status) {
+        return true;
+    }
+
+    // Strength and quality jitter on every poll and do not count as a change
+    return old_status->connected != signal_status.connected ||
+           old_status->signal_locked != signal_status.signal_locked ||
+           old_status->device_name != signal_status.device_name ||
+           old_status->video_format != signal_status.video_format ||
+           old_status->audio_format != signal_status.audio_format;
+}
+
+void ChannelTable::SetInput(const InputSource& input) {
+    auto it = std::lower_bound(inputs.begin(), inputs.end(), input.input_id,
+        [](const InputSource& existing, uint32_t id) { return existing.input_id < id; });
+    if (it != inputs.end() && it->input_id == input.input_id) {
+        *it = input;
+    } else {
+        inputs.insert(it, input);
+    }
+    ++inputs_version;
+}
+
+bool ChannelTable::EraseInput(uint32_t input_id) {
+    auto it = std::lower_bound(inputs.begin(), inputs.end(), input_id,
+        [](const InputSource& input, uint32_t id) { return input.input_id < id; });
+    if (it == inputs.end() || it->input_id != input_id) {
+        return false;
+    }
+    inputs.erase(it);
+    ++inputs_version;
+    return true;
+}
+
+void ChannelTable::SetStatus(uint32_t channel_number, const SignalStatus& signal_status) {
+    auto it = std::lower_bound(status.begin(), status.end(), channel_number,
+        [](const ChannelStatusEntry& entry, uint32_t number) { return entry.channel_number < number; });
+    if (it != status.end() && it->channel_number == channel_number) {
+        if (IsStatusChange(channel_number, signal_status)) {
+            ++it->version;
+        }
+        it->status = signal_status;
+    } else {
+        status.insert(it, ChannelStatusEntry{channel_number, signal_status, 1});
+    }
+}
+
+void ChannelTable::EraseStatus(uint32_t channel_number) {
+    auto it = std::lower_bound(status.begin(), status.end(), channel_number,
+        [](const ChannelStatusEntry& entry, uint32_t number) { return entry.channel_number < number; });
+    if (it != status.end() && it->channel_number == channel_number) {
+        status.erase(it);
+    }
+}
+
+void ChannelTable::RebuildChannelIndex() {
+    channels.clear();
+    channels.reserve(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        channels.emplace_back(inputs[i].channel_number, i);
+    }
+
+    // A channel number claimed twice belongs to the input with the higher id
+    std::stable_sort(channels.begin(), channels.end(),
+        [](const std::pair<uint32_t, size_t>& a, const std::pair<uint32_t, size_t>& b) { return a.first < b.first; });
+    auto last = std::unique(channels.rbegin(), channels.rend(),
+        [](const std::pair<uint32_t, size_t>& a, const std::pair<uint32_t, size_t>& b) { return a.first == b.first; });
+    channels.erase(channels.begin(), last.base());
+}
+
 // ChannelManager Implementation
 ChannelManager::ChannelManager(V4L2Device* v4l2_device)
     : m_v4l2_device(v4l2_device)
     , m_owns_v4l2_device(false)
+    , m_table(std::make_shared<ChannelTable>())
 {
     if (!m_v4l2_device) {
         m_v4l2_device = new V4L2Device();
@@ -151,68 +254,78 @@ bool ChannelManager::Initialize(const std::string& config_path) {
 
     m_config_path = config_path.empty() ? "hdmi_pvr_channels.conf" : config_path;
 
-    // Initialize V4L2 device
-    if (m_v4l2_device && !m_v4l2_device->IsOpen()) {
+    // A device passed in is opened by its owner, possibly later - channels
+    // are served from the configuration until then
+    if (m_owns_v4l2_device && !m_v4l2_device->IsOpen()) {
         if (!m_v4l2_device->Open()) {
-            kodi::Log(ADDON_LOG_WARNING, "Failed to open V4L2 device, continuing with simulation mode");
+            Log(LogLevel::Warning, "Failed to open V4L2 device, continuing with simulation mode");
         } else {
             m_v4l2_device->QueryCapabilities();
         }
     }
 
     // Load configuration
-    if (!LoadChannelSettings(m_config_path)) {
-        kodi::Log(ADDON_LOG_INFO, "No existing configuration found, loading defaults");
+    if (m_settings.LoadFromFile(m_config_path)) {
+        Log(LogLevel::Info, "Loaded channel settings from %s with %zu input sources",
+            m_config_path.c_str(), m_settings.inputs.size());
+    } else {
+        Log(LogLevel::Info, "No existing configuration found, loading defaults");
         if (!LoadDefaultConfiguration()) {
-            kodi::Log(ADDON_LOG_ERROR, "Failed to load default configuration");
+            Log(LogLevel::Error, "Failed to load default configuration");
             return false;
         }
     }
 
-    // Probe for V4L2 inputs if device is available
-    if (m_v4l2_device && m_v4l2_device->IsOpen()) {
-        ProbeV4L2Inputs();
+    auto table = std::make_shared<ChannelTable>();
+    for (const auto& [input_id, input_source] : m_settings.inputs) {
+        table->SetInput(input_source);
     }
+    table->enable_epg = m_settings.enable_epg;
 
-    // Update input mapping
-    if (!UpdateInputMapping()) {
-        kodi::Log(ADDON_LOG_ERROR, "Failed to update input mapping");
-        return false;
+    // Probe for V4L2 inputs if device is available
+    if (m_v4l2_device && m_v4l2_device->IsOpen()) {
+        ProbeV4L2Inputs(*table);
     }
 
     // Assign channel numbers if auto-numbering is enabled
     if (m_settings.auto_channel_numbering) {
-        AssignChannelNumbers();
+        AssignChannelNumbers(*table);
     }
+    table->RebuildChannelIndex();
 
     // Set first available channel as active
-    if (!m_input_sources.empty()) {
-        m_active_channel_id = m_input_sources.begin()->second.channel_number;
-        m_current_input_id = m_input_sources.begin()->first;
+    if (!table->inputs.empty()) {
+        m_active_channel_id = table->inputs.front().channel_number;
+        m_current_input_id = table->inputs.front().input_id;
     }
 
+    PublishTable(table);
+
     m_initialized = true;
-    kodi::Log(ADDON_LOG_INFO, "ChannelManager initialized with %zu input sources", m_input_sources.size());
+    Log(LogLevel::Info, "ChannelManager initialized with %zu input sources", table->inputs.size());
     LogInputSources();
 
     return true;
 }
 
 void ChannelManager::Shutdown() {
+    // The scanner takes the channel lock to publish results
+    CancelInputScan();
+
     if (!m_initialized.load()) {
         return;
     }
 
-    std::lock_guard<std::mutex> settings_lock(m_settings_mutex);
-    std::lock_guard<std::mutex> channel_lock(m_channel_mutex);
-
     // Save current configuration
     if (!m_config_path.empty()) {
         SaveChannelSettings(m_config_path);
     }
 
     // Clear all data
-    ClearChannelData();
+    {
+        std::lock_guard<std::mutex> channel_lock(m_channel_mutex);
+        ClearChannelData();
+    }
 
     // Close V4L2 device if we own it
     if (m_v4l2_device && m_owns_v4l2_device && m_v4l2_device->IsOpen()) {
@@ -220,49 +333,47 @@ void ChannelManager::Shutdown() {
     }
 
     m_initialized = false;
-    kodi::Log(ADDON_LOG_INFO, "ChannelManager shutdown complete");
+    Log(LogLevel::Info, "ChannelManager shutdown complete");
 }
 
 int ChannelManager::GetChannelCount() const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
-    return static_cast<int>(m_input_sources.size());
+    return static_cast<int>(GetChannelTable()->inputs.size());
 }
 
 PVR_ERROR ChannelManager::GetChannels(kodi::addon::PVRChannelsResultSet& results) {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
 
-    for (const auto& [input_id, input_source] : m_input_sources) {
+    for (const auto& input_source : table->inputs) {
         if (!input_source.enabled) {
             continue;
         }
 
-        kodi::addon::PVRChannel channel = CreateKodiChannel(input_source, input_source.channel_number);
+        kodi::addon::PVRChannel channel = CreateKodiChannel(input_source, m_unique_id_base + input_source.channel_number);
         results.Add(channel);
     }
 
-    kodi::Log(ADDON_LOG_DEBUG, "Returned %d channels to Kodi", results.Size());
+    Log(LogLevel::Debug, "Returned %d channels to Kodi", results.Size());
     return PVR_ERROR_NO_ERROR;
 }
 
 PVR_ERROR ChannelManager::GetChannelInfo(uint32_t channel_id, ChannelInfo& channel_info) {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
 
     // Find input source by channel number
-    for (const auto& [input_id, input_source] : m_input_sources) {
-        if (input_source.channel_number == channel_id) {
-            channel_info.channel_id = channel_id;
-            channel_info.channel_name = input_source.display_name.empty() ? input_source.name : input_source.display_name;
-            channel_info.channel_icon = input_source.icon_path;
-            channel_info.channel_number = input_source.channel_number;
-            channel_info.sub_channel_number = input_source.sub_channel_number;
-            channel_info.preview_enabled = true;
-            channel_info.radio = false;
-            channel_info.is_hidden = !input_source.enabled;
-            return PVR_ERROR_NO_ERROR;
-        }
-    }
-
-    return PVR_ERROR_INVALID_PARAMETERS;
+    const InputSource* input_source = table->FindChannel(channel_id);
+    if (!input_source) {
+        return PVR_ERROR_INVALID_PARAMETERS;
+    }
+
+    channel_info.channel_id = channel_id;
+    channel_info.channel_name = input_source->display_name.empty() ? input_source->name : input_source->display_name;
+    channel_info.channel_icon = input_source->icon_path;
+    channel_info.channel_number = input_source->channel_number;
+    channel_info.sub_channel_number = input_source->sub_channel_number;
+    channel_info.preview_enabled = true;
+    channel_info.radio = false;
+    channel_info.is_hidden = !input_source->enabled;
+    return PVR_ERROR_NO_ERROR;
 }
 
 bool ChannelManager::AddInputSource(const InputSource& input) {
@@ -271,52 +382,48 @@ bool ChannelManager::AddInputSource(const InputSource& input) {
     }
 
     std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = CopyTable();
 
     // Check if input_id already exists
-    if (m_input_sources.find(input.input_id) != m_input_sources.end()) {
-        kodi::Log(ADDON_LOG_WARNING, "Input source with ID %u already exists", input.input_id);
+    if (table->FindInput(input.input_id)) {
+        Log(LogLevel::Warning, "Input source with ID %u already exists", input.input_id);
         return false;
     }
 
     // Check channel number availability
-    if (!IsChannelNumberAvailable(input.channel_number)) {
-        kodi::Log(ADDON_LOG_WARNING, "Channel number %u is already in use", input.channel_number);
+    if (!IsChannelNumberAvailable(*table, input.channel_number)) {
+        Log(LogLevel::Warning, "Channel number %u is already in use", input.channel_number);
         return false;
     }
 
-    m_input_sources[input.input_id] = input;
-    UpdateInputMapping();
+    table->SetInput(input);
+    table->RebuildChannelIndex();
+    PublishTable(table);
 
-    kodi::Log(ADDON_LOG_INFO, "Added input source: ID=%u, Name='%s', Channel=%u",
-              input.input_id, input.name.c_str(), input.channel_number);
+    Log(LogLevel::Info, "Added input source: ID=%u, Name='%s', Channel=%u",
+        input.input_id, input.name.c_str(), input.channel_number);
 
     return true;
 }
 
 bool ChannelManager::RemoveInputSource(uint32_t input_id) {
     std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = CopyTable();
 
-    auto it = m_input_sources.find(input_id);
-    if (it == m_input_sources.end()) {
+    const InputSource* input = table->FindInput(input_id);
+    if (!input) {
         return false;
     }
 
-    uint32_t channel_number = it->second.channel_number;
-    m_input_sources.erase(it);
+    uint32_t channel_number = input->channel_number;
+    table->EraseInput(input_id);
 
-    // Remove from channel mapping
-    auto channel_it = m_channel_to_input_map.find(channel_number);
-    if (channel_it != m_channel_to_input_map.end()) {
-        m_channel_to_input_map.erase(channel_it);
-    }
-
-    // Remove from status tracking
-    auto status_it = m_channel_status.find(channel_number);
-    if (status_it != m_channel_status.end()) {
-        m_channel_status.erase(status_it);
-    }
+    // Remove from channel mapping and status tracking
+    table->RebuildChannelIndex();
+    table->EraseStatus(channel_number);
+    PublishTable(table);
 
-    kodi::Log(ADDON_LOG_INFO, "Removed input source: ID=%u", input_id);
+    Log(LogLevel::Info, "Removed input source: ID=%u", input_id);
     return true;
 }
 
@@ -326,139 +433,117 @@ bool ChannelManager::UpdateInputSource(uint32_t input_id, const InputSource& inp
     }
 
     std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = CopyTable();
 
-    auto it = m_input_sources.find(input_id);
-    if (it == m_input_sources.end()) {
+    const InputSource* existing = table->FindInput(input_id);
+    if (!existing) {
         return false;
     }
 
-    uint32_t old_channel_number = it->second.channel_number;
+    uint32_t old_channel_number = existing->channel_number;
     uint32_t new_channel_number = input.channel_number;
 
     // Check if new channel number is available (unless it's the same)
-    if (old_channel_number != new_channel_number && !IsChannelNumberAvailable(new_channel_number)) {
-        kodi::Log(ADDON_LOG_WARNING, "Channel number %u is already in use", new_channel_number);
+    if (old_channel_number != new_channel_number && !IsChannelNumberAvailable(*table, new_channel_number)) {
+        Log(LogLevel::Warning, "Channel number %u is already in use", new_channel_number);
         return false;
     }
 
     // Update input source
-    it->second = input;
+    table->SetInput(input);
 
     // Update channel mapping if channel number changed
     if (old_channel_number != new_channel_number) {
-        m_channel_to_input_map.erase(old_channel_number);
-        m_channel_to_input_map[new_channel_number] = input_id;
+        table->RebuildChannelIndex();
 
         // Move status data
-        auto status_it = m_channel_status.find(old_channel_number);
-        if (status_it != m_channel_status.end()) {
-            m_channel_status[new_channel_number] = status_it->second;
-            m_channel_status.erase(status_it);
+        if (const SignalStatus* status = table->FindStatus(old_channel_number)) {
+            SignalStatus moved = *status;
+            table->EraseStatus(old_channel_number);
+            table->SetStatus(new_channel_number, moved);
         }
     }
+    PublishTable(table);
 
-    kodi::Log(ADDON_LOG_INFO, "Updated input source: ID=%u, Name='%s', Channel=%u",
-              input_id, input.name.c_str(), input.channel_number);
+    Log(LogLevel::Info, "Updated input source: ID=%u, Name='%s', Channel=%u",
+        input_id, input.name.c_str(), input.channel_number);
 
     return true;
 }
 
 std::vector<InputSource> ChannelManager::GetInputSources() const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
-    std::vector<InputSource> sources;
-    sources.reserve(m_input_sources.size());
-
-    for (const auto& [input_id, input_source] : m_input_sources) {
-        sources.push_back(input_source);
-    }
-
-    return sources;
+    return GetChannelTable()->inputs;
 }
 
-InputSource* ChannelManager::GetInputSource(uint32_t input_id) {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
-    auto it = m_input_sources.find(input_id);
-    return (it != m_input_sources.end()) ? &it->second : nullptr;
-}
-
-const InputSource* ChannelManager::GetInputSource(uint32_t input_id) const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
-    auto it = m_input_sources.find(input_id);
-    return (it != m_input_sources.end()) ? &it->second : nullptr;
+bool ChannelManager::GetInputSource(uint32_t input_id, InputSource& input) const {
+    auto table = GetChannelTable();
+    const InputSource* found = table->FindInput(input_id);
+    if (!found) {
+        return false;
+    }
+    input = *found;
+    return true;
 }
 
 bool ChannelManager::SetActiveChannel(uint32_t channel_id) {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
 
-    auto channel_it = m_channel_to_input_map.find(channel_id);
-    if (channel_it == m_channel_to_input_map.end()) {
+    const InputSource* input = table->FindChannel(channel_id);
+    if (!input || !input->enabled) {
         return false;
     }
 
-    uint32_t input_id = channel_it->second;
-    auto input_it = m_input_sources.find(input_id);
-    if (input_it == m_input_sources.end() || !input_it->second.enabled) {
-        return false;
-    }
+    uint32_t input_id = input->input_id;
 
     m_active_channel_id = channel_id;
     m_current_input_id = input_id;
 
     // Switch V4L2 input if device is available
     if (m_v4l2_device && m_v4l2_device->IsOpen()) {
+        std::lock_guard<std::mutex> input_lock(m_input_mutex);
         m_v4l2_device->SetInput(input_id);
     }
 
-    kodi::Log(ADDON_LOG_INFO, "Set active channel to %u (input %u)", channel_id, input_id);
+    Log(LogLevel::Info, "Set active channel to %u (input %u)", channel_id, input_id);
     return true;
 }
 
 bool ChannelManager::IsChannelAvailable(uint32_t channel_id) const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
-    auto it = m_channel_to_input_map.find(channel_id);
-    if (it == m_channel_to_input_map.end()) {
-        return false;
-    }
-
-    auto input_it = m_input_sources.find(it->second);
-    return (input_it != m_input_sources.end() && input_it->second.enabled);
+    auto table = GetChannelTable();
+    const InputSource* input = table->FindChannel(channel_id);
+    return input && input->enabled;
 }
 
 std::string ChannelManager::GetChannelName(uint32_t channel_id) const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
-    auto channel_it = m_channel_to_input_map.find(channel_id);
-    if (channel_it == m_channel_to_input_map.end()) {
-        return "";
-    }
-
-    auto input_it = m_input_sources.find(channel_it->second);
-    if (input_it == m_input_sources.end()) {
+    auto table = GetChannelTable();
+    const InputSource* input = table->FindChannel(channel_id);
+    if (!input) {
         return "";
     }
 
-    const auto& input = input_it->second;
-    return input.display_name.empty() ? input.name : input.display_name;
+    return input->display_name.empty() ? input->name : input->display_name;
 }
 
 bool ChannelManager::SwitchToInput(uint32_t input_id) {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
 
-    auto it = m_input_sources.find(input_id);
-    if (it == m_input_sources.end() || !it->second.enabled) {
+    const InputSource* input = table->FindInput(input_id);
+    if (!input || !input->enabled) {
         return false;
     }
 
     m_current_input_id = input_id;
-    m_active_channel_id = it->second.channel_number;
+    m_active_channel_id = input->channel_number;
 
     // Switch V4L2 input if device is available
     if (m_v4l2_device && m_v4l2_device->IsOpen()) {
+        std::lock_guard<std::mutex> input_lock(m_input_mutex);
         if (!m_v4l2_device->SetInput(input_id)) {
-            kodi::Log(ADDON_LOG_WARNING, "Failed to switch V4L2 device to input %u", input_id);
+            Log(LogLevel::Warning, "Failed to switch V4L2 device to input %u", input_id);
         }
     }
 
-    kodi::Log(ADDON_LOG_INFO, "Switched to input %u (channel %u)", input_id, m_active_channel_id.load());
+    Log(LogLevel::Info, "Switched to input %u (channel %u)", input_id, m_active_channel_id.load());
     return true;
 }
 
@@ -467,20 +552,95 @@ bool ChannelManager::DetectActiveInputs() {
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    std::lock_guard<std::mutex> scan_lock(m_scan_mutex);
+    if (m_scan_running.load()) {
+        Log(LogLevel::Debug, "Input scan already running");
+        return false;
+    }
+
+    // Reap the previous, finished scan
+    if (m_scan_thread.joinable()) {
+        m_scan_thread.join();
+    }
+
+    // Work on a snapshot so channel queries never wait for the scan
+    std::vector<std::pair<uint32_t, uint32_t>> inputs;
+    for (const auto& input_source : GetChannelTable()->inputs) {
+        if (input_source.enabled && input_source.auto_detect) {
+            inputs.emplace_back(input_source.input_id, input_source.channel_number);
+        }
+    }
+
+    m_scan_cancel = false;
+    m_scan_running = true;
+    m_scan_thread = std::thread(&ChannelManager::InputScanThread, this, std::move(inputs));
+    return true;
+}
+
+void ChannelManager::CancelInputScan() {
+    std::lock_guard<std::mutex> scan_lock(m_scan_mutex);
+    m_scan_cancel = true;
+    if (m_scan_thread.joinable()) {
+        m_scan_thread.join();
+    }
+}
+
+void ChannelManager::InputScanThread(std::vector<std::pair<uint32_t, uint32_t>> inputs) {
+    size_t probed = 0;
+    size_t with_signal = 0;
+
+    for (const auto& [input_id, channel_number] : inputs) {
+        if (m_scan_cancel.load()) {
+            break;
+        }
 
-    for (auto& [input_id, input_source] : m_input_sources) {
-        if (!input_source.auto_detect) {
+        SignalStatus status = GetChannelStatus(channel_number);
+        if (!ProbeInputSignal(input_id, status)) {
             continue;
         }
 
-        // Check signal presence for this input
-        m_v4l2_device->SetInput(input_id);
-        bool signal_present = m_v4l2_device->CheckSignalPresent();
+        // Publish right away - a slow input does not hold back the others
+        UpdateChannelStatus(channel_number, status);
+
+        ++probed;
+        if (status.connected) {
+            ++with_signal;
+        }
+    }
+
+    Log(LogLevel::Info, "Input scan %s: %zu of %zu inputs probed, %zu with signal",
+        m_scan_cancel.load() ? "cancelled" : "finished", probed, inputs.size(), with_signal);
+    m_scan_running = false;
+}
+
+bool ChannelManager::ProbeInputSignal(uint32_t input_id, SignalStatus& status) {
+    std::lock_guard<std::mutex> input_lock(m_input_mutex);
+
+    // A capture being brought up owns the input before it streams; the flag
+    // is set before its input switch, which waits for this lock
+    uint32_t selected_input = m_current_input_id.load();
+    bool streaming = m_v4l2_device->IsStreaming() || m_capture_starting.load();
+
+    // The live input is reported by the signal monitor
+    if (streaming && input_id == selected_input) {
+        return false;
+    }
+
+    // Switching inputs under a running capture would break the stream -
+    // other inputs are then only queried where they are
+    bool switched = false;
+    if (!streaming && input_id != selected_input) {
+        if (!m_v4l2_device->SetInput(input_id)) {
+            return false;
+        }
+        switched = true;
+        m_v4l2_device->WaitForSignalLock(SCAN_LOCK_TIMEOUT_MS);
+    }
+
+    bool signal_present = false;
+    bool queried = m_v4l2_device->QueryInputSignal(input_id, signal_present);
 
-        // Update channel status
-        uint32_t channel_number = input_source.channel_number;
-        SignalStatus& status = m_channel_status[channel_number];
+    if (queried) {
         status.connected = signal_present;
         status.signal_locked = signal_present;
         status.last_update = std::chrono::steady_clock::now();
@@ -488,8 +648,10 @@ bool ChannelManager::DetectActiveInputs() {
         if (signal_present) {
             status.signal_strength = 100;
             status.signal_quality = 90;
+
+            // Timings can only be read from the selected input
             VideoFormat format;
-            if (m_v4l2_device->DetectInputFormat(format)) {
+            if (!streaming && m_v4l2_device->DetectInputFormat(format)) {
                 status.video_format = format;
             }
         } else {
@@ -498,18 +660,41 @@ bool ChannelManager::DetectActiveInputs() {
         }
     }
 
+    if (switched) {
+        m_v4l2_device->SetInput(selected_input);
+    }
+
+    return queried;
+}
+
+bool ChannelManager::ProbeInputs() {
+    std::lock_guard<std::mutex> settings_lock(m_settings_mutex);
+    std::lock_guard<std::mutex> channel_lock(m_channel_mutex);
+
+    auto table = CopyTable();
+    size_t known_inputs = table->inputs.size();
+    if (!ProbeV4L2Inputs(*table) || table->inputs.size() == known_inputs) {
+        return false;
+    }
+
+    if (m_settings.auto_channel_numbering) {
+        AssignChannelNumbers(*table);
+    }
+    table->RebuildChannelIndex();
+    PublishTable(table);
+
+    Log(LogLevel::Info, "Device added %zu input sources", table->inputs.size() - known_inputs);
     return true;
 }
 
 std::vector<uint32_t> ChannelManager::GetActiveInputs() const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
     std::vector<uint32_t> active_inputs;
 
-    for (const auto& [channel_number, status] : m_channel_status) {
-        if (status.connected && status.signal_locked) {
-            auto channel_it = m_channel_to_input_map.find(channel_number);
-            if (channel_it != m_channel_to_input_map.end()) {
-                active_inputs.push_back(channel_it->second);
+    for (const auto& entry : table->status) {
+        if (entry.status.connected && entry.status.signal_locked) {
+            if (const InputSource* input = table->FindChannel(entry.channel_number)) {
+                active_inputs.push_back(input->input_id);
             }
         }
     }
@@ -523,27 +708,33 @@ bool ChannelManager::SetChannelSettings(const ChannelSettings& settings) {
 
     m_settings = settings;
     
-    // Update input sources from settings
-    m_input_sources = settings.inputs;
-    
-    // Update mappings
-    UpdateInputMapping();
+    // Update input sources from settings, keeping the known signal status
+    auto table = CopyTable();
+    table->inputs.clear();
+    for (const auto& [input_id, input_source] : settings.inputs) {
+        table->SetInput(input_source);
+    }
+    table->enable_epg = m_settings.enable_epg;
     
     // Reassign channel numbers if auto-numbering is enabled
     if (m_settings.auto_channel_numbering) {
-        AssignChannelNumbers();
+        AssignChannelNumbers(*table);
     }
+    table->RebuildChannelIndex();
+    PublishTable(table);
 
-    kodi::Log(ADDON_LOG_INFO, "Updated channel settings with %zu input sources", m_input_sources.size());
+    Log(LogLevel::Info, "Updated channel settings with %zu input sources", table->inputs.size());
     return true;
 }
 
 ChannelSettings ChannelManager::GetChannelSettings() const {
     std::lock_guard<std::mutex> settings_lock(m_settings_mutex);
-    std::lock_guard<std::mutex> channel_lock(m_channel_mutex);
 
     ChannelSettings settings = m_settings;
-    settings.inputs = m_input_sources;
+    settings.inputs.clear();
+    for (const auto& input_source : GetChannelTable()->inputs) {
+        settings.inputs[input_source.input_id] = input_source;
+    }
     return settings;
 }
 
@@ -555,27 +746,29 @@ bool ChannelManager::LoadChannelSettings(const std::string& config_path) {
     }
 
     std::lock_guard<std::mutex> channel_lock(m_channel_mutex);
-    m_input_sources = m_settings.inputs;
-    UpdateInputMapping();
+    auto table = CopyTable();
+    table->inputs.clear();
+    for (const auto& [input_id, input_source] : m_settings.inputs) {
+        table->SetInput(input_source);
+    }
+    table->enable_epg = m_settings.enable_epg;
+    table->RebuildChannelIndex();
+    PublishTable(table);
 
-    kodi::Log(ADDON_LOG_INFO, "Loaded channel settings from %s with %zu input sources",
-              config_path.c_str(), m_input_sources.size());
+    Log(LogLevel::Info, "Loaded channel settings from %s with %zu input sources",
+        config_path.c_str(), table->inputs.size());
 
     return true;
 }
 
 bool ChannelManager::SaveChannelSettings(const std::string& config_path) const {
-    std::lock_guard<std::mutex> settings_lock(m_settings_mutex);
-    std::lock_guard<std::mutex> channel_lock(m_channel_mutex);
-
-    ChannelSettings settings = m_settings;
-    settings.inputs = m_input_sources;
+    ChannelSettings settings = GetChannelSettings();
 
     bool result = settings.SaveToFile(config_path);
     if (result) {
-        kodi::Log(ADDON_LOG_INFO, "Saved channel settings to %s", config_path.c_str());
+        Log(LogLevel::Info, "Saved channel settings to %s", config_path.c_str());
     } else {
-        kodi::Log(ADDON_LOG_ERROR, "Failed to save channel settings to %s", config_path.c_str());
+        Log(LogLevel::Error, "Failed to save channel settings to %s", config_path.c_str());
     }
 
     return result;
@@ -584,83 +777,71 @@ bool ChannelManager::SaveChannelSettings(const std::string& config_path) const {
 bool ChannelManager::UpdateChannelMetadata(uint32_t channel_id, const std::string& name,
                                          const std::string& icon, const std::string& description) {
     std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = CopyTable();
 
-    auto channel_it = m_channel_to_input_map.find(channel_id);
-    if (channel_it == m_channel_to_input_map.end()) {
-        return false;
-    }
-
-    auto input_it = m_input_sources.find(channel_it->second);
-    if (input_it == m_input_sources.end()) {
+    const InputSource* channel = table->FindChannel(channel_id);
+    if (!channel) {
         return false;
     }
 
-    InputSource& input = input_it->second;
+    InputSource input = *channel;
     if (!name.empty()) input.display_name = name;
     if (!icon.empty()) input.icon_path = icon;
     if (!description.empty()) input.description = description;
+    table->SetInput(input);
+    PublishTable(table);
 
-    kodi::Log(ADDON_LOG_INFO, "Updated metadata for channel %u", channel_id);
+    Log(LogLevel::Info, "Updated metadata for channel %u", channel_id);
     return true;
 }
 
 std::vector<EpgEntry> ChannelManager::GenerateEPG(uint32_t channel_id, time_t start_time, time_t end_time) {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
     std::vector<EpgEntry> epg_entries;
 
-    if (!m_settings.enable_epg) {
-        return epg_entries;
-    }
-
-    auto channel_it = m_channel_to_input_map.find(channel_id);
-    if (channel_it == m_channel_to_input_map.end()) {
+    if (!table->enable_epg) {
         return epg_entries;
     }
 
-    auto input_it = m_input_sources.find(channel_it->second);
-    if (input_it == m_input_sources.end()) {
+    const InputSource* channel = table->FindChannel(channel_id);
+    if (!channel) {
         return epg_entries;
     }
 
-    const InputSource& input = input_it->second;
-    SignalStatus status;
-    auto status_it = m_channel_status.find(channel_id);
-    if (status_it != m_channel_status.end()) {
-        status = status_it->second;
-    }
-
-    // Generate EPG entries for the time range
-    time_t current_time = start_time;
-    uint32_t broadcast_id = channel_id * 1000; // Base broadcast ID
-
-    while (current_time < end_time) {
-        time_t entry_duration = 3600; // 1 hour entries
-        if (current_time + entry_duration > end_time) {
-            entry_duration = end_time - current_time;
-        }
-
-        EpgEntry entry = CreateBasicEpgEntry(channel_id, current_time, entry_duration);
-        entry.broadcast_id = broadcast_id++;
-        entry.title = GenerateEpgTitle(input, status);
-        entry.plot = GenerateEpgDescription(input, status);
-
-        epg_entries.push_back(entry);
-        current_time += entry_duration;
-    }
-
-    return epg_entries;
+    // Texts are only formatted when the source or format changed since the
+    // channel's guide was last generated
+    return m_epg_cache.GetEntries(channel_id, table->inputs_version, table->GetStatusVersion(channel_id),
+                                  start_time, end_time,
+        [&](std::string& title, std::string& plot) {
+            SignalStatus status;
+            if (const SignalStatus* known = table->FindStatus(channel_id)) {
+                status = *known;
+            }
+            title = GenerateEpgTitle(*channel, status);
+            plot = GenerateEpgDescription(*channel, status);
+        });
 }
 
 bool ChannelManager::UpdateChannelStatus(uint32_t channel_id, const SignalStatus& status) {
     std::lock_guard<std::mutex> lock(m_channel_mutex);
-    m_channel_status[channel_id] = status;
+
+    // The signal is polled every 50 ms during a burst - only a change worth
+    // a new version is worth copying the table for, the published status
+    // keeps the strength and quality of that change
+    if (!GetChannelTable()->IsStatusChange(channel_id, status)) {
+        return true;
+    }
+
+    auto table = CopyTable();
+    table->SetStatus(channel_id, status);
+    PublishTable(table);
     return true;
 }
 
 SignalStatus ChannelManager::GetChannelStatus(uint32_t channel_id) const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
-    auto it = m_channel_status.find(channel_id);
-    return (it != m_channel_status.end()) ? it->second : SignalStatus{};
+    auto table = GetChannelTable();
+    const SignalStatus* status = table->FindStatus(channel_id);
+    return status ? *status : SignalStatus{};
 }
 
 void ChannelManager::RefreshAllChannelStatus() {
@@ -668,25 +849,42 @@ void ChannelManager::RefreshAllChannelStatus() {
         return;
     }
 
+    // Probe without holding the channel lock, then publish all results at once
+    auto snapshot = GetChannelTable();
+    std::vector<ChannelStatusEntry> results;
+    for (const auto& input_source : snapshot->inputs) {
+        ChannelStatusEntry entry;
+        entry.channel_number = input_source.channel_number;
+        entry.status = GetChannelStatus(entry.channel_number);
+        if (ProbeInputSignal(input_source.input_id, entry.status)) {
+            results.push_back(entry);
+        }
+    }
+
     std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto current = GetChannelTable();
+    results.erase(std::remove_if(results.begin(), results.end(),
+        [&current](const ChannelStatusEntry& entry) {
+            return !current->IsStatusChange(entry.channel_number, entry.status);
+        }),
+        results.end());
+    if (results.empty()) {
+        return;
+    }
 
-    for (const auto& [input_id, input_source] : m_input_sources) {
-        uint32_t channel_number = input_source.channel_number;
-        
-        // Switch to input and get status
-        m_v4l2_device->SetInput(input_id);
-        SignalStatus status = m_v4l2_device->GetSignalStatus();
-        
-        m_channel_status[channel_number] = status;
+    auto table = CopyTable();
+    for (const auto& entry : results) {
+        table->SetStatus(entry.channel_number, entry.status);
     }
+    PublishTable(table);
 }
 
 bool ChannelManager::ValidateChannelConfiguration() const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
 
     // Check for duplicate channel numbers
     std::set<uint32_t> channel_numbers;
-    for (const auto& [input_id, input_source] : m_input_sources) {
+    for (const auto& input_source : table->inputs) {
         if (channel_numbers.count(input_source.channel_number)) {
             return false;
         }
@@ -694,7 +892,7 @@ bool ChannelManager::ValidateChannelConfiguration() const {
     }
 
     // Check for valid input sources
-    for (const auto& [input_id, input_source] : m_input_sources) {
+    for (const auto& input_source : table->inputs) {
         if (!ValidateInputSource(input_source)) {
             return false;
         }
@@ -704,13 +902,13 @@ bool ChannelManager::ValidateChannelConfiguration() const {
 }
 
 std::vector<std::string> ChannelManager::GetConfigurationErrors() const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
     std::vector<std::string> errors;
 
     // Check for duplicate channel numbers
     std::map<uint32_t, std::vector<uint32_t>> channel_conflicts;
-    for (const auto& [input_id, input_source] : m_input_sources) {
-        channel_conflicts[input_source.channel_number].push_back(input_id);
+    for (const auto& input_source : table->inputs) {
+        channel_conflicts[input_source.channel_number].push_back(input_source.input_id);
     }
 
     for (const auto& [channel_number, input_ids] : channel_conflicts) {
@@ -726,12 +924,12 @@ std::vector<std::string> ChannelManager::GetConfigurationErrors() const {
     }
 
     // Validate each input source
-    for (const auto& [input_id, input_source] : m_input_sources) {
+    for (const auto& input_source : table->inputs) {
         if (input_source.name.empty()) {
-            errors.push_back("Input " + std::to_string(input_id) + " has empty name");
+            errors.push_back("Input " + std::to_string(input_source.input_id) + " has empty name");
         }
         if (input_source.channel_number == 0) {
-            errors.push_back("Input " + std::to_string(input_id) + " has invalid channel number 0");
+            errors.push_back("Input " + std::to_string(input_source.input_id) + " has invalid channel number 0");
         }
     }
 
@@ -739,25 +937,25 @@ std::vector<std::string> ChannelManager::GetConfigurationErrors() const {
 }
 
 void ChannelManager::LogChannelStatus() const {
-    std::lock_guard<std::mutex> lock(m_channel_mutex);
+    auto table = GetChannelTable();
     
-    kodi::Log(ADDON_LOG_INFO, "=== Channel Manager Status ===");
-    kodi::Log(ADDON_LOG_INFO, "Initialized: %s", m_initialized.load() ? "true" : "false");
-    kodi::Log(ADDON_LOG_INFO, "Active Channel: %u", m_active_channel_id.load());
-    kodi::Log(ADDON_LOG_INFO, "Current Input: %u", m_current_input_id.load());
-    kodi::Log(ADDON_LOG_INFO, "Input Sources: %zu", m_input_sources.size());
+    Log(LogLevel::Info, "=== Channel Manager Status ===");
+    Log(LogLevel::Info, "Initialized: %s", m_initialized.load() ? "true" : "false");
+    Log(LogLevel::Info, "Active Channel: %u", m_active_channel_id.load());
+    Log(LogLevel::Info, "Current Input: %u", m_current_input_id.load());
+    Log(LogLevel::Info, "Input Sources: %zu", table->inputs.size());
     
-    for (const auto& [input_id, input_source] : m_input_sources) {
-        kodi::Log(ADDON_LOG_INFO, "  Input %u: %s (Channel %u, %s)",
-                  input_id, input_source.name.c_str(), input_source.channel_number,
-                  input_source.enabled ? "enabled" : "disabled");
+    for (const auto& input_source : table->inputs) {
+        Log(LogLevel::Info, "  Input %u: %s (Channel %u, %s)",
+            input_source.input_id, input_source.name.c_str(), input_source.channel_number,
+            input_source.enabled ? "enabled" : "disabled");
     }
     
-    kodi::Log(ADDON_LOG_INFO, "Channel Status: %zu entries", m_channel_status.size());
-    for (const auto& [channel_id, status] : m_channel_status) {
-        kodi::Log(ADDON_LOG_INFO, "  Channel %u: %s, signal=%u%%, quality=%u%%",
-                  channel_id, status.connected ? "connected" : "disconnected",
-                  status.signal_strength, status.signal_quality);
+    Log(LogLevel::Info, "Channel Status: %zu entries", table->status.size());
+    for (const auto& entry : table->status) {
+        Log(LogLevel::Info, "  Channel %u: %s, signal=%u%%, quality=%u%%",
+            entry.channel_number, entry.status.connected ? "connected" : "disconnected",
+            entry.status.signal_strength, entry.status.signal_quality);
     }
 }
 
@@ -820,10 +1018,9 @@ bool ChannelManager::LoadDefaultConfiguration() {
     hdmi_input.channel_number = 1;
     hdmi_input.show_osd = true;
 
-    m_input_sources[0] = hdmi_input;
-    m_settings.inputs = m_input_sources;
+    m_settings.inputs[0] = hdmi_input;
 
-    kodi::Log(ADDON_LOG_INFO, "Loaded default configuration with HDMI input");
+    Log(LogLevel::Info, "Loaded default configuration with HDMI input");
     return true;
 }
 
@@ -844,10 +1041,10 @@ uint32_t ChannelManager::GenerateChannelId(const InputSource& input) const {
     return input.channel_number;
 }
 
-uint32_t ChannelManager::GetNextAvailableChannelNumber() const {
+uint32_t ChannelManager::GetNextAvailableChannelNumber(const ChannelTable& table) const {
     uint32_t next_number = m_settings.base_channel_number;
     
-    while (!IsChannelNumberAvailable(next_number)) {
+    while (!IsChannelNumberAvailable(table, next_number)) {
         next_number++;
         if (next_number > 999) { // Prevent infinite loop
             break;
@@ -857,38 +1054,37 @@ uint32_t ChannelManager::GetNextAvailableChannelNumber() const {
     return next_number;
 }
 
-bool ChannelManager::UpdateInputMapping() {
-    m_channel_to_input_map.clear();
-    
-    for (const auto& [input_id, input_source] : m_input_sources) {
-        m_channel_to_input_map[input_source.channel_number] = input_id;
-    }
-    
-    return true;
+std::shared_ptr<ChannelTable> ChannelManager::CopyTable() const {
+    return std::make_shared<ChannelTable>(*GetChannelTable());
+}
+
+void ChannelManager::PublishTable(std::shared_ptr<ChannelTable> table) {
+    // Readers still holding the old table keep it alive until they are done
+    std::atomic_store(&m_table, std::shared_ptr<const ChannelTable>(std::move(table)));
 }
 
 void ChannelManager::ClearChannelData() {
-    m_input_sources.clear();
-    m_channel_to_input_map.clear();  
-    m_channel_status.clear();
+    // A fresh table starts its versions over, so cached guides must go too
+    PublishTable(std::make_shared<ChannelTable>());
+    m_epg_cache.Clear();
     m_active_channel_id = 1;
     m_current_input_id = 0;
 }
 
-bool ChannelManager::ProbeV4L2Inputs() {
+bool ChannelManager::ProbeV4L2Inputs(ChannelTable& table) {
     if (!m_v4l2_device || !m_v4l2_device->IsOpen()) {
         return false;
     }
 
     std::vector<std::string> input_names = m_v4l2_device->GetInputNames();
-    kodi::Log(ADDON_LOG_INFO, "Found %zu V4L2 inputs", input_names.size());
+    Log(LogLevel::Info, "Found %zu V4L2 inputs", input_names.size());
 
     // Create input sources for detected V4L2 inputs
     for (size_t i = 0; i < input_names.size(); ++i) {
         uint32_t input_id = static_cast<uint32_t>(i);
         
         // Skip if we already have this input configured
-        if (m_input_sources.find(input_id) != m_input_sources.end()) {
+        if (table.FindInput(input_id)) {
             continue;
         }
 
@@ -899,11 +1095,11 @@ bool ChannelManager::ProbeV4L2Inputs() {
         input.display_name = input_names[i];
         input.enabled = true;
         input.auto_detect = true;
-        input.channel_number = GetNextAvailableChannelNumber();
+        input.channel_number = GetNextAvailableChannelNumber(table);
 
-        m_input_sources[input_id] = input;
-        kodi::Log(ADDON_LOG_INFO, "Added V4L2 input: %s (ID=%u, Channel=%u)",
-                  input.name.c_str(), input_id, input.channel_number);
+        table.SetInput(input);
+        Log(LogLevel::Info, "Added V4L2 input: %s (ID=%u, Channel=%u)",
+            input.name.c_str(), input_id, input.channel_number);
     }
 
     return true;
@@ -919,20 +1115,28 @@ std::string ChannelManager::GenerateInputName(InputType type, uint32_t input_id)
     return InputTypeToString(type) + " Input " + std::to_string(input_id);
 }
 
-bool ChannelManager::AssignChannelNumbers() {
+bool ChannelManager::AssignChannelNumbers(ChannelTable& table) {
     uint32_t next_channel = m_settings.base_channel_number;
+    std::set<uint32_t> assigned;
     
-    for (auto& [input_id, input_source] : m_input_sources) {
-        if (input_source.channel_number == 0 || !IsChannelNumberAvailable(input_source.channel_number)) {
+    // Inputs keep their number unless it is missing or taken by an earlier input
+    for (auto& input_source : table.inputs) {
+        if (input_source.channel_number == 0 || assigned.count(input_source.channel_number)) {
+            while (next_channel < 999 &&
+                   (assigned.count(next_channel) || !IsChannelNumberAvailable(table, next_channel))) {
+                next_channel++;
+            }
             input_source.channel_number = next_channel++;
         }
+        assigned.insert(input_source.channel_number);
     }
     
-    return UpdateInputMapping();
+    table.RebuildChannelIndex();
+    return true;
 }
 
-bool ChannelManager::IsChannelNumberAvailable(uint32_t channel_number) const {
-    for (const auto& [input_id, input_source] : m_input_sources) {
+bool ChannelManager::IsChannelNumberAvailable(const ChannelTable& table, uint32_t channel_number) const {
+    for (const auto& input_source : table.inputs) {
         if (input_source.channel_number == channel_number) {
             return false;
         }
@@ -940,15 +1144,6 @@ bool ChannelManager::IsChannelNumberAvailable(uint32_t channel_number) const {
     return true;
 }
 
-EpgEntry ChannelManager::CreateBasicEpgEntry(uint32_t channel_id, time_t start_time, time_t duration) const {
-    EpgEntry entry;
-    entry.channel_id = channel_id;
-    entry.start_time = start_time;
-    entry.end_time = start_time + duration;
-    entry.unique_id = channel_id * 10000 + (start_time % 10000);
-    return entry;
-}
-
 std::string ChannelManager::GenerateEpgTitle(const InputSource& input, const SignalStatus& status) const {
     if (status.connected && status.signal_locked) {
         if (!status.device_name.empty()) {
@@ -996,20 +1191,21 @@ std::string ChannelManager::GenerateEpgDescription(const InputSource& input, con
 }
 
 void ChannelManager::LogInputSources() const {
-    kodi::Log(ADDON_LOG_INFO, "=== Input Sources ===");
-    for (const auto& [input_id, input_source] : m_input_sources) {
-        kodi::Log(ADDON_LOG_INFO, "Input %u: %s (%s) - Channel %u - %s",
-                  input_id, input_source.name.c_str(), 
-                  InputTypeToString(input_source.type).c_str(),
-                  input_source.channel_number,
-                  input_source.enabled ? "enabled" : "disabled");
+    Log(LogLevel::Info, "=== Input Sources ===");
+    for (const auto& input_source : GetChannelTable()->inputs) {
+        Log(LogLevel::Info, "Input %u: %s (%s) - Channel %u - %s",
+            input_source.input_id, input_source.name.c_str(), 
+            InputTypeToString(input_source.type).c_str(),
+            input_source.channel_number,
+            input_source.enabled ? "enabled" : "disabled");
     }
 }
 
 void ChannelManager::LogChannelMapping() const {
-    kodi::Log(ADDON_LOG_INFO, "=== Channel Mapping ===");
-    for (const auto& [channel_id, input_id] : m_channel_to_input_map) {
-        kodi::Log(ADDON_LOG_INFO, "Channel %u -> Input %u", channel_id, input_id);
+    Log(LogLevel::Info, "=== Channel Mapping ===");
+    auto table = GetChannelTable();
+    for (const auto& [channel_number, index] : table->channels) {
+        Log(LogLevel::Info, "Channel %u -> Input %u", channel_number, table->inputs[index].input_id);
     }
 }
 
@@ -1017,7 +1213,7 @@ std::string ChannelManager::GetStatusString() const {
     std::ostringstream oss;
     oss << "ChannelManager[";
     oss << "initialized=" << (m_initialized.load() ? "true" : "false");
-    oss << ", inputs=" << m_input_sources.size();
+    oss << ", inputs=" << GetChannelTable()->inputs.size();
     oss << ", active_channel=" << m_active_channel_id.load();
     oss << ", current_input=" << m_current_input_id.load();
     oss << "]";
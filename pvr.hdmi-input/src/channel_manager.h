@@ -1,6 +1,7 @@
 #pragma once
 
 #include "types.h"
+#include "epg_cache.h"
 #include <kodi/addon-instance/PVR.h>
 #include <vector>
 #include <map>
@@ -8,6 +9,8 @@
 #include <mutex>
 #include <string>
 #include <atomic>
+#include <thread>
+#include <utility>
 
 namespace hdmi_pvr {
 
@@ -58,6 +61,45 @@ struct ChannelSettings {
     bool SaveToFile(const std::string& config_path) const;
 };
 
+// Last known signal of one channel
+struct ChannelStatusEntry {
+    uint32_t channel_number = 0;
+    SignalStatus status;
+    uint64_t version = 0;  // Bumped when the detected source or format changes
+};
+
+// Immutable snapshot of the channel line-up. Readers take a reference to the
+// published table and never wait for a writer's copy; the shared_ptr itself
+// is swapped with std::atomic_load/atomic_store, which libstdc++ implements
+// with a small pool of internal mutexes, so a read is short but not wait-free.
+// Writers copy the table, change the copy and publish that.
+// Flat vectors sorted by key keep lookups to a binary search over
+// contiguous memory.
+struct ChannelTable {
+    std::vector<InputSource> inputs;                    // Sorted by input_id
+    std::vector<std::pair<uint32_t, size_t>> channels;  // channel_number -> index into inputs, sorted
+    std::vector<ChannelStatusEntry> status;             // Sorted by channel_number
+    bool enable_epg = true;
+    uint64_t inputs_version = 0;                        // Bumped by every input change
+
+    const InputSource* FindInput(uint32_t input_id) const;
+    InputSource* FindInput(uint32_t input_id);
+    const InputSource* FindChannel(uint32_t channel_number) const;
+    const SignalStatus* FindStatus(uint32_t channel_number) const;
+    uint64_t GetStatusVersion(uint32_t channel_number) const;
+    // True if SetStatus() would bump the version or add an entry
+    bool IsStatusChange(uint32_t channel_number, const SignalStatus& status) const;
+
+    // Mutators for a private copy - call RebuildChannelIndex() after
+    // changing inputs or channel numbers, and change inputs through
+    // SetInput() so inputs_version follows
+    void SetInput(const InputSource& input);
+    bool EraseInput(uint32_t input_id);
+    void SetStatus(uint32_t channel_number, const SignalStatus& status);
+    void EraseStatus(uint32_t channel_number);
+    void RebuildChannelIndex();
+};
+
 class ChannelManager {
 public:
     explicit ChannelManager(V4L2Device* v4l2_device = nullptr);
@@ -69,6 +111,10 @@ public:
     bool IsInitialized() const { return m_initialized; }
 
     // Channel enumeration for Kodi PVR
+    // Kodi unique ids are base + channel number, so several managers can
+    // publish channels side by side
+    void SetUniqueIdBase(uint32_t base) { m_unique_id_base = base; }
+    uint32_t GetUniqueIdBase() const { return m_unique_id_base; }
     int GetChannelCount() const;
     PVR_ERROR GetChannels(kodi::addon::PVRChannelsResultSet& results);
     PVR_ERROR GetChannelInfo(uint32_t channel_id, ChannelInfo& channel_info);
@@ -78,8 +124,7 @@ public:
     bool RemoveInputSource(uint32_t input_id);
     bool UpdateInputSource(uint32_t input_id, const InputSource& input);
     std::vector<InputSource> GetInputSources() const;
-    InputSource* GetInputSource(uint32_t input_id);
-    const InputSource* GetInputSource(uint32_t input_id) const;
+    bool GetInputSource(uint32_t input_id, InputSource& input) const;
 
     // Channel operations
     bool SetActiveChannel(uint32_t channel_id);
@@ -90,8 +135,21 @@ public:
     // Input switching and detection
     bool SwitchToInput(uint32_t input_id);
     uint32_t GetCurrentInput() const { return m_current_input_id; }
+    // Probe every auto-detect input on a background thread, publishing each
+    // result as soon as it is known. While streaming the live input is left
+    // to the signal monitor and other inputs are queried without switching.
+    // Returns false if the device is unavailable or a scan is already running.
     bool DetectActiveInputs();
+    void CancelInputScan();
+    bool IsScanning() const { return m_scan_running.load(); }
+    // Mark a capture bring-up (input switch, lock wait, format setup) that
+    // has not reached STREAMON yet - the scanner treats the device as
+    // streaming and leaves its input alone until this is cleared
+    void SetCaptureStarting(bool starting) { m_capture_starting = starting; }
     std::vector<uint32_t> GetActiveInputs() const;
+    // Add the inputs an opened device reports that the configuration does
+    // not know yet. Returns true if channels were added.
+    bool ProbeInputs();
 
     // Channel settings and configuration
     bool SetChannelSettings(const ChannelSettings& settings);
@@ -109,12 +167,8 @@ public:
     SignalStatus GetChannelStatus(uint32_t channel_id) const;
     void RefreshAllChannelStatus();
 
-    // Thread-safe channel access
-    void LockChannels() const { m_channel_mutex.lock(); }
-    void UnlockChannels() const { m_channel_mutex.unlock(); }
-    std::unique_lock<std::mutex> GetChannelLock() const { 
-        return std::unique_lock<std::mutex>(m_channel_mutex); 
-    }
+    // Thread-safe channel access - the snapshot stays valid while it is held
+    std::shared_ptr<const ChannelTable> GetChannelTable() const { return std::atomic_load(&m_table); }
 
     // Channel validation and health
     bool ValidateChannelConfiguration() const;
@@ -135,26 +189,38 @@ private:
     std::atomic<bool> m_initialized{false};
     std::atomic<uint32_t> m_active_channel_id{1};
     std::atomic<uint32_t> m_current_input_id{0};
+    uint32_t m_unique_id_base{0};
 
     // Configuration
     ChannelSettings m_settings;
     std::string m_config_path;
     
-    // Channel data
-    std::map<uint32_t, InputSource> m_input_sources;
-    std::map<uint32_t, uint32_t> m_channel_to_input_map;  // channel_id -> input_id
-    std::map<uint32_t, SignalStatus> m_channel_status;
+    // Channel data, replaced as a whole by PublishTable()
+    std::shared_ptr<const ChannelTable> m_table;
+
+    // Generated guides, reused until a channel's inputs or status version changes
+    EpgCache m_epg_cache;
 
     // Thread safety
-    mutable std::mutex m_channel_mutex;
+    mutable std::mutex m_channel_mutex;  // Serializes writers of m_table
     mutable std::mutex m_settings_mutex;
+    std::mutex m_input_mutex;  // Serializes input switches of channel changes and the scanner
+
+    // Background input scan
+    static constexpr uint32_t SCAN_LOCK_TIMEOUT_MS = 500;  // Settle time after switching to a probed input
+    std::thread m_scan_thread;
+    std::mutex m_scan_mutex;  // Guards m_scan_thread
+    std::atomic<bool> m_scan_running{false};
+    std::atomic<bool> m_scan_cancel{false};
+    std::atomic<bool> m_capture_starting{false};
 
     // Internal helpers
     bool LoadDefaultConfiguration();
     bool ValidateInputSource(const InputSource& input) const;
     uint32_t GenerateChannelId(const InputSource& input) const;
-    uint32_t GetNextAvailableChannelNumber() const;
-    bool UpdateInputMapping();
+    uint32_t GetNextAvailableChannelNumber(const ChannelTable& table) const;
+    std::shared_ptr<ChannelTable> CopyTable() const;
+    void PublishTable(std::shared_ptr<ChannelTable> table);
     void ClearChannelData();
     
     // Configuration file management
@@ -162,16 +228,17 @@ private:
     bool WriteConfigurationFile(const std::string& config_path) const;
     
     // Input detection and management
-    bool ProbeV4L2Inputs();
+    bool ProbeV4L2Inputs(ChannelTable& table);
+    void InputScanThread(std::vector<std::pair<uint32_t, uint32_t>> inputs);  // (input_id, channel_number)
+    bool ProbeInputSignal(uint32_t input_id, SignalStatus& status);
     InputType DetectInputType(uint32_t v4l2_input_id) const;
     std::string GenerateInputName(InputType type, uint32_t input_id) const;
     
     // Channel number management
-    bool AssignChannelNumbers();
-    bool IsChannelNumberAvailable(uint32_t channel_number) const;
+    bool AssignChannelNumbers(ChannelTable& table);
+    bool IsChannelNumberAvailable(const ChannelTable& table, uint32_t channel_number) const;
     
     // EPG generation helpers
-    EpgEntry CreateBasicEpgEntry(uint32_t channel_id, time_t start_time, time_t duration) const;
     std::string GenerateEpgTitle(const InputSource& input, const SignalStatus& status) const;
     std::string GenerateEpgDescription(const InputSource& input, const SignalStatus& status) const;
 
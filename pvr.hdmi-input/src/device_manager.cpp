@@ -0,0 +1,243 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Device Manager Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "device_manager.h"
+#include "log.h"
+#include "metrics_exporter.h"
+#include <functional>
+#include <map>
+
+namespace hdmi_pvr {
+
+DeviceManager::DeviceManager()
+    : m_resources(std::make_shared<CaptureResources>()) {
+}
+
+DeviceManager::~DeviceManager() {
+    Shutdown();
+}
+
+bool DeviceManager::Initialize(const std::vector<std::string>& device_paths, uint32_t buffer_count,
+                               size_t memory_budget, Reactor* reactor) {
+    if (device_paths.empty()) {
+        Log(LogLevel::Error, "No capture device configured");
+        return false;
+    }
+
+    m_resources->budget.SetLimit(memory_budget);
+    m_buffer_count = buffer_count;
+
+    for (size_t i = 0; i < device_paths.size(); ++i) {
+        uint32_t index = static_cast<uint32_t>(i);
+        auto pipeline = std::make_unique<CapturePipeline>(index, device_paths[i], m_resources, reactor);
+
+        if (!pipeline->LoadChannels()) {
+            if (index == 0) {
+                return false;
+            }
+            Log(LogLevel::Warning, "Skipping capture device %s", device_paths[i].c_str());
+            continue;
+        }
+
+        m_pipelines.push_back(std::move(pipeline));
+    }
+
+    AssignGroupNames();
+
+    Log(LogLevel::Info, "%zu capture device(s) configured, frame memory budget %zu MB",
+        m_pipelines.size(), memory_budget / (1024 * 1024));
+    return true;
+}
+
+void DeviceManager::Shutdown() {
+    if (m_pipelines.empty()) {
+        return;
+    }
+
+    for (auto it = m_pipelines.rbegin(); it != m_pipelines.rend(); ++it) {
+        (*it)->Shutdown();
+    }
+    m_pipelines.clear();
+
+    const CaptureStatistics& stats = m_resources->stats;
+    Log(LogLevel::Debug, "Capture totals: %llu frames, %llu dropped, %llu duplicates",
+        static_cast<unsigned long long>(stats.frames_captured.load()),
+        static_cast<unsigned long long>(stats.frames_dropped.load()),
+        static_cast<unsigned long long>(stats.duplicate_frames.load()));
+}
+
+bool DeviceManager::Start(CapturePipeline& pipeline) {
+    if (pipeline.IsReady()) {
+        return true;
+    }
+
+    // Only the primary device gets its buffers up front - the others
+    // map them when first tuned
+    if (!pipeline.Start(pipeline.GetIndex() == 0 ? m_buffer_count : 0)) {
+        return false;
+    }
+
+    // The card name is known now
+    std::lock_guard<std::mutex> lock(m_names_mutex);
+    AssignGroupNames();
+    return true;
+}
+
+bool DeviceManager::ReplaceDevice(CapturePipeline& pipeline, const std::string& device_path) {
+    pipeline.Stop();
+    if (!pipeline.SetDevicePath(device_path)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_names_mutex);
+        AssignGroupNames();
+    }
+    return Start(pipeline);
+}
+
+CapturePipeline* DeviceManager::GetPrimary() const {
+    if (m_pipelines.empty() || m_pipelines.front()->GetIndex() != 0) {
+        return nullptr;
+    }
+    return m_pipelines.front().get();
+}
+
+CapturePipeline* DeviceManager::FindPipelineForChannel(uint32_t channel_uid) const {
+    uint32_t index = CapturePipeline::ToPipelineIndex(channel_uid);
+    for (const auto& pipeline : m_pipelines) {
+        if (pipeline->GetIndex() == index) {
+            return pipeline.get();
+        }
+    }
+    return nullptr;
+}
+
+CapturePipeline* DeviceManager::FindPipelineByGroup(const std::string& group_name) const {
+    for (const auto& pipeline : m_pipelines) {
+        if (pipeline->GetName() == group_name) {
+            return pipeline.get();
+        }
+    }
+    return nullptr;
+}
+
+void DeviceManager::Activate(const CapturePipeline* pipeline) {
+    for (const auto& other : m_pipelines) {
+        if (other.get() != pipeline) {
+            other->ReleaseIdleResources();
+        }
+    }
+}
+
+void DeviceManager::RecordTelemetry() {
+    for (const auto& pipeline : m_pipelines) {
+        pipeline->RecordTelemetry();
+    }
+}
+
+void DeviceManager::AppendMetrics(std::string& out) const {
+    const CaptureStatistics& stats = m_resources->stats;
+    struct Total {
+        const char* name;
+        const char* type;
+        const char* help;
+        uint64_t value;
+    };
+    const Total totals[] = {
+        {"hdmi_pvr_frames_captured_total", "counter", "Frames captured by all devices", stats.frames_captured.load()},
+        {"hdmi_pvr_frames_dropped_total", "counter", "Frames lost to buffer pressure", stats.frames_dropped.load()},
+        {"hdmi_pvr_duplicate_frames_total", "counter", "Repeated frames not sent downstream", stats.duplicate_frames.load()},
+        {"hdmi_pvr_captured_bytes_total", "counter", "Bytes of captured frames", stats.bytes_captured.load()},
+        {"hdmi_pvr_copied_bytes_total", "counter", "Bytes copied out of driver buffers", stats.bytes_copied.load()},
+        {"hdmi_pvr_frame_memory_bytes", "gauge", "Frame memory held by all devices", m_resources->budget.GetUsed()},
+        {"hdmi_pvr_frame_memory_limit_bytes", "gauge", "Frame memory budget, 0 for none", m_resources->budget.GetLimit()},
+    };
+    for (const Total& total : totals) {
+        MetricsExporter::AppendFamily(out, total.name, total.type, total.help);
+        MetricsExporter::AppendSample(out, total.name, "", total.value);
+    }
+
+    // Snapshot each device once, so all families describe the same moment
+    struct DeviceSample {
+        std::string labels;
+        bool ready;
+        const StreamProcessor* processor;
+        SignalStatus signal;
+        uint32_t poll_interval_ms;
+        RawCaptureStats raw;
+    };
+    std::vector<DeviceSample> devices;
+    for (const auto& pipeline : m_pipelines) {
+        DeviceSample sample;
+        sample.labels = "device=\"" + std::to_string(pipeline->GetIndex()) +
+                        "\",path=" + MetricsExporter::EscapeLabel(pipeline->GetDevicePath());
+        sample.ready = pipeline->IsReady();
+        sample.processor = &pipeline->GetStreamProcessor();
+        sample.signal = pipeline->GetSignalMonitor().GetSignalStatus();
+        sample.poll_interval_ms = pipeline->GetSignalMonitor().GetPollInterval();
+        sample.raw = sample.processor->GetRawCaptureStats();
+        devices.push_back(std::move(sample));
+    }
+
+    struct Family {
+        const char* name;
+        const char* type;
+        const char* help;
+        std::function<double(const DeviceSample&)> value;
+    };
+    const Family families[] = {
+        {"hdmi_pvr_device_ready", "gauge", "Device opened and started",
+         [](const DeviceSample& d) { return d.ready ? 1.0 : 0.0; }},
+        {"hdmi_pvr_device_streaming", "gauge", "Device capturing",
+         [](const DeviceSample& d) { return d.processor->IsStreaming() ? 1.0 : 0.0; }},
+        {"hdmi_pvr_device_standby", "gauge", "Capture kept warm without a viewer",
+         [](const DeviceSample& d) { return d.processor->IsInStandby() ? 1.0 : 0.0; }},
+        {"hdmi_pvr_device_frames_processed_total", "counter", "Frames processed in the current stream",
+         [](const DeviceSample& d) { return static_cast<double>(d.processor->GetFramesProcessed()); }},
+        {"hdmi_pvr_device_frames_dropped_total", "counter", "Frames dropped in the current stream",
+         [](const DeviceSample& d) { return static_cast<double>(d.processor->GetDroppedFrames()); }},
+        {"hdmi_pvr_device_duplicate_frames_total", "counter", "Repeated frames skipped in the current stream",
+         [](const DeviceSample& d) { return static_cast<double>(d.processor->GetDuplicateFrameCount()); }},
+        {"hdmi_pvr_device_stream_bits_per_second", "gauge", "Average bitrate of the current stream",
+         [](const DeviceSample& d) { return static_cast<double>(d.processor->GetStreamBitrate()); }},
+        {"hdmi_pvr_signal_connected", "gauge", "HDMI source connected",
+         [](const DeviceSample& d) { return d.signal.connected ? 1.0 : 0.0; }},
+        {"hdmi_pvr_signal_locked", "gauge", "HDMI signal locked",
+         [](const DeviceSample& d) { return d.signal.signal_locked ? 1.0 : 0.0; }},
+        {"hdmi_pvr_signal_strength_percent", "gauge", "Averaged signal strength",
+         [](const DeviceSample& d) { return static_cast<double>(d.signal.signal_strength); }},
+        {"hdmi_pvr_signal_quality_percent", "gauge", "Averaged signal quality",
+         [](const DeviceSample& d) { return static_cast<double>(d.signal.signal_quality); }},
+        {"hdmi_pvr_signal_frame_rate", "gauge", "Frame rate of the source, 0 without signal",
+         [](const DeviceSample& d) { return d.signal.video_format.frame_rate.to_double(); }},
+        {"hdmi_pvr_signal_poll_interval_seconds", "gauge", "Current signal poll interval",
+         [](const DeviceSample& d) { return d.poll_interval_ms / 1000.0; }},
+        {"hdmi_pvr_raw_capture_frames_total", "counter", "Frames written to the raw capture",
+         [](const DeviceSample& d) { return static_cast<double>(d.raw.frames_recorded); }},
+        {"hdmi_pvr_raw_capture_dropped_total", "counter", "Frames the raw capture skipped",
+         [](const DeviceSample& d) { return static_cast<double>(d.raw.frames_dropped); }},
+    };
+    for (const Family& family : families) {
+        MetricsExporter::AppendFamily(out, family.name, family.type, family.help);
+        for (const DeviceSample& device : devices) {
+            MetricsExporter::AppendSample(out, family.name, device.labels, family.value(device));
+        }
+    }
+}
+
+void DeviceManager::AssignGroupNames() {
+    std::map<std::string, int> seen;
+    for (const auto& pipeline : m_pipelines) {
+        std::string name = pipeline->GetCardName();
+        int count = ++seen[name];
+        pipeline->SetName(count > 1 ? name + " (" + std::to_string(count) + ")" : name);
+    }
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,117 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "capture_pipeline.h"
+#include "capture_resources.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hdmi_pvr {
+
+/**
+ * DeviceManager owns one CapturePipeline per configured capture device.
+ *
+ * All pipelines share one memory budget and one set of statistics. Only the
+ * pipelines that are capturing hold frame memory: Activate() returns the
+ * pools and V4L2 buffers of every idle device, so adding inputs costs
+ * little more than their open file descriptors.
+ *
+ * Initialize() only loads the channel configuration of each device; the
+ * hardware is brought up per pipeline by Start().
+ *
+ * The pipeline list is fixed between Initialize() and Shutdown(), so lookups
+ * need no locking.
+ */
+class DeviceManager {
+public:
+    DeviceManager();
+    ~DeviceManager();
+
+    /**
+     * Create a pipeline per device and load its channels, without opening
+     * any hardware
+     * @param device_paths V4L2 device nodes, the first one is the primary device
+     * @param buffer_count V4L2 buffers to map on start of the primary device
+     * @param memory_budget Total frame pool bytes of all devices, 0 for no limit
+     * @param reactor Event loop serving the devices, nullptr for a capture thread each
+     * @return false if the primary device's channels cannot be loaded -
+     *         secondary devices that fail are skipped and keep their index free
+     */
+    bool Initialize(const std::vector<std::string>& device_paths, uint32_t buffer_count,
+                    size_t memory_budget, Reactor* reactor = nullptr);
+    void Shutdown();
+
+    /**
+     * Bring up the hardware of a pipeline if it is not running yet
+     * @param pipeline Pipeline to start
+     * @return false if the device cannot be used at the moment
+     */
+    bool Start(CapturePipeline& pipeline);
+
+    /**
+     * Move a pipeline to another device node, keeping its channels
+     * @param pipeline Pipeline to move
+     * @param device_path New V4L2 device node
+     * @return false if the new device cannot be started - the pipeline stays
+     *         stopped and is retried when tuned
+     */
+    bool ReplaceDevice(CapturePipeline& pipeline, const std::string& device_path);
+
+    const std::vector<std::unique_ptr<CapturePipeline>>& GetPipelines() const { return m_pipelines; }
+    CapturePipeline* GetPrimary() const;
+
+    /**
+     * Pipeline publishing a Kodi channel
+     * @param channel_uid Kodi channel unique id
+     * @return nullptr if no device owns the channel
+     */
+    CapturePipeline* FindPipelineForChannel(uint32_t channel_uid) const;
+
+    /**
+     * Pipeline behind a channel group
+     * @param group_name Name from CapturePipeline::GetName()
+     * @return nullptr if unknown
+     */
+    CapturePipeline* FindPipelineByGroup(const std::string& group_name) const;
+
+    /**
+     * Prepare a pipeline for streaming by releasing what idle pipelines hold
+     * @param pipeline Pipeline about to stream
+     */
+    void Activate(const CapturePipeline* pipeline);
+
+    /**
+     * Record a second of telemetry for every device
+     */
+    void RecordTelemetry();
+
+    /**
+     * Append the shared capture counters and each device's stream and
+     * signal state as Prometheus text, labelled with the device index and path
+     */
+    void AppendMetrics(std::string& out) const;
+
+    void SetMemoryBudget(size_t bytes) { m_resources->budget.SetLimit(bytes); }
+    const CaptureResources& GetResources() const { return *m_resources; }
+
+private:
+    std::shared_ptr<CaptureResources> m_resources;
+    std::vector<std::unique_ptr<CapturePipeline>> m_pipelines;
+    uint32_t m_buffer_count = 0;
+    std::mutex m_names_mutex;  ///< Pipelines starting concurrently rename their groups
+
+    /**
+     * Make group names unique when several devices report the same card
+     */
+    void AssignGroupNames();
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,90 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  EPG Cache Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "epg_cache.h"
+
+namespace hdmi_pvr {
+
+std::vector<EpgEntry> EpgCache::GetEntries(uint32_t channel_id, uint64_t inputs_version, uint64_t status_version,
+                                           time_t start_time, time_t end_time, const DescribeFunc& describe) {
+    std::vector<EpgEntry> entries;
+    if (end_time <= start_time) {
+        return entries;
+    }
+
+    time_t first_slot = start_time - start_time % SLOT_SECONDS;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ChannelEpg& epg = m_channels[channel_id];
+
+    if (!epg.described || epg.inputs_version != inputs_version || epg.status_version != status_version) {
+        describe(epg.title, epg.plot);
+        epg.described = true;
+        epg.inputs_version = inputs_version;
+        epg.status_version = status_version;
+        epg.slots.clear();
+    }
+
+    // Start over if the cached hours do not touch the requested ones
+    if (!epg.slots.empty() &&
+        (first_slot > epg.slots.back().end_time || end_time < epg.slots.front().start_time)) {
+        epg.slots.clear();
+    }
+
+    // Extend the cached range to cover the window
+    if (epg.slots.empty()) {
+        epg.slots.push_back(MakeSlot(channel_id, epg, first_slot));
+    }
+    while (epg.slots.front().start_time > first_slot) {
+        epg.slots.push_front(MakeSlot(channel_id, epg, epg.slots.front().start_time - SLOT_SECONDS));
+    }
+    while (epg.slots.back().end_time < end_time) {
+        epg.slots.push_back(MakeSlot(channel_id, epg, epg.slots.back().end_time));
+    }
+
+    // Keep memory bounded by dropping hours outside the window, oldest first
+    while (epg.slots.size() > MAX_SLOTS) {
+        if (epg.slots.front().end_time <= start_time) {
+            epg.slots.pop_front();
+        } else if (epg.slots.back().start_time >= end_time) {
+            epg.slots.pop_back();
+        } else {
+            break;
+        }
+    }
+
+    for (const auto& slot : epg.slots) {
+        if (slot.end_time > start_time && slot.start_time < end_time) {
+            entries.push_back(slot);
+        }
+    }
+
+    return entries;
+}
+
+void EpgCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_channels.clear();
+}
+
+EpgEntry EpgCache::MakeSlot(uint32_t channel_id, const ChannelEpg& epg, time_t slot_start) {
+    EpgEntry entry;
+    entry.channel_id = channel_id;
+    entry.start_time = slot_start;
+    entry.end_time = slot_start + SLOT_SECONDS;
+
+    // Derived from the hour alone, so Kodi sees a refreshed entry rather
+    // than a new one when the description changes
+    entry.unique_id = channel_id * 10000 + static_cast<uint32_t>((slot_start / SLOT_SECONDS) % 10000);
+    entry.broadcast_id = entry.unique_id;
+    entry.title = epg.title;
+    entry.plot = epg.plot;
+    return entry;
+}
+
+} // namespace hdmi_pvr
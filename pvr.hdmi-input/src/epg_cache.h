@@ -0,0 +1,76 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "types.h"
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hdmi_pvr {
+
+/**
+ * EpgCache keeps the generated guide of each channel between Kodi requests.
+ *
+ * Entries are hour slots aligned to the clock, so consecutive requests share
+ * them and a window moving forward in time only appends the new hours. The
+ * title and description are formatted once per (inputs version, status
+ * version) of a channel and reused for every slot until the detected source
+ * or format changes.
+ *
+ * Thread-safe.
+ */
+class EpgCache {
+public:
+    static constexpr time_t SLOT_SECONDS = 3600;        ///< One guide entry per hour
+    static constexpr size_t MAX_SLOTS = 14 * 24;        ///< Cached hours per channel
+
+    /**
+     * Formats the title and description of a channel's entries
+     */
+    using DescribeFunc = std::function<void(std::string& title, std::string& plot)>;
+
+    /**
+     * Guide entries of a channel overlapping [start_time, end_time)
+     * @param channel_id Channel number
+     * @param inputs_version ChannelTable::inputs_version the request was served from
+     * @param status_version Status version of the channel in that table
+     * @param start_time Window start
+     * @param end_time Window end
+     * @param describe Called only when the versions differ from the cached ones
+     * @return Slot aligned entries, the first and last may reach outside the window
+     */
+    std::vector<EpgEntry> GetEntries(uint32_t channel_id, uint64_t inputs_version, uint64_t status_version,
+                                     time_t start_time, time_t end_time, const DescribeFunc& describe);
+
+    /**
+     * Drop all cached guides (channel table replaced)
+     */
+    void Clear();
+
+private:
+    struct ChannelEpg {
+        bool described = false;
+        uint64_t inputs_version = 0;
+        uint64_t status_version = 0;
+        std::string title;
+        std::string plot;
+        std::deque<EpgEntry> slots;  ///< Consecutive hours, oldest first
+    };
+
+    mutable std::mutex m_mutex;
+    std::map<uint32_t, ChannelEpg> m_channels;
+
+    static EpgEntry MakeSlot(uint32_t channel_id, const ChannelEpg& epg, time_t slot_start);
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,123 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Capture Format Negotiation Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "format_negotiator.h"
+#include "log.h"
+#include <linux/videodev2.h>
+#include <algorithm>
+
+namespace hdmi_pvr {
+
+namespace {
+
+struct FormatCost {
+    uint32_t fourcc;
+    uint32_t bits_per_pixel;
+    uint32_t conversion_cost;  ///< Percent added on top of the raw bytes
+};
+
+// Ordered by preference when scores tie. Planar 4:2:0 is what the renderer
+// uploads directly; packed 4:2:2 needs a repack and chroma decimation; RGB
+// needs a full colour space conversion. Only layouts FrameConverter can
+// repack for the player are listed.
+constexpr FormatCost FORMAT_COSTS[] = {
+    {V4L2_PIX_FMT_NV12, 12, 0},
+    {V4L2_PIX_FMT_YUV420, 12, 0},
+    {V4L2_PIX_FMT_NV21, 12, 5},
+    {V4L2_PIX_FMT_YUYV, 16, 25},
+    {V4L2_PIX_FMT_UYVY, 16, 25},
+    {V4L2_PIX_FMT_RGB24, 24, 75},
+    {V4L2_PIX_FMT_BGR24, 24, 75},
+};
+
+const FormatCost* FindCost(uint32_t fourcc) {
+    for (const auto& cost : FORMAT_COSTS) {
+        if (cost.fourcc == fourcc) {
+            return &cost;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+FormatNegotiator::FormatNegotiator()
+    : m_accepted(GetRawFormats()) {
+}
+
+std::vector<uint32_t> FormatNegotiator::GetRawFormats() {
+    std::vector<uint32_t> formats;
+    for (const auto& cost : FORMAT_COSTS) {
+        formats.push_back(cost.fourcc);
+    }
+    return formats;
+}
+
+bool FormatNegotiator::Evaluate(uint32_t fourcc, const VideoFormat& format, FormatCandidate& candidate) {
+    const FormatCost* cost = FindCost(fourcc);
+    if (!cost) {
+        return false;
+    }
+
+    candidate.fourcc = fourcc;
+    candidate.bits_per_pixel = cost->bits_per_pixel;
+    candidate.conversion_cost = cost->conversion_cost;
+    candidate.bytes_per_frame = static_cast<uint64_t>(format.width) * format.height * cost->bits_per_pixel / 8;
+    candidate.score = candidate.bytes_per_frame * (100 + cost->conversion_cost) / 100;
+    return true;
+}
+
+bool FormatNegotiator::Negotiate(const std::vector<uint32_t>& supported, const VideoFormat& format,
+                                 FormatCandidate& choice) const {
+    bool found = false;
+
+    for (uint32_t fourcc : m_accepted) {
+        if (std::find(supported.begin(), supported.end(), fourcc) == supported.end()) {
+            continue;
+        }
+
+        FormatCandidate candidate;
+        if (!Evaluate(fourcc, format, candidate)) {
+            continue;
+        }
+
+        Log(LogLevel::Debug, "Format candidate %s: %u bpp, conversion +%u%%, score %llu",
+            FourCCToString(fourcc).c_str(), candidate.bits_per_pixel, candidate.conversion_cost,
+            static_cast<unsigned long long>(candidate.score));
+
+        if (!found || candidate.score < choice.score) {
+            choice = candidate;  // Ties keep the earlier, preferred format
+            found = true;
+        }
+    }
+
+    if (!found) {
+        Log(LogLevel::Warning, "No device format accepted by the stream pipeline");
+        return false;
+    }
+
+    // Show what the choice saves over the format drivers fall back to
+    FormatCandidate yuyv;
+    Evaluate(V4L2_PIX_FMT_YUYV, format, yuyv);
+    Log(LogLevel::Info, "Capture format %s selected for %s: %.2f MB/frame, %.1f MB/s (YUYV: %.1f MB/s)",
+        FourCCToString(choice.fourcc).c_str(), format.to_string().c_str(),
+        choice.bytes_per_frame / 1e6, choice.bandwidth(format.frame_rate) / 1e6,
+        yuyv.bandwidth(format.frame_rate) / 1e6);
+    return true;
+}
+
+std::string FormatNegotiator::FourCCToString(uint32_t fourcc) {
+    std::string name(4, ' ');
+    for (size_t i = 0; i < 4; ++i) {
+        char c = static_cast<char>((fourcc >> (i * 8)) & 0xff);
+        name[i] = (c >= 0x20 && c < 0x7f) ? c : '?';
+    }
+    return name;
+}
+
+} // namespace hdmi_pvr
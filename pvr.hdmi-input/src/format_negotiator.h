@@ -0,0 +1,93 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hdmi_pvr {
+
+/**
+ * Cost estimate of capturing in one pixel format
+ */
+struct FormatCandidate {
+    uint32_t fourcc = 0;
+    uint32_t bits_per_pixel = 0;    ///< Average bits per pixel including chroma
+    uint32_t conversion_cost = 0;   ///< Downstream conversion penalty in percent
+    uint64_t bytes_per_frame = 0;
+    uint64_t score = 0;             ///< Bytes per frame weighted by conversion cost, lower is better
+
+    /**
+     * Expected capture bandwidth
+     * @param rate Frame rate
+     * @return Bytes per second
+     */
+    uint64_t bandwidth(const FrameRate& rate) const {
+        return rate.is_valid() ? bytes_per_frame * rate.num / rate.den : 0;
+    }
+};
+
+/**
+ * FormatNegotiator picks the capture pixel format for a stream.
+ *
+ * Every format offered by the device and accepted by the consumer chain is
+ * ranked by the bytes it moves per frame, weighted by the work needed to turn
+ * it into what the renderer consumes natively (planar 4:2:0). On this SoC the
+ * capture DMA and every copy behind it are memory bound, so NV12 at 12 bpp
+ * beats YUYV at 16 bpp, and RGB24 at 24 bpp plus a colour space conversion
+ * comes last.
+ */
+class FormatNegotiator {
+public:
+    FormatNegotiator();
+
+    /**
+     * Restrict the formats the consumer chain can handle
+     * @param formats Accepted V4L2 pixel formats, in order of preference for ties
+     */
+    void SetAcceptedFormats(const std::vector<uint32_t>& formats) { m_accepted = formats; }
+    const std::vector<uint32_t>& GetAcceptedFormats() const { return m_accepted; }
+
+    /**
+     * Pick the cheapest format
+     * @param supported Pixel formats offered by the device
+     * @param format Input resolution and frame rate
+     * @param choice Selected format and its cost
+     * @return false if no supported format is accepted
+     */
+    bool Negotiate(const std::vector<uint32_t>& supported, const VideoFormat& format,
+                   FormatCandidate& choice) const;
+
+    /**
+     * Estimate the cost of one format
+     * @param fourcc V4L2 pixel format
+     * @param format Input resolution
+     * @param candidate Filled cost estimate
+     * @return false if the format layout is unknown
+     */
+    static bool Evaluate(uint32_t fourcc, const VideoFormat& format, FormatCandidate& candidate);
+
+    /**
+     * Raw formats the stream pipeline knows how to describe
+     */
+    static std::vector<uint32_t> GetRawFormats();
+
+    /**
+     * Printable name of a pixel format
+     * @param fourcc V4L2 pixel format
+     * @return Four character code, e.g. "NV12"
+     */
+    static std::string FourCCToString(uint32_t fourcc);
+
+private:
+    std::vector<uint32_t> m_accepted;
+};
+
+} // namespace hdmi_pvr
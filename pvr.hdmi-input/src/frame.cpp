@@ -0,0 +1,115 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Shared Frame Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "frame.h"
+#include "log.h"
+#include <new>
+
+namespace hdmi_pvr {
+
+//
+// Frame implementation
+//
+
+Frame::Frame(std::shared_ptr<PoolState> pool, size_t capacity)
+    : m_pool(std::move(pool)) {
+    Reserve(capacity);
+}
+
+bool Frame::Reserve(size_t capacity) {
+    if (capacity <= m_capacity) {
+        return true;
+    }
+
+    std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[capacity]);
+    if (!data) {
+        Log(LogLevel::Error, "Failed to allocate frame of size %zu", capacity);
+        return false;
+    }
+
+    m_data = std::move(data);
+    m_capacity = capacity;
+    m_size = 0;
+    return true;
+}
+
+void Frame::Release() {
+    if (m_refcount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    // Last reference - hold the pool state so its mutex survives a delete
+    std::shared_ptr<PoolState> pool = m_pool;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    if (pool->retired) {
+        lock.unlock();
+        delete this;
+        return;
+    }
+
+    m_size = 0;
+    timestamp = 0;
+    duration.store(0);
+    sequence = 0;
+    pool->idle.push_back(this);
+}
+
+//
+// FramePool implementation
+//
+
+FramePool::FramePool(size_t frame_count, size_t frame_size)
+    : m_state(std::make_shared<Frame::PoolState>())
+    , m_frame_size(frame_size) {
+    m_state->idle.reserve(frame_count);
+
+    for (size_t i = 0; i < frame_count; ++i) {
+        auto* frame = new (std::nothrow) Frame(m_state, frame_size);
+        if (!frame || !frame->Data()) {
+            delete frame;
+            break;
+        }
+        m_state->idle.push_back(frame);
+    }
+    m_total_frames = m_state->idle.size();
+
+    Log(LogLevel::Debug, "FramePool initialized with %zu frames of size %zu",
+        m_total_frames, frame_size);
+}
+
+FramePool::~FramePool() {
+    std::vector<Frame*> idle;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->retired = true;
+        idle.swap(m_state->idle);
+    }
+
+    for (Frame* frame : idle) {
+        delete frame;
+    }
+}
+
+FrameRef FramePool::Acquire() {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    if (m_state->idle.empty()) {
+        return FrameRef();
+    }
+
+    Frame* frame = m_state->idle.back();
+    m_state->idle.pop_back();
+    frame->m_refcount.store(1, std::memory_order_relaxed);
+    return FrameRef(frame);
+}
+
+size_t FramePool::GetUsedFrames() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_total_frames - m_state->idle.size();
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,192 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <utility>
+
+namespace hdmi_pvr {
+
+class FramePool;
+class FrameRef;
+
+/**
+ * Frame is one captured video frame shared by every consumer of the
+ * pipeline (live read, demux, timeshift, recording, ...).
+ *
+ * Frames are reference counted intrusively and are only handled through
+ * FrameRef. When the last reference is dropped the frame goes back to the
+ * pool it came from, so a frame fanned out to N consumers costs a single
+ * capture copy and no allocation.
+ */
+class Frame {
+public:
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+
+    uint8_t* Data() { return m_data.get(); }
+    const uint8_t* Data() const { return m_data.get(); }
+    size_t Size() const { return m_size; }
+    size_t Capacity() const { return m_capacity; }
+
+    /**
+     * Set the number of valid bytes
+     * @param size Payload size, must not exceed Capacity()
+     */
+    void SetSize(size_t size) { m_size = size; }
+
+    /**
+     * Grow the frame storage, discarding its contents
+     * @param capacity Required capacity in bytes
+     * @return true if the frame can hold capacity bytes
+     */
+    bool Reserve(size_t capacity);
+
+    uint64_t timestamp = 0;   ///< Capture time in microseconds
+    std::atomic<uint64_t> duration{0};  ///< Display duration in microseconds, 0 = unknown (extended for repeats)
+    uint64_t sequence = 0;    ///< Capture sequence number
+    uint64_t device_timestamp = 0;  ///< Driver timestamp in microseconds (CLOCK_MONOTONIC), 0 = unknown
+    uint64_t device_sequence = 0;   ///< Driver sequence number, gaps are frames the driver lost
+    uint32_t layout = 0;      ///< Layout id of the stream processor at capture time
+
+private:
+    friend class FramePool;
+    friend class FrameRef;
+
+    struct PoolState;
+
+    explicit Frame(std::shared_ptr<PoolState> pool, size_t capacity);
+    ~Frame() = default;
+
+    void AddRef() { m_refcount.fetch_add(1, std::memory_order_relaxed); }
+    void Release();
+
+    std::unique_ptr<uint8_t[]> m_data;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+    std::atomic<uint32_t> m_refcount{0};
+    std::shared_ptr<PoolState> m_pool;  ///< Outlives the FramePool while frames are in flight
+};
+
+/**
+ * Owning handle to a shared Frame. Copying adds a reference, destruction
+ * drops one.
+ */
+class FrameRef {
+public:
+    FrameRef() = default;
+    ~FrameRef() { Reset(); }
+
+    FrameRef(const FrameRef& other) : m_frame(other.m_frame) {
+        if (m_frame) {
+            m_frame->AddRef();
+        }
+    }
+
+    FrameRef(FrameRef&& other) noexcept : m_frame(std::exchange(other.m_frame, nullptr)) {}
+
+    FrameRef& operator=(const FrameRef& other) {
+        if (this != &other) {
+            FrameRef(other).Swap(*this);
+        }
+        return *this;
+    }
+
+    FrameRef& operator=(FrameRef&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            m_frame = std::exchange(other.m_frame, nullptr);
+        }
+        return *this;
+    }
+
+    void Reset() {
+        if (m_frame) {
+            std::exchange(m_frame, nullptr)->Release();
+        }
+    }
+
+    void Swap(FrameRef& other) noexcept { std::swap(m_frame, other.m_frame); }
+
+    Frame* Get() const { return m_frame; }
+    Frame* operator->() const { return m_frame; }
+    Frame& operator*() const { return *m_frame; }
+    explicit operator bool() const { return m_frame != nullptr; }
+
+    /**
+     * Number of handles currently sharing the frame
+     * @return Reference count, 0 for an empty handle
+     */
+    uint32_t UseCount() const { return m_frame ? m_frame->m_refcount.load() : 0; }
+
+private:
+    friend class FramePool;
+
+    /**
+     * Adopt a frame whose reference count has already been set
+     */
+    explicit FrameRef(Frame* frame) : m_frame(frame) {}
+
+    Frame* m_frame = nullptr;
+};
+
+/**
+ * Fixed-size pool of frames. Acquire() never allocates; when every frame is
+ * referenced it returns an empty handle and the caller drops the capture.
+ *
+ * The pool may be destroyed while consumers still hold frames, those frames
+ * are freed when their last reference goes away.
+ */
+class FramePool {
+public:
+    /**
+     * Constructor
+     * @param frame_count Number of frames to allocate
+     * @param frame_size Capacity of each frame in bytes
+     */
+    FramePool(size_t frame_count, size_t frame_size);
+
+    /**
+     * Destructor - frees idle frames and orphans those still referenced
+     */
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * Take an idle frame from the pool
+     * @return Handle holding the only reference, empty if the pool is exhausted
+     */
+    FrameRef Acquire();
+
+    size_t GetTotalFrames() const { return m_total_frames; }
+    size_t GetUsedFrames() const;
+    size_t GetFrameSize() const { return m_frame_size; }
+
+private:
+    std::shared_ptr<Frame::PoolState> m_state;
+    size_t m_total_frames = 0;
+    size_t m_frame_size = 0;
+};
+
+/**
+ * Shared bookkeeping between a pool and its frames
+ */
+struct Frame::PoolState {
+    std::mutex mutex;
+    std::vector<Frame*> idle;
+    bool retired = false;  ///< Pool destroyed - free frames on last release
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,212 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Frame Conversion Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "frame_converter.h"
+#include <linux/videodev2.h>
+#include <algorithm>
+
+namespace hdmi_pvr {
+
+namespace {
+
+// Chroma of a 4:2:0 frame, one sample per 2x2 block
+struct ChromaPlanes {
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+    uint32_t pixel_stride = 1;  ///< Bytes between horizontally adjacent samples
+    uint32_t bytes_per_line = 0;
+};
+
+// Byte layout of a packed 4:2:2 or RGB pixel
+struct PackedLayout {
+    uint32_t pixel_stride = 0;  ///< Bytes per pixel
+    uint32_t first = 0;         ///< Offset of Y (4:2:2) or red (RGB)
+    uint32_t second = 0;        ///< Offset of U (4:2:2), unused for RGB
+    uint32_t third = 0;         ///< Offset of V (4:2:2) or blue (RGB)
+};
+
+inline uint32_t Half(uint32_t value) {
+    return (value + 1) / 2;
+}
+
+inline uint8_t* PutBlock(uint8_t* out, uint8_t u, uint8_t v, uint8_t y00, uint8_t y01, uint8_t y10, uint8_t y11) {
+    out[0] = u ^ 0x80;
+    out[1] = v ^ 0x80;
+    out[2] = y00;
+    out[3] = y01;
+    out[4] = y10;
+    out[5] = y11;
+    return out + 6;
+}
+
+// BT.709 limited range in 8.8 fixed point, the matrix Kodi assumes for HD
+inline uint8_t RgbToY(uint32_t r, uint32_t g, uint32_t b) {
+    return static_cast<uint8_t>(16 + ((47 * r + 157 * g + 16 * b + 128) >> 8));
+}
+
+inline uint8_t RgbToU(uint32_t r, uint32_t g, uint32_t b) {
+    return static_cast<uint8_t>((32896 - 26 * r - 87 * g + 112 * b) >> 8);
+}
+
+inline uint8_t RgbToV(uint32_t r, uint32_t g, uint32_t b) {
+    return static_cast<uint8_t>((32896 + 112 * r - 102 * g - 10 * b) >> 8);
+}
+
+void ConvertPlanar(const uint8_t* luma, uint32_t bytes_per_line, const ChromaPlanes& chroma,
+                   uint32_t width, uint32_t height, uint8_t* dest) {
+    for (uint32_t by = 0; by < Half(height); ++by) {
+        const uint8_t* row0 = luma + static_cast<size_t>(2 * by) * bytes_per_line;
+        const uint8_t* row1 = luma + static_cast<size_t>(std::min(2 * by + 1, height - 1)) * bytes_per_line;
+        const uint8_t* u = chroma.u + static_cast<size_t>(by) * chroma.bytes_per_line;
+        const uint8_t* v = chroma.v + static_cast<size_t>(by) * chroma.bytes_per_line;
+        for (uint32_t bx = 0; bx < Half(width); ++bx) {
+            uint32_t x0 = 2 * bx;
+            uint32_t x1 = std::min(x0 + 1, width - 1);
+            dest = PutBlock(dest, u[bx * chroma.pixel_stride], v[bx * chroma.pixel_stride],
+                            row0[x0], row0[x1], row1[x0], row1[x1]);
+        }
+    }
+}
+
+// 4:2:2 to 4:2:0 averages the chroma of both rows of a block
+void ConvertPacked422(const uint8_t* data, uint32_t bytes_per_line, const PackedLayout& layout,
+                      uint32_t width, uint32_t height, uint8_t* dest) {
+    for (uint32_t by = 0; by < Half(height); ++by) {
+        const uint8_t* row0 = data + static_cast<size_t>(2 * by) * bytes_per_line;
+        const uint8_t* row1 = data + static_cast<size_t>(std::min(2 * by + 1, height - 1)) * bytes_per_line;
+        for (uint32_t bx = 0; bx < Half(width); ++bx) {
+            uint32_t x0 = 2 * bx;
+            uint32_t x1 = std::min(x0 + 1, width - 1);
+            const uint8_t* pair0 = row0 + bx * 2 * layout.pixel_stride;
+            const uint8_t* pair1 = row1 + bx * 2 * layout.pixel_stride;
+            uint8_t u = static_cast<uint8_t>((pair0[layout.second] + pair1[layout.second] + 1) >> 1);
+            uint8_t v = static_cast<uint8_t>((pair0[layout.third] + pair1[layout.third] + 1) >> 1);
+            dest = PutBlock(dest, u, v,
+                            row0[x0 * layout.pixel_stride + layout.first],
+                            row0[x1 * layout.pixel_stride + layout.first],
+                            row1[x0 * layout.pixel_stride + layout.first],
+                            row1[x1 * layout.pixel_stride + layout.first]);
+        }
+    }
+}
+
+void ConvertRgb(const uint8_t* data, uint32_t bytes_per_line, const PackedLayout& layout,
+                uint32_t width, uint32_t height, uint8_t* dest) {
+    for (uint32_t by = 0; by < Half(height); ++by) {
+        const uint8_t* rows[2] = {
+            data + static_cast<size_t>(2 * by) * bytes_per_line,
+            data + static_cast<size_t>(std::min(2 * by + 1, height - 1)) * bytes_per_line,
+        };
+        for (uint32_t bx = 0; bx < Half(width); ++bx) {
+            uint32_t xs[2] = {2 * bx, std::min(2 * bx + 1, width - 1)};
+            uint8_t y[4];
+            uint32_t r = 0;
+            uint32_t g = 0;
+            uint32_t b = 0;
+            for (int i = 0; i < 4; ++i) {
+                const uint8_t* pixel = rows[i / 2] + xs[i % 2] * layout.pixel_stride;
+                uint32_t pr = pixel[layout.first];
+                uint32_t pg = pixel[1];
+                uint32_t pb = pixel[layout.third];
+                y[i] = RgbToY(pr, pg, pb);
+                r += pr;
+                g += pg;
+                b += pb;
+            }
+            r = (r + 2) / 4;
+            g = (g + 2) / 4;
+            b = (b + 2) / 4;
+            dest = PutBlock(dest, RgbToU(r, g, b), RgbToV(r, g, b), y[0], y[1], y[2], y[3]);
+        }
+    }
+}
+
+} // namespace
+
+bool FrameConverter::SupportsFormat(uint32_t fourcc) {
+    switch (fourcc) {
+        case V4L2_PIX_FMT_NV12:
+        case V4L2_PIX_FMT_NV21:
+        case V4L2_PIX_FMT_YUV420:
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_UYVY:
+        case V4L2_PIX_FMT_RGB24:
+        case V4L2_PIX_FMT_BGR24:
+            return true;
+        default:
+            return false;
+    }
+}
+
+size_t FrameConverter::GetSourceSize(const FrameGeometry& geometry) {
+    if (geometry.width == 0 || geometry.height == 0) {
+        return 0;
+    }
+
+    size_t bytes_per_line = geometry.bytes_per_line;
+    size_t luma = bytes_per_line * geometry.height;
+    switch (geometry.fourcc) {
+        case V4L2_PIX_FMT_NV12:
+        case V4L2_PIX_FMT_NV21:
+            return bytes_per_line >= Half(geometry.width) * 2 ? luma + bytes_per_line * Half(geometry.height) : 0;
+        case V4L2_PIX_FMT_YUV420:
+            return bytes_per_line / 2 >= Half(geometry.width)
+                   ? luma + 2 * (bytes_per_line / 2) * Half(geometry.height) : 0;
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_UYVY:
+            return bytes_per_line >= Half(geometry.width) * 4 ? luma : 0;
+        case V4L2_PIX_FMT_RGB24:
+        case V4L2_PIX_FMT_BGR24:
+            return bytes_per_line >= static_cast<size_t>(geometry.width) * 3 ? luma : 0;
+        default:
+            return 0;
+    }
+}
+
+size_t FrameConverter::GetYuv4Size(uint32_t width, uint32_t height) {
+    return static_cast<size_t>(6) * Half(width) * Half(height);
+}
+
+void FrameConverter::ToYuv4(const uint8_t* data, const FrameGeometry& geometry, uint8_t* dest) {
+    uint32_t width = geometry.width;
+    uint32_t height = geometry.height;
+    uint32_t bytes_per_line = geometry.bytes_per_line;
+    const uint8_t* chroma = data + static_cast<size_t>(bytes_per_line) * height;
+
+    switch (geometry.fourcc) {
+        case V4L2_PIX_FMT_NV12:
+            ConvertPlanar(data, bytes_per_line, {chroma, chroma + 1, 2, bytes_per_line}, width, height, dest);
+            break;
+        case V4L2_PIX_FMT_NV21:
+            ConvertPlanar(data, bytes_per_line, {chroma + 1, chroma, 2, bytes_per_line}, width, height, dest);
+            break;
+        case V4L2_PIX_FMT_YUV420: {
+            // V4L2 single-plane layout: U then V, each at half the luma stride
+            uint32_t chroma_bytes_per_line = bytes_per_line / 2;
+            const uint8_t* v = chroma + static_cast<size_t>(chroma_bytes_per_line) * Half(height);
+            ConvertPlanar(data, bytes_per_line, {chroma, v, 1, chroma_bytes_per_line}, width, height, dest);
+            break;
+        }
+        case V4L2_PIX_FMT_YUYV:
+            ConvertPacked422(data, bytes_per_line, {2, 0, 1, 3}, width, height, dest);
+            break;
+        case V4L2_PIX_FMT_UYVY:
+            ConvertPacked422(data, bytes_per_line, {2, 1, 0, 2}, width, height, dest);
+            break;
+        case V4L2_PIX_FMT_RGB24:
+            ConvertRgb(data, bytes_per_line, {3, 0, 0, 2}, width, height, dest);
+            break;
+        case V4L2_PIX_FMT_BGR24:
+            ConvertRgb(data, bytes_per_line, {3, 2, 0, 0}, width, height, dest);
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace hdmi_pvr
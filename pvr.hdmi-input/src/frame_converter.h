@@ -0,0 +1,70 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace hdmi_pvr {
+
+/**
+ * FrameConverter repacks captured frames for Kodi's player.
+ *
+ * Kodi's PVR stream properties carry no pixel format, stride or codec tag,
+ * so FFmpeg's rawvideo decoder cannot be opened for a demuxed stream. The
+ * "yuv4" codec is uncompressed 4:2:0 whose decoder needs nothing but the
+ * picture size: every 2x2 block is stored as six bytes, U and V with the
+ * sign bit flipped followed by the four luma samples.
+ *
+ * Stateless; safe to use from any thread.
+ */
+class FrameConverter {
+public:
+    /**
+     * FFmpeg name of the codec the frames are converted to
+     */
+    static constexpr const char* CODEC_NAME = "yuv4";
+
+    /**
+     * FFmpeg pixel format the converted frames decode to
+     */
+    static constexpr const char* DECODED_PIXEL_FORMAT = "yuv420p";
+
+    /**
+     * Check if a pixel format can be converted
+     * @param fourcc V4L2 pixel format
+     * @return true if ToYuv4 handles the format
+     */
+    static bool SupportsFormat(uint32_t fourcc);
+
+    /**
+     * Get the bytes a captured frame must hold
+     * @param geometry Layout of the captured frame
+     * @return Minimum frame size, 0 if the format is not supported
+     */
+    static size_t GetSourceSize(const FrameGeometry& geometry);
+
+    /**
+     * Get the size of a converted frame
+     * @param width Picture width in pixels
+     * @param height Picture height in pixels
+     * @return Bytes of a yuv4 frame, the minimum its decoder accepts
+     */
+    static size_t GetYuv4Size(uint32_t width, uint32_t height);
+
+    /**
+     * Convert a captured frame
+     * @param data Frame data of at least GetSourceSize(geometry) bytes
+     * @param geometry Layout of the captured frame, of a supported format
+     * @param dest Output of GetYuv4Size(geometry.width, geometry.height) bytes
+     */
+    static void ToYuv4(const uint8_t* data, const FrameGeometry& geometry, uint8_t* dest);
+};
+
+} // namespace hdmi_pvr
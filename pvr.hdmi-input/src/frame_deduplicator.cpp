@@ -0,0 +1,109 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Duplicate Frame Detection Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "frame_deduplicator.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define HDMI_PVR_HAVE_NEON 1
+#endif
+
+namespace hdmi_pvr {
+
+namespace {
+
+constexpr uint32_t HASH_PRIME = 0x9E3779B1u;
+
+// Both paths fold a 64-byte block into four 32-bit lanes as
+// lane = lane * PRIME + word, so they produce identical hashes
+
+#ifdef HDMI_PVR_HAVE_NEON
+inline void MixBlock(uint32x4_t& acc, const uint8_t* block) {
+    acc = vmlaq_n_u32(vreinterpretq_u32_u8(vld1q_u8(block)), acc, HASH_PRIME);
+    acc = vmlaq_n_u32(vreinterpretq_u32_u8(vld1q_u8(block + 16)), acc, HASH_PRIME);
+    acc = vmlaq_n_u32(vreinterpretq_u32_u8(vld1q_u8(block + 32)), acc, HASH_PRIME);
+    acc = vmlaq_n_u32(vreinterpretq_u32_u8(vld1q_u8(block + 48)), acc, HASH_PRIME);
+}
+#else
+inline void MixBlock(uint32_t acc[4], const uint8_t* block) {
+    for (size_t row = 0; row < 4; ++row) {
+        uint32_t words[4];
+        std::memcpy(words, block + row * 16, sizeof(words));
+        for (size_t lane = 0; lane < 4; ++lane) {
+            acc[lane] = words[lane] + acc[lane] * HASH_PRIME;
+        }
+    }
+}
+#endif
+
+} // namespace
+
+uint64_t FrameDeduplicator::SampledHash(const uint8_t* data, size_t size) {
+    if (!data || size < HASH_BLOCK_SIZE) {
+        uint64_t hash = size;
+        for (size_t i = 0; data && i < size; ++i) {
+            hash = hash * HASH_PRIME + data[i];
+        }
+        return hash;
+    }
+
+    // Spread the samples evenly so any region of the picture is covered
+    size_t blocks = std::min(HASH_SAMPLE_BLOCKS, size / HASH_BLOCK_SIZE);
+    size_t stride = blocks > 1 ? (size - HASH_BLOCK_SIZE) / (blocks - 1) : 0;
+
+    uint32_t lanes[4];
+#ifdef HDMI_PVR_HAVE_NEON
+    uint32x4_t acc = vdupq_n_u32(static_cast<uint32_t>(size));
+    for (size_t i = 0; i < blocks; ++i) {
+        MixBlock(acc, data + i * stride);
+    }
+    vst1q_u32(lanes, acc);
+#else
+    lanes[0] = lanes[1] = lanes[2] = lanes[3] = static_cast<uint32_t>(size);
+    for (size_t i = 0; i < blocks; ++i) {
+        MixBlock(lanes, data + i * stride);
+    }
+#endif
+
+    uint64_t hash = (static_cast<uint64_t>(lanes[0]) << 32) | lanes[1];
+    hash ^= ((static_cast<uint64_t>(lanes[2]) << 32) | lanes[3]) * 0x9E3779B97F4A7C15ull;
+    return hash;
+}
+
+bool FrameDeduplicator::IsDuplicate(const FrameRef& frame) {
+    if (!frame || frame->Size() == 0) {
+        return false;
+    }
+
+    uint64_t hash = SampledHash(frame->Data(), frame->Size());
+
+    // Hash match is only a hint - confirm with a full compare
+    if (m_reference && m_reference_hash == hash && m_reference->Size() == frame->Size() &&
+        std::memcmp(m_reference->Data(), frame->Data(), frame->Size()) == 0) {
+        // The reference is now shown until the duplicate would have ended
+        if (frame->timestamp > m_reference->timestamp) {
+            m_reference->duration.store(frame->timestamp + frame->duration.load() - m_reference->timestamp);
+        }
+        ++m_duplicates;
+        return true;
+    }
+
+    m_reference = frame;
+    m_reference_hash = hash;
+    return false;
+}
+
+void FrameDeduplicator::Reset() {
+    m_reference.Reset();
+    m_reference_hash = 0;
+    m_duplicates = 0;
+}
+
+} // namespace hdmi_pvr
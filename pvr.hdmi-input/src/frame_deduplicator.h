@@ -0,0 +1,67 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "frame.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace hdmi_pvr {
+
+/**
+ * FrameDeduplicator detects frames identical to the previous unique frame.
+ *
+ * HDMI sources repeat frames constantly: 24p film sent in a 60 Hz signal
+ * (3:2 cadence), paused video and static menus. Each candidate is first
+ * compared by a hash over a sparse set of sampled blocks (NEON on ARM),
+ * and only a hash match is confirmed with a full compare, so changed frames
+ * cost a few KiB of reads and a repeated frame is never misdetected.
+ *
+ * Not thread-safe; used from the capture thread only.
+ */
+class FrameDeduplicator {
+public:
+    FrameDeduplicator() = default;
+
+    /**
+     * Check a captured frame against the last unique frame. A unique frame
+     * becomes the new reference; a duplicate extends the reference frame's
+     * duration up to the end of the duplicate.
+     * @param frame Captured frame (duration set to one frame interval)
+     * @return true if the frame repeats the previous one and can be skipped
+     */
+    bool IsDuplicate(const FrameRef& frame);
+
+    /**
+     * Forget the reference frame (stream start/stop, format change)
+     */
+    void Reset();
+
+    /**
+     * Number of duplicates detected since the last Reset()
+     */
+    uint64_t GetDuplicateCount() const { return m_duplicates; }
+
+    /**
+     * Sampled block hash of a frame buffer
+     * @param data Frame data
+     * @param size Frame size in bytes
+     * @return 64-bit hash
+     */
+    static uint64_t SampledHash(const uint8_t* data, size_t size);
+
+private:
+    static constexpr size_t HASH_BLOCK_SIZE = 64;    ///< Bytes per sampled block
+    static constexpr size_t HASH_SAMPLE_BLOCKS = 256; ///< Blocks sampled per frame
+
+    FrameRef m_reference;      ///< Last unique frame
+    uint64_t m_reference_hash = 0;
+    uint64_t m_duplicates = 0;
+};
+
+} // namespace hdmi_pvr
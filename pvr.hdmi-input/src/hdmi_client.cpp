@@ -6,10 +6,19 @@
  */
 
 #include "hdmi_client.h"
+#include "letterbox_detector.h"
+#include "trace.h"
 #include <kodi/General.h>
 #include <algorithm>
 #include <chrono>
 #include <thread>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace hdmi_pvr {
 
@@ -32,19 +41,28 @@ bool HdmiClient::Initialize() {
         return false;
     }
 
-    // Initialize components
+    // The pipelines register their devices with the reactor as they start
+    if (!m_reactor.Start()) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to start event loop");
+        return false;
+    }
+
+    // Initialize components - channels only, the hardware is not touched yet
     if (!InitializeComponents()) {
         kodi::Log(ADDON_LOG_ERROR, "Failed to initialize components");
         ShutdownComponents();
+        m_reactor.Stop();
         return false;
     }
 
-    // Start monitoring thread
+    // Bring up the capture devices first, then check expiries once a second
     m_shutdown_requested = false;
-    m_monitor_thread = std::thread(&HdmiClient::MonitorThread, this);
-
     m_initialized = true;
-    kodi::Log(ADDON_LOG_INFO, "HDMI client initialized successfully");
+    m_reactor.Post([this]() { StartDevices(); });
+    m_monitor_timer = m_reactor.AddTimer(MONITOR_INTERVAL_MS, [this]() { MonitorTick(); });
+    ApplyMetricsExporter();
+
+    kodi::Log(ADDON_LOG_INFO, "HDMI client initialized, capture devices starting in background");
     return true;
 }
 
@@ -55,11 +73,16 @@ void HdmiClient::Shutdown() {
 
     kodi::Log(ADDON_LOG_INFO, "Shutting down HDMI client...");
 
-    // Request shutdown and wait for monitor thread
+    // Request shutdown and wait for the reactor - after this, capture and
+    // polling only happen on request
     m_shutdown_requested = true;
-    if (m_monitor_thread.joinable()) {
-        m_monitor_thread.join();
-    }
+    m_reactor.Stop();
+    m_monitor_timer = 0;
+    m_metrics_exporter.Stop();
+
+    StopRecording("add-on shutdown");
+    CloseRecordedStream();
+    ExpireStandby(true);
 
     // Shutdown components
     ShutdownComponents();
@@ -68,70 +91,262 @@ void HdmiClient::Shutdown() {
     kodi::Log(ADDON_LOG_INFO, "HDMI client shutdown complete");
 }
 
-bool HdmiClient::SetSetting(const std::string& settingName, const kodi::addon::CSettingValue& settingValue) {
-    bool changed = false;
+ADDON_STATUS HdmiClient::SetSetting(const std::string& settingName, const kodi::addon::CSettingValue& settingValue) {
+    // Everything is applied to the running pipelines - only a change in the
+    // number of capture devices needs the add-on to be restarted
+    ADDON_STATUS status = ADDON_STATUS_OK;
 
     if (settingName == "device_path") {
         std::string new_path = settingValue.GetString();
         if (new_path != m_device_path) {
             m_device_path = new_path;
-            changed = true;
             kodi::Log(ADDON_LOG_INFO, "Device path changed to: %s", m_device_path.c_str());
+            if (!ApplyDevicePaths()) {
+                status = ADDON_STATUS_NEED_RESTART;
+            }
+        }
+    }
+    else if (settingName == "extra_device_paths") {
+        std::string new_paths = settingValue.GetString();
+        if (new_paths != m_extra_device_paths) {
+            m_extra_device_paths = new_paths;
+            kodi::Log(ADDON_LOG_INFO, "Additional capture devices changed to: %s",
+                      m_extra_device_paths.empty() ? "none" : m_extra_device_paths.c_str());
+            if (!ApplyDevicePaths()) {
+                status = ADDON_STATUS_NEED_RESTART;
+            }
+        }
+    }
+    else if (settingName == "capture_memory_mb") {
+        uint32_t new_size = static_cast<uint32_t>(std::clamp(settingValue.GetInt(), 8, 1024));
+        if (new_size != m_capture_memory_mb) {
+            m_capture_memory_mb = new_size;
+            if (m_devices) {
+                m_devices->SetMemoryBudget(static_cast<size_t>(m_capture_memory_mb) * 1024 * 1024);
+            }
+            kodi::Log(ADDON_LOG_INFO, "Capture memory budget changed to: %u MB (from next stream)",
+                      m_capture_memory_mb);
         }
     }
     else if (settingName == "buffer_count") {
         uint32_t new_count = static_cast<uint32_t>(settingValue.GetInt());
         if (new_count != m_buffer_count && new_count >= 2 && new_count <= 16) {
             m_buffer_count = new_count;
-            changed = true;
             kodi::Log(ADDON_LOG_INFO, "Buffer count changed to: %u", m_buffer_count);
+            ApplyStreamSettingsToIdle(true);
+            RestartCapture("buffer count change", true);
         }
     }
     else if (settingName == "hardware_decoding") {
         bool new_value = settingValue.GetBoolean();
-        if (new_value != m_hardware_decoding) {
-            m_hardware_decoding = new_value;
-            changed = true;
-            kodi::Log(ADDON_LOG_INFO, "Hardware decoding %s", m_hardware_decoding ? "enabled" : "disabled");
+        if (new_value != m_hardware_decoding.load()) {
+            m_hardware_decoding.store(new_value);
+            kodi::Log(ADDON_LOG_INFO, "Hardware decoding %s (after restart)", new_value ? "enabled" : "disabled");
+            status = ADDON_STATUS_NEED_RESTART;
+        }
+    }
+    else if (settingName == "standby_grace_seconds") {
+        uint32_t new_grace = static_cast<uint32_t>(std::clamp(settingValue.GetInt(), 0, 300));
+        if (new_grace != m_standby_grace_s) {
+            m_standby_grace_s = new_grace;
+            kodi::Log(ADDON_LOG_INFO, "Warm standby grace period changed to: %u s", m_standby_grace_s);
+        }
+    }
+    else if (settingName == "timeshift_enabled") {
+        bool new_value = settingValue.GetBoolean();
+        if (new_value != m_timeshift_enabled) {
+            m_timeshift_enabled = new_value;
+            kodi::Log(ADDON_LOG_INFO, "Timeshift %s", m_timeshift_enabled ? "enabled" : "disabled");
+            ApplyStreamSettingsToIdle(false);
+            RestartCapture("timeshift change", false);
+        }
+    }
+    else if (settingName == "timeshift_path") {
+        std::string new_path = settingValue.GetString();
+        if (!new_path.empty() && new_path != m_timeshift_path) {
+            m_timeshift_path = new_path;
+            kodi::Log(ADDON_LOG_INFO, "Timeshift path changed to: %s", m_timeshift_path.c_str());
+            ApplyStreamSettingsToIdle(false);
+            RestartCapture("timeshift change", false);
+        }
+    }
+    else if (settingName == "timeshift_size_mb") {
+        uint32_t new_size = static_cast<uint32_t>(std::clamp(settingValue.GetInt(), 16, 4096));
+        if (new_size != m_timeshift_size_mb) {
+            m_timeshift_size_mb = new_size;
+            kodi::Log(ADDON_LOG_INFO, "Timeshift size changed to: %u MB", m_timeshift_size_mb);
+            ApplyStreamSettingsToIdle(false);
+            RestartCapture("timeshift change", false);
+        }
+    }
+    else if (settingName == "skip_duplicate_frames") {
+        bool new_value = settingValue.GetBoolean();
+        if (new_value != m_skip_duplicate_frames) {
+            m_skip_duplicate_frames = new_value;
+            if (m_devices) {
+                for (const auto& pipeline : m_devices->GetPipelines()) {
+                    pipeline->GetStreamProcessor().SetDuplicateFrameSkipping(m_skip_duplicate_frames);
+                }
+            }
+            kodi::Log(ADDON_LOG_INFO, "Duplicate frame skipping %s", m_skip_duplicate_frames ? "enabled" : "disabled");
+        }
+    }
+    else if (settingName == "letterbox_crop") {
+        bool new_value = settingValue.GetBoolean();
+        if (new_value != m_letterbox_crop) {
+            m_letterbox_crop = new_value;
+            if (m_devices) {
+                for (const auto& pipeline : m_devices->GetPipelines()) {
+                    pipeline->GetStreamProcessor().SetLetterboxCrop(m_letterbox_crop);
+                }
+            }
+            kodi::Log(ADDON_LOG_INFO, "Letterbox cropping %s (from next stream)",
+                      m_letterbox_crop ? "enabled" : "disabled");
+        }
+    }
+    else if (settingName == "recording_path") {
+        std::string new_path = settingValue.GetString();
+        if (new_path.empty()) {
+            new_path = kodi::addon::GetUserPath("recordings");
+        }
+        if (new_path != m_recording_path) {
+            m_recording_path = new_path;
+            kodi::Log(ADDON_LOG_INFO, "Recording path changed to: %s", m_recording_path.c_str());
         }
     }
     else if (settingName == "audio_enabled") {
         bool new_value = settingValue.GetBoolean();
-        if (new_value != m_audio_enabled) {
-            m_audio_enabled = new_value;
-            changed = true;
-            kodi::Log(ADDON_LOG_INFO, "Audio %s", m_audio_enabled ? "enabled" : "disabled");
+        if (new_value != m_audio_enabled.load()) {
+            m_audio_enabled.store(new_value);
+            kodi::Log(ADDON_LOG_INFO, "Audio %s", new_value ? "enabled" : "disabled");
+            RestartCapture("audio change", false);
+        }
+    }
+    else if (settingName == "trace_enabled") {
+        bool new_value = settingValue.GetBoolean();
+        if (new_value != m_trace_enabled) {
+            if (!new_value) {
+                DisableTracing();
+                m_trace_enabled = false;
+            } else if (EnableTracing()) {
+                m_trace_enabled = true;
+            }
+            kodi::Log(ADDON_LOG_INFO, "Pipeline tracing %s", m_trace_enabled ? "enabled" : "disabled");
+        }
+    }
+    else if (settingName == "metrics_enabled") {
+        bool new_value = settingValue.GetBoolean();
+        if (new_value != m_metrics_enabled) {
+            m_metrics_enabled = new_value;
+            kodi::Log(ADDON_LOG_INFO, "Metrics exporter %s", m_metrics_enabled ? "enabled" : "disabled");
+            ApplyMetricsExporter();
+        }
+    }
+    else if (settingName == "metrics_endpoint") {
+        std::string new_endpoint = settingValue.GetString();
+        if (!new_endpoint.empty() && new_endpoint != m_metrics_endpoint) {
+            m_metrics_endpoint = new_endpoint;
+            kodi::Log(ADDON_LOG_INFO, "Metrics endpoint changed to: %s", m_metrics_endpoint.c_str());
+            m_metrics_exporter.Stop();
+            ApplyMetricsExporter();
         }
     }
 
-    return changed;
+    return status;
 }
 
 int HdmiClient::GetChannelCount() const {
-    if (!m_initialized.load() || !m_channel_manager) {
+    if (!m_initialized.load() || !m_devices) {
         return 0;
     }
-    return m_channel_manager->GetChannelCount();
+
+    int count = 0;
+    for (const auto& pipeline : m_devices->GetPipelines()) {
+        count += pipeline->GetChannelManager().GetChannelCount();
+    }
+    return count;
 }
 
 PVR_ERROR HdmiClient::GetChannels(kodi::addon::PVRChannelsResultSet& results) {
-    if (!m_initialized.load() || !m_channel_manager) {
+    if (!m_initialized.load() || !m_devices) {
         return PVR_ERROR_SERVER_ERROR;
     }
-    return m_channel_manager->GetChannels(results);
+
+    for (const auto& pipeline : m_devices->GetPipelines()) {
+        PVR_ERROR error = pipeline->GetChannelManager().GetChannels(results);
+        if (error != PVR_ERROR_NO_ERROR) {
+            return error;
+        }
+    }
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::GetChannelGroupsAmount(int& amount) const {
+    if (!m_initialized.load() || !m_devices) {
+        return PVR_ERROR_SERVER_ERROR;
+    }
+    amount = static_cast<int>(m_devices->GetPipelines().size());
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::GetChannelGroups(kodi::addon::PVRChannelGroupsResultSet& results) const {
+    if (!m_initialized.load() || !m_devices) {
+        return PVR_ERROR_SERVER_ERROR;
+    }
+
+    for (const auto& pipeline : m_devices->GetPipelines()) {
+        kodi::addon::PVRChannelGroup group;
+        group.SetGroupName(pipeline->GetName());
+        group.SetIsRadio(false);
+        group.SetPosition(pipeline->GetIndex() + 1);
+        results.Add(group);
+    }
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group,
+                                             kodi::addon::PVRChannelGroupMembersResultSet& results) const {
+    if (!m_initialized.load() || !m_devices) {
+        return PVR_ERROR_SERVER_ERROR;
+    }
+
+    CapturePipeline* pipeline = m_devices->FindPipelineByGroup(group.GetGroupName());
+    if (!pipeline) {
+        return PVR_ERROR_INVALID_PARAMETERS;
+    }
+
+    for (const auto& input : pipeline->GetChannelManager().GetInputSources()) {
+        if (!input.enabled) {
+            continue;
+        }
+
+        kodi::addon::PVRChannelGroupMember member;
+        member.SetGroupName(pipeline->GetName());
+        member.SetChannelUniqueId(pipeline->ToChannelUid(input.channel_number));
+        member.SetChannelNumber(input.channel_number);
+        member.SetSubChannelNumber(input.sub_channel_number);
+        results.Add(member);
+    }
+    return PVR_ERROR_NO_ERROR;
 }
 
 PVR_ERROR HdmiClient::GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results) {
-    if (!m_initialized.load() || !m_channel_manager) {
+    if (!m_initialized.load() || !m_devices) {
         return PVR_ERROR_SERVER_ERROR;
     }
 
-    auto epg_entries = m_channel_manager->GenerateEPG(static_cast<uint32_t>(channelUid), start, end);
+    uint32_t channel_uid = static_cast<uint32_t>(channelUid);
+    CapturePipeline* pipeline = m_devices->FindPipelineForChannel(channel_uid);
+    if (!pipeline) {
+        return PVR_ERROR_INVALID_PARAMETERS;
+    }
+
+    auto epg_entries = pipeline->GetChannelManager().GenerateEPG(CapturePipeline::ToChannelId(channel_uid), start, end);
     
     for (const auto& entry : epg_entries) {
         kodi::addon::PVREPGTag tag;
         tag.SetUniqueBroadcastId(entry.unique_id);
-        tag.SetUniqueChannelId(entry.channel_id);
+        tag.SetUniqueChannelId(channel_uid);
         tag.SetTitle(entry.title);
         tag.SetPlot(entry.plot);
         tag.SetGenreType(0);
@@ -147,59 +362,204 @@ PVR_ERROR HdmiClient::GetEPGForChannel(int channelUid, time_t start, time_t end,
 }
 
 bool HdmiClient::OpenLiveStream(const kodi::addon::PVRChannel& channel) {
-    if (!m_initialized.load() || !m_stream_processor || !m_v4l2_device) {
+    if (!m_initialized.load() || !m_devices) {
         kodi::Log(ADDON_LOG_ERROR, "Cannot open live stream - components not initialized");
         return false;
     }
 
+    uint32_t channel_uid = channel.GetUniqueId();
+    CapturePipeline* pipeline = m_devices->FindPipelineForChannel(channel_uid);
+    if (!pipeline) {
+        kodi::Log(ADDON_LOG_ERROR, "No capture device serves channel %u", channel_uid);
+        return false;
+    }
+
     if (m_streaming.load()) {
         kodi::Log(ADDON_LOG_WARNING, "Stream already open");
         return true;
     }
 
-    kodi::Log(ADDON_LOG_INFO, "Opening live stream for channel %u", channel.GetUniqueId());
+    // Normally up already - a stream opened during startup waits for or
+    // performs the bring-up of its device here
+    if (!m_devices->Start(*pipeline)) {
+        kodi::Log(ADDON_LOG_ERROR, "Capture device %s is not available", pipeline->GetDevicePath().c_str());
+        return false;
+    }
+
+    kodi::Log(ADDON_LOG_INFO, "Opening live stream for channel %u on %s", channel_uid,
+              pipeline->GetDevicePath().c_str());
+
+    // Reopen of the channel kept warm after the last close
+    if (ResumeStandby(channel_uid)) {
+        m_streaming = true;
+        kodi::Log(ADDON_LOG_INFO, "Live stream resumed from warm standby");
+        return true;
+    }
+
+    // Idle devices give their memory back before this one allocates
+    m_active_pipeline = pipeline;
+    m_devices->Activate(pipeline);
+
+    if (!StartCapture(*pipeline, channel_uid)) {
+        return false;
+    }
+
+    m_streaming = true;
+    kodi::Log(ADDON_LOG_INFO, "Live stream opened successfully");
+    return true;
+}
+
+bool HdmiClient::StartCapture(CapturePipeline& pipeline, uint32_t channel_uid) {
+    // The device only looks busy once it streams - until then the input
+    // scanner must not switch it to another port
+    ChannelManager& channels = pipeline.GetChannelManager();
+    channels.SetCaptureStarting(true);
+    bool started = BringUpCapture(pipeline, channel_uid);
+    channels.SetCaptureStarting(false);
+    return started;
+}
+
+bool HdmiClient::BringUpCapture(CapturePipeline& pipeline, uint32_t channel_uid) {
+    V4L2Device& device = pipeline.GetDevice();
 
     // Switch to the requested channel input
-    if (m_channel_manager && !m_channel_manager->SetActiveChannel(channel.GetUniqueId())) {
-        kodi::Log(ADDON_LOG_ERROR, "Failed to switch to channel %u", channel.GetUniqueId());
+    if (!pipeline.GetChannelManager().SetActiveChannel(CapturePipeline::ToChannelId(channel_uid))) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to switch to channel %u", channel_uid);
         return false;
     }
 
-    // Wait for signal to stabilize
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    // Wait for the receiver to lock onto the source instead of a fixed delay
+    uint32_t lock_timeout_ms = GetLockTimeout(pipeline);
+    if (!device.WaitForSignalLock(lock_timeout_ms)) {
+        kodi::Log(ADDON_LOG_WARNING, "No signal lock within %u ms", lock_timeout_ms);
+    }
 
     // Detect input format
     VideoFormat video_format;
-    if (!m_v4l2_device->DetectInputFormat(video_format)) {
+    if (!device.DetectInputFormat(video_format)) {
         kodi::Log(ADDON_LOG_WARNING, "Could not detect input format, using default");
         video_format.width = 1920;
         video_format.height = 1080;
-        video_format.fps = 60;
+        video_format.frame_rate = {60, 1};
         video_format.fourcc = 0; // Use default
         video_format.interlaced = false;
     }
 
-    // Set the format on V4L2 device
-    if (!m_v4l2_device->SetFormat(video_format)) {
-        kodi::Log(ADDON_LOG_ERROR, "Failed to set video format: %s", video_format.to_string().c_str());
+    NegotiateCaptureFormat(device, video_format);
+
+    if (!ConfigureCaptureFormat(device, video_format)) {
         return false;
     }
 
-    // Configure audio format
-    AudioFormat audio_format;
-    audio_format.sample_rate = 48000;
-    audio_format.channels = 2;
-    audio_format.bit_depth = 16;
-    audio_format.compressed = false;
-
     // Start streaming
-    if (!m_stream_processor->StartStreaming(video_format, audio_format)) {
+    if (!pipeline.GetStreamProcessor().StartStreaming(video_format, GetAudioFormat())) {
         kodi::Log(ADDON_LOG_ERROR, "Failed to start stream processor");
         return false;
     }
 
-    m_streaming = true;
-    kodi::Log(ADDON_LOG_INFO, "Live stream opened successfully");
+    return true;
+}
+
+AudioFormat HdmiClient::GetAudioFormat() const {
+    // HDMI audio is 48 kHz stereo PCM; disabled, the stream is video only
+    AudioFormat audio_format;
+    if (m_audio_enabled.load()) {
+        audio_format.sample_rate = 48000;
+        audio_format.channels = 2;
+        audio_format.bit_depth = 16;
+        audio_format.compressed = false;
+    }
+    return audio_format;
+}
+
+bool HdmiClient::RestartCapture(const char* reason, bool remap_buffers) {
+    std::lock_guard<std::mutex> lock(m_standby_mutex);
+    CapturePipeline* pipeline = GetActivePipeline();
+    if (!pipeline || !pipeline->IsBusy()) {
+        // Nothing running - the next stream picks the settings up
+        return true;
+    }
+
+    StreamProcessor& processor = pipeline->GetStreamProcessor();
+    V4L2Device& device = pipeline->GetDevice();
+    bool standby = processor.IsInStandby();
+
+    // The source has not changed, so the running format is reused and
+    // there is no new wait for the signal lock
+    VideoFormat video_format;
+    AudioFormat audio_format;
+    processor.GetCurrentFormat(video_format, audio_format);
+    audio_format = GetAudioFormat();
+
+    auto start_time = std::chrono::steady_clock::now();
+    ChannelManager& channels = pipeline->GetChannelManager();
+    channels.SetCaptureStarting(true);
+    processor.StopStreaming();
+    ApplyStreamSettings(*pipeline);
+    if (remap_buffers) {
+        device.DeallocateBuffers();
+    }
+
+    bool restarted = ConfigureCaptureFormat(device, video_format) &&
+                     processor.StartStreaming(video_format, audio_format);
+    channels.SetCaptureStarting(false);
+    if (!restarted) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to restart capture after %s", reason);
+        return false;
+    }
+    if (standby) {
+        processor.EnterStandby(STANDBY_RING_FRAMES);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    kodi::Log(ADDON_LOG_INFO, "Capture restarted for %s in %lld ms", reason,
+              static_cast<long long>(elapsed.count()));
+    return true;
+}
+
+bool HdmiClient::ApplyDevicePaths() {
+    if (!m_devices) {
+        return true;
+    }
+
+    // Channel ids are derived from a device's position, so only devices
+    // that keep their position can be swapped while running
+    std::vector<std::string> paths = GetDevicePaths();
+    const auto& pipelines = m_devices->GetPipelines();
+    if (paths.size() != pipelines.size()) {
+        return false;
+    }
+
+    bool swapped = false;
+    for (const auto& pipeline : pipelines) {
+        const std::string& path = paths[pipeline->GetIndex() < paths.size() ? pipeline->GetIndex() : 0];
+        if (path == pipeline->GetDevicePath()) {
+            continue;
+        }
+
+        bool live = pipeline.get() == GetActivePipeline() && pipeline->IsBusy();
+        uint32_t channel_uid = GetActiveChannelUid();
+        auto start_time = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(m_standby_mutex);
+        if (!m_devices->ReplaceDevice(*pipeline, path)) {
+            kodi::Log(ADDON_LOG_WARNING, "Capture device %s not available, retrying when tuned", path.c_str());
+        } else if (live && m_streaming.load() && !StartCapture(*pipeline, channel_uid)) {
+            kodi::Log(ADDON_LOG_ERROR, "Failed to resume channel %u on %s", channel_uid, path.c_str());
+        }
+        swapped = true;
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time);
+        kodi::Log(ADDON_LOG_INFO, "Capture device %u moved to %s in %lld ms", pipeline->GetIndex(),
+                  path.c_str(), static_cast<long long>(elapsed.count()));
+    }
+
+    // Probing may have found other inputs and the group follows the card name
+    if (swapped) {
+        NotifyChannelsChanged();
+    }
     return true;
 }
 
@@ -210,8 +570,24 @@ void HdmiClient::CloseLiveStream() {
 
     kodi::Log(ADDON_LOG_INFO, "Closing live stream");
 
-    if (m_stream_processor) {
-        m_stream_processor->StopStreaming();
+    if (StreamProcessor* processor = GetActiveStreamProcessor()) {
+        // An active recording keeps capture running regardless of the grace period
+        bool recording = m_recording_engine && m_recording_engine->IsRecording();
+        bool standby = false;
+        if (m_standby_grace_s > 0 || recording) {
+            std::lock_guard<std::mutex> lock(m_standby_mutex);
+            standby = processor->EnterStandby(STANDBY_RING_FRAMES);
+            if (standby) {
+                m_standby_channel = GetActiveChannelUid();
+                m_standby_deadline = std::chrono::steady_clock::now() +
+                                     std::chrono::seconds(m_standby_grace_s);
+                kodi::Log(ADDON_LOG_DEBUG, "Keeping channel %u warm for %u s",
+                          m_standby_channel, m_standby_grace_s);
+            }
+        }
+        if (!standby) {
+            processor->StopStreaming();
+        }
     }
 
     m_streaming = false;
@@ -219,30 +595,366 @@ void HdmiClient::CloseLiveStream() {
 }
 
 int HdmiClient::ReadLiveStream(unsigned char* buffer, unsigned int size) {
-    if (!m_streaming.load() || !m_stream_processor || !buffer || size == 0) {
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!m_streaming.load() || !processor || !buffer || size == 0) {
+        return -1;
+    }
+
+    return processor->ReadLiveStream(buffer, size);
+}
+
+PVR_ERROR HdmiClient::GetStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties,
+                                          const StreamProcessor::CodecLookup& lookup) {
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        if (m_recording_player.IsOpen()) {
+            return m_recording_player.GetStreamProperties(properties, lookup);
+        }
+    }
+
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!m_streaming.load() || !processor) {
+        return PVR_ERROR_SERVER_ERROR;
+    }
+
+    return processor->GetDemuxStreamProperties(properties, lookup);
+}
+
+bool HdmiClient::CanPauseStream() const {
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        if (m_recording_player.IsOpen()) {
+            return true;
+        }
+    }
+
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    return m_streaming.load() && processor && processor->IsTimeshiftActive();
+}
+
+bool HdmiClient::CanSeekStream() const {
+    return CanPauseStream();
+}
+
+void HdmiClient::PauseStream(bool paused) {
+    // The ring keeps filling while paused; reads resume from the paused position
+    if (StreamProcessor* processor = GetActiveStreamProcessor()) {
+        processor->PauseDemuxStream(paused);
+    }
+    kodi::Log(ADDON_LOG_DEBUG, "Live stream %s", paused ? "paused" : "resumed");
+}
+
+int64_t HdmiClient::SeekLiveStream(int64_t position, int whence) {
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!m_streaming.load() || !processor) {
+        return -1;
+    }
+    return processor->SeekLiveStream(position, whence);
+}
+
+int64_t HdmiClient::LengthLiveStream() const {
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!m_streaming.load() || !processor) {
         return -1;
     }
+    return processor->LengthLiveStream();
+}
+
+bool HdmiClient::IsRealTimeStream() const {
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        if (m_recording_player.IsOpen()) {
+            return false;
+        }
+    }
 
-    return m_stream_processor->ReadLiveStream(buffer, size);
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    return !processor || processor->IsRealTimeStream();
 }
 
-PVR_ERROR HdmiClient::GetStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties) {
-    if (!m_streaming.load() || !m_stream_processor) {
+PVR_ERROR HdmiClient::GetStreamTimes(kodi::addon::PVRStreamTimes& times) const {
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        if (m_recording_player.IsOpen()) {
+            uint64_t begin_us = 0;
+            uint64_t end_us = 0;
+            if (!m_recording_player.GetTimes(begin_us, end_us)) {
+                return PVR_ERROR_FAILED;
+            }
+            // Play position and duration are relative to the first frame
+            times.SetStartTime(0);
+            times.SetPTSStart(static_cast<int64_t>(begin_us));
+            times.SetPTSBegin(static_cast<int64_t>(begin_us));
+            times.SetPTSEnd(static_cast<int64_t>(end_us));
+            return PVR_ERROR_NO_ERROR;
+        }
+    }
+
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!m_streaming.load() || !processor) {
         return PVR_ERROR_SERVER_ERROR;
     }
 
-    return m_stream_processor->GetStreamProperties(properties);
+    time_t start_time = 0;
+    uint64_t start_us = 0;
+    uint64_t begin_us = 0;
+    uint64_t end_us = 0;
+    if (!processor->GetStreamTimes(start_time, start_us, begin_us, end_us)) {
+        return PVR_ERROR_NOT_IMPLEMENTED;
+    }
+
+    // Packet timestamps are microseconds, which matches DVD_TIME_BASE; the
+    // player subtracts PTSStart from its clock to get the play position
+    times.SetStartTime(start_time);
+    times.SetPTSStart(static_cast<int64_t>(start_us));
+    times.SetPTSBegin(static_cast<int64_t>(begin_us));
+    times.SetPTSEnd(static_cast<int64_t>(end_us));
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::GetTimerTypes(std::vector<kodi::addon::PVRTimerType>& types) const {
+    kodi::addon::PVRTimerType type;
+    type.SetId(TIMER_TYPE_INSTANT);
+    type.SetAttributes(PVR_TIMER_TYPE_IS_MANUAL |
+                       PVR_TIMER_TYPE_SUPPORTS_CHANNELS |
+                       PVR_TIMER_TYPE_SUPPORTS_START_TIME |
+                       PVR_TIMER_TYPE_SUPPORTS_END_TIME);
+    type.SetDescription("Record HDMI input");
+    types.emplace_back(type);
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::GetTimersAmount(int& amount) const {
+    amount = (m_recording_engine && m_recording_engine->IsRecording()) ? 1 : 0;
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::GetTimers(kodi::addon::PVRTimersResultSet& results) const {
+    if (!m_recording_engine || !m_recording_engine->IsRecording()) {
+        return PVR_ERROR_NO_ERROR;
+    }
+
+    std::lock_guard<std::mutex> lock(m_recording_mutex);
+    kodi::addon::PVRTimer timer;
+    timer.SetClientIndex(TIMER_INDEX_ACTIVE);
+    timer.SetTimerType(TIMER_TYPE_INSTANT);
+    timer.SetClientChannelUid(static_cast<int>(m_recording_channel));
+    timer.SetTitle(m_recording_title);
+    timer.SetStartTime(m_recording_start);
+    timer.SetEndTime(m_recording_end);
+    timer.SetState(PVR_TIMER_STATE_RECORDING);
+    results.Add(timer);
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::AddTimer(const kodi::addon::PVRTimer& timer) {
+    if (!m_initialized.load() || !m_recording_engine || !m_devices) {
+        return PVR_ERROR_SERVER_ERROR;
+    }
+
+    // Only the channel being watched can be recorded, and only from now on
+    uint32_t channel_id = static_cast<uint32_t>(timer.GetClientChannelUid());
+    if (!m_streaming.load() || channel_id != GetActiveChannelUid()) {
+        kodi::Log(ADDON_LOG_WARNING, "Only the channel currently playing can be recorded");
+        return PVR_ERROR_REJECTED;
+    }
+
+    time_t now = time(nullptr);
+    if (timer.GetStartTime() > now + 60) {
+        kodi::Log(ADDON_LOG_WARNING, "Scheduled recordings are not supported");
+        return PVR_ERROR_REJECTED;
+    }
+
+    if (m_recording_engine->IsRecording()) {
+        return PVR_ERROR_ALREADY_PRESENT;
+    }
+
+    if (mkdir(m_recording_path.c_str(), 0755) != 0 && errno != EEXIST) {
+        kodi::Log(ADDON_LOG_ERROR, "Cannot create recording directory %s: %s",
+                  m_recording_path.c_str(), strerror(errno));
+        return PVR_ERROR_FAILED;
+    }
+
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "ch%u-%lld.hyraw", channel_id, static_cast<long long>(now));
+
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        if (!m_recording_engine->Start(GetRecordingFilePath(file_name))) {
+            return PVR_ERROR_FAILED;
+        }
+
+        m_recording_channel = channel_id;
+        m_recording_title = timer.GetTitle().empty() ? GetChannelName(channel_id) : timer.GetTitle();
+        m_recording_start = now;
+        m_recording_end = timer.GetEndTime() > now ? timer.GetEndTime() : 0;
+    }
+
+    NotifyTimersChanged();
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::DeleteTimer(const kodi::addon::PVRTimer& timer, bool forceDelete) {
+    (void)forceDelete;
+    if (timer.GetClientIndex() != TIMER_INDEX_ACTIVE || !m_recording_engine ||
+        !m_recording_engine->IsRecording()) {
+        return PVR_ERROR_INVALID_PARAMETERS;
+    }
+
+    StopRecording("timer deleted");
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::GetRecordingsAmount(int& amount) const {
+    amount = 0;
+
+    DIR* dir = opendir(m_recording_path.c_str());
+    if (!dir) {
+        return PVR_ERROR_NO_ERROR;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        unsigned int channel_id;
+        long long start;
+        if (sscanf(entry->d_name, "ch%u-%lld.hyraw", &channel_id, &start) == 2) {
+            ++amount;
+        }
+    }
+    closedir(dir);
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::GetRecordings(kodi::addon::PVRRecordingsResultSet& results) const {
+    DIR* dir = opendir(m_recording_path.c_str());
+    if (!dir) {
+        return PVR_ERROR_NO_ERROR;
+    }
+
+    std::string active_path = m_recording_engine && m_recording_engine->IsRecording()
+                              ? m_recording_engine->GetPath() : std::string();
+
+    while (struct dirent* entry = readdir(dir)) {
+        unsigned int channel_id;
+        long long start;
+        if (sscanf(entry->d_name, "ch%u-%lld.hyraw", &channel_id, &start) != 2) {
+            continue;
+        }
+
+        std::string path = GetRecordingFilePath(entry->d_name);
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            continue;
+        }
+
+        // The index is only written at the end - the file's last write marks it
+        time_t end = (path == active_path) ? time(nullptr) : st.st_mtime;
+        std::string name = GetChannelName(channel_id);
+
+        kodi::addon::PVRRecording recording;
+        recording.SetRecordingId(entry->d_name);
+        recording.SetTitle(name);
+        recording.SetChannelName(name);
+        recording.SetChannelUid(static_cast<int>(channel_id));
+        recording.SetChannelType(PVR_RECORDING_CHANNEL_TYPE_TV);
+        recording.SetRecordingTime(static_cast<time_t>(start));
+        recording.SetDuration(static_cast<int>(std::max<time_t>(end - static_cast<time_t>(start), 0)));
+        recording.SetSizeInBytes(static_cast<int64_t>(st.st_size));
+        results.Add(recording);
+    }
+    closedir(dir);
+
+    return PVR_ERROR_NO_ERROR;
+}
+
+PVR_ERROR HdmiClient::DeleteRecording(const kodi::addon::PVRRecording& recording) {
+    std::string path = GetRecordingFilePath(recording.GetRecordingId());
+    if (m_recording_engine && m_recording_engine->IsRecording() && m_recording_engine->GetPath() == path) {
+        return PVR_ERROR_RECORDING_RUNNING;
+    }
+
+    if (unlink(path.c_str()) != 0) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to delete recording %s: %s", path.c_str(), strerror(errno));
+        return PVR_ERROR_FAILED;
+    }
+
+    NotifyRecordingsChanged();
+    return PVR_ERROR_NO_ERROR;
+}
+
+bool HdmiClient::OpenRecordedStream(const kodi::addon::PVRRecording& recording) {
+    CloseRecordedStream();
+
+    std::string path = GetRecordingFilePath(recording.GetRecordingId());
+    std::lock_guard<std::mutex> lock(m_recording_mutex);
+    m_recorded_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_recorded_fd < 0) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to open recording %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    // Kodi demuxes recordings through DemuxRead like the live stream. A
+    // recording still being written is played up to where it is now.
+    if (!m_recording_player.Open(path)) {
+        kodi::Log(ADDON_LOG_ERROR, "Recording %s cannot be played", path.c_str());
+        close(m_recorded_fd);
+        m_recorded_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void HdmiClient::CloseRecordedStream() {
+    std::lock_guard<std::mutex> lock(m_recording_mutex);
+    m_recording_player.Close();
+    if (m_recorded_fd >= 0) {
+        close(m_recorded_fd);
+        m_recorded_fd = -1;
+    }
+}
+
+int HdmiClient::ReadRecordedStream(unsigned char* buffer, unsigned int size) {
+    std::lock_guard<std::mutex> lock(m_recording_mutex);
+    if (m_recorded_fd < 0 || !buffer) {
+        return -1;
+    }
+    ssize_t ret = read(m_recorded_fd, buffer, size);
+    return ret < 0 ? -1 : static_cast<int>(ret);
+}
+
+int64_t HdmiClient::SeekRecordedStream(int64_t position, int whence) {
+    std::lock_guard<std::mutex> lock(m_recording_mutex);
+    if (m_recorded_fd < 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(lseek(m_recorded_fd, static_cast<off_t>(position), whence));
+}
+
+int64_t HdmiClient::LengthRecordedStream() const {
+    std::lock_guard<std::mutex> lock(m_recording_mutex);
+    struct stat st;
+    if (m_recorded_fd < 0 || fstat(m_recorded_fd, &st) != 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(st.st_size);
 }
 
 PVR_ERROR HdmiClient::GetSignalStatus(int channelUid, kodi::addon::PVRSignalStatus& signalStatus) {
-    if (!m_initialized.load() || !m_signal_monitor) {
+    if (!m_initialized.load() || !m_devices) {
         return PVR_ERROR_SERVER_ERROR;
     }
 
-    SignalStatus status = m_signal_monitor->GetSignalStatus();
+    CapturePipeline* pipeline = m_devices->FindPipelineForChannel(static_cast<uint32_t>(channelUid));
+    if (!pipeline) {
+        return PVR_ERROR_INVALID_PARAMETERS;
+    }
+
+    SignalStatus status = pipeline->GetSignalMonitor().GetSignalStatus();
     
-    signalStatus.SetAdapterName("HY300 HDMI Input");
-    signalStatus.SetAdapterStatus(status.connected ? "Connected" : "No Signal");
+    signalStatus.SetAdapterName(pipeline->GetName());
+    if (!pipeline->IsReady()) {
+        signalStatus.SetAdapterStatus("Not Available");
+    } else {
+        signalStatus.SetAdapterStatus(status.connected ? "Connected" : "No Signal");
+    }
     signalStatus.SetServiceName(status.device_name);
     signalStatus.SetMuxName("HDMI Input");
     signalStatus.SetSignal(static_cast<int>(status.signal_strength * 655.35)); // Scale to 0-65535
@@ -254,7 +966,7 @@ PVR_ERROR HdmiClient::GetSignalStatus(int channelUid, kodi::addon::PVRSignalStat
 }
 
 bool HdmiClient::OpenDemuxStream(const kodi::addon::PVRChannel& channel) {
-    if (!m_initialized.load() || !m_stream_processor) {
+    if (!m_initialized.load() || !m_devices) {
         return false;
     }
 
@@ -263,52 +975,92 @@ bool HdmiClient::OpenDemuxStream(const kodi::addon::PVRChannel& channel) {
         return false;
     }
 
-    return m_stream_processor->OpenDemuxStream();
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    return processor && processor->OpenDemuxStream();
 }
 
 void HdmiClient::CloseDemuxStream() {
-    if (m_stream_processor) {
-        m_stream_processor->CloseDemuxStream();
+    if (StreamProcessor* processor = GetActiveStreamProcessor()) {
+        processor->CloseDemuxStream();
     }
 }
 
-DEMUX_PACKET* HdmiClient::DemuxRead() {
-    if (!m_stream_processor) {
+DEMUX_PACKET* HdmiClient::DemuxRead(const StreamProcessor::DemuxPacketAllocator& allocate) {
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        if (m_recording_player.IsOpen()) {
+            return m_recording_player.DemuxRead(allocate);
+        }
+    }
+
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!processor) {
         return nullptr;
     }
-    return m_stream_processor->DemuxRead();
+    return processor->DemuxRead(allocate);
 }
 
 void HdmiClient::DemuxAbort() {
-    if (m_stream_processor) {
-        m_stream_processor->DemuxAbort();
+    if (StreamProcessor* processor = GetActiveStreamProcessor()) {
+        processor->DemuxAbort();
     }
 }
 
 void HdmiClient::DemuxFlush() {
-    if (m_stream_processor) {
-        m_stream_processor->DemuxFlush();
+    if (StreamProcessor* processor = GetActiveStreamProcessor()) {
+        processor->DemuxFlush();
     }
 }
 
 void HdmiClient::DemuxReset() {
-    if (m_stream_processor) {
-        m_stream_processor->DemuxReset();
+    if (StreamProcessor* processor = GetActiveStreamProcessor()) {
+        processor->DemuxReset();
+    }
+}
+
+bool HdmiClient::DemuxSeekTime(double time_ms, bool backwards, double& start_pts) {
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        if (m_recording_player.IsOpen()) {
+            return m_recording_player.SeekTime(time_ms, backwards, start_pts);
+        }
     }
+
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!m_streaming.load() || !processor) {
+        return false;
+    }
+    return processor->DemuxSeekTime(time_ms, backwards, start_pts);
 }
 
-PVR_ERROR HdmiClient::CallMenuHook(const kodi::addon::PVRMenuhook& menuhook, const kodi::addon::PVRChannel& channel) {
+PVR_ERROR HdmiClient::CallChannelMenuHook(const kodi::addon::PVRMenuhook& menuhook, const kodi::addon::PVRChannel& channel) {
     kodi::Log(ADDON_LOG_INFO, "Menu hook called: %u for channel %u", menuhook.GetHookId(), channel.GetUniqueId());
     
+    CapturePipeline* pipeline = m_devices ? m_devices->FindPipelineForChannel(channel.GetUniqueId()) : nullptr;
+    if (pipeline && !pipeline->IsReady()) {
+        pipeline = nullptr;
+    }
     switch (menuhook.GetHookId()) {
         case 1: // Refresh signal status
-            if (m_signal_monitor) {
-                m_signal_monitor->UpdateSignalStatus();
+            if (pipeline) {
+                pipeline->GetSignalMonitor().UpdateSignalStatus();
             }
             break;
-        case 2: // Switch input
-            if (m_channel_manager) {
-                m_channel_manager->DetectActiveInputs();
+        case 2: // Scan inputs - runs in the background, Kodi's thread returns at once
+            if (pipeline) {
+                pipeline->GetChannelManager().DetectActiveInputs();
+            }
+            break;
+        case 3: { // Export signal telemetry - kept while the device is stopped
+            CapturePipeline* device = m_devices ? m_devices->FindPipelineForChannel(channel.GetUniqueId()) : nullptr;
+            if (device && !ExportTelemetry(*device)) {
+                return PVR_ERROR_FAILED;
+            }
+            break;
+        }
+        case 4: // Start/stop a raw capture of the live stream, for replaying field problems
+            if (pipeline && !ToggleRawCapture(*pipeline)) {
+                return PVR_ERROR_FAILED;
             }
             break;
         default:
@@ -320,57 +1072,90 @@ PVR_ERROR HdmiClient::CallMenuHook(const kodi::addon::PVRMenuhook& menuhook, con
 
 // Private methods
 
-bool HdmiClient::InitializeComponents() {
-    try {
-        // Initialize V4L2 device
-        m_v4l2_device = std::make_unique<V4L2Device>(m_device_path);
-        if (!m_v4l2_device->Open()) {
-            kodi::Log(ADDON_LOG_ERROR, "Failed to open V4L2 device: %s", m_device_path.c_str());
-            return false;
-        }
+bool HdmiClient::ExportTelemetry(const CapturePipeline& pipeline) const {
+    std::string base = kodi::addon::GetUserPath("signal_telemetry." + std::to_string(pipeline.GetIndex()));
+    const SignalTelemetry& telemetry = pipeline.GetTelemetry();
 
-        if (!m_v4l2_device->QueryCapabilities()) {
-            kodi::Log(ADDON_LOG_ERROR, "V4L2 device does not support required capabilities");
-            return false;
-        }
+    std::ofstream csv(base + ".csv");
+    std::ofstream json(base + ".json");
+    if (!(csv << telemetry.ToCsv()) || !(json << telemetry.ToJson())) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to export signal telemetry to %s", base.c_str());
+        return false;
+    }
 
-        kodi::Log(ADDON_LOG_INFO, "V4L2 device opened: %s (driver: %s)", 
-                  m_v4l2_device->GetCardName().c_str(), 
-                  m_v4l2_device->GetDriverName().c_str());
+    kodi::Log(ADDON_LOG_INFO, "Signal telemetry of %s exported to %s.csv and %s.json",
+              pipeline.GetName().c_str(), base.c_str(), base.c_str());
+    return true;
+}
 
-        // Initialize channel manager
-        m_channel_manager = std::make_unique<ChannelManager>(m_v4l2_device.get());
-        if (!m_channel_manager->Initialize()) {
-            kodi::Log(ADDON_LOG_ERROR, "Failed to initialize channel manager");
-            return false;
-        }
+bool HdmiClient::ToggleRawCapture(CapturePipeline& pipeline) {
+    StreamProcessor& processor = pipeline.GetStreamProcessor();
+    if (processor.IsRawCapturing()) {
+        processor.StopRawCapture();
+        return true;
+    }
 
-        // Initialize stream processor
-        m_stream_processor = std::make_unique<StreamProcessor>(m_v4l2_device.get());
-        if (!m_stream_processor->Initialize()) {
-            kodi::Log(ADDON_LOG_ERROR, "Failed to initialize stream processor");
-            return false;
-        }
+    std::string path = kodi::addon::GetUserPath("raw_capture." + std::to_string(pipeline.GetIndex()) + ".hyraw");
+    if (!processor.StartRawCapture(path)) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to start a raw capture of %s", pipeline.GetName().c_str());
+        return false;
+    }
+    return true;
+}
+
+void HdmiClient::ApplyMetricsExporter() {
+    if (!m_metrics_enabled || !m_initialized.load()) {
+        m_metrics_exporter.Stop();
+        return;
+    }
+    if (m_metrics_exporter.IsRunning()) {
+        return;
+    }
 
-        // Set buffer parameters
-        if (!m_stream_processor->SetBufferParameters(m_buffer_count, 1024 * 1024)) {
-            kodi::Log(ADDON_LOG_WARNING, "Failed to set buffer parameters, using defaults");
+    // The device list is fixed while initialized, the exporter thread only reads it
+    m_metrics_exporter.SetCollector([this](std::string& out) {
+        if (m_devices) {
+            m_devices->AppendMetrics(out);
         }
+    });
+    if (!m_metrics_exporter.Start(m_metrics_endpoint)) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to start the metrics exporter on %s", m_metrics_endpoint.c_str());
+    }
+}
 
-        // Initialize signal monitor with shared V4L2 device
-        auto shared_v4l2 = std::shared_ptr<V4L2Device>(m_v4l2_device.get(), [](V4L2Device*){});
-        m_signal_monitor = std::make_unique<SignalMonitor>(shared_v4l2);
-        if (!m_signal_monitor->Initialize()) {
-            kodi::Log(ADDON_LOG_ERROR, "Failed to initialize signal monitor");
+bool HdmiClient::InitializeComponents() {
+    try {
+        // One capture pipeline per configured device
+        m_devices = std::make_unique<DeviceManager>();
+        if (!m_devices->Initialize(GetDevicePaths(), m_buffer_count,
+                                   static_cast<size_t>(m_capture_memory_mb) * 1024 * 1024, &m_reactor)) {
+            kodi::Log(ADDON_LOG_ERROR, "Failed to initialize capture device: %s", m_device_path.c_str());
             return false;
         }
 
-        // Allocate V4L2 buffers
-        if (!m_v4l2_device->AllocateBuffers(m_buffer_count)) {
-            kodi::Log(ADDON_LOG_ERROR, "Failed to allocate V4L2 buffers");
-            return false;
+        // Recording engine is idle until a timer starts it
+        m_recording_engine = std::make_unique<RecordingEngine>();
+        RecordingEngine* recorder = m_recording_engine.get();
+
+        for (const auto& pipeline : m_devices->GetPipelines()) {
+            ApplyStreamSettings(*pipeline);
+
+            // Only the live pipeline captures, so it is the one feeding the recorder
+            StreamProcessor* processor = &pipeline->GetStreamProcessor();
+            m_recorder_consumers.push_back(processor->AddFrameConsumer(
+                [recorder, processor](const FrameRef& frame) {
+                    // Never blocks - the engine drops frames when storage falls behind
+                    if (recorder->IsRecording()) {
+                        FrameGeometry geometry;
+                        FrameRate frame_rate;
+                        processor->GetFrameFormat(*frame, geometry, frame_rate);
+                        recorder->SubmitFrame(*frame, geometry, frame_rate);
+                    }
+                }));
         }
 
+        m_active_pipeline = m_devices->GetPrimary();
+
         kodi::Log(ADDON_LOG_INFO, "All components initialized successfully");
         return true;
     }
@@ -381,34 +1166,99 @@ bool HdmiClient::InitializeComponents() {
 }
 
 void HdmiClient::ShutdownComponents() {
-    // Shutdown in reverse order
-    if (m_signal_monitor) {
-        m_signal_monitor->Shutdown();
-        m_signal_monitor.reset();
-    }
+    m_active_pipeline = nullptr;
 
-    if (m_stream_processor) {
-        m_stream_processor->Shutdown();
-        m_stream_processor.reset();
+    // Stop feeding the recorder before it goes away
+    if (m_devices) {
+        const auto& pipelines = m_devices->GetPipelines();
+        for (size_t i = 0; i < m_recorder_consumers.size() && i < pipelines.size(); ++i) {
+            pipelines[i]->GetStreamProcessor().RemoveFrameConsumer(m_recorder_consumers[i]);
+        }
     }
+    m_recorder_consumers.clear();
 
-    if (m_channel_manager) {
-        m_channel_manager->Shutdown();
-        m_channel_manager.reset();
+    if (m_recording_engine) {
+        m_recording_engine->Stop();
+        m_recording_engine.reset();
     }
 
-    if (m_v4l2_device) {
-        m_v4l2_device->Close();
-        m_v4l2_device.reset();
+    if (m_devices) {
+        m_devices->Shutdown();
+        m_devices.reset();
     }
 
     kodi::Log(ADDON_LOG_INFO, "All components shut down");
 }
 
+void HdmiClient::ApplyStreamSettings(CapturePipeline& pipeline) {
+    StreamProcessor& processor = pipeline.GetStreamProcessor();
+
+    if (!processor.SetBufferParameters(m_buffer_count, 1024 * 1024)) {
+        kodi::Log(ADDON_LOG_WARNING, "Failed to set buffer parameters, using defaults");
+    }
+
+    // Each device gets its own ring next to the configured one
+    std::string timeshift_path = m_timeshift_path;
+    if (pipeline.GetIndex() > 0) {
+        timeshift_path += "." + std::to_string(pipeline.GetIndex());
+    }
+    processor.SetTimeshift(timeshift_path,
+        m_timeshift_enabled ? static_cast<size_t>(m_timeshift_size_mb) * 1024 * 1024 : 0);
+
+    processor.SetDuplicateFrameSkipping(m_skip_duplicate_frames);
+    processor.SetLetterboxCrop(m_letterbox_crop);
+}
+
+void HdmiClient::ApplyStreamSettingsToIdle(bool release_buffers) {
+    if (!m_devices) {
+        return;
+    }
+
+    // The live pipeline is handled by RestartCapture()
+    for (const auto& pipeline : m_devices->GetPipelines()) {
+        if (pipeline->IsBusy()) {
+            continue;
+        }
+        ApplyStreamSettings(*pipeline);
+        if (release_buffers) {
+            pipeline->ReleaseIdleResources();
+        }
+    }
+}
+
+std::vector<std::string> HdmiClient::GetDevicePaths() const {
+    std::vector<std::string> paths{m_device_path};
+
+    size_t pos = 0;
+    while (pos <= m_extra_device_paths.size()) {
+        size_t comma = m_extra_device_paths.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = m_extra_device_paths.size();
+        }
+
+        std::string path = m_extra_device_paths.substr(pos, comma - pos);
+        path.erase(0, path.find_first_not_of(" \t"));
+        path.erase(path.find_last_not_of(" \t") + 1);
+        if (!path.empty() && std::find(paths.begin(), paths.end(), path) == paths.end()) {
+            paths.push_back(path);
+        }
+        pos = comma + 1;
+    }
+
+    return paths;
+}
+
 bool HdmiClient::LoadSettings() {
     try {
         // Load device path setting
         m_device_path = kodi::addon::GetSettingString("device_path", "/dev/video0");
+
+        // Load additional capture devices, each one gets its own channel group
+        m_extra_device_paths = kodi::addon::GetSettingString("extra_device_paths", "");
+
+        // Load frame memory budget shared by all devices
+        m_capture_memory_mb = static_cast<uint32_t>(
+            std::clamp(kodi::addon::GetSettingInt("capture_memory_mb", 64), 8, 1024));
         
         // Load buffer count setting  
         m_buffer_count = static_cast<uint32_t>(kodi::addon::GetSettingInt("buffer_count", 4));
@@ -416,15 +1266,51 @@ bool HdmiClient::LoadSettings() {
         if (m_buffer_count > 16) m_buffer_count = 16;
         
         // Load hardware decoding setting
-        m_hardware_decoding = kodi::addon::GetSettingBoolean("hardware_decoding", true);
+        m_hardware_decoding.store(kodi::addon::GetSettingBoolean("hardware_decoding", true));
         
         // Load audio enabled setting
-        m_audio_enabled = kodi::addon::GetSettingBoolean("audio_enabled", true);
+        m_audio_enabled.store(kodi::addon::GetSettingBoolean("audio_enabled", true));
+
+        // Load warm standby grace period (0 disables standby)
+        m_standby_grace_s = static_cast<uint32_t>(
+            std::max(kodi::addon::GetSettingInt("standby_grace_seconds", 10), 0));
+        if (m_standby_grace_s > 300) m_standby_grace_s = 300;
+
+        // Load timeshift settings
+        m_timeshift_enabled = kodi::addon::GetSettingBoolean("timeshift_enabled", false);
+        m_timeshift_path = kodi::addon::GetSettingString("timeshift_path", "/dev/shm/pvr.hdmi-input.timeshift");
+        m_timeshift_size_mb = static_cast<uint32_t>(
+            std::clamp(kodi::addon::GetSettingInt("timeshift_size_mb", 256), 16, 4096));
+
+        // Load duplicate frame elimination
+        m_skip_duplicate_frames = kodi::addon::GetSettingBoolean("skip_duplicate_frames", true);
+
+        // Load automatic letterbox cropping
+        m_letterbox_crop = kodi::addon::GetSettingBoolean("letterbox_crop", false);
+
+        // Load recording location, the add-on profile when none is set
+        m_recording_path = kodi::addon::GetSettingString("recording_path", "");
+        if (m_recording_path.empty()) {
+            m_recording_path = kodi::addon::GetUserPath("recordings");
+        }
+
+        // Load pipeline tracing
+        m_trace_enabled = kodi::addon::GetSettingBoolean("trace_enabled", false);
+        if (m_trace_enabled && !EnableTracing()) {
+            m_trace_enabled = false;
+        }
+
+        // Load metrics exporter, started once the devices exist
+        m_metrics_enabled = kodi::addon::GetSettingBoolean("metrics_enabled", false);
+        m_metrics_endpoint = kodi::addon::GetSettingString("metrics_endpoint", "9465");
+        if (m_metrics_endpoint.empty()) {
+            m_metrics_endpoint = "9465";
+        }
 
         kodi::Log(ADDON_LOG_INFO, "Settings loaded - Device: %s, Buffers: %u, HW Decode: %s, Audio: %s",
                   m_device_path.c_str(), m_buffer_count,
-                  m_hardware_decoding ? "enabled" : "disabled",
-                  m_audio_enabled ? "enabled" : "disabled");
+                  m_hardware_decoding.load() ? "enabled" : "disabled",
+                  m_audio_enabled.load() ? "enabled" : "disabled");
 
         return true;
     }
@@ -434,41 +1320,220 @@ bool HdmiClient::LoadSettings() {
     }
 }
 
-void HdmiClient::MonitorThread() {
-    kodi::Log(ADDON_LOG_DEBUG, "Monitor thread started");
+StreamProcessor* HdmiClient::GetActiveStreamProcessor() const {
+    CapturePipeline* pipeline = GetActivePipeline();
+    return pipeline ? &pipeline->GetStreamProcessor() : nullptr;
+}
+
+uint32_t HdmiClient::GetActiveChannelUid() const {
+    CapturePipeline* pipeline = GetActivePipeline();
+    return pipeline ? pipeline->ToChannelUid(pipeline->GetChannelManager().GetActiveChannel()) : 0;
+}
+
+std::string HdmiClient::GetChannelName(uint32_t channel_uid) const {
+    CapturePipeline* pipeline = m_devices ? m_devices->FindPipelineForChannel(channel_uid) : nullptr;
+    if (!pipeline) {
+        return "HDMI Input";
+    }
+    return pipeline->GetChannelManager().GetChannelName(CapturePipeline::ToChannelId(channel_uid));
+}
+
+uint32_t HdmiClient::GetLockTimeout(const CapturePipeline& pipeline) const {
+    const ChannelManager& channels = pipeline.GetChannelManager();
+    InputSource input;
+    if (channels.GetInputSource(channels.GetCurrentInput(), input) && input.detection_timeout_ms > 0) {
+        return input.detection_timeout_ms;
+    }
+    return DEFAULT_LOCK_TIMEOUT_MS;
+}
 
-    while (!m_shutdown_requested.load()) {
-        try {
-            UpdateSignalStatus();
-            
-            // Sleep for 1 second before next update
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+void HdmiClient::NegotiateCaptureFormat(V4L2Device& device, VideoFormat& format) {
+    // Every consumer has to handle the format: the demux output describes
+    // raw layouts only and letterbox detection needs to locate the luma
+    std::vector<uint32_t> accepted;
+    for (uint32_t fourcc : FormatNegotiator::GetRawFormats()) {
+        if (!m_letterbox_crop || LetterboxDetector::SupportsFormat(fourcc)) {
+            accepted.push_back(fourcc);
         }
-        catch (const std::exception& e) {
-            kodi::Log(ADDON_LOG_ERROR, "Exception in monitor thread: %s", e.what());
-            std::this_thread::sleep_for(std::chrono::seconds(5));
+    }
+    m_format_negotiator.SetAcceptedFormats(accepted);
+
+    FormatCandidate choice;
+    if (m_format_negotiator.Negotiate(device.GetPixelFormats(), format, choice)) {
+        format.fourcc = choice.fourcc;
+    } else {
+        kodi::Log(ADDON_LOG_WARNING, "Format negotiation failed, keeping %s",
+                  format.fourcc ? FormatNegotiator::FourCCToString(format.fourcc).c_str() : "driver default");
+    }
+}
+
+bool HdmiClient::ConfigureCaptureFormat(V4L2Device& device, const VideoFormat& format) {
+    VideoFormat requested = format;
+    VideoFormat configured = device.GetConfiguredFormat();
+    if (requested.fourcc == 0) {
+        requested.fourcc = configured.fourcc;
+    }
+
+    // Same source format as the last stream - keep the mapped buffers
+    if (requested == configured && device.GetBufferCount() > 0) {
+        kodi::Log(ADDON_LOG_DEBUG, "Capture format unchanged (%s), reusing buffers",
+                  configured.to_string().c_str());
+        return true;
+    }
+
+    // Drivers refuse S_FMT while buffers are allocated
+    device.DeallocateBuffers();
+
+    if (!device.SetFormat(format)) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to set video format: %s", format.to_string().c_str());
+        return false;
+    }
+
+    if (!device.AllocateBuffers(m_buffer_count)) {
+        kodi::Log(ADDON_LOG_ERROR, "Failed to allocate V4L2 buffers");
+        return false;
+    }
+
+    uint32_t actual_fourcc = device.GetConfiguredFormat().fourcc;
+    if (format.fourcc != 0 && actual_fourcc != format.fourcc) {
+        kodi::Log(ADDON_LOG_WARNING, "Driver replaced pixel format %s with %s",
+                  FormatNegotiator::FourCCToString(format.fourcc).c_str(),
+                  FormatNegotiator::FourCCToString(actual_fourcc).c_str());
+    }
+
+    kodi::Log(ADDON_LOG_INFO, "Capture format configured: %s %s, %u bytes/frame", format.to_string().c_str(),
+              FormatNegotiator::FourCCToString(actual_fourcc).c_str(), device.GetFrameSize());
+    return true;
+}
+
+bool HdmiClient::ResumeStandby(uint32_t channel_uid) {
+    std::lock_guard<std::mutex> lock(m_standby_mutex);
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!processor || !processor->IsInStandby()) {
+        return false;
+    }
+
+    if (channel_uid != m_standby_channel) {
+        // Different channel or device - the warm capture is of no use
+        if (m_recording_engine && m_recording_engine->IsRecording()) {
+            kodi::Log(ADDON_LOG_WARNING, "Channel switch ends the recording of channel %u", m_standby_channel);
+            m_recording_engine->Stop();
         }
+        processor->StopStreaming();
+        return false;
     }
 
-    kodi::Log(ADDON_LOG_DEBUG, "Monitor thread stopped");
+    return processor->ResumeFromStandby();
 }
 
-void HdmiClient::UpdateSignalStatus() {
-    if (!m_v4l2_device || !m_signal_monitor) {
+void HdmiClient::ExpireStandby(bool force) {
+    std::lock_guard<std::mutex> lock(m_standby_mutex);
+    StreamProcessor* processor = GetActiveStreamProcessor();
+    if (!processor || !processor->IsInStandby()) {
         return;
     }
 
-    // Force signal status update
-    m_signal_monitor->UpdateSignalStatus();
+    // Capture keeps feeding the recorder until the recording ends
+    if (!force && m_recording_engine && m_recording_engine->IsRecording()) {
+        return;
+    }
 
-    // Update channel status if channel manager exists
-    if (m_channel_manager) {
-        SignalStatus status = m_signal_monitor->GetSignalStatus();
-        uint32_t active_channel = m_channel_manager->GetActiveChannel();
-        if (active_channel > 0) {
-            m_channel_manager->UpdateChannelStatus(active_channel, status);
+    if (force || std::chrono::steady_clock::now() >= m_standby_deadline) {
+        kodi::Log(ADDON_LOG_DEBUG, "Warm standby expired for channel %u", m_standby_channel);
+        processor->StopStreaming();
+    }
+}
+
+void HdmiClient::StopRecording(const char* reason) {
+    if (!m_recording_engine || !m_recording_engine->IsRecording()) {
+        return;
+    }
+
+    kodi::Log(ADDON_LOG_INFO, "Stopping recording: %s", reason);
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        m_recording_engine->Stop();
+        m_recording_end = 0;
+    }
+
+    NotifyTimersChanged();
+    NotifyRecordingsChanged();
+}
+
+void HdmiClient::ExpireRecording() {
+    time_t end;
+    {
+        std::lock_guard<std::mutex> lock(m_recording_mutex);
+        end = m_recording_end;
+    }
+
+    if (end > 0 && time(nullptr) >= end) {
+        StopRecording("end time reached");
+    }
+}
+
+void HdmiClient::NotifyTimersChanged() const {
+    if (m_timers_changed) {
+        m_timers_changed();
+    }
+}
+
+void HdmiClient::NotifyRecordingsChanged() const {
+    if (m_recordings_changed) {
+        m_recordings_changed();
+    }
+}
+
+void HdmiClient::NotifyChannelsChanged() const {
+    if (m_channels_changed) {
+        m_channels_changed();
+    }
+}
+
+std::string HdmiClient::GetRecordingFilePath(const std::string& recording_id) const {
+    // Recording ids are bare file names - never let them escape the directory
+    if (recording_id.empty() || recording_id.find('/') != std::string::npos) {
+        return std::string();
+    }
+    return m_recording_path + "/" + recording_id;
+}
+
+void HdmiClient::MonitorTick() {
+    if (m_shutdown_requested.load()) {
+        return;
+    }
+
+    // The pipelines poll their signal on timers of their own
+    if (m_devices) {
+        m_devices->RecordTelemetry();
+    }
+    ExpireRecording();
+    ExpireStandby(false);
+}
+
+void HdmiClient::StartDevices() {
+    auto start_time = std::chrono::steady_clock::now();
+    size_t started = 0;
+
+    for (const auto& pipeline : m_devices->GetPipelines()) {
+        if (m_shutdown_requested.load()) {
+            return;
+        }
+        if (m_devices->Start(*pipeline)) {
+            ++started;
+        } else {
+            kodi::Log(ADDON_LOG_WARNING, "Capture device %s not available, retrying when tuned",
+                      pipeline->GetDevicePath().c_str());
         }
     }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    kodi::Log(ADDON_LOG_INFO, "%zu of %zu capture device(s) started in %lld ms", started,
+              m_devices->GetPipelines().size(), static_cast<long long>(elapsed.count()));
+
+    // Probing may have found new inputs and group names follow the card names
+    NotifyChannelsChanged();
 }
 
 } // namespace hdmi_pvr
\ No newline at end of file
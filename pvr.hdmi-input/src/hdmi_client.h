@@ -1,14 +1,20 @@
 #pragma once
 
 #include "types.h"
-#include "v4l2_device.h"
-#include "channel_manager.h"
-#include "stream_processor.h"
-#include "signal_monitor.h"
+#include "device_manager.h"
+#include "recording_engine.h"
+#include "recording_player.h"
+#include "format_negotiator.h"
+#include "metrics_exporter.h"
+#include "reactor.h"
 #include <kodi/addon-instance/PVR.h>
 #include <memory>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <vector>
 
 namespace hdmi_pvr {
 
@@ -18,16 +24,39 @@ public:
     ~HdmiClient();
 
     // Initialization and lifecycle
+    // Initialize() returns once settings and channel configuration are
+    // loaded; capture devices come up on the reactor thread afterwards, or
+    // on the first stream opened before that
     bool Initialize();
     void Shutdown();
 
-    // Settings management
-    bool SetSetting(const std::string& settingName, const kodi::addon::CSettingValue& settingValue);
+    // Notifications back to Kodi (set by the add-on instance before Initialize)
+    void SetUpdateCallbacks(std::function<void()> timers_changed, std::function<void()> recordings_changed,
+                            std::function<void()> channels_changed) {
+        m_timers_changed = std::move(timers_changed);
+        m_recordings_changed = std::move(recordings_changed);
+        m_channels_changed = std::move(channels_changed);
+    }
+
+    // Settings management - applied to the running pipelines, the result
+    // only asks for a restart when the number of capture devices or the
+    // demux capability changes
+    ADDON_STATUS SetSetting(const std::string& settingName, const kodi::addon::CSettingValue& settingValue);
+
+    // Kodi reads the capabilities once per add-on instance, so a change of
+    // hardware_decoding asks for a restart
+    bool HandlesDemuxing() const { return m_hardware_decoding.load(); }
 
     // Channel operations
     int GetChannelCount() const;
     PVR_ERROR GetChannels(kodi::addon::PVRChannelsResultSet& results);
 
+    // Channel groups (one per capture device)
+    PVR_ERROR GetChannelGroupsAmount(int& amount) const;
+    PVR_ERROR GetChannelGroups(kodi::addon::PVRChannelGroupsResultSet& results) const;
+    PVR_ERROR GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group,
+                                     kodi::addon::PVRChannelGroupMembersResultSet& results) const;
+
     // EPG operations
     PVR_ERROR GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results);
 
@@ -35,7 +64,34 @@ public:
     bool OpenLiveStream(const kodi::addon::PVRChannel& channel);
     void CloseLiveStream();
     int ReadLiveStream(unsigned char* buffer, unsigned int size);
-    PVR_ERROR GetStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties);
+    PVR_ERROR GetStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties,
+                                  const StreamProcessor::CodecLookup& lookup);
+
+    // Timeshift operations
+    bool CanPauseStream() const;
+    bool CanSeekStream() const;
+    void PauseStream(bool paused);
+    int64_t SeekLiveStream(int64_t position, int whence);
+    int64_t LengthLiveStream() const;
+    bool IsRealTimeStream() const;
+    PVR_ERROR GetStreamTimes(kodi::addon::PVRStreamTimes& times) const;
+
+    // Timer operations (instant recording of the live channel)
+    PVR_ERROR GetTimerTypes(std::vector<kodi::addon::PVRTimerType>& types) const;
+    PVR_ERROR GetTimersAmount(int& amount) const;
+    PVR_ERROR GetTimers(kodi::addon::PVRTimersResultSet& results) const;
+    PVR_ERROR AddTimer(const kodi::addon::PVRTimer& timer);
+    PVR_ERROR DeleteTimer(const kodi::addon::PVRTimer& timer, bool forceDelete);
+
+    // Recording operations
+    PVR_ERROR GetRecordingsAmount(int& amount) const;
+    PVR_ERROR GetRecordings(kodi::addon::PVRRecordingsResultSet& results) const;
+    PVR_ERROR DeleteRecording(const kodi::addon::PVRRecording& recording);
+    bool OpenRecordedStream(const kodi::addon::PVRRecording& recording);
+    void CloseRecordedStream();
+    int ReadRecordedStream(unsigned char* buffer, unsigned int size);
+    int64_t SeekRecordedStream(int64_t position, int whence);
+    int64_t LengthRecordedStream() const;
 
     // Signal status
     PVR_ERROR GetSignalStatus(int channelUid, kodi::addon::PVRSignalStatus& signalStatus);
@@ -43,41 +99,109 @@ public:
     // Demux operations for hardware-accelerated streaming
     bool OpenDemuxStream(const kodi::addon::PVRChannel& channel);
     void CloseDemuxStream();
-    DEMUX_PACKET* DemuxRead();
+    DEMUX_PACKET* DemuxRead(const StreamProcessor::DemuxPacketAllocator& allocate);
     void DemuxAbort();
     void DemuxFlush();
     void DemuxReset();
+    bool DemuxSeekTime(double time_ms, bool backwards, double& start_pts);
 
     // Menu hooks
-    PVR_ERROR CallMenuHook(const kodi::addon::PVRMenuhook& menuhook, const kodi::addon::PVRChannel& channel);
+    PVR_ERROR CallChannelMenuHook(const kodi::addon::PVRMenuhook& menuhook, const kodi::addon::PVRChannel& channel);
 
 private:
+    // Event loop for device I/O, signal polling and expiry timers - declared
+    // first so it outlives the pipelines watching descriptors on it
+    Reactor m_reactor;
+    int m_monitor_timer{0};
+    static constexpr uint32_t MONITOR_INTERVAL_MS = 1000;
+
     // Component instances
-    std::unique_ptr<V4L2Device> m_v4l2_device;
-    std::unique_ptr<ChannelManager> m_channel_manager;
-    std::unique_ptr<StreamProcessor> m_stream_processor;
-    std::unique_ptr<SignalMonitor> m_signal_monitor;
+    std::unique_ptr<DeviceManager> m_devices;
+    std::atomic<CapturePipeline*> m_active_pipeline{nullptr};  ///< Device serving the live stream
+    std::unique_ptr<RecordingEngine> m_recording_engine;
+    std::vector<int> m_recorder_consumers;  ///< Frame consumer per pipeline feeding m_recording_engine
+    FormatNegotiator m_format_negotiator;
+    MetricsExporter m_metrics_exporter;  ///< Serves m_devices, stopped before they go
 
     // State management
     std::atomic<bool> m_initialized{false};
     std::atomic<bool> m_streaming{false};
     std::atomic<bool> m_shutdown_requested{false};
 
-    // Threading
-    std::thread m_monitor_thread;
-    void MonitorThread();
+    void MonitorTick();
 
     // Configuration
     std::string m_device_path{"/dev/video0"};
+    std::string m_extra_device_paths;  ///< Further capture devices, comma separated
+    uint32_t m_capture_memory_mb{64};  ///< Frame pool budget of all devices together
     uint32_t m_buffer_count{4};
-    bool m_hardware_decoding{true};
-    bool m_audio_enabled{true};
+    std::atomic<bool> m_hardware_decoding{true};  ///< Frames go to Kodi's decoders through DemuxRead
+    std::atomic<bool> m_audio_enabled{true};      ///< Audio stream announced by the pipeline
+    uint32_t m_standby_grace_s{10};
+    bool m_timeshift_enabled{false};
+    std::string m_timeshift_path{"/dev/shm/pvr.hdmi-input.timeshift"};
+    uint32_t m_timeshift_size_mb{256};
+    std::string m_recording_path;
+    bool m_skip_duplicate_frames{true};
+    bool m_letterbox_crop{false};
+    bool m_trace_enabled{false};  ///< Pipeline trace points to ftrace
+    bool m_metrics_enabled{false};
+    std::string m_metrics_endpoint{"9465"};  ///< Loopback port or Unix socket path
+
+    // Active recording (one timer at a time, always the live channel)
+    mutable std::mutex m_recording_mutex;
+    uint32_t m_recording_channel{0};  ///< Channel unique id
+    std::string m_recording_title;
+    time_t m_recording_start{0};
+    time_t m_recording_end{0};  ///< 0 = until deleted
+    int m_recorded_fd{-1};      ///< Recording being played back, for byte-stream reads
+    RecordingPlayer m_recording_player;  ///< Same recording, for demux reads
+    std::function<void()> m_timers_changed;
+    std::function<void()> m_recordings_changed;
+    std::function<void()> m_channels_changed;
+    static constexpr unsigned int TIMER_TYPE_INSTANT = 1;
+    static constexpr unsigned int TIMER_INDEX_ACTIVE = 1;
+
+    // Warm standby state (capture kept running after CloseLiveStream)
+    std::mutex m_standby_mutex;
+    uint32_t m_standby_channel{0};  ///< Channel unique id
+    std::chrono::steady_clock::time_point m_standby_deadline;
+    static constexpr uint32_t STANDBY_RING_FRAMES = 3;
+
+    // Default lock wait when the channel has no detection timeout configured
+    static constexpr uint32_t DEFAULT_LOCK_TIMEOUT_MS = 3000;
 
     // Internal helpers
     bool InitializeComponents();
+    bool ExportTelemetry(const CapturePipeline& pipeline) const;
+    bool ToggleRawCapture(CapturePipeline& pipeline);
+    void ApplyMetricsExporter();
     void ShutdownComponents();
     bool LoadSettings();
-    void UpdateSignalStatus();
+    void StartDevices();
+    std::vector<std::string> GetDevicePaths() const;
+    void ApplyStreamSettings(CapturePipeline& pipeline);
+    void ApplyStreamSettingsToIdle(bool release_buffers);
+    bool ApplyDevicePaths();
+    bool StartCapture(CapturePipeline& pipeline, uint32_t channel_uid);
+    bool BringUpCapture(CapturePipeline& pipeline, uint32_t channel_uid);
+    bool RestartCapture(const char* reason, bool remap_buffers);
+    CapturePipeline* GetActivePipeline() const { return m_active_pipeline.load(); }
+    StreamProcessor* GetActiveStreamProcessor() const;
+    uint32_t GetActiveChannelUid() const;
+    std::string GetChannelName(uint32_t channel_uid) const;
+    uint32_t GetLockTimeout(const CapturePipeline& pipeline) const;
+    bool ResumeStandby(uint32_t channel_uid);
+    void ExpireStandby(bool force);
+    AudioFormat GetAudioFormat() const;
+    void NegotiateCaptureFormat(V4L2Device& device, VideoFormat& format);
+    bool ConfigureCaptureFormat(V4L2Device& device, const VideoFormat& format);
+    void StopRecording(const char* reason);
+    void ExpireRecording();
+    void NotifyTimersChanged() const;
+    void NotifyRecordingsChanged() const;
+    void NotifyChannelsChanged() const;
+    std::string GetRecordingFilePath(const std::string& recording_id) const;
 };
 
 } // namespace hdmi_pvr
\ No newline at end of file
@@ -0,0 +1,244 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Letterbox Detection Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "letterbox_detector.h"
+#include <linux/videodev2.h>
+#include <algorithm>
+
+namespace hdmi_pvr {
+
+namespace {
+
+// Byte layout of the luma (or green) component of one pixel
+struct LumaLayout {
+    uint32_t pixel_stride = 0;  ///< Bytes between horizontally adjacent samples
+    uint32_t offset = 0;        ///< Offset of the sample within the pixel
+};
+
+bool GetLumaLayout(uint32_t fourcc, LumaLayout& layout) {
+    switch (fourcc) {
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_YVYU:
+            layout = {2, 0};
+            return true;
+        case V4L2_PIX_FMT_UYVY:
+        case V4L2_PIX_FMT_VYUY:
+            layout = {2, 1};
+            return true;
+        case V4L2_PIX_FMT_NV12:
+        case V4L2_PIX_FMT_NV21:
+        case V4L2_PIX_FMT_NV16:
+        case V4L2_PIX_FMT_NV61:
+        case V4L2_PIX_FMT_YUV420:
+        case V4L2_PIX_FMT_YVU420:
+        case V4L2_PIX_FMT_GREY:
+            layout = {1, 0};  // Luma plane comes first
+            return true;
+        case V4L2_PIX_FMT_RGB24:
+        case V4L2_PIX_FMT_BGR24:
+            layout = {3, 1};  // Green carries most of the luminance
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline bool IsBlackRow(const uint8_t* row, const LumaLayout& layout, uint32_t width, uint8_t threshold,
+                       uint32_t samples) {
+    uint32_t step = std::max<uint32_t>(width / samples, 1);
+    for (uint32_t x = step / 2; x < width; x += step) {
+        if (row[x * layout.pixel_stride + layout.offset] > threshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool IsBlackColumn(const uint8_t* data, const LumaLayout& layout, uint32_t bytes_per_line,
+                          uint32_t x, uint32_t first_row, uint32_t last_row, uint8_t threshold,
+                          uint32_t samples) {
+    uint32_t rows = last_row - first_row;
+    uint32_t step = std::max<uint32_t>(rows / samples, 1);
+    const uint8_t* column = data + x * layout.pixel_stride + layout.offset;
+    for (uint32_t y = first_row + step / 2; y < last_row; y += step) {
+        if (column[static_cast<size_t>(y) * bytes_per_line] > threshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool LetterboxDetector::SupportsFormat(uint32_t fourcc) {
+    LumaLayout layout;
+    return GetLumaLayout(fourcc, layout);
+}
+
+void LetterboxDetector::Reset(const CropRect& bounds) {
+    m_bounds = bounds;
+    m_crop = bounds;
+    m_pending = {};
+    m_stable_count = 0;
+    m_required_stable = STABLE_ANALYSES;
+    m_expand_count = 0;
+}
+
+void LetterboxDetector::SetApplied(const CropRect& crop) {
+    m_crop = crop;
+    m_pending = {};
+    m_stable_count = 0;
+    m_expand_count = 0;
+}
+
+bool LetterboxDetector::Analyze(const uint8_t* data, const FrameGeometry& geometry, CropRect& new_crop) {
+    if (!data || !m_bounds.is_valid() || !m_crop.is_valid()) {
+        return false;
+    }
+
+    Bars bars;
+    if (!DetectBars(data, geometry, bars)) {
+        return false;  // Black screen or unsupported - nothing to learn
+    }
+
+    // Map the bars from frame pixels into full capture coordinates; a
+    // scaling bridge may deliver the crop at a different size
+    auto scale_x = [&](uint32_t v) { return static_cast<uint32_t>(uint64_t(v) * m_crop.width / geometry.width); };
+    auto scale_y = [&](uint32_t v) { return static_cast<uint32_t>(uint64_t(v) * m_crop.height / geometry.height); };
+    Bars full = {scale_y(bars.top), scale_y(bars.bottom), scale_x(bars.left), scale_x(bars.right)};
+
+    // Picture reaching into the guard band of a cropped edge - release at once
+    bool top_cropped = m_crop.top > m_bounds.top;
+    bool bottom_cropped = m_crop.top + m_crop.height < m_bounds.top + m_bounds.height;
+    bool left_cropped = m_crop.left > m_bounds.left;
+    bool right_cropped = m_crop.left + m_crop.width < m_bounds.left + m_bounds.width;
+    uint32_t guard_hit = GUARD_BAND / 2;
+    if ((top_cropped && full.top < guard_hit) || (bottom_cropped && full.bottom < guard_hit) ||
+        (left_cropped && full.left < guard_hit) || (right_cropped && full.right < guard_hit)) {
+        m_stable_count = 0;
+        if (++m_expand_count >= EXPAND_ANALYSES) {
+            m_required_stable = std::min(m_required_stable * 2, MAX_STABLE_ANALYSES);
+            new_crop = m_bounds;
+            return true;
+        }
+        return false;
+    }
+    m_expand_count = 0;
+
+    // Bars thinner than this are overscan noise, not letterboxing
+    uint32_t min_bar_y = std::max<uint32_t>(m_bounds.height / 50, GUARD_BAND * 2);
+    uint32_t min_bar_x = std::max<uint32_t>(m_bounds.width / 50, GUARD_BAND * 2);
+
+    uint32_t top = m_crop.top + full.top;
+    uint32_t bottom = m_crop.top + m_crop.height - full.bottom;
+    uint32_t left = m_crop.left + full.left;
+    uint32_t right = m_crop.left + m_crop.width - full.right;
+
+    // Keep the guard band, drop insignificant bars, align for chroma subsampling
+    top = (top - m_bounds.top < min_bar_y) ? m_bounds.top : (top - GUARD_BAND) & ~1u;
+    bottom = (m_bounds.top + m_bounds.height - bottom < min_bar_y) ? m_bounds.top + m_bounds.height
+             : std::min((bottom + GUARD_BAND + 1) & ~1u, m_bounds.top + m_bounds.height);
+    left = (left - m_bounds.left < min_bar_x) ? m_bounds.left : (left - GUARD_BAND) & ~15u;
+    right = (m_bounds.left + m_bounds.width - right < min_bar_x) ? m_bounds.left + m_bounds.width
+            : std::min((right + GUARD_BAND + 15) & ~15u, m_bounds.left + m_bounds.width);
+
+    // Never grow beyond the current crop here - growing goes through the guard band
+    top = std::max(top, m_crop.top);
+    bottom = std::min(bottom, m_crop.top + m_crop.height);
+    left = std::max(left, m_crop.left);
+    right = std::min(right, m_crop.left + m_crop.width);
+
+    CropRect target = {left, top, right - left, bottom - top};
+    if (IsClose(target, m_crop)) {
+        m_stable_count = 0;
+        return false;
+    }
+
+    if (m_stable_count > 0 && IsClose(target, m_pending)) {
+        // Settle on the union, so content seen at any point stays inside
+        uint32_t p_right = std::max(m_pending.left + m_pending.width, target.left + target.width);
+        uint32_t p_bottom = std::max(m_pending.top + m_pending.height, target.top + target.height);
+        m_pending.left = std::min(m_pending.left, target.left);
+        m_pending.top = std::min(m_pending.top, target.top);
+        m_pending.width = p_right - m_pending.left;
+        m_pending.height = p_bottom - m_pending.top;
+        ++m_stable_count;
+    } else {
+        m_pending = target;
+        m_stable_count = 1;
+    }
+
+    if (m_stable_count >= m_required_stable) {
+        new_crop = m_pending;
+        m_stable_count = 0;
+        return true;
+    }
+
+    return false;
+}
+
+bool LetterboxDetector::DetectBars(const uint8_t* data, const FrameGeometry& geometry, Bars& bars) {
+    LumaLayout layout;
+    if (!GetLumaLayout(geometry.fourcc, layout) || geometry.width == 0 || geometry.height == 0) {
+        return false;
+    }
+
+    uint32_t bytes_per_line = geometry.bytes_per_line > 0 ? geometry.bytes_per_line
+                                                          : geometry.width * layout.pixel_stride;
+
+    // Bars larger than a third of the picture are a dark scene, not letterboxing
+    uint32_t max_rows = geometry.height / 3;
+    uint32_t max_cols = geometry.width / 3;
+
+    uint32_t top = 0;
+    while (top < max_rows && IsBlackRow(data + static_cast<size_t>(top) * bytes_per_line, layout,
+                                        geometry.width, BLACK_THRESHOLD, SAMPLES_PER_LINE)) {
+        ++top;
+    }
+    if (top == max_rows && IsBlackRow(data + static_cast<size_t>(geometry.height / 2) * bytes_per_line,
+                                      layout, geometry.width, BLACK_THRESHOLD, SAMPLES_PER_LINE)) {
+        return false;  // Entirely black
+    }
+
+    uint32_t bottom = 0;
+    while (bottom < max_rows &&
+           IsBlackRow(data + static_cast<size_t>(geometry.height - 1 - bottom) * bytes_per_line, layout,
+                      geometry.width, BLACK_THRESHOLD, SAMPLES_PER_LINE)) {
+        ++bottom;
+    }
+
+    // Columns are only sampled within the active rows
+    uint32_t first_row = top;
+    uint32_t last_row = geometry.height - bottom;
+
+    uint32_t left = 0;
+    while (left < max_cols && IsBlackColumn(data, layout, bytes_per_line, left, first_row, last_row,
+                                            BLACK_THRESHOLD, SAMPLES_PER_LINE)) {
+        ++left;
+    }
+
+    uint32_t right = 0;
+    while (right < max_cols && IsBlackColumn(data, layout, bytes_per_line, geometry.width - 1 - right,
+                                             first_row, last_row, BLACK_THRESHOLD, SAMPLES_PER_LINE)) {
+        ++right;
+    }
+
+    bars = {top == max_rows ? 0 : top, bottom == max_rows ? 0 : bottom,
+            left == max_cols ? 0 : left, right == max_cols ? 0 : right};
+    return true;
+}
+
+bool LetterboxDetector::IsClose(const CropRect& a, const CropRect& b) {
+    auto near = [](uint32_t x, uint32_t y) {
+        return (x > y ? x - y : y - x) <= POSITION_TOLERANCE;
+    };
+    return near(a.left, b.left) && near(a.top, b.top) &&
+           near(a.left + a.width, b.left + b.width) && near(a.top + a.height, b.top + b.height);
+}
+
+} // namespace hdmi_pvr
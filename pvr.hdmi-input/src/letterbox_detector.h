@@ -0,0 +1,101 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace hdmi_pvr {
+
+/**
+ * LetterboxDetector finds the active picture inside black bars and decides
+ * when the capture crop should change.
+ *
+ * Only border rows and columns are sampled. The crop keeps a thin band of
+ * black around the picture; when that guard band lights up (aspect change,
+ * subtitles drawn into the bar) the crop is released at once, while a new
+ * or tighter crop is only applied after the bounds stayed stable for a
+ * while. Every release doubles that waiting time so content that keeps
+ * touching the bars cannot make the crop flap.
+ *
+ * Not thread-safe; used from the capture thread only.
+ */
+class LetterboxDetector {
+public:
+    LetterboxDetector() = default;
+
+    /**
+     * Start over for a new stream
+     * @param bounds Full capture area (no crop applied)
+     */
+    void Reset(const CropRect& bounds);
+
+    /**
+     * Analyze a captured frame
+     * @param data Frame data, captured with the crop last reported by SetApplied()
+     * @param geometry Layout of the captured frame
+     * @param new_crop Crop to apply, in full capture coordinates
+     * @return true if the crop should be changed to new_crop
+     */
+    bool Analyze(const uint8_t* data, const FrameGeometry& geometry, CropRect& new_crop);
+
+    /**
+     * Record the crop that is now active
+     * @param crop Crop as accepted by the driver
+     */
+    void SetApplied(const CropRect& crop);
+
+    /**
+     * Get the crop currently in effect
+     */
+    const CropRect& GetCurrentCrop() const { return m_crop; }
+
+    /**
+     * Check if a pixel format can be analyzed
+     * @param fourcc V4L2 pixel format
+     * @return true if the luma of the format can be sampled
+     */
+    static bool SupportsFormat(uint32_t fourcc);
+
+private:
+    struct Bars {
+        uint32_t top = 0;
+        uint32_t bottom = 0;
+        uint32_t left = 0;
+        uint32_t right = 0;
+    };
+
+    static constexpr uint8_t BLACK_THRESHOLD = 32;     ///< Max luma counted as black (limited range black is 16)
+    static constexpr uint32_t SAMPLES_PER_LINE = 64;   ///< Pixels sampled per row or column
+    static constexpr uint32_t GUARD_BAND = 8;          ///< Black rows/columns kept inside the crop
+    static constexpr uint32_t POSITION_TOLERANCE = 4;  ///< Jitter accepted between analyses
+    static constexpr uint32_t STABLE_ANALYSES = 20;    ///< Stable analyses before cropping
+    static constexpr uint32_t MAX_STABLE_ANALYSES = 160;
+    static constexpr uint32_t EXPAND_ANALYSES = 2;     ///< Guard band hits before releasing the crop
+
+    CropRect m_bounds;              ///< Full capture area
+    CropRect m_crop;                ///< Crop currently applied
+    CropRect m_pending;             ///< Candidate crop being confirmed
+    uint32_t m_stable_count = 0;
+    uint32_t m_required_stable = STABLE_ANALYSES;
+    uint32_t m_expand_count = 0;
+
+    /**
+     * Measure black bars of a frame
+     * @return false if the frame is entirely black or cannot be analyzed
+     */
+    static bool DetectBars(const uint8_t* data, const FrameGeometry& geometry, Bars& bars);
+
+    /**
+     * Check if two rectangles differ by no more than POSITION_TOLERANCE
+     */
+    static bool IsClose(const CropRect& a, const CropRect& b);
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,51 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Logging Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "log.h"
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+namespace hdmi_pvr {
+
+namespace {
+
+void StderrSink(LogLevel level, const char* message) {
+    static const char* const names[] = {"debug", "info", "warning", "error"};
+    fprintf(stderr, "[%s] %s\n", names[static_cast<int>(level)], message);
+}
+
+std::atomic<LogSink> g_sink{StderrSink};
+std::atomic<LogLevel> g_minimum{LogLevel::Debug};
+
+} // namespace
+
+void SetLogSink(LogSink sink) {
+    g_sink.store(sink ? sink : StderrSink);
+}
+
+void SetLogLevel(LogLevel minimum) {
+    g_minimum.store(minimum);
+}
+
+void Log(LogLevel level, const char* format, ...) {
+    if (level < g_minimum.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Long enough for every message of the core; longer ones are truncated
+    char message[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    g_sink.load()(level, message);
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,47 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+namespace hdmi_pvr {
+
+/**
+ * Logging of the capture core, so it runs without Kodi.
+ *
+ * Messages below the minimum level are dropped before formatting. The
+ * formatted ones go to the installed sink - the add-on forwards them to
+ * kodi::Log, standalone tools leave the default that writes to stderr.
+ */
+enum class LogLevel {
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+/**
+ * Receives every message at or above the minimum level, from any thread
+ */
+using LogSink = void (*)(LogLevel level, const char* message);
+
+/**
+ * Install the sink, nullptr restores the stderr default. Meant to be called
+ * once at start-up, before the core logs.
+ */
+void SetLogSink(LogSink sink);
+
+/**
+ * Drop messages below this level (default: Debug, everything)
+ */
+void SetLogLevel(LogLevel minimum);
+
+/**
+ * Format and emit a message
+ */
+void Log(LogLevel level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+} // namespace hdmi_pvr
@@ -0,0 +1,364 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Metrics Exporter Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "metrics_exporter.h"
+#include "log.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace hdmi_pvr {
+
+namespace {
+
+std::vector<std::string> ListDirectory(const std::string& path) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return names;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            names.emplace_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    // Stable order, so scrapes can be diffed
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+bool ReadAttribute(const std::string& path, size_t limit, std::string& content) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    content.clear();
+    char buffer[4096];
+    ssize_t bytes;
+    while (content.size() < limit && (bytes = read(fd, buffer, sizeof(buffer))) > 0) {
+        content.append(buffer, static_cast<size_t>(bytes));
+    }
+    close(fd);
+    return !content.empty();
+}
+
+using Deadline = std::chrono::steady_clock::time_point;
+
+/**
+ * Wait until the socket is ready or the deadline has passed
+ */
+bool WaitReady(int fd, short events, Deadline deadline) {
+    while (true) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+
+        struct pollfd pfd = {fd, events, 0};
+        int ready = poll(&pfd, 1, static_cast<int>(remaining));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        return ready > 0;
+    }
+}
+
+bool SendAll(int fd, const char* data, size_t size, Deadline deadline) {
+    while (size > 0) {
+        if (!WaitReady(fd, POLLOUT, deadline)) {
+            return false;
+        }
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+} // namespace
+
+MetricsExporter::~MetricsExporter() {
+    Stop();
+}
+
+bool MetricsExporter::Start(const std::string& endpoint) {
+    if (m_running.load()) {
+        return true;
+    }
+
+    if (!endpoint.empty() && endpoint[0] == '/') {
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (endpoint.size() >= sizeof(addr.sun_path)) {
+            Log(LogLevel::Error, "Metrics socket path too long: %s", endpoint.c_str());
+            return false;
+        }
+        memcpy(addr.sun_path, endpoint.c_str(), endpoint.size() + 1);
+
+        // A stale socket of an earlier run is replaced, anything else is not touched
+        struct stat st;
+        if (lstat(endpoint.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(endpoint.c_str());
+        }
+
+        m_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_listen_fd < 0 || bind(m_listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+            Log(LogLevel::Error, "Cannot bind metrics socket %s: %s", endpoint.c_str(), strerror(errno));
+            Stop();
+            return false;
+        }
+        m_socket_path = endpoint;
+    } else {
+        char* end = nullptr;
+        long port = strtol(endpoint.c_str(), &end, 10);
+        if (endpoint.empty() || *end != '\0' || port <= 0 || port > 65535) {
+            Log(LogLevel::Error, "Invalid metrics endpoint '%s' - expected a port or a socket path",
+                endpoint.c_str());
+            return false;
+        }
+
+        // Loopback only - the metrics are for a local agent, not the network
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        m_listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        if (m_listen_fd >= 0) {
+            setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (m_listen_fd < 0 || bind(m_listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+            Log(LogLevel::Error, "Cannot bind metrics port 127.0.0.1:%ld: %s", port, strerror(errno));
+            Stop();
+            return false;
+        }
+    }
+
+    m_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (listen(m_listen_fd, 4) < 0 || m_wake_fd < 0) {
+        Log(LogLevel::Error, "Cannot listen for metrics scrapes: %s", strerror(errno));
+        Stop();
+        return false;
+    }
+
+    m_running.store(true);
+    m_thread = std::thread(&MetricsExporter::ServerThread, this);
+    Log(LogLevel::Info, "Serving metrics on %s", m_socket_path.empty() ? ("127.0.0.1:" + endpoint).c_str()
+                                                                       : m_socket_path.c_str());
+    return true;
+}
+
+void MetricsExporter::Stop() {
+    if (m_running.exchange(false)) {
+        uint64_t one = 1;
+        if (write(m_wake_fd, &one, sizeof(one)) < 0) {
+            Log(LogLevel::Warning, "Cannot wake the metrics exporter: errno %d", errno);
+        }
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    if (m_listen_fd >= 0) {
+        close(m_listen_fd);
+        m_listen_fd = -1;
+    }
+    if (m_wake_fd >= 0) {
+        close(m_wake_fd);
+        m_wake_fd = -1;
+    }
+    if (!m_socket_path.empty()) {
+        unlink(m_socket_path.c_str());
+        m_socket_path.clear();
+    }
+}
+
+std::string MetricsExporter::Scrape() const {
+    std::string out;
+    out.reserve(16384);
+
+    if (m_collector) {
+        m_collector(out);
+    }
+
+    AppendFamily(out, "hdmi_pvr_exporter_scrapes_total", "counter", "Scrapes served by the metrics exporter");
+    AppendSample(out, "hdmi_pvr_exporter_scrapes_total", "", m_scrapes.load());
+
+    AppendDriverMetrics(out);
+    return out;
+}
+
+void MetricsExporter::AppendFamily(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void MetricsExporter::AppendSample(std::string& out, const char* name, const std::string& labels, uint64_t value) {
+    char number[32];
+    snprintf(number, sizeof(number), " %llu\n", static_cast<unsigned long long>(value));
+    out += name;
+    if (!labels.empty()) {
+        out += '{' + labels + '}';
+    }
+    out += number;
+}
+
+void MetricsExporter::AppendSample(std::string& out, const char* name, const std::string& labels, double value) {
+    char number[40];
+    snprintf(number, sizeof(number), " %.15g\n", value);
+    out += name;
+    if (!labels.empty()) {
+        out += '{' + labels + '}';
+    }
+    out += number;
+}
+
+std::string MetricsExporter::EscapeLabel(const std::string& value) {
+    std::string escaped = "\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped + '"';
+}
+
+void MetricsExporter::AppendDriverMetrics(std::string& out) const {
+    // Attributes that are not metrics (uevent, dev, ...) do not start with a comment
+    std::string content;
+    for (const std::string& device : ListDirectory(m_sysfs_root)) {
+        std::string device_path = m_sysfs_root + "/" + device;
+        for (const std::string& attribute : ListDirectory(device_path)) {
+            if (!ReadAttribute(device_path + "/" + attribute, MAX_ATTRIBUTE, content) ||
+                content.compare(0, 2, "# ") != 0) {
+                continue;
+            }
+            out += content;
+            if (out.back() != '\n') {
+                out += '\n';
+            }
+        }
+    }
+}
+
+void MetricsExporter::ServerThread() {
+    Log(LogLevel::Debug, "Metrics exporter thread started");
+
+    struct pollfd fds[2] = {{m_listen_fd, POLLIN, 0}, {m_wake_fd, POLLIN, 0}};
+    while (m_running.load()) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Log(LogLevel::Error, "Metrics exporter poll failed: errno %d", errno);
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            int client_fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client_fd >= 0) {
+                HandleClient(client_fd);
+                close(client_fd);
+            }
+        }
+    }
+
+    Log(LogLevel::Debug, "Metrics exporter thread finished");
+}
+
+void MetricsExporter::HandleClient(int client_fd) {
+    // One deadline for the whole exchange - a client trickling a byte at a
+    // time must not hold the exporter longer than a silent one
+    Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CLIENT_TIMEOUT_MS);
+
+    // Only the request line matters, headers are read and ignored
+    std::string request;
+    char buffer[1024];
+    while (request.size() < MAX_REQUEST && request.find("\r\n\r\n") == std::string::npos) {
+        if (!WaitReady(client_fd, POLLIN, deadline)) {
+            break;
+        }
+        ssize_t bytes = recv(client_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytes < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+            continue;
+        }
+        if (bytes <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(bytes));
+    }
+
+    size_t line_end = request.find("\r\n");
+    if (line_end == std::string::npos) {
+        return;
+    }
+    std::string line = request.substr(0, line_end);
+
+    const char* status = "200 OK";
+    std::string body;
+    if (line.compare(0, 4, "GET ") != 0) {
+        status = "405 Method Not Allowed";
+    } else if (line.compare(4, 9, "/metrics ") != 0 && line.compare(4, 2, "/ ") != 0) {
+        status = "404 Not Found";
+    } else {
+        m_scrapes.fetch_add(1);
+        body = Scrape();
+    }
+
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+                          "HTTP/1.1 %s\r\n"
+                          "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                          "Content-Length: %zu\r\n"
+                          "Connection: close\r\n\r\n",
+                          status, body.size());
+    if (SendAll(client_fd, header, static_cast<size_t>(length), deadline)) {
+        SendAll(client_fd, body.data(), body.size(), deadline);
+    }
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,96 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace hdmi_pvr {
+
+/**
+ * MetricsExporter serves one Prometheus text scrape over HTTP, either on a
+ * loopback TCP port or on a Unix socket (curl --unix-socket).
+ *
+ * A scrape holds the add-on's metrics, written by the collector, followed
+ * by the metrics the HY300 drivers publish in sysfs: every attribute below
+ * /sys/class/hy300/<device>/ that is already Prometheus text (tvcap
+ * capture_stats, buffer_status, error_counters, the mipsloader and motor
+ * counters). Drivers that are not loaded are simply missing.
+ *
+ * Requests are answered one at a time on the exporter's own thread, never
+ * on the capture path; a client gets one second for its whole request and
+ * response, then it is cut off.
+ */
+class MetricsExporter {
+public:
+    /**
+     * Appends the add-on's metrics to a scrape, called on the exporter thread
+     */
+    using Collector = std::function<void(std::string& out)>;
+
+    static constexpr const char* DEFAULT_SYSFS_ROOT = "/sys/class/hy300";
+
+    MetricsExporter() = default;
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Configuration, while stopped
+    void SetCollector(Collector collector) { m_collector = std::move(collector); }
+    void SetSysfsRoot(const std::string& root) { m_sysfs_root = root; }
+
+    /**
+     * Listen and start the exporter thread
+     * @param endpoint A port number for 127.0.0.1, or an absolute path for
+     *                 a Unix socket (an existing socket file is replaced)
+     * @return false if the endpoint is invalid or cannot be bound
+     */
+    bool Start(const std::string& endpoint);
+    void Stop();
+    bool IsRunning() const { return m_running.load(); }
+
+    /**
+     * The full scrape, as served
+     */
+    std::string Scrape() const;
+
+    // Writers for collectors; a family's HELP/TYPE goes before its samples
+    static void AppendFamily(std::string& out, const char* name, const char* type, const char* help);
+    static void AppendSample(std::string& out, const char* name, const std::string& labels, uint64_t value);
+    static void AppendSample(std::string& out, const char* name, const std::string& labels, double value);
+
+    /**
+     * Quote a label value
+     */
+    static std::string EscapeLabel(const std::string& value);
+
+private:
+    static constexpr int CLIENT_TIMEOUT_MS = 1000;
+    static constexpr size_t MAX_REQUEST = 4096;
+    static constexpr size_t MAX_ATTRIBUTE = 65536;  ///< sysfs attributes are one page, leave room
+
+    void ServerThread();
+    void HandleClient(int client_fd);
+    void AppendDriverMetrics(std::string& out) const;
+
+    Collector m_collector;
+    std::string m_sysfs_root{DEFAULT_SYSFS_ROOT};
+    std::string m_socket_path;   ///< Removed again on Stop()
+    int m_listen_fd = -1;
+    int m_wake_fd = -1;          ///< eventfd ending the thread
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_scrapes{0};
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,72 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Presentation Timestamp Generator Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "pts_generator.h"
+
+namespace hdmi_pvr {
+
+namespace {
+
+constexpr uint64_t US_PER_SECOND = 1000000;
+
+} // namespace
+
+void PtsGenerator::Reset(const FrameRate& rate) {
+    m_rate = rate;
+    m_base_time = 0;
+    m_index = 0;
+    m_started = false;
+    m_resyncs = 0;
+}
+
+uint64_t PtsGenerator::OffsetForIndex(uint64_t index) const {
+    // Whole periods of num frames first, so index * den * 1e6 cannot overflow
+    uint64_t period_us = static_cast<uint64_t>(m_rate.den) * US_PER_SECOND;
+    return (index / m_rate.num) * period_us + (index % m_rate.num) * period_us / m_rate.num;
+}
+
+bool PtsGenerator::Next(uint64_t capture_time, uint64_t& pts, uint64_t& duration) {
+    if (!m_rate.is_valid()) {
+        return false;
+    }
+
+    if (!m_started) {
+        m_base_time = capture_time;
+        m_index = 0;
+        m_started = true;
+    } else {
+        uint64_t expected = m_index + 1;
+
+        // Nearest grid slot to the capture time
+        uint64_t elapsed = capture_time > m_base_time ? capture_time - m_base_time : 0;
+        uint64_t period_us = static_cast<uint64_t>(m_rate.den) * US_PER_SECOND;
+        uint64_t measured = (elapsed / period_us) * m_rate.num +
+                            ((elapsed % period_us) * m_rate.num + period_us / 2) / period_us;
+
+        if (measured >= expected + RESYNC_FRAMES) {
+            // Frames were lost - skip their slots
+            m_index = measured;
+            ++m_resyncs;
+        } else if (measured + RESYNC_FRAMES <= expected) {
+            // Source runs ahead of the nominal rate - move the grid instead
+            // of stamping frames into the future
+            m_index = expected;
+            m_base_time = capture_time - OffsetForIndex(m_index);
+            ++m_resyncs;
+        } else {
+            m_index = expected;
+        }
+    }
+
+    uint64_t offset = OffsetForIndex(m_index);
+    pts = m_base_time + offset;
+    duration = OffsetForIndex(m_index + 1) - offset;
+    return true;
+}
+
+} // namespace hdmi_pvr
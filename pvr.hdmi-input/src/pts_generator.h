@@ -0,0 +1,70 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+
+namespace hdmi_pvr {
+
+/**
+ * PtsGenerator places captured frames on the exact time grid of the source
+ * frame rate.
+ *
+ * Timestamps are computed from the frame index as index * den / num rather
+ * than by adding a rounded frame duration, so 59.94 or 23.976 Hz streams
+ * never accumulate rounding error however long they run. Capture times are
+ * only used to keep the index in step with reality: frames lost to a stall
+ * or a dropped buffer advance the index instead of compressing time.
+ *
+ * Not thread-safe; used from the capture thread only.
+ */
+class PtsGenerator {
+public:
+    PtsGenerator() = default;
+
+    /**
+     * Start a new timeline
+     * @param rate Nominal source frame rate
+     */
+    void Reset(const FrameRate& rate);
+
+    /**
+     * Timestamp the next captured frame
+     * @param capture_time Monotonic capture time in microseconds
+     * @param pts Presentation timestamp in microseconds (same clock as capture_time)
+     * @param duration Exact duration of this frame in microseconds
+     * @return false if no valid frame rate is set, pts and duration are then left untouched
+     */
+    bool Next(uint64_t capture_time, uint64_t& pts, uint64_t& duration);
+
+    /**
+     * Number of times the grid was realigned with the capture clock
+     */
+    uint64_t GetResyncCount() const { return m_resyncs; }
+
+    const FrameRate& GetFrameRate() const { return m_rate; }
+
+private:
+    static constexpr uint64_t RESYNC_FRAMES = 2;  ///< Deviation that realigns the grid
+
+    /**
+     * Offset of a frame from the start of the timeline
+     * @param index Frame index
+     * @return Offset in microseconds, rounded down
+     */
+    uint64_t OffsetForIndex(uint64_t index) const;
+
+    FrameRate m_rate;
+    uint64_t m_base_time = 0;   ///< Capture time of frame 0
+    uint64_t m_index = 0;       ///< Index of the last timestamped frame
+    bool m_started = false;
+    uint64_t m_resyncs = 0;
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,431 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Raw Capture Container Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "raw_capture.h"
+#include "log.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace hdmi_pvr {
+
+namespace {
+
+bool WriteAll(int fd, const void* data, size_t size, uint64_t offset) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+RawCaptureReader::~RawCaptureReader() {
+    Close();
+}
+
+bool RawCaptureReader::Open(const std::string& path) {
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Log(LogLevel::Error, "Cannot open raw capture %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st = {};
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(RawCaptureHeader))) {
+        Log(LogLevel::Error, "Raw capture %s is too short", path.c_str());
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file alive, the descriptor is not needed
+    m_size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        Log(LogLevel::Error, "Cannot map raw capture %s: %s", path.c_str(), strerror(errno));
+        m_size = 0;
+        return false;
+    }
+    m_map = static_cast<uint8_t*>(map);
+
+    RawCaptureHeader header;
+    memcpy(&header, m_map, sizeof(header));
+    if (memcmp(header.magic, RAW_CAPTURE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != RAW_CAPTURE_VERSION || header.record_size != sizeof(RawRecord)) {
+        Log(LogLevel::Error, "%s is not a raw capture of version %u", path.c_str(), RAW_CAPTURE_VERSION);
+        Close();
+        return false;
+    }
+
+    m_indexed = ReadIndex(header);
+    if (!m_indexed) {
+        Log(LogLevel::Warning, "Raw capture %s has no index, recovering records", path.c_str());
+        ScanRecords();
+    }
+
+    m_frame_count = 0;
+    for (const auto& record : m_records) {
+        if (record.type == RAW_RECORD_FRAME) {
+            ++m_frame_count;
+        }
+    }
+
+    Log(LogLevel::Info, "Raw capture %s: %llu frames, %zu records", path.c_str(),
+        static_cast<unsigned long long>(m_frame_count), m_records.size());
+    return true;
+}
+
+void RawCaptureReader::Close() {
+    if (m_map) {
+        munmap(m_map, m_size);
+        m_map = nullptr;
+    }
+    m_size = 0;
+    m_records.clear();
+    m_frame_count = 0;
+    m_indexed = false;
+}
+
+const uint8_t* RawCaptureReader::GetPayload(const RawRecord& record) const {
+    if (!m_map || record.payload_offset > m_size || record.payload_size > m_size - record.payload_offset) {
+        return nullptr;
+    }
+    return m_map + record.payload_offset;
+}
+
+VideoFormat RawCaptureReader::ToVideoFormat(const RawRecord& record) {
+    VideoFormat format;
+    format.width = record.width;
+    format.height = record.height;
+    format.fourcc = record.fourcc;
+    format.frame_rate = FrameRate::from_ratio(record.fps_num, record.fps_den);
+    format.interlaced = (record.flags & RAW_RECORD_FLAG_INTERLACED) != 0;
+    return format;
+}
+
+bool RawCaptureReader::ReadIndex(const RawCaptureHeader& header) {
+    if (header.index_offset == 0 || header.index_offset > m_size ||
+        header.index_count > (m_size - header.index_offset) / sizeof(RawRecord)) {
+        return false;
+    }
+
+    std::vector<RawRecord> records(header.index_count);
+    memcpy(records.data(), m_map + header.index_offset, records.size() * sizeof(RawRecord));
+    for (const auto& record : records) {
+        if (!IsValidRecord(record)) {
+            return false;
+        }
+    }
+
+    m_records = std::move(records);
+    return true;
+}
+
+void RawCaptureReader::ScanRecords() {
+    // Each payload starts on the first boundary that leaves room for its
+    // record after the previous payload - the same rule the writer follows
+    m_records.clear();
+    uint64_t end = sizeof(RawCaptureHeader);
+    while (true) {
+        uint64_t payload_offset = RawCaptureRecorder::GetPayloadOffset(end);
+        if (payload_offset > m_size) {
+            break;
+        }
+
+        RawRecord record;
+        memcpy(&record, m_map + payload_offset - sizeof(RawRecord), sizeof(record));
+        if (record.payload_offset != payload_offset || !IsValidRecord(record)) {
+            break;  // End of the recording, or a frame that was cut off
+        }
+
+        m_records.push_back(record);
+        end = record.payload_offset + record.payload_size;
+    }
+}
+
+bool RawCaptureReader::IsValidRecord(const RawRecord& record) const {
+    if (record.magic != RAW_RECORD_MAGIC || record.payload_offset % RAW_CAPTURE_ALIGNMENT != 0 ||
+        record.payload_offset > m_size || record.payload_size > m_size - record.payload_offset) {
+        return false;
+    }
+    return record.type == RAW_RECORD_FORMAT || record.type == RAW_RECORD_FRAME;
+}
+
+//
+// RawCaptureRecorder
+//
+
+RawCaptureRecorder::~RawCaptureRecorder() {
+    Stop();
+}
+
+bool RawCaptureRecorder::Start(const std::string& path) {
+    if (m_recording.load()) {
+        Log(LogLevel::Warning, "Raw capture already active: %s", m_path.c_str());
+        return false;
+    }
+
+    // A recording that ended on a write error still has its writer waiting
+    // for Stop() - reap it, or no new recording could ever start
+    Stop();
+
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        Log(LogLevel::Error, "Failed to create raw capture %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    // Without an index the file stays readable by walking the records
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    m_created_us = static_cast<uint64_t>(now.tv_sec) * 1000000ULL + static_cast<uint64_t>(now.tv_nsec) / 1000;
+    RawCaptureHeader header = CreateHeader(m_created_us);
+    if (!WriteAll(m_fd, &header, sizeof(header), 0)) {
+        Log(LogLevel::Error, "Failed to write raw capture %s: %s", path.c_str(), strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_queue.clear();
+        m_queued_frames = 0;
+        m_lost = 0;
+        m_stop_requested = false;
+        m_path = path;
+    }
+
+    m_end = sizeof(header);
+    m_index.clear();
+    m_frames_recorded.store(0);
+    m_frames_dropped.store(0);
+    m_bytes_written.store(sizeof(header));
+
+    m_writer_thread = std::thread(&RawCaptureRecorder::WriterThread, this);
+    m_recording.store(true);
+
+    Log(LogLevel::Info, "Raw capture started: %s", path.c_str());
+    return true;
+}
+
+void RawCaptureRecorder::Stop() {
+    if (!m_writer_thread.joinable()) {
+        return;
+    }
+
+    m_recording.store(false);
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_stop_requested = true;
+    }
+    m_queue_condition.notify_all();
+    m_writer_thread.join();
+
+    Log(LogLevel::Info, "Raw capture stopped: %s, %llu frames, %llu skipped", m_path.c_str(),
+        static_cast<unsigned long long>(m_frames_recorded.load()),
+        static_cast<unsigned long long>(m_frames_dropped.load()));
+}
+
+std::string RawCaptureRecorder::GetPath() const {
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    return m_path;
+}
+
+void RawCaptureRecorder::SubmitFormat(const VideoFormat& format, uint32_t frame_size, uint32_t bytes_per_line,
+                                      uint64_t sequence, uint64_t timestamp) {
+    Pending pending;
+    pending.record.type = RAW_RECORD_FORMAT;
+    pending.record.flags = format.interlaced ? RAW_RECORD_FLAG_INTERLACED : 0;
+    pending.record.sequence = sequence;
+    pending.record.timestamp_us = timestamp;
+    pending.record.width = format.width;
+    pending.record.height = format.height;
+    pending.record.fourcc = format.fourcc;
+    pending.record.bytes_per_line = bytes_per_line;
+    pending.record.frame_size = frame_size;
+    pending.record.fps_num = format.frame_rate.num;
+    pending.record.fps_den = format.frame_rate.den;
+
+    // Format records are small and never skipped, the frames after them
+    // would be unreadable
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    if (m_recording.load() && !m_stop_requested) {
+        m_queue.push_back(std::move(pending));
+        m_queue_condition.notify_one();
+    }
+}
+
+bool RawCaptureRecorder::SubmitFrame(const FrameRef& frame) {
+    if (!m_recording.load() || !frame) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    if (m_stop_requested) {
+        return false;
+    }
+    if (m_queued_frames >= MAX_QUEUED_FRAMES) {
+        ++m_lost;
+        m_frames_dropped.fetch_add(1);
+        return false;
+    }
+
+    Pending pending;
+    pending.record.type = RAW_RECORD_FRAME;
+    pending.record.payload_size = frame->Size();
+    pending.record.sequence = frame->device_sequence;
+    pending.record.timestamp_us = frame->device_timestamp;
+    pending.record.lost_before = m_lost;
+    pending.frame = frame;
+    m_lost = 0;
+
+    m_queue.push_back(std::move(pending));
+    ++m_queued_frames;
+    m_queue_condition.notify_one();
+    return true;
+}
+
+RawCaptureStats RawCaptureRecorder::GetStats() const {
+    RawCaptureStats stats;
+    stats.frames_recorded = m_frames_recorded.load();
+    stats.frames_dropped = m_frames_dropped.load();
+    stats.bytes_written = m_bytes_written.load();
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    stats.queued_frames = static_cast<uint32_t>(m_queued_frames);
+    return stats;
+}
+
+void RawCaptureRecorder::WriterThread() {
+    bool failed = false;
+
+    while (true) {
+        Pending pending;
+        {
+            std::unique_lock<std::mutex> lock(m_queue_mutex);
+            m_queue_condition.wait(lock, [this] { return !m_queue.empty() || m_stop_requested; });
+            if (m_queue.empty()) {
+                break;
+            }
+            pending = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        // After a write error the rest is discarded, the file stays
+        // readable up to the last complete record
+        if (!failed) {
+            const uint8_t* payload = pending.frame ? pending.frame->Data() : nullptr;
+            if (WriteRecord(pending.record, payload)) {
+                if (pending.frame) {
+                    m_frames_recorded.fetch_add(1);
+                }
+            } else {
+                Log(LogLevel::Error, "Raw capture write failed, stopping: %s", strerror(errno));
+                failed = true;
+                m_recording.store(false);
+            }
+        }
+
+        if (pending.frame) {
+            pending.frame.Reset();
+            std::lock_guard<std::mutex> lock(m_queue_mutex);
+            --m_queued_frames;
+        }
+    }
+
+    if (!failed) {
+        if (WriteIndex(m_fd, m_index, m_end, m_created_us)) {
+            m_bytes_written.fetch_add(m_index.size() * sizeof(RawRecord));
+        } else {
+            Log(LogLevel::Warning, "Failed to write the raw capture index: %s", strerror(errno));
+        }
+    }
+    close(m_fd);
+    m_fd = -1;
+}
+
+bool RawCaptureRecorder::WriteRecord(RawRecord& record, const uint8_t* payload) {
+    // The record goes right in front of its page-aligned payload
+    record.magic = RAW_RECORD_MAGIC;
+    record.payload_offset = GetPayloadOffset(m_end);
+    uint64_t offset = record.payload_offset - sizeof(RawRecord);
+
+    struct iovec iov[2];
+    iov[0].iov_base = &record;
+    iov[0].iov_len = sizeof(record);
+    iov[1].iov_base = const_cast<uint8_t*>(payload);
+    iov[1].iov_len = payload ? static_cast<size_t>(record.payload_size) : 0;
+
+    ssize_t written = pwritev(m_fd, iov, payload ? 2 : 1, static_cast<off_t>(offset));
+    if (written < 0 && errno != EINTR) {
+        return false;
+    }
+
+    // A short write is finished piece by piece
+    size_t done = written > 0 ? static_cast<size_t>(written) : 0;
+    size_t payload_done = done > sizeof(record) ? done - sizeof(record) : 0;
+    if ((done < sizeof(record) && !WriteAll(m_fd, reinterpret_cast<uint8_t*>(&record) + done,
+                                            sizeof(record) - done, offset + done)) ||
+        (payload && !WriteAll(m_fd, payload + payload_done, iov[1].iov_len - payload_done,
+                              record.payload_offset + payload_done))) {
+        return false;
+    }
+
+    m_end = record.payload_offset + record.payload_size;
+    m_index.push_back(record);
+    m_bytes_written.fetch_add(iov[0].iov_len + iov[1].iov_len);
+    return true;
+}
+
+RawCaptureHeader RawCaptureRecorder::CreateHeader(uint64_t created_us) {
+    RawCaptureHeader header = {};
+    memcpy(header.magic, RAW_CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = RAW_CAPTURE_VERSION;
+    header.record_size = sizeof(RawRecord);
+    header.created_us = created_us;
+    return header;
+}
+
+uint64_t RawCaptureRecorder::GetPayloadOffset(uint64_t end) {
+    return (end + sizeof(RawRecord) + RAW_CAPTURE_ALIGNMENT - 1) & ~static_cast<uint64_t>(RAW_CAPTURE_ALIGNMENT - 1);
+}
+
+bool RawCaptureRecorder::WriteIndex(int fd, const std::vector<RawRecord>& index, uint64_t end, uint64_t created_us) {
+    RawCaptureHeader header = CreateHeader(created_us);
+    header.index_offset = end;
+    header.index_count = index.size();
+    for (const auto& record : index) {
+        if (record.type == RAW_RECORD_FRAME) {
+            ++header.frame_count;
+        }
+    }
+
+    // Index first, the header only points at it once it is complete
+    return WriteAll(fd, index.data(), index.size() * sizeof(RawRecord), end) && fdatasync(fd) == 0 &&
+           WriteAll(fd, &header, sizeof(header), 0);
+}
+
+} // namespace hdmi_pvr
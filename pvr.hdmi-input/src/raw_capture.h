@@ -0,0 +1,249 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "frame.h"
+#include "types.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hdmi_pvr {
+
+//
+// Raw capture container
+//
+// A recorded capture session, byte-for-byte as the driver delivered it:
+//
+//   [RawCaptureHeader, padded to RAW_CAPTURE_ALIGNMENT]
+//   [padding][RawRecord][payload]   repeated, each payload page aligned
+//   [RawRecord x index_count]       index, written when recording ends
+//
+// Every record sits directly in front of its payload, so a file whose
+// recording was cut short (no index yet) is recovered by walking the
+// records. Page-aligned payloads can be used straight from an mmap.
+// All fields are little-endian.
+//
+
+static constexpr char RAW_CAPTURE_MAGIC[8] = {'H', 'Y', 'R', 'A', 'W', 'C', 'A', 'P'};
+static constexpr uint32_t RAW_CAPTURE_VERSION = 1;
+static constexpr uint32_t RAW_CAPTURE_ALIGNMENT = 4096;
+static constexpr uint32_t RAW_RECORD_MAGIC = 0x52525948;  // "HYRR"
+
+enum RawRecordType : uint16_t {
+    RAW_RECORD_FORMAT = 1,  ///< Format of the frames that follow
+    RAW_RECORD_FRAME = 2    ///< One captured frame
+};
+
+static constexpr uint16_t RAW_RECORD_FLAG_INTERLACED = 1 << 0;  ///< Format records
+
+struct RawCaptureHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;     ///< sizeof(RawRecord) of the writer
+    uint64_t index_offset;    ///< 0 until the recording was closed
+    uint64_t index_count;
+    uint64_t frame_count;
+    uint64_t created_us;      ///< Wall clock at the start, for humans
+    uint64_t reserved[2];
+};
+
+struct RawRecord {
+    uint32_t magic;
+    uint16_t type;            ///< RawRecordType
+    uint16_t flags;
+    uint64_t payload_offset;  ///< Absolute, RAW_CAPTURE_ALIGNMENT aligned
+    uint64_t payload_size;    ///< 0 for format records
+    uint64_t sequence;        ///< Driver sequence number (frame records)
+    uint64_t timestamp_us;    ///< Driver timestamp, or presentation time in recordings; CLOCK_MONOTONIC
+    uint32_t width;           ///< Format fields, format records only
+    uint32_t height;
+    uint32_t fourcc;
+    uint32_t bytes_per_line;
+    uint32_t frame_size;
+    uint32_t fps_num;
+    uint32_t fps_den;
+    uint32_t lost_before;     ///< Frames the recorder had to skip before this one
+};
+
+static_assert(sizeof(RawCaptureHeader) == 64, "RawCaptureHeader layout changed");
+static_assert(sizeof(RawRecord) == 72, "RawRecord layout changed");
+
+/**
+ * Read-only view of a raw capture file.
+ *
+ * The file is mapped, payloads are pointers into the mapping and stay
+ * valid until Close().
+ */
+class RawCaptureReader {
+public:
+    RawCaptureReader() = default;
+    ~RawCaptureReader();
+
+    RawCaptureReader(const RawCaptureReader&) = delete;
+    RawCaptureReader& operator=(const RawCaptureReader&) = delete;
+
+    /**
+     * Map a capture file and load its records, from the index or - for an
+     * unfinished recording - by walking the file
+     */
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return m_map != nullptr; }
+
+    const std::vector<RawRecord>& GetRecords() const { return m_records; }
+    uint64_t GetFrameCount() const { return m_frame_count; }
+    bool IsIndexed() const { return m_indexed; }  ///< false if the index was missing
+
+    /**
+     * Payload of a frame record, nullptr if it lies outside the file
+     */
+    const uint8_t* GetPayload(const RawRecord& record) const;
+
+    static VideoFormat ToVideoFormat(const RawRecord& record);
+
+private:
+    bool ReadIndex(const RawCaptureHeader& header);
+    void ScanRecords();
+    bool IsValidRecord(const RawRecord& record) const;
+
+    uint8_t* m_map = nullptr;
+    size_t m_size = 0;
+    std::vector<RawRecord> m_records;
+    uint64_t m_frame_count = 0;
+    bool m_indexed = false;
+};
+
+/**
+ * Raw capture statistics snapshot
+ */
+struct RawCaptureStats {
+    uint64_t frames_recorded = 0;  ///< Frames written to the file
+    uint64_t frames_dropped = 0;   ///< Frames skipped because storage fell behind
+    uint64_t bytes_written = 0;
+    uint32_t queued_frames = 0;    ///< Frames waiting for the writer
+};
+
+/**
+ * RawCaptureRecorder writes captured frames unmodified into a raw capture
+ * file, from a dedicated writer thread.
+ *
+ * The queue holds references to the pipeline's frames rather than copies,
+ * at most MAX_QUEUED_FRAMES of them so the live path keeps enough of the
+ * pool. When storage falls behind the frame is skipped instead of waiting;
+ * the next record carries the count and the sequence numbers show the gap.
+ */
+class RawCaptureRecorder {
+public:
+    static constexpr size_t MAX_QUEUED_FRAMES = 3;
+
+    RawCaptureRecorder() = default;
+    ~RawCaptureRecorder();
+
+    RawCaptureRecorder(const RawCaptureRecorder&) = delete;
+    RawCaptureRecorder& operator=(const RawCaptureRecorder&) = delete;
+
+    /**
+     * Create the file and start the writer thread; a recording that ended
+     * on a write error is closed first
+     */
+    bool Start(const std::string& path);
+
+    /**
+     * Write what is queued, then the index, and close the file
+     */
+    void Stop();
+
+    bool IsRecording() const { return m_recording.load(); }
+    std::string GetPath() const;
+
+    /**
+     * Queue a format record for the frames submitted after it
+     * @param sequence Driver sequence number of the first frame in this format
+     * @param timestamp Driver timestamp of that frame
+     */
+    void SubmitFormat(const VideoFormat& format, uint32_t frame_size, uint32_t bytes_per_line,
+                      uint64_t sequence, uint64_t timestamp);
+
+    /**
+     * Queue a frame with its device timestamp and sequence number. Never
+     * blocks on storage.
+     * @return true if queued, false if skipped or not recording
+     */
+    bool SubmitFrame(const FrameRef& frame);
+
+    RawCaptureStats GetStats() const;
+
+    //
+    // Container layout, shared with RecordingEngine
+    //
+
+    /**
+     * Header of a file without index yet
+     * @param created_us Wall clock at the start of the recording
+     */
+    static RawCaptureHeader CreateHeader(uint64_t created_us);
+
+    /**
+     * Where the payload of the next record goes
+     * @param end End of the previous payload, or of the header
+     * @return Page-aligned offset with room for the record in front of it
+     */
+    static uint64_t GetPayloadOffset(uint64_t end);
+
+    /**
+     * Append the index behind the last payload and point the header at it
+     * @param fd File open for buffered writing
+     * @param index Every record in file order
+     * @param end End of the last payload
+     * @param created_us Wall clock at the start of the recording
+     * @return true if the index and header were written
+     */
+    static bool WriteIndex(int fd, const std::vector<RawRecord>& index, uint64_t end, uint64_t created_us);
+
+private:
+    struct Pending {
+        RawRecord record = {};
+        FrameRef frame;  ///< Empty for format records
+    };
+
+    void WriterThread();
+    bool WriteRecord(RawRecord& record, const uint8_t* payload);
+    void Enqueue(Pending&& pending);
+
+    std::string m_path;
+    int m_fd = -1;
+    uint64_t m_created_us = 0;
+    uint64_t m_end = 0;                ///< End of the last payload (writer thread only)
+    std::vector<RawRecord> m_index;    ///< Records written so far (writer thread only)
+
+    // Queue
+    mutable std::mutex m_queue_mutex;
+    std::condition_variable m_queue_condition;
+    std::deque<Pending> m_queue;
+    size_t m_queued_frames = 0;
+    uint32_t m_lost = 0;               ///< Frames skipped since the last queued one
+    bool m_stop_requested = false;
+
+    // Threading
+    std::thread m_writer_thread;
+    std::atomic<bool> m_recording{false};
+
+    // Statistics
+    std::atomic<uint64_t> m_frames_recorded{0};
+    std::atomic<uint64_t> m_frames_dropped{0};
+    std::atomic<uint64_t> m_bytes_written{0};
+};
+
+} // namespace hdmi_pvr
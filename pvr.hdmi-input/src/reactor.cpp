@@ -0,0 +1,292 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Reactor Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "reactor.h"
+#include "log.h"
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace hdmi_pvr {
+
+Reactor::~Reactor() {
+    Stop();
+}
+
+bool Reactor::Start() {
+    if (m_running.load()) {
+        return true;
+    }
+
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll_fd < 0 || m_event_fd < 0) {
+        Log(LogLevel::Error, "Failed to create reactor descriptors: errno %d", errno);
+        Stop();
+        return false;
+    }
+
+    // Id 0 is the wakeup descriptor
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = 0;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_event_fd, &event) < 0) {
+        Log(LogLevel::Error, "Failed to watch reactor wakeup descriptor: errno %d", errno);
+        Stop();
+        return false;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&Reactor::Run, this);
+    m_thread_id = m_thread.get_id();
+    return true;
+}
+
+void Reactor::Stop() {
+    if (m_running.exchange(false)) {
+        Wake();
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_thread_id = std::thread::id();
+
+    {
+        std::lock_guard<std::mutex> lock(m_handlers_mutex);
+        for (const auto& [id, handler] : m_handlers) {
+            if (handler->is_timer) {
+                close(handler->fd);
+            }
+        }
+        m_handlers.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_post_mutex);
+        m_posted.clear();
+    }
+
+    if (m_event_fd >= 0) {
+        close(m_event_fd);
+        m_event_fd = -1;
+    }
+    if (m_epoll_fd >= 0) {
+        close(m_epoll_fd);
+        m_epoll_fd = -1;
+    }
+}
+
+int Reactor::AddFd(int fd, uint32_t events, FdCallback callback) {
+    if (fd < 0 || !callback) {
+        return 0;
+    }
+
+    auto handler = std::make_shared<Handler>();
+    handler->fd = fd;
+    handler->fd_callback = std::move(callback);
+    return AddHandler(std::move(handler), events);
+}
+
+int Reactor::AddTimer(uint32_t interval_ms, Callback callback) {
+    if (interval_ms == 0 || !callback) {
+        return 0;
+    }
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+
+    if (!ArmTimer(fd, interval_ms)) {
+        close(fd);
+        return 0;
+    }
+
+    auto handler = std::make_shared<Handler>();
+    handler->fd = fd;
+    handler->is_timer = true;
+    handler->timer_callback = std::move(callback);
+
+    int id = AddHandler(handler, EPOLLIN);
+    if (id == 0) {
+        close(fd);
+    }
+    return id;
+}
+
+bool Reactor::SetTimerInterval(int id, uint32_t interval_ms) {
+    if (interval_ms == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_handlers_mutex);
+    auto it = m_handlers.find(id);
+    if (it == m_handlers.end() || !it->second->is_timer) {
+        return false;
+    }
+    return ArmTimer(it->second->fd, interval_ms);
+}
+
+bool Reactor::ArmTimer(int fd, uint32_t interval_ms) {
+    struct itimerspec spec = {};
+    spec.it_interval.tv_sec = interval_ms / 1000;
+    spec.it_interval.tv_nsec = static_cast<long>(interval_ms % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    return timerfd_settime(fd, 0, &spec, nullptr) == 0;
+}
+
+int Reactor::AddHandler(std::shared_ptr<Handler> handler, uint32_t events) {
+    std::lock_guard<std::mutex> lock(m_handlers_mutex);
+    if (m_epoll_fd < 0) {
+        return 0;
+    }
+
+    int id = m_next_id++;
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.u32 = static_cast<uint32_t>(id);
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, handler->fd, &event) < 0) {
+        Log(LogLevel::Error, "Failed to watch descriptor %d: errno %d", handler->fd, errno);
+        return 0;
+    }
+
+    m_handlers[id] = std::move(handler);
+    return id;
+}
+
+void Reactor::Remove(int id) {
+    std::shared_ptr<Handler> handler;
+    {
+        std::lock_guard<std::mutex> lock(m_handlers_mutex);
+        auto it = m_handlers.find(id);
+        if (it == m_handlers.end()) {
+            return;
+        }
+        handler = std::move(it->second);
+        m_handlers.erase(it);
+        if (m_epoll_fd >= 0) {
+            epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, handler->fd, nullptr);
+        }
+    }
+
+    // Wait for a callback in progress - recursive, so a handler may remove itself
+    std::lock_guard<std::recursive_mutex> lock(handler->mutex);
+    handler->active = false;
+    if (handler->is_timer) {
+        close(handler->fd);
+        handler->fd = -1;
+    }
+}
+
+bool Reactor::Post(Callback callback) {
+    if (!m_running.load() || !callback) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_post_mutex);
+        m_posted.push_back(std::move(callback));
+    }
+    Wake();
+    return true;
+}
+
+void Reactor::Wake() {
+    uint64_t one = 1;
+    if (m_event_fd >= 0 && write(m_event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        Log(LogLevel::Warning, "Failed to wake reactor: errno %d", errno);
+    }
+}
+
+void Reactor::Run() {
+    Log(LogLevel::Debug, "Reactor thread started");
+
+    struct epoll_event events[MAX_EVENTS];
+    while (m_running.load()) {
+        int count = epoll_wait(m_epoll_fd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Log(LogLevel::Error, "Reactor wait failed: errno %d", errno);
+            break;
+        }
+
+        // Control messages go first so they act on the state the I/O sees
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u32 == 0) {
+                uint64_t value;
+                while (read(m_event_fd, &value, sizeof(value)) > 0) {
+                }
+                RunPosted();
+            }
+        }
+
+        for (int i = 0; i < count && m_running.load(); ++i) {
+            if (events[i].data.u32 != 0) {
+                Dispatch(static_cast<int>(events[i].data.u32), events[i].events);
+            }
+        }
+    }
+
+    Log(LogLevel::Debug, "Reactor thread stopped");
+}
+
+void Reactor::Dispatch(int id, uint32_t events) {
+    std::shared_ptr<Handler> handler;
+    {
+        std::lock_guard<std::mutex> lock(m_handlers_mutex);
+        auto it = m_handlers.find(id);
+        if (it == m_handlers.end()) {
+            return;
+        }
+        handler = it->second;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(handler->mutex);
+    if (!handler->active) {
+        return;
+    }
+
+    try {
+        if (handler->is_timer) {
+            uint64_t expirations = 0;
+            if (read(handler->fd, &expirations, sizeof(expirations)) > 0) {
+                handler->timer_callback();
+            }
+        } else {
+            handler->fd_callback(events);
+        }
+    }
+    catch (const std::exception& e) {
+        Log(LogLevel::Error, "Exception in reactor handler %d: %s", id, e.what());
+    }
+}
+
+void Reactor::RunPosted() {
+    std::vector<Callback> posted;
+    {
+        std::lock_guard<std::mutex> lock(m_post_mutex);
+        posted.swap(m_posted);
+    }
+
+    for (const auto& callback : posted) {
+        if (!m_running.load()) {
+            break;
+        }
+        try {
+            callback();
+        }
+        catch (const std::exception& e) {
+            Log(LogLevel::Error, "Exception in posted reactor job: %s", e.what());
+        }
+    }
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,127 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hdmi_pvr {
+
+/**
+ * Reactor runs the periodic and I/O driven work of the add-on on a single
+ * thread: device file descriptors and V4L2 events through epoll, timers
+ * through timerfd and control messages from other threads through an
+ * eventfd. The thread sleeps in epoll_wait() until one of them is due.
+ *
+ * Callbacks run one at a time and each to completion, in the order epoll
+ * reports them, with posted messages first. Remove() waits for a callback
+ * of the removed handler that is still running, so its caller must not hold
+ * a lock that callback takes.
+ */
+class Reactor {
+public:
+    using FdCallback = std::function<void(uint32_t events)>;
+    using Callback = std::function<void()>;
+
+    Reactor() = default;
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /**
+     * Create the epoll and eventfd descriptors and start the thread
+     * @return false if the kernel objects cannot be created
+     */
+    bool Start();
+
+    /**
+     * Stop the thread and drop every handler and pending message
+     */
+    void Stop();
+
+    bool IsRunning() const { return m_running.load(); }
+    bool IsReactorThread() const { return std::this_thread::get_id() == m_thread_id; }
+
+    /**
+     * Watch a file descriptor
+     * @param fd Descriptor, stays owned by the caller and must stay open until Remove()
+     * @param events EPOLL* event mask, EPOLLET included if wanted
+     * @param callback Called with the reported events
+     * @return Handler id, 0 on failure
+     */
+    int AddFd(int fd, uint32_t events, FdCallback callback);
+
+    /**
+     * Run a callback periodically
+     * @param interval_ms Period in milliseconds
+     * @param callback Called once per expiry, missed expiries are merged
+     * @return Handler id, 0 on failure
+     */
+    int AddTimer(uint32_t interval_ms, Callback callback);
+
+    /**
+     * Change the period of a timer, restarting it
+     * @param id Handler id from AddTimer()
+     * @param interval_ms New period in milliseconds, the next expiry is this far away
+     * @return false if id is not a timer
+     */
+    bool SetTimerInterval(int id, uint32_t interval_ms);
+
+    /**
+     * Stop watching a descriptor or cancel a timer
+     * @param id Handler id from AddFd() or AddTimer()
+     */
+    void Remove(int id);
+
+    /**
+     * Run a callback once on the reactor thread
+     * @return false if the reactor is not running
+     */
+    bool Post(Callback callback);
+
+private:
+    struct Handler {
+        int fd = -1;
+        bool is_timer = false;        ///< Owns a timerfd
+        FdCallback fd_callback;
+        Callback timer_callback;
+        std::recursive_mutex mutex;   ///< Held while a callback runs
+        bool active = true;
+    };
+
+    static constexpr int MAX_EVENTS = 16;
+
+    int m_epoll_fd = -1;
+    int m_event_fd = -1;
+    std::thread m_thread;
+    std::thread::id m_thread_id;
+    std::atomic<bool> m_running{false};
+
+    std::mutex m_handlers_mutex;
+    std::map<int, std::shared_ptr<Handler>> m_handlers;
+    int m_next_id = 1;
+
+    std::mutex m_post_mutex;
+    std::vector<Callback> m_posted;
+
+    int AddHandler(std::shared_ptr<Handler> handler, uint32_t events);
+    static bool ArmTimer(int fd, uint32_t interval_ms);
+    void Run();
+    void Dispatch(int id, uint32_t events);
+    void RunPosted();
+    void Wake();
+};
+
+} // namespace hdmi_pvr
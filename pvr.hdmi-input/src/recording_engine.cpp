@@ -0,0 +1,410 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Recording Engine Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "recording_engine.h"
+#include "log.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+
+namespace hdmi_pvr {
+
+namespace {
+
+// Frames of one format share a format record; the frame size is not part
+// of it, bytesused may vary a little between frames
+bool IsSameFormat(const RawRecord& a, const RawRecord& b) {
+    return a.width == b.width && a.height == b.height && a.fourcc == b.fourcc &&
+           a.bytes_per_line == b.bytes_per_line && a.fps_num == b.fps_num && a.fps_den == b.fps_den;
+}
+
+} // namespace
+
+RecordingEngine::RecordingEngine(size_t segment_size, size_t segment_count)
+    : m_segment_size((std::max(segment_size, IO_ALIGNMENT) + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT) {
+    segment_count = std::max<size_t>(segment_count, 2);
+    m_storage.reserve(segment_count);
+
+    for (size_t i = 0; i < segment_count; ++i) {
+        auto* data = static_cast<uint8_t*>(aligned_alloc(IO_ALIGNMENT, m_segment_size));
+        if (!data) {
+            Log(LogLevel::Error, "Failed to allocate recording segment of size %zu", m_segment_size);
+            break;
+        }
+        m_storage.emplace_back(data);
+    }
+
+    Log(LogLevel::Debug, "RecordingEngine created with %zu segments of %zu bytes",
+        m_storage.size(), m_segment_size);
+}
+
+RecordingEngine::~RecordingEngine() {
+    Stop();
+}
+
+bool RecordingEngine::Start(const std::string& path) {
+    if (m_recording.load()) {
+        Log(LogLevel::Warning, "Recording already active: %s", m_path.c_str());
+        return false;
+    }
+
+    if (m_storage.size() < 2) {
+        Log(LogLevel::Error, "Not enough recording segments available");
+        return false;
+    }
+
+    // O_DIRECT keeps recordings out of the page cache; tmpfs and some
+    // filesystems reject it, in which case buffered writes are used
+    m_direct_io = true;
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+    if (m_fd < 0 && errno == EINVAL) {
+        m_direct_io = false;
+        m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (m_fd < 0) {
+        Log(LogLevel::Error, "Failed to create recording %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_free_segments.clear();
+        m_full_segments.clear();
+        for (auto& storage : m_storage) {
+            m_free_segments.push_back({storage.get(), 0});
+        }
+        m_current = m_free_segments.front();
+        m_free_segments.pop_front();
+        m_stop_requested = false;
+        m_path = path;
+    }
+
+    m_file_offset = 0;
+    m_logical_size = 0;
+    m_write_failed = false;
+    m_in_gap = false;
+    m_lost = 0;
+    m_format = {};
+    m_index.clear();
+    m_bytes_written.store(0);
+    m_frames_recorded.store(0);
+    m_frames_dropped.store(0);
+    m_dropped_segments.store(0);
+    m_write_time_us.store(0);
+    m_elapsed_us.store(0);
+    m_start_time = std::chrono::steady_clock::now();
+
+    // The header leads the first segment; until Stop() adds the index the
+    // file is read by walking the records
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    m_created_us = static_cast<uint64_t>(now.tv_sec) * 1000000ULL + static_cast<uint64_t>(now.tv_nsec) / 1000;
+    RawCaptureHeader header = RawCaptureRecorder::CreateHeader(m_created_us);
+    std::memcpy(m_current.data, &header, sizeof(header));
+    m_current.used = sizeof(header);
+    m_stream_end = sizeof(header);
+
+    m_writer_thread = std::thread(&RecordingEngine::WriterThread, this);
+    m_recording.store(true);
+
+    Log(LogLevel::Info, "Recording started: %s (%s)", path.c_str(),
+        m_direct_io ? "direct I/O" : "buffered I/O");
+    return true;
+}
+
+void RecordingEngine::Stop() {
+    if (!m_recording.load()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> submit_lock(m_submit_mutex);
+        m_recording.store(false);
+
+        // Queue the partially filled tail segment
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        if (m_current.data && m_current.used > 0) {
+            m_full_segments.push_back(m_current);
+        }
+        m_current = {};
+        m_stop_requested = true;
+    }
+    m_queue_condition.notify_all();
+
+    if (m_writer_thread.joinable()) {
+        m_writer_thread.join();
+    }
+
+    // Direct I/O pads the tail to the block size - trim it off again
+    if (m_direct_io && ftruncate(m_fd, static_cast<off_t>(m_logical_size)) != 0) {
+        Log(LogLevel::Warning, "Failed to trim recording %s: %s", m_path.c_str(), strerror(errno));
+    }
+
+    // The index is small and unaligned, it goes through the page cache.
+    // After a write error the file is still read up to the last complete
+    // record by walking it.
+    if (!m_write_failed) {
+        if (m_direct_io) {
+            fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+        }
+        if (RawCaptureRecorder::WriteIndex(m_fd, m_index, m_stream_end, m_created_us)) {
+            m_bytes_written.fetch_add(m_index.size() * sizeof(RawRecord));
+        } else {
+            Log(LogLevel::Warning, "Failed to write the recording index of %s: %s", m_path.c_str(), strerror(errno));
+        }
+    }
+    m_index.clear();
+    m_index.shrink_to_fit();
+    close(m_fd);
+    m_fd = -1;
+
+    m_elapsed_us.store(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - m_start_time).count());
+
+    RecordingStats stats = GetStats();
+    Log(LogLevel::Info, "Recording stopped: %s - %llu bytes, %.1f MB/s sustained, "
+        "%llu frames dropped in %u gaps", m_path.c_str(),
+        static_cast<unsigned long long>(stats.bytes_written), stats.sustained_mbps,
+        static_cast<unsigned long long>(stats.frames_dropped), stats.dropped_segments);
+}
+
+std::string RecordingEngine::GetPath() const {
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    return m_path;
+}
+
+bool RecordingEngine::SubmitFrame(const Frame& frame, const FrameGeometry& geometry, const FrameRate& frame_rate) {
+    if (frame.Size() == 0 || !m_recording.load()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> submit_lock(m_submit_mutex);
+    if (!m_recording.load()) {
+        return false;
+    }
+
+    RawRecord format = {};
+    format.type = RAW_RECORD_FORMAT;
+    format.sequence = frame.sequence;
+    format.timestamp_us = frame.timestamp;
+    format.width = geometry.width;
+    format.height = geometry.height;
+    format.fourcc = geometry.fourcc;
+    format.bytes_per_line = geometry.bytes_per_line;
+    format.frame_size = static_cast<uint32_t>(frame.Size());
+    format.fps_num = frame_rate.num;
+    format.fps_den = frame_rate.den;
+    bool format_changed = m_index.empty() || !IsSameFormat(format, m_format);
+
+    // Only accept the frame if it fits entirely, a partial frame would
+    // corrupt everything after it
+    uint64_t end = format_changed ? RawCaptureRecorder::GetPayloadOffset(m_stream_end) : m_stream_end;
+    uint64_t required = RawCaptureRecorder::GetPayloadOffset(end) + frame.Size() - m_stream_end;
+    size_t available = m_current.data ? m_segment_size - m_current.used : 0;
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        available += m_free_segments.size() * m_segment_size;
+    }
+
+    if (available < required) {
+        m_frames_dropped.fetch_add(1);
+        ++m_lost;
+        if (!m_in_gap) {
+            m_in_gap = true;
+            m_dropped_segments.fetch_add(1);
+            Log(LogLevel::Warning, "Recording storage too slow, dropping frames");
+        }
+        return false;
+    }
+
+    if (format_changed) {
+        if (!AppendRecord(format, nullptr)) {
+            // Cannot happen after the capacity check, but never block here
+            m_frames_dropped.fetch_add(1);
+            return false;
+        }
+        m_format = format;
+    }
+
+    RawRecord record = {};
+    record.type = RAW_RECORD_FRAME;
+    record.payload_size = frame.Size();
+    record.sequence = frame.sequence;
+    record.timestamp_us = frame.timestamp;
+    record.lost_before = m_lost;
+    if (!AppendRecord(record, frame.Data())) {
+        m_frames_dropped.fetch_add(1);
+        return false;
+    }
+
+    m_lost = 0;
+    m_in_gap = false;
+    m_frames_recorded.fetch_add(1);
+    return true;
+}
+
+RecordingStats RecordingEngine::GetStats() const {
+    RecordingStats stats;
+    stats.bytes_written = m_bytes_written.load();
+    stats.frames_recorded = m_frames_recorded.load();
+    stats.frames_dropped = m_frames_dropped.load();
+    stats.dropped_segments = m_dropped_segments.load();
+
+    uint64_t write_time_us = m_write_time_us.load();
+    if (write_time_us > 0) {
+        stats.write_mbps = static_cast<double>(stats.bytes_written) / write_time_us;
+    }
+
+    int64_t elapsed_us = m_recording.load()
+        ? std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - m_start_time).count()
+        : m_elapsed_us.load();
+    if (elapsed_us > 0) {
+        stats.sustained_mbps = static_cast<double>(stats.bytes_written) / elapsed_us;
+    }
+
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    stats.queued_segments = static_cast<uint32_t>(m_full_segments.size());
+    return stats;
+}
+
+//
+// Private methods
+//
+
+void RecordingEngine::WriterThread() {
+    Log(LogLevel::Debug, "Recording writer thread started");
+
+    while (true) {
+        Segment segment;
+        {
+            std::unique_lock<std::mutex> lock(m_queue_mutex);
+            m_queue_condition.wait(lock, [this]() {
+                return !m_full_segments.empty() || m_stop_requested;
+            });
+
+            if (m_full_segments.empty()) {
+                break;  // Stop requested and everything flushed
+            }
+
+            segment = m_full_segments.front();
+            m_full_segments.pop_front();
+        }
+
+        if (!m_write_failed && !WriteSegment(segment)) {
+            // Keep draining so the capture side does not stall on a dead disk
+            m_write_failed = true;
+            Log(LogLevel::Error, "Recording write failed: %s", strerror(errno));
+        }
+
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        segment.used = 0;
+        m_free_segments.push_back(segment);
+    }
+
+    Log(LogLevel::Debug, "Recording writer thread finished");
+}
+
+bool RecordingEngine::WriteSegment(Segment& segment) {
+    size_t length = segment.used;
+    if (m_direct_io) {
+        // O_DIRECT needs block-sized writes; only the final segment is partial
+        size_t aligned = (length + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT;
+        std::memset(segment.data + length, 0, aligned - length);
+        length = aligned;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    size_t written = 0;
+    while (written < length) {
+        ssize_t ret = pwrite(m_fd, segment.data + written, length - written,
+                             static_cast<off_t>(m_file_offset + written));
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(ret);
+    }
+
+    m_write_time_us.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+
+    m_file_offset += length;
+    m_logical_size += segment.used;
+    m_bytes_written.fetch_add(segment.used);
+    return true;
+}
+
+bool RecordingEngine::RotateSegment() {
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        if (m_current.data && m_current.used > 0) {
+            m_full_segments.push_back(m_current);
+            m_current = {};
+        }
+
+        if (!m_free_segments.empty()) {
+            m_current = m_free_segments.front();
+            m_free_segments.pop_front();
+        }
+    }
+    m_queue_condition.notify_one();
+
+    return m_current.data != nullptr;
+}
+
+bool RecordingEngine::Append(const void* data, size_t size) {
+    const auto* src = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        if (!m_current.data || m_current.used == m_segment_size) {
+            if (!RotateSegment()) {
+                return false;
+            }
+        }
+
+        size_t chunk = std::min(size, m_segment_size - m_current.used);
+        if (src) {
+            std::memcpy(m_current.data + m_current.used, src, chunk);
+            src += chunk;
+        } else {
+            std::memset(m_current.data + m_current.used, 0, chunk);
+        }
+        m_current.used += chunk;
+        size -= chunk;
+    }
+
+    if (m_current.used == m_segment_size) {
+        RotateSegment();
+    }
+    return true;
+}
+
+bool RecordingEngine::AppendRecord(RawRecord& record, const void* payload) {
+    // Same layout as RawCaptureRecorder: the record sits right in front of
+    // its page-aligned payload
+    record.magic = RAW_RECORD_MAGIC;
+    record.payload_offset = RawCaptureRecorder::GetPayloadOffset(m_stream_end);
+    size_t padding = static_cast<size_t>(record.payload_offset - sizeof(RawRecord) - m_stream_end);
+    if (!Append(nullptr, padding) || !Append(&record, sizeof(record)) ||
+        !Append(payload, static_cast<size_t>(record.payload_size))) {
+        return false;
+    }
+
+    m_stream_end = record.payload_offset + record.payload_size;
+    m_index.push_back(record);
+    return true;
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,198 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "frame.h"
+#include "raw_capture.h"
+#include "types.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+namespace hdmi_pvr {
+
+/**
+ * Recording statistics snapshot
+ */
+struct RecordingStats {
+    uint64_t bytes_written = 0;      ///< Bytes committed to storage
+    uint64_t frames_recorded = 0;    ///< Frames accepted into the write queue
+    uint64_t frames_dropped = 0;     ///< Frames dropped because storage fell behind
+    uint32_t dropped_segments = 0;   ///< Contiguous gaps in the recording
+    double write_mbps = 0.0;         ///< Throughput while the writer was busy (MB/s)
+    double sustained_mbps = 0.0;     ///< Bytes written over recording wall time (MB/s)
+    uint32_t queued_segments = 0;    ///< Segments waiting for the writer
+};
+
+/**
+ * RecordingEngine writes the captured stream to a file from a dedicated
+ * writer thread.
+ *
+ * The file is a raw capture container (see raw_capture.h): every frame has
+ * a record with its presentation time in front of it, and a format record
+ * precedes the first frame and every layout change, so a recording can be
+ * played back without knowing how it was captured.
+ *
+ * Frames are packed into large page-aligned segments that are written with
+ * O_DIRECT, so the page cache is bypassed and eMMC sees long sequential
+ * writes. The segment pool is fixed: when storage cannot keep up the capture
+ * thread drops the frame instead of waiting, and the gap is reported in the
+ * statistics.
+ */
+class RecordingEngine {
+public:
+    /**
+     * Constructor
+     * @param segment_size Size of each write batch in bytes (rounded to 4 KiB)
+     * @param segment_count Number of batches that may be in flight
+     */
+    explicit RecordingEngine(size_t segment_size = 4 * 1024 * 1024, size_t segment_count = 8);
+
+    /**
+     * Destructor - stops any active recording
+     */
+    ~RecordingEngine();
+
+    RecordingEngine(const RecordingEngine&) = delete;
+    RecordingEngine& operator=(const RecordingEngine&) = delete;
+
+    /**
+     * Open the output file and start the writer thread
+     * @param path Output file path
+     * @return true if recording started
+     */
+    bool Start(const std::string& path);
+
+    /**
+     * Flush pending segments, finalize the file and stop the writer thread
+     */
+    void Stop();
+
+    /**
+     * Check if a recording is active
+     * @return true if recording
+     */
+    bool IsRecording() const { return m_recording.load(); }
+
+    /**
+     * Get the path of the active or last recording
+     * @return Output file path
+     */
+    std::string GetPath() const;
+
+    /**
+     * Queue a frame for writing. Never blocks on storage.
+     * @param frame Captured frame, stored with its timestamp as presentation time
+     * @param geometry Layout the frame was captured in
+     * @param frame_rate Frame rate of the stream
+     * @return true if queued, false if dropped or not recording
+     */
+    bool SubmitFrame(const Frame& frame, const FrameGeometry& geometry, const FrameRate& frame_rate);
+
+    /**
+     * Get recording statistics
+     * @return Statistics snapshot
+     */
+    RecordingStats GetStats() const;
+
+private:
+    struct Segment {
+        uint8_t* data = nullptr;
+        size_t used = 0;
+    };
+
+    struct AlignedDeleter {
+        void operator()(uint8_t* ptr) const { free(ptr); }
+    };
+
+    static constexpr size_t IO_ALIGNMENT = 4096;
+
+    size_t m_segment_size;
+    std::vector<std::unique_ptr<uint8_t, AlignedDeleter>> m_storage;
+
+    // File state
+    std::string m_path;
+    int m_fd = -1;
+    bool m_direct_io = false;
+    uint64_t m_file_offset = 0;      ///< Aligned write position (writer thread only)
+    uint64_t m_logical_size = 0;     ///< Bytes of real data (writer thread only)
+    bool m_write_failed = false;     ///< (writer thread only until joined)
+    uint64_t m_created_us = 0;       ///< Wall clock at Start(), for the header
+
+    // Segment queues
+    mutable std::mutex m_queue_mutex;
+    std::condition_variable m_queue_condition;
+    std::deque<Segment> m_free_segments;
+    std::deque<Segment> m_full_segments;
+    std::mutex m_submit_mutex;       ///< Serializes SubmitFrame() against Stop()
+    Segment m_current;               ///< Segment being filled (under m_submit_mutex)
+    bool m_in_gap = false;           ///< Last frame was dropped (under m_submit_mutex)
+    uint32_t m_lost = 0;             ///< Frames dropped since the last record (under m_submit_mutex)
+    uint64_t m_stream_end = 0;       ///< End of the last payload queued (under m_submit_mutex)
+    RawRecord m_format = {};         ///< Format of the frames being written (under m_submit_mutex)
+    std::vector<RawRecord> m_index;  ///< Records queued so far (under m_submit_mutex)
+
+    // Threading
+    std::thread m_writer_thread;
+    std::atomic<bool> m_recording{false};
+    bool m_stop_requested = false;
+
+    // Statistics
+    std::atomic<uint64_t> m_bytes_written{0};
+    std::atomic<uint64_t> m_frames_recorded{0};
+    std::atomic<uint64_t> m_frames_dropped{0};
+    std::atomic<uint32_t> m_dropped_segments{0};
+    std::atomic<uint64_t> m_write_time_us{0};
+    std::chrono::steady_clock::time_point m_start_time;
+    std::atomic<int64_t> m_elapsed_us{0};
+
+    /**
+     * Writer thread function
+     */
+    void WriterThread();
+
+    /**
+     * Write one segment to the file
+     * @param segment Segment to write
+     * @return true on success
+     */
+    bool WriteSegment(Segment& segment);
+
+    /**
+     * Queue the current segment for writing and take a free one
+     * @return true if a free segment was available
+     */
+    bool RotateSegment();
+
+    /**
+     * Copy bytes into the segments, rotating as they fill up
+     * @param data Bytes to copy, nullptr for zero padding
+     * @param size Number of bytes
+     * @return true if everything was copied
+     */
+    bool Append(const void* data, size_t size);
+
+    /**
+     * Append a record, padded so its payload starts page aligned, and the payload
+     * @param record Record to complete with its magic and payload offset
+     * @param payload record.payload_size bytes, nullptr for format records
+     * @return true if record and payload were copied
+     */
+    bool AppendRecord(RawRecord& record, const void* payload);
+};
+
+} // namespace hdmi_pvr
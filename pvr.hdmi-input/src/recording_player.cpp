@@ -0,0 +1,137 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Recording Playback Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "recording_player.h"
+#include "frame_converter.h"
+#include "log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace hdmi_pvr {
+
+bool RecordingPlayer::Open(const std::string& path) {
+    Close();
+    if (!m_reader.Open(path)) {
+        return false;
+    }
+
+    // Frames ahead of the first format record, or too short for their
+    // layout, cannot be converted and are left out
+    const RawRecord* format = nullptr;
+    for (const auto& record : m_reader.GetRecords()) {
+        if (record.type == RAW_RECORD_FORMAT) {
+            format = &record;
+        } else if (format && m_reader.GetPayload(record)) {
+            size_t source_size = FrameConverter::GetSourceSize(ToGeometry(*format));
+            if (source_size > 0 && record.payload_size >= source_size) {
+                m_frames.push_back({&record, format});
+            }
+        }
+    }
+
+    if (m_frames.empty()) {
+        Log(LogLevel::Error, "Recording %s has no playable frames", path.c_str());
+        Close();
+        return false;
+    }
+
+    m_announced = m_frames.front().format;
+    Log(LogLevel::Info, "Playing recording %s: %zu frames, %ux%u@%s", path.c_str(), m_frames.size(),
+        m_announced->width, m_announced->height,
+        RawCaptureReader::ToVideoFormat(*m_announced).frame_rate.to_string().c_str());
+    return true;
+}
+
+void RecordingPlayer::Close() {
+    m_frames.clear();
+    m_position = 0;
+    m_announced = nullptr;
+    m_reader.Close();
+}
+
+PVR_ERROR RecordingPlayer::GetStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties,
+                                               const StreamProcessor::CodecLookup& lookup) const {
+    if (!m_announced) {
+        return PVR_ERROR_FAILED;
+    }
+
+    properties.clear();
+    VideoStreamDescriptor video = StreamProcessor::DescribeVideoStream(
+        ToGeometry(*m_announced), FrameRate::from_ratio(m_announced->fps_num, m_announced->fps_den));
+    return StreamProcessor::AddVideoStreamProperties(video, lookup, properties);
+}
+
+DEMUX_PACKET* RecordingPlayer::DemuxRead(const StreamProcessor::DemuxPacketAllocator& allocate) {
+    if (m_position >= m_frames.size()) {
+        return nullptr;
+    }
+
+    // Kodi fetches the stream properties again on a stream change
+    const FrameEntry& entry = m_frames[m_position];
+    if (entry.format != m_announced) {
+        DEMUX_PACKET* packet = allocate(0);
+        if (!packet) {
+            return nullptr;
+        }
+        packet->iStreamId = DMX_SPECIALID_STREAMCHANGE;
+        m_announced = entry.format;
+        Log(LogLevel::Debug, "Recording changes to %ux%u", m_announced->width, m_announced->height);
+        return packet;
+    }
+
+    const RawRecord& record = *entry.record;
+    DEMUX_PACKET* packet = StreamProcessor::CreateDemuxPacket(m_reader.GetPayload(record),
+                                                              static_cast<size_t>(record.payload_size),
+                                                              ToGeometry(*entry.format), record.timestamp_us,
+                                                              0, allocate);
+    if (packet) {
+        ++m_position;
+    }
+    return packet;
+}
+
+bool RecordingPlayer::SeekTime(double time_ms, bool backwards, double& start_pts) {
+    if (m_frames.empty()) {
+        return false;
+    }
+
+    // Recorded timestamps are presentation times, ordered like the frames
+    uint64_t target = time_ms > 0 ? static_cast<uint64_t>(std::llround(time_ms * 1000)) : 0;
+    auto it = std::lower_bound(m_frames.begin(), m_frames.end(), target,
+        [](const FrameEntry& entry, uint64_t time) { return entry.record->timestamp_us < time; });
+    if (it == m_frames.end()) {
+        it = std::prev(it);
+    } else if (backwards && it->record->timestamp_us > target && it != m_frames.begin()) {
+        it = std::prev(it);
+    }
+
+    m_position = static_cast<size_t>(it - m_frames.begin());
+    start_pts = static_cast<double>(it->record->timestamp_us);
+    Log(LogLevel::Debug, "Recording seek to %.0f ms landed on frame %zu", time_ms, m_position);
+    return true;
+}
+
+bool RecordingPlayer::GetTimes(uint64_t& begin_us, uint64_t& end_us) const {
+    if (m_frames.empty()) {
+        return false;
+    }
+    begin_us = m_frames.front().record->timestamp_us;
+    end_us = m_frames.back().record->timestamp_us;
+    return true;
+}
+
+FrameGeometry RecordingPlayer::ToGeometry(const RawRecord& format) {
+    FrameGeometry geometry;
+    geometry.width = format.width;
+    geometry.height = format.height;
+    geometry.bytes_per_line = format.bytes_per_line;
+    geometry.fourcc = format.fourcc;
+    return geometry;
+}
+
+} // namespace hdmi_pvr
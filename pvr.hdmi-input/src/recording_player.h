@@ -0,0 +1,93 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "raw_capture.h"
+#include "stream_processor.h"
+#include <kodi/addon-instance/PVR.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hdmi_pvr {
+
+/**
+ * RecordingPlayer plays a recording written by RecordingEngine through
+ * Kodi's demuxer.
+ *
+ * Frames go out as demux packets exactly like the live stream, converted
+ * with the layout of the format record in force and stamped with their
+ * recorded presentation time; Kodi paces playback by those. Where the
+ * format changes a stream change packet comes first, so the stream
+ * properties always describe the frames that follow.
+ *
+ * Not thread-safe, the owner serializes all calls.
+ */
+class RecordingPlayer {
+public:
+    RecordingPlayer() = default;
+
+    RecordingPlayer(const RecordingPlayer&) = delete;
+    RecordingPlayer& operator=(const RecordingPlayer&) = delete;
+
+    /**
+     * Load a recording and position at its first frame
+     * @param path Recording file
+     * @return false if the file is unreadable or holds no playable frame
+     */
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return m_reader.IsOpen(); }
+
+    /**
+     * Get the stream list for the frames at the read position
+     * @param properties Vector to fill
+     * @param lookup Codec resolver of the add-on instance
+     * @return PVR_ERROR_NO_ERROR on success
+     */
+    PVR_ERROR GetStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties,
+                                  const StreamProcessor::CodecLookup& lookup) const;
+
+    /**
+     * Read the next frame as a demux packet
+     * @param allocate Packet allocator of the add-on instance
+     * @return DEMUX_PACKET, nullptr at the end of the recording
+     */
+    DEMUX_PACKET* DemuxRead(const StreamProcessor::DemuxPacketAllocator& allocate);
+
+    /**
+     * Move the read position to the frame at a time
+     * @param time_ms Target on the packet pts timeline, in milliseconds
+     * @param backwards Prefer the frame at or before the target
+     * @param start_pts Filled with the pts of that frame in microseconds
+     * @return true if the recording has frames
+     */
+    bool SeekTime(double time_ms, bool backwards, double& start_pts);
+
+    /**
+     * Get the pts of the first and last frame in microseconds
+     * @return true if the recording has frames
+     */
+    bool GetTimes(uint64_t& begin_us, uint64_t& end_us) const;
+
+private:
+    struct FrameEntry {
+        const RawRecord* record = nullptr;
+        const RawRecord* format = nullptr;  ///< Format record in force for the frame
+    };
+
+    static FrameGeometry ToGeometry(const RawRecord& format);
+
+    RawCaptureReader m_reader;
+    std::vector<FrameEntry> m_frames;       ///< Playable frames in file order
+    size_t m_position = 0;                  ///< Next frame to deliver
+    const RawRecord* m_announced = nullptr; ///< Format Kodi has the stream properties of
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,276 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Replay Capture Source Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "replay_source.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace hdmi_pvr {
+
+namespace {
+
+uint64_t MonotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+} // namespace
+
+ReplaySource::~ReplaySource() {
+    StopStreaming();
+}
+
+bool ReplaySource::Open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_streaming) {
+        Log(LogLevel::Error, "Cannot open a recording while replaying");
+        return false;
+    }
+
+    if (!m_reader.Open(path)) {
+        return false;
+    }
+
+    const auto& records = m_reader.GetRecords();
+    if (records.empty() || records.front().type != RAW_RECORD_FORMAT) {
+        Log(LogLevel::Error, "Raw capture %s does not start with a format", path.c_str());
+        m_reader.Close();
+        return false;
+    }
+
+    auto first_frame = std::find_if(records.begin(), records.end(),
+                                    [](const RawRecord& record) { return record.type == RAW_RECORD_FRAME; });
+    m_first_timestamp = first_frame != records.end() ? first_frame->timestamp_us : 0;
+    Rewind();
+
+    Log(LogLevel::Info, "Replaying %s: %s, %llu frames", path.c_str(), m_format.to_string().c_str(),
+        static_cast<unsigned long long>(m_reader.GetFrameCount()));
+    return true;
+}
+
+void ReplaySource::Close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_streaming) {
+        Log(LogLevel::Error, "Cannot close the recording while replaying");
+        return;
+    }
+    m_reader.Close();
+    m_format = VideoFormat();
+    m_frame_size = 0;
+    m_bytes_per_line = 0;
+}
+
+bool ReplaySource::IsFinished() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished;
+}
+
+bool ReplaySource::StartStreaming() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_reader.IsOpen()) {
+        return false;
+    }
+    if (m_streaming) {
+        return true;
+    }
+
+    Rewind();
+    m_start_us = MonotonicMicros();
+    m_delivered = 0;
+    m_sequence_gaps = 0;
+    m_streaming = true;
+    return true;
+}
+
+bool ReplaySource::StopStreaming() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_streaming = false;
+    m_condition.notify_all();
+    return true;
+}
+
+VideoFormat ReplaySource::GetConfiguredFormat() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_format;
+}
+
+uint32_t ReplaySource::GetFrameSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frame_size;
+}
+
+uint32_t ReplaySource::GetBytesPerLine() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes_per_line;
+}
+
+bool ReplaySource::CaptureFrame(VideoBuffer& buffer, uint32_t timeout_ms) {
+    uint64_t timestamp = 0;
+    const RawRecord* record = NextFrame(timeout_ms, timestamp);
+    const uint8_t* payload = record ? m_reader.GetPayload(*record) : nullptr;
+    if (!payload) {
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(record->payload_size);
+    if (buffer.size < size) {
+        free(buffer.data);
+        buffer.data = aligned_alloc(4096, size);
+        buffer.size = buffer.data ? size : 0;
+    }
+    if (!buffer.data) {
+        return false;
+    }
+
+    memcpy(buffer.data, payload, size);
+    buffer.timestamp = timestamp;
+    buffer.in_use = true;
+    return true;
+}
+
+bool ReplaySource::CaptureFrameInto(uint8_t* dest, size_t capacity, size_t& frame_size,
+                                    uint64_t& timestamp, uint32_t timeout_ms) {
+    if (!dest) {
+        return false;
+    }
+
+    // The mapping stays valid while streaming, the copy needs no lock
+    const RawRecord* record = NextFrame(timeout_ms, timestamp);
+    const uint8_t* payload = record ? m_reader.GetPayload(*record) : nullptr;
+    if (!payload || record->payload_size > capacity) {
+        return false;
+    }
+
+    frame_size = static_cast<size_t>(record->payload_size);
+    memcpy(dest, payload, frame_size);
+    return true;
+}
+
+uint64_t ReplaySource::GetLastSequence() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_sequence;
+}
+
+bool ReplaySource::CheckSignalPresent() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_reader.IsOpen() && !m_finished;
+}
+
+SignalStatus ReplaySource::GetSignalStatus() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SignalStatus status;
+    status.connected = m_reader.IsOpen() && !m_finished;
+    status.signal_locked = status.connected;
+    status.signal_strength = status.connected ? 100 : 0;
+    status.signal_quality = status.connected ? 100 : 0;
+    if (status.connected) {
+        status.video_format = m_format;
+    }
+    status.device_name = "Replay";
+    status.last_update = std::chrono::steady_clock::now();
+    return status;
+}
+
+const RawRecord* ReplaySource::NextFrame(uint32_t timeout_ms, uint64_t& timestamp) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const auto& records = m_reader.GetRecords();
+    uint64_t deadline = MonotonicMicros() + static_cast<uint64_t>(timeout_ms) * 1000;
+
+    while (m_streaming && !m_finished) {
+        if (m_position >= records.size()) {
+            if (!m_loop || m_reader.GetFrameCount() == 0) {
+                m_finished = true;
+                Log(LogLevel::Info, "Replay finished after %llu frames",
+                    static_cast<unsigned long long>(m_delivered.load()));
+                break;
+            }
+            // The next lap starts one frame after the last one
+            m_loop_offset_us += m_last_timestamp - m_first_timestamp + FramePeriod();
+            m_position = 0;
+            m_have_sequence = false;
+            ApplyPendingFormats();
+            continue;
+        }
+
+        const RawRecord& record = records[m_position];
+        uint64_t offset = record.timestamp_us > m_first_timestamp ? record.timestamp_us - m_first_timestamp : 0;
+        uint64_t due = m_start_us + m_loop_offset_us + offset;
+
+        if (m_paced) {
+            uint64_t now = MonotonicMicros();
+            if (due > now) {
+                if (now >= deadline) {
+                    return nullptr;
+                }
+                m_condition.wait_for(lock, std::chrono::microseconds(std::min(due, deadline) - now));
+                continue;
+            }
+        }
+
+        if (m_have_sequence && record.sequence > m_last_sequence + 1) {
+            m_sequence_gaps.fetch_add(record.sequence - m_last_sequence - 1);
+        }
+        m_last_sequence = record.sequence;
+        m_have_sequence = true;
+        m_last_timestamp = record.timestamp_us;
+
+        // Sizes must describe the next frame before it is asked for
+        ++m_position;
+        ApplyPendingFormats();
+
+        m_delivered.fetch_add(1);
+        timestamp = due;
+        return &record;
+    }
+
+    // Nothing more to deliver - behave like a source without signal
+    if (m_streaming) {
+        uint64_t now = MonotonicMicros();
+        if (deadline > now) {
+            m_condition.wait_for(lock, std::chrono::microseconds(deadline - now));
+        }
+    }
+    return nullptr;
+}
+
+void ReplaySource::ApplyPendingFormats() {
+    const auto& records = m_reader.GetRecords();
+    while (m_position < records.size() && records[m_position].type == RAW_RECORD_FORMAT) {
+        const RawRecord& record = records[m_position];
+        VideoFormat format = RawCaptureReader::ToVideoFormat(record);
+        if (format != m_format && m_format.is_valid()) {
+            Log(LogLevel::Info, "Replay format change: %s -> %s", m_format.to_string().c_str(),
+                format.to_string().c_str());
+        }
+        m_format = format;
+        m_frame_size = record.frame_size;
+        m_bytes_per_line = record.bytes_per_line;
+        ++m_position;
+    }
+}
+
+void ReplaySource::Rewind() {
+    m_position = 0;
+    m_loop_offset_us = 0;
+    m_last_timestamp = m_first_timestamp;
+    m_have_sequence = false;
+    m_finished = false;
+    ApplyPendingFormats();
+}
+
+uint64_t ReplaySource::FramePeriod() const {
+    const FrameRate& rate = m_format.frame_rate;
+    return rate.is_valid() ? 1000000ULL * rate.den / rate.num : 16667;
+}
+
+} // namespace hdmi_pvr
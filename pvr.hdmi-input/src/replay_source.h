@@ -0,0 +1,107 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "capture_source.h"
+#include "raw_capture.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace hdmi_pvr {
+
+/**
+ * ReplaySource plays back a raw capture file (see raw_capture.h) in place
+ * of HDMI capture.
+ *
+ * Frames come out byte-for-byte as recorded, with the recorded spacing:
+ * the timeline is shifted to start with StartStreaming(), so timestamps
+ * stay CLOCK_MONOTONIC and comparable with the time of delivery. Format
+ * records switch GetConfiguredFormat()/GetFrameSize() for the frames that
+ * follow. Unpaced, frames are handed out as fast as they are pulled.
+ *
+ * A frame that is collected late is still delivered - the recording
+ * already holds the driver's losses, as gaps in the sequence numbers.
+ */
+class ReplaySource : public CaptureSource {
+public:
+    ReplaySource() = default;
+    ~ReplaySource() override;
+
+    /**
+     * Load a recording, only while not streaming
+     * @return false if the file is unreadable or holds no format
+     */
+    bool Open(const std::string& path);
+    void Close();  ///< Only while not streaming
+    bool IsOpen() const override { return m_reader.IsOpen(); }
+
+    void SetPaced(bool paced) { m_paced = paced; }
+    void SetLoop(bool loop) { m_loop = loop; }  ///< Start over at the end instead of running dry
+
+    /**
+     * Every frame of the recording was delivered (never with looping)
+     */
+    bool IsFinished() const;
+
+    // CaptureSource
+    bool StartStreaming() override;
+    bool StopStreaming() override;
+    VideoFormat GetConfiguredFormat() const override;
+    uint32_t GetFrameSize() const override;
+    uint32_t GetBytesPerLine() const override;
+    uint32_t GetBufferCount() const override { return REPLAY_BUFFER_COUNT; }
+    bool CaptureFrame(VideoBuffer& buffer, uint32_t timeout_ms = 1000) override;
+    bool CaptureFrameInto(uint8_t* dest, size_t capacity, size_t& frame_size,
+                          uint64_t& timestamp, uint32_t timeout_ms = 1000) override;
+    uint64_t GetLastSequence() const override;
+    bool CheckSignalPresent() override;
+    SignalStatus GetSignalStatus() override;
+
+    // Counters of the current stream
+    uint64_t GetFramesDelivered() const { return m_delivered.load(); }
+    uint64_t GetSequenceGaps() const { return m_sequence_gaps.load(); }  ///< Frames missing from the recording
+
+private:
+    static constexpr uint32_t REPLAY_BUFFER_COUNT = 4;  ///< Frames drained per readiness, as for V4L2
+
+    const RawRecord* NextFrame(uint32_t timeout_ms, uint64_t& timestamp);
+    void ApplyPendingFormats();
+    void Rewind();
+    uint64_t FramePeriod() const;
+
+    RawCaptureReader m_reader;
+    std::atomic<bool> m_paced{true};
+    std::atomic<bool> m_loop{false};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_streaming = false;
+
+    // Format of the frames at the current position
+    VideoFormat m_format;
+    uint32_t m_frame_size = 0;
+    uint32_t m_bytes_per_line = 0;
+
+    // Playback position
+    size_t m_position = 0;           ///< Next record
+    uint64_t m_start_us = 0;         ///< Monotonic time of the first frame
+    uint64_t m_first_timestamp = 0;  ///< Recorded timestamp of the first frame
+    uint64_t m_loop_offset_us = 0;   ///< Length of the laps already played
+    uint64_t m_last_timestamp = 0;   ///< Recorded timestamp of the last frame delivered
+    uint64_t m_last_sequence = 0;
+    bool m_have_sequence = false;
+    bool m_finished = false;
+
+    std::atomic<uint64_t> m_delivered{0};
+    std::atomic<uint64_t> m_sequence_gaps{0};
+};
+
+} // namespace hdmi_pvr
@@ -7,15 +7,16 @@
  */
 
 #include "signal_monitor.h"
-#include "v4l2_device.h"
-#include <kodi/General.h>
+#include "capture_source.h"
+#include "log.h"
+#include "trace.h"
 #include <algorithm>
 #include <numeric>
 
 namespace hdmi_pvr {
 
-SignalMonitor::SignalMonitor(std::shared_ptr<V4L2Device> v4l2_device)
-    : m_v4l2_device(std::move(v4l2_device)) {
+SignalMonitor::SignalMonitor(std::shared_ptr<CaptureSource> source)
+    : m_source(std::move(source)) {
     
     // Initialize quality history vectors
     m_strength_history.resize(QUALITY_HISTORY_SIZE, 0);
@@ -28,16 +29,16 @@ SignalMonitor::SignalMonitor(std::shared_ptr<V4L2Device> v4l2_device)
     m_last_stable_time = std::chrono::steady_clock::now();
     m_last_hotplug_time = std::chrono::steady_clock::now();
     
-    kodi::Log(ADDON_LOG_DEBUG, "SignalMonitor created");
+    Log(LogLevel::Debug, "SignalMonitor created");
 }
 
 SignalMonitor::~SignalMonitor() {
-    kodi::Log(ADDON_LOG_DEBUG, "SignalMonitor destructor called");
+    Log(LogLevel::Debug, "SignalMonitor destructor called");
     Shutdown();
 }
 
 SignalMonitor::SignalMonitor(SignalMonitor&& other) noexcept 
-    : m_v4l2_device(std::move(other.m_v4l2_device))
+    : m_source(std::move(other.m_source))
     , m_active(other.m_active.load())
     , m_shutdown_requested(other.m_shutdown_requested.load())
     , m_monitor_thread(std::move(other.m_monitor_thread))
@@ -47,6 +48,8 @@ SignalMonitor::SignalMonitor(SignalMonitor&& other) noexcept
     , m_hotplug_callback(std::move(other.m_hotplug_callback))
     , m_update_interval_ms(other.m_update_interval_ms.load())
     , m_detailed_analysis(other.m_detailed_analysis.load())
+    , m_poll_interval_ms(other.m_poll_interval_ms.load())
+    , m_burst_until(other.m_burst_until)
     , m_last_stable_time(other.m_last_stable_time)
     , m_stability_threshold_ms(other.m_stability_threshold_ms)
     , m_consecutive_stable_readings(other.m_consecutive_stable_readings)
@@ -67,7 +70,7 @@ SignalMonitor& SignalMonitor::operator=(SignalMonitor&& other) noexcept {
         Shutdown();
         
         // Move data from other
-        m_v4l2_device = std::move(other.m_v4l2_device);
+        m_source = std::move(other.m_source);
         m_active.store(other.m_active.load());
         m_shutdown_requested.store(other.m_shutdown_requested.load());
         m_monitor_thread = std::move(other.m_monitor_thread);
@@ -77,6 +80,8 @@ SignalMonitor& SignalMonitor::operator=(SignalMonitor&& other) noexcept {
         m_hotplug_callback = std::move(other.m_hotplug_callback);
         m_update_interval_ms.store(other.m_update_interval_ms.load());
         m_detailed_analysis.store(other.m_detailed_analysis.load());
+        m_poll_interval_ms.store(other.m_poll_interval_ms.load());
+        m_burst_until = other.m_burst_until;
         m_last_stable_time = other.m_last_stable_time;
         m_stability_threshold_ms = other.m_stability_threshold_ms;
         m_consecutive_stable_readings = other.m_consecutive_stable_readings;
@@ -93,14 +98,14 @@ SignalMonitor& SignalMonitor::operator=(SignalMonitor&& other) noexcept {
     return *this;
 }
 
-bool SignalMonitor::Initialize() {
+bool SignalMonitor::Initialize(bool start_thread) {
     if (m_active.load()) {
-        kodi::Log(ADDON_LOG_WARNING, "SignalMonitor already initialized");
+        Log(LogLevel::Warning, "SignalMonitor already initialized");
         return true;
     }
     
     if (!ValidateDevice()) {
-        kodi::Log(ADDON_LOG_ERROR, "V4L2 device validation failed");
+        Log(LogLevel::Error, "Capture source validation failed");
         return false;
     }
     
@@ -109,10 +114,12 @@ bool SignalMonitor::Initialize() {
     
     // Start monitoring thread
     m_shutdown_requested.store(false);
-    m_monitor_thread = std::thread(&SignalMonitor::MonitorThread, this);
+    if (start_thread) {
+        m_monitor_thread = std::thread(&SignalMonitor::MonitorThread, this);
+    }
     
     m_active.store(true);
-    kodi::Log(ADDON_LOG_INFO, "SignalMonitor initialized successfully");
+    Log(LogLevel::Info, "SignalMonitor initialized successfully");
     return true;
 }
 
@@ -121,7 +128,7 @@ void SignalMonitor::Shutdown() {
         return;
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Shutting down SignalMonitor");
+    Log(LogLevel::Debug, "Shutting down SignalMonitor");
     
     // Signal shutdown to monitoring thread
     m_shutdown_requested.store(true);
@@ -140,7 +147,7 @@ void SignalMonitor::Shutdown() {
     }
     
     m_active.store(false);
-    kodi::Log(ADDON_LOG_INFO, "SignalMonitor shutdown complete");
+    Log(LogLevel::Info, "SignalMonitor shutdown complete");
 }
 
 SignalStatus SignalMonitor::GetSignalStatus() const {
@@ -149,7 +156,7 @@ SignalStatus SignalMonitor::GetSignalStatus() const {
 }
 
 bool SignalMonitor::UpdateSignalStatus() {
-    if (!m_active.load() || !m_v4l2_device) {
+    if (!m_active.load() || !m_source) {
         return false;
     }
     
@@ -189,13 +196,13 @@ AudioFormat SignalMonitor::GetAudioFormat() const {
 void SignalMonitor::SetStatusCallback(StatusCallback callback) {
     std::lock_guard<std::mutex> lock(m_callback_mutex);
     m_status_callback = std::move(callback);
-    kodi::Log(ADDON_LOG_DEBUG, "Status callback registered");
+    Log(LogLevel::Debug, "Status callback registered");
 }
 
 void SignalMonitor::SetHotPlugCallback(HotPlugCallback callback) {
     std::lock_guard<std::mutex> lock(m_callback_mutex);
     m_hotplug_callback = std::move(callback);
-    kodi::Log(ADDON_LOG_DEBUG, "Hot-plug callback registered");
+    Log(LogLevel::Debug, "Hot-plug callback registered");
 }
 
 void SignalMonitor::SetUpdateInterval(uint32_t interval_ms) {
@@ -206,44 +213,51 @@ void SignalMonitor::SetUpdateInterval(uint32_t interval_ms) {
     }
     
     m_update_interval_ms.store(interval_ms);
+    m_poll_interval_ms.store(interval_ms);
     m_thread_cv.notify_all();
     
-    kodi::Log(ADDON_LOG_DEBUG, "Update interval set to %u ms", interval_ms);
+    Log(LogLevel::Debug, "Update interval set to %u ms", interval_ms);
+}
+
+void SignalMonitor::RequestBurst() {
+    m_burst_requested.store(true);
+    m_poll_interval_ms.store(BURST_INTERVAL_MS);
+    m_thread_cv.notify_all();
 }
 
 // Private methods
 
 void SignalMonitor::MonitorThread() {
-    kodi::Log(ADDON_LOG_DEBUG, "Signal monitoring thread started");
+    Log(LogLevel::Debug, "Signal monitoring thread started");
     
     while (!m_shutdown_requested.load()) {
         try {
             // Check signal status
             CheckSignalStatus();
             
-            // Wait for next update interval or shutdown signal
+            // Wait for the next scheduled poll, a burst request or shutdown
             std::unique_lock<std::mutex> lock(m_thread_mutex);
-            auto timeout = std::chrono::milliseconds(m_update_interval_ms.load());
+            auto timeout = std::chrono::milliseconds(m_poll_interval_ms.load());
             m_thread_cv.wait_for(lock, timeout, [this]() {
-                return m_shutdown_requested.load();
+                return m_shutdown_requested.load() || m_burst_requested.load();
             });
         }
         catch (const std::exception& e) {
-            kodi::Log(ADDON_LOG_ERROR, "Exception in signal monitoring thread: %s", e.what());
+            Log(LogLevel::Error, "Exception in signal monitoring thread: %s", e.what());
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Signal monitoring thread finished");
+    Log(LogLevel::Debug, "Signal monitoring thread finished");
 }
 
 bool SignalMonitor::CheckSignalStatus() {
-    if (!m_v4l2_device) {
+    if (!m_source) {
         return false;
     }
     
-    // Get current status from V4L2 device
-    SignalStatus new_status = m_v4l2_device->GetSignalStatus();
+    // Get current status from the capture source
+    SignalStatus new_status = m_source->GetSignalStatus();
     
     // Perform detailed analysis if enabled
     if (m_detailed_analysis.load()) {
@@ -261,7 +275,7 @@ bool SignalMonitor::CheckSignalStatus() {
     AnalyzeSignalStability(new_status);
     
     // Check for hot-plug events
-    CheckHotPlugEvents(new_status);
+    bool hotplug = CheckHotPlugEvents(new_status);
     
     // Update current status
     bool status_changed = false;
@@ -276,12 +290,56 @@ bool SignalMonitor::CheckSignalStatus() {
     
     // Trigger callbacks if status changed significantly
     if (status_changed) {
+        if (IsTracing()) {
+            TraceSignalChange(new_status);
+        }
         TriggerStatusCallback(new_status);
     }
     
+    SchedulePoll(hotplug || status_changed);
     return true;
 }
 
+void SignalMonitor::TraceSignalChange(const SignalStatus& status) {
+    SignalStatus previous;
+    {
+        std::lock_guard<std::mutex> lock(m_status_mutex);
+        previous = m_previous_status;
+    }
+    
+    if (status.connected != previous.connected || status.signal_locked != previous.signal_locked) {
+        TraceInstant("signal change connected=%d locked=%d", status.connected ? 1 : 0,
+                     status.signal_locked ? 1 : 0);
+    }
+    if (status.video_format.is_valid() &&
+        (status.video_format.width != previous.video_format.width ||
+        status.video_format.height != previous.video_format.height ||
+         status.video_format.frame_rate != previous.video_format.frame_rate)) {
+        TraceInstant("format change %s", status.video_format.to_string().c_str());
+    }
+}
+
+void SignalMonitor::SchedulePoll(bool changed) {
+    auto now = std::chrono::steady_clock::now();
+    
+    // A change may be followed by more while the source settles
+    if (changed || m_burst_requested.exchange(false)) {
+        m_burst_until = now + std::chrono::milliseconds(BURST_DURATION_MS);
+    }
+    
+    uint32_t base = m_update_interval_ms.load();
+    uint32_t interval = base;
+    if (now < m_burst_until) {
+        interval = BURST_INTERVAL_MS;
+    } else if (m_consecutive_stable_readings >= MIN_STABLE_READINGS) {
+        // Stable lock - back off, doubling from the base interval
+        uint32_t previous = std::max(m_poll_interval_ms.load(), base);
+        interval = std::min(previous * 2, std::max(MAX_BACKOFF_INTERVAL_MS, base));
+    }
+    
+    m_poll_interval_ms.store(interval);
+}
+
 void SignalMonitor::AnalyzeSignalStability(const SignalStatus& current_status) {
     auto now = std::chrono::steady_clock::now();
     
@@ -302,7 +360,7 @@ void SignalMonitor::AnalyzeSignalStability(const SignalStatus& current_status) {
     }
 }
 
-void SignalMonitor::CheckHotPlugEvents(const SignalStatus& current_status) {
+bool SignalMonitor::CheckHotPlugEvents(const SignalStatus& current_status) {
     bool current_connection = current_status.connected;
     
     // Check if connection state changed
@@ -313,15 +371,17 @@ void SignalMonitor::CheckHotPlugEvents(const SignalStatus& current_status) {
         
         // Apply debounce filter
         if (debounce_elapsed.count() >= HOTPLUG_DEBOUNCE_MS) {
-            kodi::Log(ADDON_LOG_INFO, "Hot-plug event detected: %s", 
-                      current_connection ? "connected" : "disconnected");
+            Log(LogLevel::Info, "Hot-plug event detected: %s", 
+                current_connection ? "connected" : "disconnected");
             
             m_last_connection_state = current_connection;
             m_last_hotplug_time = now;
             
             TriggerHotPlugCallback(current_connection);
+            return true;
         }
     }
+    return false;
 }
 
 void SignalMonitor::UpdateQualityHistory(uint8_t strength, uint8_t quality) {
@@ -356,7 +416,7 @@ void SignalMonitor::TriggerStatusCallback(const SignalStatus& status) {
             m_status_callback(status);
         }
         catch (const std::exception& e) {
-            kodi::Log(ADDON_LOG_ERROR, "Exception in status callback: %s", e.what());
+            Log(LogLevel::Error, "Exception in status callback: %s", e.what());
         }
     }
 }
@@ -368,7 +428,7 @@ void SignalMonitor::TriggerHotPlugCallback(bool connected) {
             m_hotplug_callback(connected);
         }
         catch (const std::exception& e) {
-            kodi::Log(ADDON_LOG_ERROR, "Exception in hot-plug callback: %s", e.what());
+            Log(LogLevel::Error, "Exception in hot-plug callback: %s", e.what());
         }
     }
 }
@@ -391,7 +451,7 @@ bool SignalMonitor::IsSignificantChange(const SignalStatus& status1, const Signa
     // Video format changes are significant
     if (status1.video_format.width != status2.video_format.width ||
         status1.video_format.height != status2.video_format.height ||
-        status1.video_format.fps != status2.video_format.fps) {
+        status1.video_format.frame_rate != status2.video_format.frame_rate) {
         return true;
     }
     
@@ -405,14 +465,14 @@ bool SignalMonitor::IsSignificantChange(const SignalStatus& status1, const Signa
 }
 
 void SignalMonitor::PerformDetailedAnalysis(SignalStatus& status) {
-    if (!m_v4l2_device || !status.connected) {
+    if (!m_source || !status.connected) {
         return;
     }
     
     // Try to detect video format if not already detected
     if (!status.video_format.is_valid()) {
         VideoFormat detected_format;
-        if (m_v4l2_device->DetectInputFormat(detected_format)) {
+        if (m_source->DetectInputFormat(detected_format)) {
             status.video_format = detected_format;
         }
     }
@@ -433,7 +493,7 @@ void SignalMonitor::PerformDetailedAnalysis(SignalStatus& status) {
         }
         
         // Penalize quality for very high refresh rates
-        if (status.video_format.fps > 60) {
+        if (status.video_format.frame_rate.to_double() > 60.5) {
             status.signal_quality = static_cast<uint8_t>(status.signal_quality * 0.95);
         }
     }
@@ -451,22 +511,27 @@ void SignalMonitor::ResetState() {
     m_consecutive_stable_readings = 0;
     m_last_connection_state = false;
     
+    // Poll fast until the first stable lock
+    m_burst_until = std::chrono::steady_clock::now() + std::chrono::milliseconds(BURST_DURATION_MS);
+    m_burst_requested.store(false);
+    m_poll_interval_ms.store(BURST_INTERVAL_MS);
+    
     // Reset quality history
     std::fill(m_strength_history.begin(), m_strength_history.end(), 0);
     std::fill(m_quality_history.begin(), m_quality_history.end(), 0);
     m_history_index = 0;
     
-    kodi::Log(ADDON_LOG_DEBUG, "SignalMonitor state reset");
+    Log(LogLevel::Debug, "SignalMonitor state reset");
 }
 
 bool SignalMonitor::ValidateDevice() const {
-    if (!m_v4l2_device) {
-        kodi::Log(ADDON_LOG_ERROR, "No V4L2 device provided");
+    if (!m_source) {
+        Log(LogLevel::Error, "No capture source provided");
         return false;
     }
     
-    if (!m_v4l2_device->IsOpen()) {
-        kodi::Log(ADDON_LOG_WARNING, "V4L2 device is not open, signal monitoring may be limited");
+    if (!m_source->IsOpen()) {
+        Log(LogLevel::Warning, "Capture source is not open, signal monitoring may be limited");
         // Don't fail validation - we can still provide basic monitoring
     }
     
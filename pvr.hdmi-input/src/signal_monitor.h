@@ -12,7 +12,7 @@
 namespace hdmi_pvr {
 
 // Forward declaration
-class V4L2Device;
+class CaptureSource;
 
 /**
  * SignalMonitor class for HDMI signal detection and monitoring
@@ -22,6 +22,8 @@ class V4L2Device;
  * - Signal strength and quality measurement
  * - Format detection and change notification
  * - Real-time status updates with callback support
+ * - Adaptive polling: the interval backs off exponentially while the lock
+ *   is stable and drops to a fast burst after a hot-plug or format change
  */
 class SignalMonitor {
 public:
@@ -31,9 +33,9 @@ public:
 
     /**
      * Constructor
-     * @param v4l2_device Shared pointer to V4L2Device for hardware access
+     * @param source Capture source to poll, normally the V4L2Device
      */
-    explicit SignalMonitor(std::shared_ptr<V4L2Device> v4l2_device);
+    explicit SignalMonitor(std::shared_ptr<CaptureSource> source);
     
     /**
      * Destructor - ensures clean shutdown of monitoring thread
@@ -50,9 +52,11 @@ public:
 
     /**
      * Initialize and start the signal monitoring thread
+     * @param start_thread false when the owner polls UpdateSignalStatus() itself,
+     *                     so several monitors can share one thread
      * @return true if initialization successful, false otherwise
      */
-    bool Initialize();
+    bool Initialize(bool start_thread = true);
 
     /**
      * Shutdown the signal monitor and stop all monitoring activities
@@ -127,16 +131,28 @@ public:
 
     /**
      * Set the monitoring update interval
-     * @param interval_ms Update interval in milliseconds (default: 1000ms)
+     * @param interval_ms Base update interval in milliseconds (default: 1000ms)
      */
     void SetUpdateInterval(uint32_t interval_ms);
 
     /**
-     * Get the current monitoring update interval
+     * Get the base monitoring update interval
      * @return Update interval in milliseconds
      */
     uint32_t GetUpdateInterval() const { return m_update_interval_ms; }
 
+    /**
+     * Get the delay until the next poll is due. Owners polling
+     * UpdateSignalStatus() themselves should wait this long.
+     * @return Poll interval in milliseconds
+     */
+    uint32_t GetPollInterval() const { return m_poll_interval_ms.load(); }
+
+    /**
+     * Poll fast for a while, e.g. after a source change event
+     */
+    void RequestBurst();
+
     /**
      * Enable or disable detailed signal analysis
      * @param enable true to enable detailed analysis, false for basic monitoring
@@ -150,8 +166,8 @@ public:
     bool IsDetailedAnalysisEnabled() const { return m_detailed_analysis; }
 
 private:
-    // V4L2 device for hardware access
-    std::shared_ptr<V4L2Device> m_v4l2_device;
+    // Capture source for hardware access
+    std::shared_ptr<CaptureSource> m_source;
 
     // Thread management
     std::atomic<bool> m_active{false};
@@ -174,6 +190,14 @@ private:
     std::atomic<uint32_t> m_update_interval_ms{1000};
     std::atomic<bool> m_detailed_analysis{true};
 
+    // Adaptive polling schedule
+    static constexpr uint32_t BURST_INTERVAL_MS = 50;
+    static constexpr uint32_t BURST_DURATION_MS = 2000;
+    static constexpr uint32_t MAX_BACKOFF_INTERVAL_MS = 30000;
+    std::atomic<uint32_t> m_poll_interval_ms{1000};
+    std::atomic<bool> m_burst_requested{false};  ///< Wakes the monitoring thread early
+    std::chrono::steady_clock::time_point m_burst_until;  ///< Polling thread only
+
     // Signal stability tracking
     std::chrono::steady_clock::time_point m_last_stable_time;
     uint32_t m_stability_threshold_ms = 2000;  // 2 seconds for stability
@@ -211,8 +235,20 @@ private:
     /**
      * Check for hot-plug events and trigger callbacks if needed
      * @param current_status Current signal status
+     * @return true if a hot-plug event was reported
+     */
+    bool CheckHotPlugEvents(const SignalStatus& current_status);
+
+    /**
+     * Mark what changed on the pipeline trace
+     */
+    void TraceSignalChange(const SignalStatus& status);
+
+    /**
+     * Choose the delay until the next poll
+     * @param changed Whether this poll saw a hot-plug or significant change
      */
-    void CheckHotPlugEvents(const SignalStatus& current_status);
+    void SchedulePoll(bool changed);
 
     /**
      * Update signal quality history for averaging
@@ -265,7 +301,7 @@ private:
     void ResetState();
 
     /**
-     * Validate that the V4L2 device is ready for monitoring
+     * Validate that the capture source is ready for monitoring
      * @return true if device is ready, false otherwise
      */
     bool ValidateDevice() const;
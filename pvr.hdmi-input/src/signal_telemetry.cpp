@@ -0,0 +1,182 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Signal Telemetry Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "signal_telemetry.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace hdmi_pvr {
+
+namespace {
+
+template <typename T>
+void AddSaturated(T& value, uint64_t amount) {
+    uint64_t sum = static_cast<uint64_t>(value) + amount;
+    value = static_cast<T>(std::min<uint64_t>(sum, static_cast<T>(~T(0))));
+}
+
+std::string FormatTime(int64_t seconds) {
+    time_t t = static_cast<time_t>(seconds);
+    struct tm utc = {};
+    char text[32];
+    gmtime_r(&t, &utc);
+    strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return text;
+}
+
+} // namespace
+
+SignalTelemetry::SignalTelemetry()
+    : m_seconds(SECOND_BUCKETS)
+    , m_minutes(MINUTE_BUCKETS) {
+}
+
+void SignalTelemetry::Record(time_t now, const SignalStatus& status, uint64_t frames_total,
+                             uint64_t dropped_total) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_current.start != now) {
+        CloseCurrent();
+        m_current = Bucket();
+        m_current.start = now;
+    }
+
+    // Counters restart with every stream
+    uint64_t frames = frames_total >= m_last_frames ? frames_total - m_last_frames : frames_total;
+    uint64_t dropped = dropped_total >= m_last_dropped ? dropped_total - m_last_dropped : dropped_total;
+    m_last_frames = frames_total;
+    m_last_dropped = dropped_total;
+
+    AddSaturated(m_current.samples, 1);
+    if (status.signal_locked) {
+        AddSaturated(m_current.locked, 1);
+    } else if (m_last_locked) {
+        AddSaturated(m_current.lock_losses, 1);
+    }
+    m_last_locked = status.signal_locked;
+
+    m_current.width = static_cast<uint16_t>(std::min<uint32_t>(status.video_format.width, UINT16_MAX));
+    m_current.height = static_cast<uint16_t>(std::min<uint32_t>(status.video_format.height, UINT16_MAX));
+    m_current.frame_rate_milli = static_cast<uint32_t>(status.video_format.frame_rate.to_double() * 1000.0 + 0.5);
+    AddSaturated(m_current.frames, frames);
+    AddSaturated(m_current.dropped, dropped);
+}
+
+std::vector<SignalTelemetry::Bucket> SignalTelemetry::GetSeconds() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return Collect(m_seconds, m_current.start - 1, 1);
+}
+
+std::vector<SignalTelemetry::Bucket> SignalTelemetry::GetMinutes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t newest = m_current.start - m_current.start % 60;
+    return Collect(m_minutes, newest, 60);
+}
+
+std::string SignalTelemetry::ToCsv() const {
+    std::string csv = "resolution,time,samples,locked,lock_losses,width,height,fps,frames,dropped\n";
+
+    auto append = [&csv](const char* resolution, const std::vector<Bucket>& buckets) {
+        char row[160];
+        for (const auto& bucket : buckets) {
+            snprintf(row, sizeof(row), "%s,%s,%u,%u,%u,%u,%u,%.3f,%u,%u\n", resolution,
+                     FormatTime(bucket.start).c_str(), bucket.samples, bucket.locked, bucket.lock_losses,
+                     bucket.width, bucket.height, bucket.frame_rate_milli / 1000.0, bucket.frames,
+                     bucket.dropped);
+            csv += row;
+        }
+    };
+    append("second", GetSeconds());
+    append("minute", GetMinutes());
+    return csv;
+}
+
+std::string SignalTelemetry::ToJson() const {
+    std::string json = "{";
+
+    auto append = [&json](const char* name, const std::vector<Bucket>& buckets) {
+        json += "\"";
+        json += name;
+        json += "\":[";
+        char entry[256];
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            const Bucket& bucket = buckets[i];
+            snprintf(entry, sizeof(entry),
+                     "%s{\"time\":\"%s\",\"start\":%" PRId64 ",\"samples\":%u,\"locked\":%u,"
+                     "\"lock_losses\":%u,\"width\":%u,\"height\":%u,\"fps\":%.3f,"
+                     "\"frames\":%u,\"dropped\":%u}",
+                     i > 0 ? "," : "", FormatTime(bucket.start).c_str(), bucket.start, bucket.samples,
+                     bucket.locked, bucket.lock_losses, bucket.width, bucket.height,
+                     bucket.frame_rate_milli / 1000.0, bucket.frames, bucket.dropped);
+            json += entry;
+        }
+        json += "]";
+    };
+    append("seconds", GetSeconds());
+    json += ",";
+    append("minutes", GetMinutes());
+    json += "}\n";
+    return json;
+}
+
+void SignalTelemetry::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::fill(m_seconds.begin(), m_seconds.end(), Bucket());
+    std::fill(m_minutes.begin(), m_minutes.end(), Bucket());
+    m_current = Bucket();
+    m_last_locked = false;
+    m_last_frames = 0;
+    m_last_dropped = 0;
+}
+
+void SignalTelemetry::CloseCurrent() {
+    if (m_current.start <= 0) {
+        return;
+    }
+
+    m_seconds[m_current.start % SECOND_BUCKETS] = m_current;
+
+    int64_t minute_start = m_current.start - m_current.start % 60;
+    Bucket& minute = m_minutes[(minute_start / 60) % MINUTE_BUCKETS];
+    if (minute.start != minute_start) {
+        minute = Bucket();
+        minute.start = minute_start;
+    }
+    Merge(minute, m_current);
+}
+
+void SignalTelemetry::Merge(Bucket& into, const Bucket& from) {
+    AddSaturated(into.samples, from.samples);
+    AddSaturated(into.locked, from.locked);
+    AddSaturated(into.lock_losses, from.lock_losses);
+    AddSaturated(into.frames, from.frames);
+    AddSaturated(into.dropped, from.dropped);
+    into.width = from.width;
+    into.height = from.height;
+    into.frame_rate_milli = from.frame_rate_milli;
+}
+
+std::vector<SignalTelemetry::Bucket> SignalTelemetry::Collect(const std::vector<Bucket>& ring, int64_t newest,
+                                                              int64_t step) {
+    // Slots still holding an older lap of the ring, or never used, are gaps
+    std::vector<Bucket> buckets;
+    int64_t oldest = newest - static_cast<int64_t>(ring.size() - 1) * step;
+    for (int64_t start = oldest; start <= newest; start += step) {
+        if (start <= 0) {
+            continue;
+        }
+        const Bucket& bucket = ring[(start / step) % ring.size()];
+        if (bucket.start == start) {
+            buckets.push_back(bucket);
+        }
+    }
+    return buckets;
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,97 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hdmi_pvr {
+
+/**
+ * SignalTelemetry keeps a fixed-size history of one capture device's
+ * signal, for diagnosing dropouts that only happen a few times a day: one
+ * bucket per second for the last ten minutes and one per minute for the
+ * last day, about 64 KB per device.
+ *
+ * Record() is fed by a once a second tick with the last polled signal, so
+ * every bucket is sampled at the same rate however fast the signal is
+ * polled. Records of the same second merge into one bucket, and each
+ * finished second is folded into the bucket of its minute, so nothing is
+ * allocated after construction.
+ *
+ * Thread-safe.
+ */
+class SignalTelemetry {
+public:
+    static constexpr size_t SECOND_BUCKETS = 10 * 60;   ///< Per second history
+    static constexpr size_t MINUTE_BUCKETS = 24 * 60;   ///< Per minute history
+
+    struct Bucket {
+        int64_t start = 0;              ///< Wall clock seconds since the epoch, 0 = unused
+        uint16_t samples = 0;           ///< Records merged
+        uint16_t locked = 0;            ///< Records with the signal locked
+        uint16_t lock_losses = 0;       ///< Locked to unlocked transitions
+        uint16_t width = 0;             ///< Last source format
+        uint16_t height = 0;
+        uint32_t frame_rate_milli = 0;  ///< Last source frame rate * 1000
+        uint32_t frames = 0;            ///< Frames captured
+        uint32_t dropped = 0;           ///< Frames dropped
+    };
+
+    SignalTelemetry();
+
+    /**
+     * Record the signal state and capture counters
+     * @param now Wall clock time of the record
+     * @param status Latest signal status
+     * @param frames_total Frames captured so far, may restart from 0 with a new stream
+     * @param dropped_total Frames dropped so far, same
+     */
+    void Record(time_t now, const SignalStatus& status, uint64_t frames_total, uint64_t dropped_total);
+
+    /**
+     * Finished seconds, oldest first
+     */
+    std::vector<Bucket> GetSeconds() const;
+
+    /**
+     * Minutes, oldest first - the last one is still filling
+     */
+    std::vector<Bucket> GetMinutes() const;
+
+    /**
+     * Both histories as CSV, one row per bucket with its resolution in the first column
+     */
+    std::string ToCsv() const;
+
+    /**
+     * Both histories as a JSON object with "seconds" and "minutes" arrays
+     */
+    std::string ToJson() const;
+
+    void Clear();
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<Bucket> m_seconds;  ///< Ring indexed by start % SECOND_BUCKETS
+    std::vector<Bucket> m_minutes;  ///< Ring indexed by minute % MINUTE_BUCKETS
+    Bucket m_current;               ///< Second being recorded
+    bool m_last_locked = false;
+    uint64_t m_last_frames = 0;
+    uint64_t m_last_dropped = 0;
+
+    void CloseCurrent();
+    static void Merge(Bucket& into, const Bucket& from);
+    static std::vector<Bucket> Collect(const std::vector<Bucket>& ring, int64_t newest, int64_t step);
+};
+
+} // namespace hdmi_pvr
@@ -7,168 +7,45 @@
  */
 
 #include "stream_processor.h"
-#include "v4l2_device.h"
-#include <kodi/General.h>
+#include "format_negotiator.h"
+#include "frame_converter.h"
+#include "log.h"
+#include "trace.h"
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 
 namespace hdmi_pvr {
 
-//
-// StreamBuffer implementation
-//
-
-StreamProcessor::StreamBuffer::StreamBuffer(size_t buffer_size) {
-    Allocate(buffer_size);
-}
-
-StreamProcessor::StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept 
-    : data(std::move(other.data))
-    , size(other.size)
-    , capacity(other.capacity)
-    , timestamp(other.timestamp)
-    , in_use(other.in_use) {
-    other.size = 0;
-    other.capacity = 0;
-    other.timestamp = 0;
-    other.in_use = false;
-}
-
-StreamProcessor::StreamBuffer& StreamProcessor::StreamBuffer::operator=(StreamBuffer&& other) noexcept {
-    if (this != &other) {
-        data = std::move(other.data);
-        size = other.size;
-        capacity = other.capacity;
-        timestamp = other.timestamp;
-        in_use = other.in_use;
-        
-        other.size = 0;
-        other.capacity = 0;
-        other.timestamp = 0;
-        other.in_use = false;
-    }
-    return *this;
-}
-
-bool StreamProcessor::StreamBuffer::Allocate(size_t buffer_size) {
-    try {
-        data = std::make_unique<uint8_t[]>(buffer_size);
-        capacity = buffer_size;
-        size = 0;
-        in_use = false;
-        return true;
-    } catch (const std::bad_alloc&) {
-        kodi::Log(ADDON_LOG_ERROR, "Failed to allocate stream buffer of size %zu", buffer_size);
-        return false;
-    }
-}
-
-void StreamProcessor::StreamBuffer::Reset() {
-    size = 0;
-    timestamp = 0;
-    in_use = false;
-}
-
-//
-// BufferPool implementation
-//
-
-StreamProcessor::BufferPool::BufferPool(size_t buffer_count, size_t buffer_size) {
-    m_buffers.reserve(buffer_count);
-    
-    for (size_t i = 0; i < buffer_count; ++i) {
-        auto buffer = std::make_unique<StreamBuffer>(buffer_size);
-        if (buffer && buffer->data) {
-            m_available_buffers.push(buffer.get());
-            m_buffers.push_back(std::move(buffer));
-        }
-    }
-    
-    kodi::Log(ADDON_LOG_DEBUG, "BufferPool initialized with %zu buffers of size %zu", 
-              m_buffers.size(), buffer_size);
-}
-
-StreamProcessor::StreamBuffer* StreamProcessor::BufferPool::GetBuffer() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    if (m_available_buffers.empty()) {
-        return nullptr;
-    }
-    
-    StreamBuffer* buffer = m_available_buffers.front();
-    m_available_buffers.pop();
-    buffer->Reset();
-    buffer->in_use = true;
-    
-    return buffer;
-}
-
-void StreamProcessor::BufferPool::ReturnBuffer(StreamBuffer* buffer) {
-    if (!buffer) return;
-    
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    buffer->Reset();
-    buffer->in_use = false;
-    m_available_buffers.push(buffer);
-}
-
-void StreamProcessor::BufferPool::Clear() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    // Clear available buffer queue
-    std::queue<StreamBuffer*> empty;
-    m_available_buffers.swap(empty);
-    
-    // Reset all buffers and make them available
-    for (auto& buffer : m_buffers) {
-        if (buffer) {
-            buffer->Reset();
-            buffer->in_use = false;
-            m_available_buffers.push(buffer.get());
-        }
-    }
-}
-
-size_t StreamProcessor::BufferPool::GetUsedBuffers() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_buffers.size() - m_available_buffers.size();
-}
-
 //
 // StreamProcessor main implementation
 //
 
-StreamProcessor::StreamProcessor(V4L2Device* v4l2_device)
-    : m_v4l2_device(v4l2_device) {
-    kodi::Log(ADDON_LOG_DEBUG, "StreamProcessor created");
+StreamProcessor::StreamProcessor(CaptureSource* source)
+    : m_source(source)
+    , m_resources(std::make_shared<CaptureResources>()) {
+    Log(LogLevel::Debug, "StreamProcessor created");
 }
 
 StreamProcessor::~StreamProcessor() {
-    kodi::Log(ADDON_LOG_DEBUG, "StreamProcessor destructor called");
+    Log(LogLevel::Debug, "StreamProcessor destructor called");
     Shutdown();
 }
 
 bool StreamProcessor::Initialize() {
     if (m_initialized.load()) {
-        kodi::Log(ADDON_LOG_WARNING, "StreamProcessor already initialized");
+        Log(LogLevel::Warning, "StreamProcessor already initialized");
         return true;
     }
     
-    if (!m_v4l2_device) {
-        kodi::Log(ADDON_LOG_ERROR, "No V4L2 device set for stream processor");
-        return false;
-    }
-    
-    // Initialize buffer pool
-    m_buffer_pool = std::make_unique<BufferPool>(m_buffer_count, m_buffer_size);
-    if (!m_buffer_pool || m_buffer_pool->GetTotalBuffers() == 0) {
-        kodi::Log(ADDON_LOG_ERROR, "Failed to initialize buffer pool");
+    if (!m_source) {
+        Log(LogLevel::Error, "No capture source set for stream processor");
         return false;
     }
     
+    // The frame pool is sized for the negotiated format when streaming starts
     m_initialized.store(true);
-    kodi::Log(ADDON_LOG_INFO, "StreamProcessor initialized successfully");
+    Log(LogLevel::Info, "StreamProcessor initialized successfully");
     return true;
 }
 
@@ -177,7 +54,7 @@ void StreamProcessor::Shutdown() {
         return;
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Shutting down StreamProcessor");
+    Log(LogLevel::Debug, "Shutting down StreamProcessor");
     
     // Stop streaming if active
     StopStreaming();
@@ -191,57 +68,85 @@ void StreamProcessor::Shutdown() {
     CleanupResources();
     
     m_initialized.store(false);
-    kodi::Log(ADDON_LOG_INFO, "StreamProcessor shutdown complete");
+    Log(LogLevel::Info, "StreamProcessor shutdown complete");
 }
 
-bool StreamProcessor::SetV4L2Device(V4L2Device* v4l2_device) {
+bool StreamProcessor::SetCaptureSource(CaptureSource* source) {
     if (m_streaming.load()) {
-        kodi::Log(ADDON_LOG_ERROR, "Cannot change V4L2 device while streaming");
+        Log(LogLevel::Error, "Cannot change capture source while streaming");
         return false;
     }
     
-    m_v4l2_device = v4l2_device;
-    kodi::Log(ADDON_LOG_DEBUG, "V4L2 device set");
+    m_source = source;
+    Log(LogLevel::Debug, "Capture source set");
     return true;
 }
 
 bool StreamProcessor::StartStreaming(const VideoFormat& video_fmt, const AudioFormat& audio_fmt) {
     if (!m_initialized.load()) {
-        kodi::Log(ADDON_LOG_ERROR, "StreamProcessor not initialized");
+        Log(LogLevel::Error, "StreamProcessor not initialized");
         return false;
     }
     
     if (m_streaming.load()) {
-        kodi::Log(ADDON_LOG_WARNING, "Already streaming, stopping current stream first");
+        Log(LogLevel::Warning, "Already streaming, stopping current stream first");
         StopStreaming();
     }
     
-    if (!m_v4l2_device) {
-        kodi::Log(ADDON_LOG_ERROR, "No V4L2 device available for streaming");
+    if (!m_source) {
+        Log(LogLevel::Error, "No capture source available for streaming");
         return false;
     }
     
     // Validate formats
     if (!ValidateVideoFormat(video_fmt)) {
-        kodi::Log(ADDON_LOG_ERROR, "Invalid video format for streaming");
+        Log(LogLevel::Error, "Invalid video format for streaming");
         return false;
     }
     
     if (!ValidateAudioFormat(audio_fmt)) {
-        kodi::Log(ADDON_LOG_ERROR, "Invalid audio format for streaming");
+        Log(LogLevel::Error, "Invalid audio format for streaming");
         return false;
     }
     
-    // Store current formats
+    // Store current formats - the driver has the final word on the layout
     {
         std::lock_guard<std::mutex> lock(m_format_mutex);
         m_current_video_format = video_fmt;
         m_current_audio_format = audio_fmt;
+        uint32_t configured_fourcc = m_source->GetConfiguredFormat().fourcc;
+        if (configured_fourcc != 0) {
+            m_current_video_format.fourcc = configured_fourcc;
+        }
+        m_current_stride = m_source->GetBytesPerLine();
+        FrameGeometry layout;
+        layout.width = m_current_video_format.width;
+        layout.height = m_current_video_format.height;
+        layout.bytes_per_line = m_current_stride;
+        layout.fourcc = m_current_video_format.fourcc;
+        m_frame_layouts.assign(1, layout);
+        m_capture_layout.store(0);
+        m_demux_layout.store(0);
     }
     
-    // Start V4L2 streaming
-    if (!m_v4l2_device->StartStreaming()) {
-        kodi::Log(ADDON_LOG_ERROR, "Failed to start V4L2 streaming");
+    // Start from the uncropped picture
+    StartLetterboxDetection();
+    
+    // Size the pool for the negotiated frame before capture starts
+    if (!EnsureBufferPool(m_source->GetFrameSize())) {
+        Log(LogLevel::Error, "Failed to prepare buffer pool for streaming");
+        return false;
+    }
+    
+    // Timeshift is optional - live reads fall back to the ready queue
+    if (m_timeshift_size > 0 && !m_timeshift.Open(m_timeshift_path, m_timeshift_size)) {
+        Log(LogLevel::Warning, "Timeshift unavailable, continuing without it");
+    }
+    
+    // Start the capture source
+    if (!m_source->StartStreaming()) {
+        Log(LogLevel::Error, "Failed to start the capture source");
+        m_timeshift.Close();
         return false;
     }
     
@@ -251,17 +156,21 @@ bool StreamProcessor::StartStreaming(const VideoFormat& video_fmt, const AudioFo
     m_total_frames_processed.store(0);
     m_dropped_frames.store(0);
     m_stream_bitrate.store(0);
+    m_frame_sequence = 0;
+    VideoFormat configured = m_source->GetConfiguredFormat();
+    m_pts_generator.Reset(configured.frame_rate.is_valid() ? configured.frame_rate : video_fmt.frame_rate);
+    m_deduplicator.Reset();
     
-    // Clear buffer pool
-    m_buffer_pool->Clear();
-    
-    // Start capture thread
+    // Start capture thread - with external capture the owner's event loop
+    // calls OnFramesReady() instead
     m_capture_thread_running.store(true);
-    m_capture_thread = std::make_unique<std::thread>(&StreamProcessor::CaptureThreadFunction, this);
+    if (!m_external_capture) {
+        m_capture_thread = std::make_unique<std::thread>(&StreamProcessor::CaptureThreadFunction, this);
+    }
     
     m_streaming.store(true);
-    kodi::Log(ADDON_LOG_INFO, "Streaming started - Video: %dx%d, Audio: %dHz", 
-              video_fmt.width, video_fmt.height, audio_fmt.sample_rate);
+    Log(LogLevel::Info, "Streaming started - Video: %dx%d, Audio: %dHz", 
+        video_fmt.width, video_fmt.height, audio_fmt.sample_rate);
     
     return true;
 }
@@ -271,7 +180,9 @@ void StreamProcessor::StopStreaming() {
         return;
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Stopping streaming");
+    Log(LogLevel::Debug, "Stopping streaming");
+    
+    m_standby.store(false);
     
     // Signal capture thread to stop
     m_capture_thread_running.store(false);
@@ -283,21 +194,73 @@ void StreamProcessor::StopStreaming() {
         m_capture_thread.reset();
     }
     
-    // Stop V4L2 streaming
-    if (m_v4l2_device) {
-        m_v4l2_device->StopStreaming();
+    // Or for a capture pass of the owner's event loop
+    {
+        std::lock_guard<std::mutex> lock(m_external_capture_mutex);
     }
     
-    // Clear buffers
-    {
-        std::lock_guard<std::mutex> lock(m_buffer_mutex);
-        std::queue<StreamBuffer*> empty_queue;
-        m_ready_buffers.swap(empty_queue);
+    // Stop the capture source
+    if (m_source) {
+        m_source->StopStreaming();
     }
+    
+    StopLetterboxDetection();
+    StopRawCapture();
+    
+    if (m_deduplicator.GetDuplicateCount() > 0) {
+        Log(LogLevel::Debug, "Skipped %llu duplicate frames",
+            static_cast<unsigned long long>(m_deduplicator.GetDuplicateCount()));
+    }
+    m_deduplicator.Reset();
+    
+    // Drop unread frames so the pool is intact for the next start
+    ReleaseReadyBuffers();
     m_buffer_condition.notify_all();
     
+    m_timeshift.Close();
+    
     m_streaming.store(false);
-    kodi::Log(ADDON_LOG_INFO, "Streaming stopped");
+    Log(LogLevel::Info, "Streaming stopped");
+}
+
+bool StreamProcessor::EnterStandby(uint32_t ring_frames) {
+    if (!m_streaming.load()) {
+        return false;
+    }
+    
+    if (m_demux_open.load()) {
+        CloseDemuxStream();
+    }
+    
+    m_standby_ring_frames.store(std::max<uint32_t>(ring_frames, 1));
+    {
+        std::lock_guard<std::mutex> lock(m_buffer_mutex);
+        m_standby.store(true);
+        TrimReadyBuffers(m_standby_ring_frames.load());
+    }
+    
+    Log(LogLevel::Debug, "Entered warm standby (%u frame ring)", m_standby_ring_frames.load());
+    return true;
+}
+
+bool StreamProcessor::ResumeFromStandby() {
+    if (!m_streaming.load() || !m_standby.load()) {
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_buffer_mutex);
+        m_standby.store(false);
+        // Resume from the newest frame, anything older is stale
+        TrimReadyBuffers(1);
+    }
+    
+    if (m_timeshift.IsOpen()) {
+        m_timeshift.Seek(0, SEEK_END);
+    }
+    
+    Log(LogLevel::Debug, "Resumed from warm standby");
+    return true;
 }
 
 int StreamProcessor::ReadLiveStream(unsigned char* buffer, unsigned int size) {
@@ -309,12 +272,17 @@ int StreamProcessor::ReadLiveStream(unsigned char* buffer, unsigned int size) {
         return -1;  // Error: invalid parameters
     }
     
+    // Timeshifted playback reads straight from the mapped ring
+    if (m_timeshift.IsOpen()) {
+        return m_timeshift.Read(buffer, size, 100);  // 100ms timeout
+    }
+    
     // Wait for data with timeout
     std::unique_lock<std::mutex> lock(m_buffer_mutex);
-    if (m_ready_buffers.empty()) {
+    if (!m_read_frame && m_ready_frames.empty()) {
         auto timeout = std::chrono::milliseconds(100);  // 100ms timeout
         if (!m_buffer_condition.wait_for(lock, timeout, [this]() {
-            return !m_ready_buffers.empty() || !m_streaming.load();
+            return !m_ready_frames.empty() || !m_streaming.load();
         })) {
             return 0;  // Timeout: no data available
         }
@@ -324,106 +292,233 @@ int StreamProcessor::ReadLiveStream(unsigned char* buffer, unsigned int size) {
         return -1;  // Error: streaming was stopped
     }
     
-    if (m_ready_buffers.empty()) {
-        return 0;  // No data available
-    }
-    
-    // Get next buffer
-    StreamBuffer* stream_buffer = m_ready_buffers.front();
-    m_ready_buffers.pop();
-    lock.unlock();
-    
-    if (!stream_buffer || !stream_buffer->data) {
-        return -1;  // Error: invalid buffer
+    // Continue a frame that did not fit into the previous read
+    if (!m_read_frame) {
+        if (m_ready_frames.empty()) {
+            return 0;  // No data available
+        }
+        m_read_frame = std::move(m_ready_frames.front());
+        m_ready_frames.pop_front();
+        m_read_offset = 0;
     }
     
     // Copy data to output buffer
-    size_t bytes_to_copy = std::min(static_cast<size_t>(size), stream_buffer->size);
-    std::memcpy(buffer, stream_buffer->data.get(), bytes_to_copy);
-    
-    // Return buffer to pool
-    m_buffer_pool->ReturnBuffer(stream_buffer);
+    size_t bytes_to_copy = std::min(static_cast<size_t>(size), m_read_frame->Size() - m_read_offset);
+    std::memcpy(buffer, m_read_frame->Data() + m_read_offset, bytes_to_copy);
+    m_read_offset += bytes_to_copy;
+    
+    // Frame fully delivered - drop our reference
+    if (m_read_offset >= m_read_frame->Size()) {
+        if (IsTracing()) {
+            TraceInstant("frame delivered seq=%llu live", static_cast<unsigned long long>(m_read_frame->sequence));
+        }
+        m_read_frame.Reset();
+        m_read_offset = 0;
+    }
     
     return static_cast<int>(bytes_to_copy);
 }
 
-PVR_ERROR StreamProcessor::GetStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties) {
+bool StreamProcessor::GetStreamDescriptors(StreamDescriptors& descriptors) const {
+    descriptors = {};
     if (!m_streaming.load()) {
-        kodi::Log(ADDON_LOG_ERROR, "Cannot get stream properties: not streaming");
-        return PVR_ERROR_FAILED;
+        return false;
     }
     
     std::lock_guard<std::mutex> lock(m_format_mutex);
     
-    properties.clear();
+    // The layout is that of the frames the demux reader is at, which lags
+    // behind the capture when timeshifted
+    descriptors.video = DescribeVideoStream(FindFrameLayout(m_demux_layout.load()),
+                                            m_current_video_format.frame_rate);
+    
+    // Audio is linear PCM, interleaved little endian
+    const AudioFormat& audio = m_current_audio_format;
+    if (!audio.compressed && audio.is_valid()) {
+        AudioStreamDescriptor& audio_desc = descriptors.audio;
+        audio_desc.stream_id = AUDIO_STREAM_ID;
+        switch (audio.bit_depth) {
+            case 8:  audio_desc.codec_name = "pcm_u8"; break;
+            case 16: audio_desc.codec_name = "pcm_s16le"; break;
+            case 24: audio_desc.codec_name = "pcm_s24le"; break;
+            case 32: audio_desc.codec_name = "pcm_s32le"; break;
+            default: break;
+        }
+        static const char* const LAYOUTS[] = {"", "mono", "stereo", "2.1", "quad", "5.0", "5.1", "6.1", "7.1"};
+        audio_desc.channel_layout = audio.channels < sizeof(LAYOUTS) / sizeof(LAYOUTS[0])
+                                    ? LAYOUTS[audio.channels] : std::to_string(audio.channels) + " channels";
+        audio_desc.channels = audio.channels;
+        audio_desc.sample_rate = audio.sample_rate;
+        audio_desc.bits_per_sample = audio.bit_depth;
+        audio_desc.block_align = audio.channels * ((audio.bit_depth + 7) / 8);
+        audio_desc.bitrate = static_cast<uint64_t>(audio_desc.block_align) * 8 * audio.sample_rate;
+    }
     
-    // Video properties
-    if (m_current_video_format.width > 0 && m_current_video_format.height > 0) {
-        kodi::addon::PVRStreamProperty video_codec;
-        video_codec.SetName("codec_video");
-        video_codec.SetValue("h264");  // Assume H.264 for HDMI input
-        properties.push_back(video_codec);
-        
-        kodi::addon::PVRStreamProperty video_width;
-        video_width.SetName("video_width");
-        video_width.SetValue(std::to_string(m_current_video_format.width));
-        properties.push_back(video_width);
-        
-        kodi::addon::PVRStreamProperty video_height;
-        video_height.SetName("video_height");
-        video_height.SetValue(std::to_string(m_current_video_format.height));
-        properties.push_back(video_height);
-        
-        kodi::addon::PVRStreamProperty video_fps;
-        video_fps.SetName("video_fps");
-        video_fps.SetValue(std::to_string(m_current_video_format.framerate));
-        properties.push_back(video_fps);
-    }
-    
-    // Audio properties
-    if (m_current_audio_format.sample_rate > 0) {
-        kodi::addon::PVRStreamProperty audio_codec;
-        audio_codec.SetName("codec_audio");
-        audio_codec.SetValue("pcm");  // Assume PCM for HDMI audio
-        properties.push_back(audio_codec);
-        
-        kodi::addon::PVRStreamProperty audio_channels;
-        audio_channels.SetName("audio_channels");
-        audio_channels.SetValue(std::to_string(m_current_audio_format.channels));
-        properties.push_back(audio_channels);
-        
-        kodi::addon::PVRStreamProperty audio_samplerate;
-        audio_samplerate.SetName("audio_samplerate");
-        audio_samplerate.SetValue(std::to_string(m_current_audio_format.sample_rate));
-        properties.push_back(audio_samplerate);
+    return descriptors.video.is_valid();
+}
+
+VideoStreamDescriptor StreamProcessor::DescribeVideoStream(const FrameGeometry& layout, const FrameRate& frame_rate) {
+    // Video goes out uncompressed, repacked so the decoder needs nothing
+    // but the picture size
+    VideoStreamDescriptor video_desc;
+    video_desc.stream_id = VIDEO_STREAM_ID;
+    if (FrameConverter::SupportsFormat(layout.fourcc)) {
+        video_desc.codec_name = FrameConverter::CODEC_NAME;
+        video_desc.pixel_format = FrameConverter::DECODED_PIXEL_FORMAT;
+        video_desc.frame_size = static_cast<uint32_t>(FrameConverter::GetYuv4Size(layout.width, layout.height));
+    }
+    video_desc.fourcc = layout.fourcc;
+    video_desc.width = layout.width;
+    video_desc.height = layout.height;
+    video_desc.stride = layout.bytes_per_line;
+    video_desc.frame_rate = frame_rate;
+    video_desc.aspect = layout.height > 0 ? static_cast<float>(layout.width) / layout.height : 0.0f;  // HDMI pixels are square
+    if (frame_rate.is_valid()) {
+        video_desc.bitrate = static_cast<uint64_t>(video_desc.frame_size) * 8 * frame_rate.num / frame_rate.den;
+    }
+    return video_desc;
+}
+
+PVR_ERROR StreamProcessor::GetDemuxStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties,
+                                                    const CodecLookup& lookup) const {
+    StreamDescriptors descriptors;
+    if (!GetStreamDescriptors(descriptors)) {
+        Log(LogLevel::Error, "Cannot get demux stream properties: not streaming");
+        return PVR_ERROR_FAILED;
+    }
+    
+    // DemuxRead carries video only; announcing audio would make the player
+    // wait for packets that never come
+    properties.clear();
+    return AddVideoStreamProperties(descriptors.video, lookup, properties);
+}
+
+PVR_ERROR StreamProcessor::AddVideoStreamProperties(const VideoStreamDescriptor& video, const CodecLookup& lookup,
+                                                    std::vector<kodi::addon::PVRStreamProperties>& properties) {
+    kodi::addon::PVRCodec codec = lookup(video.codec_name);
+    if (codec.GetCodecType() == PVR_CODEC_TYPE_UNKNOWN) {
+        Log(LogLevel::Error, "Kodi does not know codec %s", video.codec_name.c_str());
+        return PVR_ERROR_FAILED;
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Stream properties: %zu items", properties.size());
+    kodi::addon::PVRStreamProperties video_props;
+    video_props.SetPID(video.stream_id);
+    video_props.SetCodecType(codec.GetCodecType());
+    video_props.SetCodecId(codec.GetCodecId());
+    video_props.SetWidth(static_cast<int>(video.width));
+    video_props.SetHeight(static_cast<int>(video.height));
+    video_props.SetFPSRate(static_cast<int>(video.frame_rate.num));
+    video_props.SetFPSScale(static_cast<int>(video.frame_rate.den));
+    video_props.SetAspect(video.aspect);
+    video_props.SetBitRate(static_cast<int>(std::min<uint64_t>(video.bitrate, INT32_MAX)));
+    properties.push_back(video_props);
+    
+    Log(LogLevel::Debug, "Demux streams: %s %ux%u@%s from %s", video.codec_name.c_str(),
+        video.width, video.height, video.frame_rate.to_string().c_str(),
+        FormatNegotiator::FourCCToString(video.fourcc).c_str());
     return PVR_ERROR_NO_ERROR;
 }
 
+void StreamProcessor::SetDuplicateFrameSkipping(bool enabled) {
+    m_skip_duplicates.store(enabled);
+    Log(LogLevel::Debug, "Duplicate frame skipping %s", enabled ? "enabled" : "disabled");
+}
+
+void StreamProcessor::SetTimeshift(const std::string& path, size_t size_bytes) {
+    m_timeshift_path = path;
+    m_timeshift_size = size_bytes;
+    Log(LogLevel::Debug, "Timeshift %s (%zu MB at %s)", size_bytes > 0 ? "enabled" : "disabled",
+        size_bytes / (1024 * 1024), path.c_str());
+}
+
+int64_t StreamProcessor::SeekLiveStream(int64_t position, int whence) {
+    if (!m_streaming.load() || !m_timeshift.IsOpen()) {
+        return -1;
+    }
+    return m_timeshift.Seek(position, whence);
+}
+
+int64_t StreamProcessor::LengthLiveStream() const {
+    if (!m_streaming.load() || !m_timeshift.IsOpen()) {
+        return -1;
+    }
+    return m_timeshift.GetLength();
+}
+
+bool StreamProcessor::IsRealTimeStream() const {
+    return !m_timeshift.IsOpen() || m_timeshift.IsAtLiveEdge();
+}
+
+bool StreamProcessor::GetStreamTimes(time_t& start_time, uint64_t& start_us, uint64_t& begin_us,
+                                     uint64_t& end_us) const {
+    if (!m_streaming.load() || !m_timeshift.IsOpen()) {
+        return false;
+    }
+    return m_timeshift.GetTimes(start_time, start_us, begin_us, end_us);
+}
+
+int StreamProcessor::AddFrameConsumer(FrameConsumer consumer) {
+    if (!consumer) {
+        return 0;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_consumer_mutex);
+    int id = m_next_consumer_id++;
+    m_consumers.push_back({id, std::move(consumer)});
+    
+    Log(LogLevel::Debug, "Frame consumer %d added (%zu total)", id, m_consumers.size());
+    return id;
+}
+
+void StreamProcessor::RemoveFrameConsumer(int consumer_id) {
+    std::lock_guard<std::mutex> lock(m_consumer_mutex);
+    m_consumers.erase(std::remove_if(m_consumers.begin(), m_consumers.end(),
+        [consumer_id](const ConsumerEntry& entry) { return entry.id == consumer_id; }),
+        m_consumers.end());
+}
+
+bool StreamProcessor::StartRawCapture(const std::string& path) {
+    if (!m_streaming.load()) {
+        Log(LogLevel::Error, "Cannot start raw capture: not streaming");
+        return false;
+    }
+    
+    // The capture thread writes the format ahead of the first frame
+    m_raw_format_pending.store(true);
+    return m_raw_capture.Start(path);
+}
+
+void StreamProcessor::StopRawCapture() {
+    m_raw_capture.Stop();
+}
+
 bool StreamProcessor::OpenDemuxStream() {
     if (m_demux_open.load()) {
-        kodi::Log(ADDON_LOG_WARNING, "Demux stream already open");
+        Log(LogLevel::Warning, "Demux stream already open");
         return true;
     }
     
     if (!m_streaming.load()) {
-        kodi::Log(ADDON_LOG_ERROR, "Cannot open demux: not streaming");
+        Log(LogLevel::Error, "Cannot open demux: not streaming");
         return false;
     }
     
     // Clear demux packet queue
     {
         std::lock_guard<std::mutex> lock(m_demux_mutex);
-        std::queue<std::unique_ptr<DEMUX_PACKET>> empty_queue;
-        m_demux_packets.swap(empty_queue);
+        m_demux_frames.clear();
     }
     
+    m_stream_change.store(false);
     m_demux_abort.store(false);
+    m_demux_paused.store(false);
+    m_demux_layout.store(m_capture_layout.load());
     m_demux_open.store(true);
     
-    kodi::Log(ADDON_LOG_DEBUG, "Demux stream opened");
+    // Demux replaces the byte-stream reader, hand its frames back to the pool
+    ReleaseReadyBuffers();
+    
+    Log(LogLevel::Debug, "Demux stream opened");
     return true;
 }
 
@@ -432,7 +527,7 @@ void StreamProcessor::CloseDemuxStream() {
         return;
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Closing demux stream");
+    Log(LogLevel::Debug, "Closing demux stream");
     
     m_demux_abort.store(true);
     m_demux_condition.notify_all();
@@ -440,15 +535,14 @@ void StreamProcessor::CloseDemuxStream() {
     // Clear demux packet queue
     {
         std::lock_guard<std::mutex> lock(m_demux_mutex);
-        std::queue<std::unique_ptr<DEMUX_PACKET>> empty_queue;
-        m_demux_packets.swap(empty_queue);
+        m_demux_frames.clear();
     }
     
     m_demux_open.store(false);
-    kodi::Log(ADDON_LOG_DEBUG, "Demux stream closed");
+    Log(LogLevel::Debug, "Demux stream closed");
 }
 
-DEMUX_PACKET* StreamProcessor::DemuxRead() {
+DEMUX_PACKET* StreamProcessor::DemuxRead(const DemuxPacketAllocator& allocate) {
     if (!m_demux_open.load()) {
         return nullptr;
     }
@@ -457,42 +551,127 @@ DEMUX_PACKET* StreamProcessor::DemuxRead() {
         return nullptr;
     }
     
+    // Resolution changed - Kodi re-reads the stream properties
+    if (m_stream_change.exchange(false)) {
+        DEMUX_PACKET* packet = allocate(0);
+        if (!packet) {
+            m_stream_change.store(true);
+            return nullptr;
+        }
+        packet->iStreamId = DMX_SPECIALID_STREAMCHANGE;
+        Log(LogLevel::Debug, "Announcing demux stream change");
+        return packet;
+    }
+    
+    // With timeshift packets come from the ring's read position
+    if (m_timeshift.IsOpen()) {
+        return ReadTimeshiftPacket(allocate);
+    }
+    
     std::unique_lock<std::mutex> lock(m_demux_mutex);
     
     // Wait for packet with timeout
     auto timeout = std::chrono::milliseconds(100);
     if (!m_demux_condition.wait_for(lock, timeout, [this]() {
-        return !m_demux_packets.empty() || m_demux_abort.load();
+        return !m_demux_frames.empty() || m_demux_abort.load();
     })) {
         return nullptr;  // Timeout
     }
     
-    if (m_demux_abort.load() || m_demux_packets.empty()) {
+    if (m_demux_abort.load() || m_demux_frames.empty()) {
         return nullptr;
     }
     
-    auto packet = std::move(m_demux_packets.front());
-    m_demux_packets.pop();
+    FrameRef frame = std::move(m_demux_frames.front());
+    m_demux_frames.pop_front();
+    lock.unlock();
+    
+    if (IsTracing()) {
+        TraceInstant("frame delivered seq=%llu demux", static_cast<unsigned long long>(frame->sequence));
+    }
+    
+    // The copy into Kodi's packet happens only for frames actually read
+    return CreateDemuxPacket(frame->Data(), frame->Size(), GetFrameGeometry(m_demux_layout.load()),
+                             frame->timestamp, frame->duration.load(), allocate);
+}
+
+DEMUX_PACKET* StreamProcessor::ReadTimeshiftPacket(const DemuxPacketAllocator& allocate) {
+    // Paused playback holds the read position while the ring keeps filling
+    {
+        std::unique_lock<std::mutex> lock(m_demux_mutex);
+        auto timeout = std::chrono::milliseconds(100);
+        if (!m_demux_condition.wait_for(lock, timeout, [this]() {
+            return !m_demux_paused.load() || m_demux_abort.load();
+        }) || m_demux_abort.load()) {
+            return nullptr;
+        }
+    }
+    
+    uint32_t demux_layout = m_demux_layout.load();
+    FrameGeometry geometry = GetFrameGeometry(demux_layout);
+    DEMUX_PACKET* packet = nullptr;
+    bool layout_changed = false;
+    m_timeshift.ReadFrame([&](const uint8_t* data, size_t size, uint64_t timestamp, uint32_t layout) {
+        // Crossing a crop change - the player needs the new properties
+        // before the frame, which stays at the read position until then
+        if (layout != demux_layout) {
+            m_demux_layout.store(layout);
+            layout_changed = true;
+            return false;
+        }
+        // Frames that cannot be converted are skipped rather than retried
+        packet = CreateDemuxPacket(data, size, geometry, timestamp, 0, allocate);
+        return true;
+    }, 100);  // 100ms timeout
     
-    return packet.release();
+    if (layout_changed) {
+        m_stream_change.store(true);
+    }
+    return packet;
+}
+
+bool StreamProcessor::DemuxSeekTime(double time_ms, bool backwards, double& start_pts) {
+    if (!m_demux_open.load() || !m_timeshift.IsOpen()) {
+        return false;
+    }
+    
+    // Packet timestamps are microseconds, Kodi seeks in milliseconds
+    uint64_t target = time_ms > 0 ? static_cast<uint64_t>(std::llround(time_ms * 1000)) : 0;
+    uint64_t frame_timestamp = 0;
+    if (!m_timeshift.SeekTime(target, backwards, frame_timestamp)) {
+        return false;
+    }
+    
+    start_pts = static_cast<double>(frame_timestamp);
+    Log(LogLevel::Debug, "Demux seek to %.0f ms landed at %llu us", time_ms,
+        static_cast<unsigned long long>(frame_timestamp));
+    return true;
+}
+
+void StreamProcessor::PauseDemuxStream(bool paused) {
+    {
+        std::lock_guard<std::mutex> lock(m_demux_mutex);
+        m_demux_paused.store(paused);
+    }
+    m_demux_condition.notify_all();
+    Log(LogLevel::Debug, "Demux stream %s", paused ? "paused" : "resumed");
 }
 
 void StreamProcessor::DemuxAbort() {
-    kodi::Log(ADDON_LOG_DEBUG, "Demux abort requested");
+    Log(LogLevel::Debug, "Demux abort requested");
     m_demux_abort.store(true);
     m_demux_condition.notify_all();
 }
 
 void StreamProcessor::DemuxFlush() {
-    kodi::Log(ADDON_LOG_DEBUG, "Demux flush requested");
+    Log(LogLevel::Debug, "Demux flush requested");
     
     std::lock_guard<std::mutex> lock(m_demux_mutex);
-    std::queue<std::unique_ptr<DEMUX_PACKET>> empty_queue;
-    m_demux_packets.swap(empty_queue);
+    m_demux_frames.clear();
 }
 
 void StreamProcessor::DemuxReset() {
-    kodi::Log(ADDON_LOG_DEBUG, "Demux reset requested");
+    Log(LogLevel::Debug, "Demux reset requested");
     DemuxFlush();
 }
 
@@ -504,42 +683,74 @@ bool StreamProcessor::GetCurrentFormat(VideoFormat& video_fmt, AudioFormat& audi
 }
 
 bool StreamProcessor::IsSignalPresent() const {
-    if (!m_v4l2_device) {
+    if (!m_source) {
         return false;
     }
     
-    return m_v4l2_device->IsSignalPresent();
+    return m_source->CheckSignalPresent();
 }
 
 bool StreamProcessor::SetBufferParameters(uint32_t buffer_count, uint32_t buffer_size) {
     if (m_streaming.load()) {
-        kodi::Log(ADDON_LOG_ERROR, "Cannot change buffer parameters while streaming");
+        Log(LogLevel::Error, "Cannot change buffer parameters while streaming");
         return false;
     }
     
     if (buffer_count == 0 || buffer_size == 0) {
-        kodi::Log(ADDON_LOG_ERROR, "Invalid buffer parameters: count=%u, size=%u", 
-                  buffer_count, buffer_size);
+        Log(LogLevel::Error, "Invalid buffer parameters: count=%u, size=%u", 
+            buffer_count, buffer_size);
         return false;
     }
     
     m_buffer_count = buffer_count;
     m_buffer_size = buffer_size;
     
-    // Reinitialize buffer pool if already initialized
-    if (m_initialized.load()) {
-        m_buffer_pool = std::make_unique<BufferPool>(m_buffer_count, m_buffer_size);
+    // The next stream sizes a new pool
+    FreeBufferPool();
+    
+    Log(LogLevel::Debug, "Buffer parameters set: count=%u, size=%u", 
+        buffer_count, buffer_size);
+    return true;
+}
+
+bool StreamProcessor::SetResources(std::shared_ptr<CaptureResources> resources) {
+    if (m_streaming.load() || !resources) {
+        return false;
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Buffer parameters set: count=%u, size=%u", 
-              buffer_count, buffer_size);
+    // The old budget gets its charge back
+    FreeBufferPool();
+    m_resources = std::move(resources);
     return true;
 }
 
+bool StreamProcessor::SetExternalCapture(bool enabled) {
+    if (m_streaming.load()) {
+        return false;
+    }
+
+    m_external_capture = enabled;
+    return true;
+}
+
+void StreamProcessor::ReleaseIdleBuffers() {
+    if (m_streaming.load() || !m_frame_pool) {
+        return;
+    }
+    
+    ReleaseReadyBuffers();
+    {
+        std::lock_guard<std::mutex> lock(m_demux_mutex);
+        m_demux_frames.clear();
+    }
+    FreeBufferPool();
+    Log(LogLevel::Debug, "Idle frame pool released");
+}
+
 void StreamProcessor::GetBufferStatistics(uint32_t& total_buffers, uint32_t& used_buffers, 
                                          uint32_t& dropped_frames) {
-    total_buffers = m_buffer_pool ? static_cast<uint32_t>(m_buffer_pool->GetTotalBuffers()) : 0;
-    used_buffers = m_buffer_pool ? static_cast<uint32_t>(m_buffer_pool->GetUsedBuffers()) : 0;
+    total_buffers = m_frame_pool ? static_cast<uint32_t>(m_frame_pool->GetTotalFrames()) : 0;
+    used_buffers = m_frame_pool ? static_cast<uint32_t>(m_frame_pool->GetUsedFrames()) : 0;
     dropped_frames = m_dropped_frames.load();
 }
 
@@ -548,106 +759,403 @@ void StreamProcessor::GetBufferStatistics(uint32_t& total_buffers, uint32_t& use
 //
 
 void StreamProcessor::CaptureThreadFunction() {
-    kodi::Log(ADDON_LOG_DEBUG, "Capture thread started");
+    Log(LogLevel::Debug, "Capture thread started");
     
     while (m_capture_thread_running.load()) {
-        if (!m_v4l2_device) {
+        if (!m_source) {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
             continue;
         }
         
-        // Capture frame from V4L2 device
-        VideoBuffer v4l2_buffer;
-        uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::steady_clock::now().time_since_epoch()).count();
-            
-        if (m_v4l2_device->CaptureFrame(v4l2_buffer, 100)) {  // 100ms timeout
-            ProcessCapturedFrame(v4l2_buffer, timestamp);
-        }
+        CaptureNextFrame(100);  // 100ms timeout
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Capture thread finished");
+    Log(LogLevel::Debug, "Capture thread finished");
 }
 
-bool StreamProcessor::ProcessCapturedFrame(const VideoBuffer& v4l2_buffer, uint64_t timestamp) {
-    if (!v4l2_buffer.data || v4l2_buffer.size == 0) {
+void StreamProcessor::OnFramesReady() {
+    std::lock_guard<std::mutex> lock(m_external_capture_mutex);
+    if (!m_external_capture || !m_source) {
+        return;
+    }
+    
+    // Bounded so a fast source cannot starve the rest of the event loop -
+    // the next completed buffer reports readiness again
+    uint32_t limit = m_source->GetBufferCount();
+    for (uint32_t i = 0; i <= limit && m_capture_thread_running.load(); ++i) {
+        if (!CaptureNextFrame(0)) {
+            break;
+        }
+    }
+}
+
+bool StreamProcessor::CaptureNextFrame(uint32_t timeout_ms) {
+    FrameRef frame = m_frame_pool->Acquire();
+    if (!frame) {
+        // Every frame is still referenced by a consumer - drop this capture
+        // into the overflow buffer, so the driver keeps cycling
+        if (!m_source->CaptureFrame(m_overflow_buffer, timeout_ms)) {
+            return false;
+        }
+        m_resources->stats.bytes_copied.fetch_add(m_overflow_buffer.size);
+        CountDroppedFrame("frame pool exhausted");
+        Log(LogLevel::Warning, "Dropped frame: frame pool exhausted");
+        return true;
+    }
+    
+    if (!frame->Reserve(m_source->GetFrameSize())) {
+        CountDroppedFrame("frame allocation failed");
         return false;
     }
     
-    // Get buffer from pool
-    StreamBuffer* stream_buffer = m_buffer_pool->GetBuffer();
-    if (!stream_buffer) {
-        // Buffer pool exhausted - drop frame
-        m_dropped_frames.fetch_add(1);
-        kodi::Log(ADDON_LOG_WARNING, "Dropped frame: buffer pool exhausted");
+    // Capture straight into the shared frame - this is the only copy
+    size_t frame_size = 0;
+    uint64_t driver_timestamp = 0;
+    if (!m_source->CaptureFrameInto(frame->Data(), frame->Capacity(), frame_size,
+                                   driver_timestamp, timeout_ms)) {
         return false;
     }
     
-    // Ensure buffer capacity
-    if (stream_buffer->capacity < v4l2_buffer.size) {
-        if (!stream_buffer->Allocate(v4l2_buffer.size)) {
-            m_buffer_pool->ReturnBuffer(stream_buffer);
-            m_dropped_frames.fetch_add(1);
-            return false;
-        }
+    uint64_t capture_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    uint64_t pts = capture_time;
+    uint64_t duration = 0;
+    m_pts_generator.Next(capture_time, pts, duration);
+    
+    m_resources->stats.bytes_copied.fetch_add(frame_size);
+    
+    frame->SetSize(frame_size);
+    frame->timestamp = pts;
+    frame->duration.store(duration);
+    frame->sequence = m_frame_sequence++;
+    frame->device_timestamp = driver_timestamp;
+    frame->device_sequence = m_source->GetLastSequence();
+    frame->layout = m_capture_layout.load();
+    if (IsTracing()) {
+        uint64_t latency = driver_timestamp > 0 && driver_timestamp <= capture_time ? capture_time - driver_timestamp : 0;
+        TraceInstant("frame dequeued seq=%llu device_seq=%llu latency_us=%llu",
+                     static_cast<unsigned long long>(frame->sequence),
+                     static_cast<unsigned long long>(frame->device_sequence),
+                     static_cast<unsigned long long>(latency));
+    }
+    if (m_raw_capture.IsRecording()) {
+        RecordRawFrame(frame);
+    }
+    ProcessCapturedFrame(frame);
+    return true;
+}
+
+void StreamProcessor::RecordRawFrame(const FrameRef& frame) {
+    VideoFormat format = m_source->GetConfiguredFormat();
+    uint32_t frame_size = m_source->GetFrameSize();
+    uint32_t bytes_per_line = m_source->GetBytesPerLine();
+    if (m_raw_format_pending.exchange(false) || format != m_raw_format || frame_size != m_raw_frame_size ||
+        bytes_per_line != m_raw_bytes_per_line) {
+        m_raw_format = format;
+        m_raw_frame_size = frame_size;
+        m_raw_bytes_per_line = bytes_per_line;
+        m_raw_capture.SubmitFormat(format, frame_size, bytes_per_line, frame->device_sequence,
+                                   frame->device_timestamp);
     }
+    m_raw_capture.SubmitFrame(frame);
+}
+
+bool StreamProcessor::ProcessCapturedFrame(const FrameRef& frame) {
+    if (!frame || frame->Size() == 0) {
+        return false;
+    }
+    
+    TraceScope trace("process frame");
     
-    // Copy frame data
-    std::memcpy(stream_buffer->data.get(), v4l2_buffer.data, v4l2_buffer.size);
-    stream_buffer->size = v4l2_buffer.size;
-    stream_buffer->timestamp = timestamp;
+    // Repeated frames (static pictures, 3:2 pulldown) only extend the
+    // duration of the demux packet already queued. The live reader,
+    // timeshift and recorders are raw byte streams without durations, they
+    // keep every frame so playback speed stays right.
+    bool duplicate = m_skip_duplicates.load() && m_deduplicator.IsDuplicate(frame);
+    if (duplicate) {
+        m_duplicate_frames.fetch_add(1);
+        m_resources->stats.duplicate_frames.fetch_add(1);
+    }
     
-    // Add to ready buffer queue
+    if (m_letterbox_active && ++m_letterbox_counter % LETTERBOX_ANALYSIS_INTERVAL == 0) {
+        AnalyzeLetterbox(*frame);
+    }
+    
+    // Registered consumers (recording, thumbnails, ...) share the frame
     {
-        std::lock_guard<std::mutex> lock(m_buffer_mutex);
-        m_ready_buffers.push(stream_buffer);
+        std::lock_guard<std::mutex> lock(m_consumer_mutex);
+        for (const auto& consumer : m_consumers) {
+            consumer.callback(frame);
+        }
     }
-    m_buffer_condition.notify_one();
     
-    // Create demux packet if demux is open
-    if (m_demux_open.load() && !m_demux_abort.load()) {
-        auto demux_packet = CreateDemuxPacket(*stream_buffer);
-        if (demux_packet) {
-            std::lock_guard<std::mutex> lock(m_demux_mutex);
-            m_demux_packets.push(std::move(demux_packet));
-            m_demux_condition.notify_one();
+    // With timeshift the ring is the source of every reader
+    if (m_timeshift.IsOpen()) {
+        if (!m_timeshift.WriteFrame(frame->Data(), frame->Size(), frame->timestamp, frame->layout)) {
+            CountDroppedFrame("timeshift write failed");
         }
     }
     
+    // Demux holds a reference until Kodi reads the packet
+    if (!duplicate && !m_timeshift.IsOpen() && m_demux_open.load() && !m_demux_abort.load()) {
+        std::lock_guard<std::mutex> lock(m_demux_mutex);
+        m_demux_frames.push_back(frame);
+        m_demux_condition.notify_one();
+    }
+    
+    // Without timeshift byte-stream reads come from the ready queue. Kodi
+    // never calls ReadLiveStream on a demuxed stream, so nothing is queued
+    // then, and an idle reader only ever pins the newest few frames.
+    if (!m_timeshift.IsOpen() && !m_demux_open.load()) {
+        size_t ready = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_buffer_mutex);
+            m_ready_frames.push_back(frame);
+            TrimReadyBuffers(m_standby.load() ? m_standby_ring_frames.load() : READY_QUEUE_FRAMES);
+            ready = m_ready_frames.size();
+        }
+        m_buffer_condition.notify_one();
+        if (IsTracing()) {
+            TraceCounter("ready frames", static_cast<int64_t>(ready));
+        }
+    }
+    
+    if (IsTracing()) {
+        TraceInstant("frame pooled seq=%llu", static_cast<unsigned long long>(frame->sequence));
+    }
+    
     // Update statistics
     m_total_frames_processed.fetch_add(1);
-    UpdateBitrate(v4l2_buffer.size);
+    m_resources->stats.frames_captured.fetch_add(1);
+    m_resources->stats.bytes_captured.fetch_add(frame->Size());
+    UpdateBitrate(frame->Size());
     
     return true;
 }
 
-std::unique_ptr<DEMUX_PACKET> StreamProcessor::CreateDemuxPacket(const StreamBuffer& stream_buffer) {
-    if (!stream_buffer.data || stream_buffer.size == 0) {
+DEMUX_PACKET* StreamProcessor::CreateDemuxPacket(const uint8_t* data, size_t size, const FrameGeometry& geometry,
+                                                 uint64_t pts, uint64_t duration,
+                                                 const DemuxPacketAllocator& allocate) {
+    // Frames captured before a crop change no longer match the geometry
+    size_t source_size = FrameConverter::GetSourceSize(geometry);
+    if (source_size == 0 || size < source_size) {
         return nullptr;
     }
     
-    auto packet = std::make_unique<DEMUX_PACKET>();
+    size_t packet_size = FrameConverter::GetYuv4Size(geometry.width, geometry.height);
+    DEMUX_PACKET* packet = allocate(static_cast<int>(packet_size));
     if (!packet) {
         return nullptr;
     }
     
-    // Allocate packet data
-    packet->pData = new uint8_t[stream_buffer.size];
-    if (!packet->pData) {
-        return nullptr;
-    }
-    
-    // Copy data
-    std::memcpy(packet->pData, stream_buffer.data.get(), stream_buffer.size);
-    packet->iSize = static_cast<int>(stream_buffer.size);
-    packet->pts = static_cast<double>(stream_buffer.timestamp);
+    // The conversion is the copy into Kodi's packet
+    FrameConverter::ToYuv4(data, geometry, packet->pData);
+    packet->iSize = static_cast<int>(packet_size);
+    packet->pts = static_cast<double>(pts);
     packet->dts = packet->pts;
-    packet->duration = 0;  // Will be set by Kodi
-    packet->iStreamId = 0;  // Video stream
+    packet->duration = static_cast<double>(duration);  // 0 lets Kodi derive it
+    packet->iStreamId = VIDEO_STREAM_ID;
     
     return packet;
 }
 
+void StreamProcessor::GetFrameFormat(const Frame& frame, FrameGeometry& geometry, FrameRate& frame_rate) const {
+    std::lock_guard<std::mutex> lock(m_format_mutex);
+    geometry = FindFrameLayout(frame.layout);
+    frame_rate = m_current_video_format.frame_rate;
+}
+
+FrameGeometry StreamProcessor::GetFrameGeometry(uint32_t layout) const {
+    std::lock_guard<std::mutex> lock(m_format_mutex);
+    return FindFrameLayout(layout);
+}
+
+FrameGeometry StreamProcessor::FindFrameLayout(uint32_t layout) const {
+    if (m_frame_layouts.empty()) {
+        return {};
+    }
+    return layout < m_frame_layouts.size() ? m_frame_layouts[layout] : m_frame_layouts.back();
+}
+
+bool StreamProcessor::EnsureBufferPool(size_t frame_size) {
+    size_t required_size = std::max<size_t>(frame_size, m_buffer_size);
+    
+    if (m_frame_pool && m_pool_buffer_count == m_buffer_count &&
+        m_frame_pool->GetFrameSize() >= required_size) {
+        // Format unchanged or smaller - keep the existing allocation
+        return true;
+    }
+    
+    // Frames still held by consumers are freed when they let go
+    FreeBufferPool();
+    
+    // Other pipelines may hold most of the budget - run with fewer frames
+    // rather than not at all
+    size_t minimum = std::min(m_buffer_count, MIN_POOL_FRAMES) * required_size;
+    size_t granted = m_resources->budget.Acquire(minimum, m_buffer_count * required_size);
+    size_t frame_count = granted / required_size;
+    if (frame_count < m_buffer_count) {
+        Log(LogLevel::Info, "Memory budget limits the frame pool to %zu of %u frames",
+            frame_count, m_buffer_count);
+    }
+    
+    m_frame_pool = std::make_unique<FramePool>(frame_count, required_size);
+    m_pool_charge = granted;
+    m_pool_buffer_count = m_buffer_count;
+    if (m_frame_pool->GetTotalFrames() == 0) {
+        Log(LogLevel::Error, "Failed to allocate frame pool for %zu byte frames", required_size);
+        FreeBufferPool();
+        return false;
+    }
+    
+    Log(LogLevel::Debug, "Frame pool resized for %zu byte frames", required_size);
+    return true;
+}
+
+void StreamProcessor::FreeBufferPool() {
+    m_frame_pool.reset();
+    m_resources->budget.Release(m_pool_charge);
+    m_pool_charge = 0;
+    m_pool_buffer_count = 0;
+}
+
+void StreamProcessor::CountDroppedFrame(const char* reason) {
+    m_dropped_frames.fetch_add(1);
+    m_resources->stats.frames_dropped.fetch_add(1);
+    if (IsTracing()) {
+        TraceInstant("frame dropped: %s", reason);
+    }
+}
+
+void StreamProcessor::ReleaseReadyBuffers() {
+    std::lock_guard<std::mutex> lock(m_buffer_mutex);
+    m_ready_frames.clear();
+    m_read_frame.Reset();
+    m_read_offset = 0;
+}
+
+void StreamProcessor::TrimReadyBuffers(size_t max_frames) {
+    while (m_ready_frames.size() > max_frames) {
+        m_ready_frames.pop_front();
+    }
+}
+
+void StreamProcessor::StartLetterboxDetection() {
+    m_letterbox_active = false;
+    m_letterbox_counter = 0;
+    
+    if (!m_letterbox_enabled.load()) {
+        return;
+    }
+    
+    VideoFormat format = m_source->GetConfiguredFormat();
+    if (!LetterboxDetector::SupportsFormat(format.fourcc)) {
+        Log(LogLevel::Debug, "Letterbox detection not available for this pixel format");
+        return;
+    }
+    
+    if (!m_source->GetCropBounds(m_crop_bounds) || !m_crop_bounds.is_valid()) {
+        Log(LogLevel::Debug, "Capture device does not support cropping");
+        return;
+    }
+    
+    CropRect current;
+    if (m_source->GetCropRect(current) && current != m_crop_bounds) {
+        CropRect full = m_crop_bounds;
+        m_source->SetCropRect(full);
+    }
+    
+    m_letterbox.Reset(m_crop_bounds);
+    m_letterbox_active = true;
+}
+
+void StreamProcessor::StopLetterboxDetection() {
+    if (!m_letterbox_active) {
+        return;
+    }
+    
+    m_letterbox_active = false;
+    if (m_letterbox.GetCurrentCrop() != m_crop_bounds) {
+        CropRect full = m_crop_bounds;
+        if (!m_source->SetCropRect(full)) {
+            Log(LogLevel::Warning, "Failed to reset capture crop");
+        }
+    }
+}
+
+void StreamProcessor::AnalyzeLetterbox(const Frame& frame) {
+    VideoFormat format = m_source->GetConfiguredFormat();
+    FrameGeometry geometry;
+    geometry.width = format.width;
+    geometry.height = format.height;
+    geometry.bytes_per_line = m_source->GetBytesPerLine();
+    geometry.fourcc = format.fourcc;
+    
+    // Frame captured before the last crop change - geometry would not match
+    if (static_cast<size_t>(geometry.bytes_per_line) * geometry.height > frame.Size()) {
+        return;
+    }
+    
+    CropRect crop;
+    if (m_letterbox.Analyze(frame.Data(), geometry, crop) && !ApplyCrop(crop)) {
+        Log(LogLevel::Warning, "Letterbox cropping disabled: driver rejected crop %s",
+            crop.to_string().c_str());
+        m_letterbox_active = false;
+    }
+}
+
+bool StreamProcessor::ApplyCrop(CropRect crop) {
+    CropRect requested = crop;
+    if (!m_source->SetCropRect(crop)) {
+        // Many drivers only accept a new selection while stopped
+        m_source->StopStreaming();
+        crop = requested;
+        bool applied = m_source->SetCropRect(crop);
+        if (!m_source->StartStreaming()) {
+            Log(LogLevel::Error, "Failed to restart the capture source after crop change");
+        }
+        if (!applied) {
+            return false;
+        }
+    }
+    
+    m_letterbox.SetApplied(crop);
+    
+    VideoFormat format = m_source->GetConfiguredFormat();
+    uint32_t layout_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_format_mutex);
+        m_current_video_format.width = format.width;
+        m_current_video_format.height = format.height;
+        m_current_stride = m_source->GetBytesPerLine();
+        FrameGeometry layout;
+        layout.width = format.width;
+        layout.height = format.height;
+        layout.bytes_per_line = m_current_stride;
+        layout.fourcc = m_current_video_format.fourcc;
+        m_frame_layouts.push_back(layout);
+        layout_id = static_cast<uint32_t>(m_frame_layouts.size() - 1);
+    }
+    m_capture_layout.store(layout_id);
+    
+    // Queued frames have the old size - drop them and tell the player. The
+    // timeshift reader announces the change when it reaches the new frames.
+    if (!m_timeshift.IsOpen()) {
+        std::lock_guard<std::mutex> lock(m_demux_mutex);
+        m_demux_frames.clear();
+        m_demux_layout.store(layout_id);
+        m_stream_change.store(true);
+    }
+    
+    if (IsTracing()) {
+        TraceInstant("format change %ux%u crop", format.width, format.height);
+    }
+    
+    Log(LogLevel::Info, "Capture crop set to %s (%ux%u delivered)",
+        crop.to_string().c_str(), format.width, format.height);
+    return true;
+}
+
 void StreamProcessor::UpdateBitrate(size_t bytes_processed) {
     m_total_bytes_processed.fetch_add(bytes_processed);
     
@@ -664,18 +1172,18 @@ void StreamProcessor::UpdateBitrate(size_t bytes_processed) {
 bool StreamProcessor::ValidateVideoFormat(const VideoFormat& format) const {
     // Check for valid dimensions
     if (format.width == 0 || format.height == 0) {
-        kodi::Log(ADDON_LOG_ERROR, "Invalid video dimensions: %dx%d", format.width, format.height);
+        Log(LogLevel::Error, "Invalid video dimensions: %dx%d", format.width, format.height);
         return false;
     }
     
     // Check for reasonable dimensions (avoid extremely large buffers)
     if (format.width > 3840 || format.height > 2160) {
-        kodi::Log(ADDON_LOG_WARNING, "Large video dimensions: %dx%d", format.width, format.height);
+        Log(LogLevel::Warning, "Large video dimensions: %dx%d", format.width, format.height);
     }
     
     // Check framerate
-    if (format.framerate <= 0 || format.framerate > 120) {
-        kodi::Log(ADDON_LOG_ERROR, "Invalid framerate: %d", format.framerate);
+    if (!format.frame_rate.is_valid() || format.frame_rate.to_double() > 120.0) {
+        Log(LogLevel::Error, "Invalid framerate: %u/%u", format.frame_rate.num, format.frame_rate.den);
         return false;
     }
     
@@ -685,13 +1193,13 @@ bool StreamProcessor::ValidateVideoFormat(const VideoFormat& format) const {
 bool StreamProcessor::ValidateAudioFormat(const AudioFormat& format) const {
     // Check sample rate
     if (format.sample_rate == 0) {
-        kodi::Log(ADDON_LOG_ERROR, "Invalid sample rate: %d", format.sample_rate);
+        Log(LogLevel::Error, "Invalid sample rate: %d", format.sample_rate);
         return false;
     }
     
     // Check channels
     if (format.channels == 0 || format.channels > 8) {
-        kodi::Log(ADDON_LOG_ERROR, "Invalid channel count: %d", format.channels);
+        Log(LogLevel::Error, "Invalid channel count: %d", format.channels);
         return false;
     }
     
@@ -699,24 +1207,16 @@ bool StreamProcessor::ValidateAudioFormat(const AudioFormat& format) const {
 }
 
 void StreamProcessor::CleanupResources() {
-    // Clear buffer pool
-    m_buffer_pool.reset();
-    
-    // Clear ready buffer queue
-    {
-        std::lock_guard<std::mutex> lock(m_buffer_mutex);
-        std::queue<StreamBuffer*> empty_queue;
-        m_ready_buffers.swap(empty_queue);
-    }
-    
-    // Clear demux packet queue
+    // Drop queued frames before their pool
+    ReleaseReadyBuffers();
     {
         std::lock_guard<std::mutex> lock(m_demux_mutex);
-        std::queue<std::unique_ptr<DEMUX_PACKET>> empty_queue;
-        m_demux_packets.swap(empty_queue);
+        m_demux_frames.clear();
     }
     
-    kodi::Log(ADDON_LOG_DEBUG, "Resources cleaned up");
+    FreeBufferPool();
+    
+    Log(LogLevel::Debug, "Resources cleaned up");
 }
 
 } // namespace hdmi_pvr
\ No newline at end of file
@@ -8,16 +8,25 @@
 #pragma once
 
 #include "types.h"
-#include "v4l2_device.h"
+#include "capture_source.h"
+#include "timeshift_buffer.h"
+#include "recording_engine.h"
+#include "frame.h"
+#include "frame_deduplicator.h"
+#include "letterbox_detector.h"
+#include "pts_generator.h"
+#include "capture_resources.h"
+#include "raw_capture.h"
 #include <kodi/addon-instance/PVR.h>
 #include <memory>
 #include <vector>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <deque>
 
 namespace hdmi_pvr {
 
@@ -25,15 +34,16 @@ namespace hdmi_pvr {
  * StreamProcessor handles real-time video/audio stream processing for HDMI input.
  * 
  * This class provides:
- * - Real-time stream capture from V4L2 HDMI devices
+ * - Real-time stream capture from V4L2 HDMI devices (or any CaptureSource)
  * - Hardware-accelerated demuxing support
  * - Thread-safe buffer management with RAII patterns
  * - Live stream reading for Kodi PVR integration
  * - Comprehensive error recovery and signal monitoring
  * 
  * The streaming pipeline:
- * 1. V4L2Device captures raw frames from HDMI input
- * 2. StreamProcessor manages buffer pools and threading
+ * 1. The CaptureSource (V4L2Device for HDMI input) fills pooled Frames
+ * 2. Each Frame is shared by reference with every consumer (live read,
+ *    demux, timeshift, recording, registered frame consumers)
  * 3. Demux operations provide hardware-accelerated stream parsing
  * 4. Kodi PVR reads processed stream data for playback
  */
@@ -41,9 +51,9 @@ class StreamProcessor {
 public:
     /**
      * Constructor
-     * @param v4l2_device Pointer to V4L2Device for HDMI capture (can be nullptr for delayed initialization)
+     * @param source Frame source, normally the V4L2Device for HDMI capture (can be nullptr for delayed initialization)
      */
-    explicit StreamProcessor(V4L2Device* v4l2_device = nullptr);
+    explicit StreamProcessor(CaptureSource* source = nullptr);
     
     /**
      * Destructor - ensures clean shutdown
@@ -76,11 +86,11 @@ public:
     bool IsInitialized() const { return m_initialized.load(); }
 
     /**
-     * Set the V4L2 device for capture (can be changed during runtime)
-     * @param v4l2_device Pointer to V4L2Device
-     * @return true if device set successfully
+     * Set the frame source (only while not streaming)
+     * @param source V4L2Device, SyntheticSource, ReplaySource, ...
+     * @return true if the source was set
      */
-    bool SetV4L2Device(V4L2Device* v4l2_device);
+    bool SetCaptureSource(CaptureSource* source);
 
     //
     // Stream operations
@@ -105,6 +115,26 @@ public:
      */
     bool IsStreaming() const { return m_streaming.load(); }
 
+    /**
+     * Keep capturing without a reader. Only the newest frames are retained
+     * in a small ring so a reopen can resume without restarting V4L2.
+     * @param ring_frames Number of most recent frames to keep (at least 1)
+     * @return true if standby was entered (requires active streaming)
+     */
+    bool EnterStandby(uint32_t ring_frames);
+
+    /**
+     * Leave standby and resume delivery from the newest captured frame
+     * @return true if the processor was in standby and is streaming again
+     */
+    bool ResumeFromStandby();
+
+    /**
+     * Check if capture is running in warm standby
+     * @return true if in standby
+     */
+    bool IsInStandby() const { return m_standby.load(); }
+
     //
     // Data reading for Kodi PVR
     //
@@ -118,11 +148,189 @@ public:
     int ReadLiveStream(unsigned char* buffer, unsigned int size);
 
     /**
-     * Get stream properties for Kodi PVR
-     * @param properties Vector to fill with stream properties
+     * Describe the streams exactly as they are delivered
+     * @param descriptors Filled with the current video and audio descriptors
+     * @return true if streaming and the video stream is described
+     */
+    bool GetStreamDescriptors(StreamDescriptors& descriptors) const;
+
+    /**
+     * Resolves an FFmpeg codec name to Kodi's codec id
+     */
+    using CodecLookup = std::function<kodi::addon::PVRCodec(const std::string& name)>;
+
+    /**
+     * Allocates a demux packet with room for the given payload. Kodi frees
+     * the packets it reads, so they must come from its own allocator, which
+     * also adds the padding FFmpeg's decoders read past the end.
+     */
+    using DemuxPacketAllocator = std::function<DEMUX_PACKET*(int size)>;
+
+    /**
+     * Create a video demux packet, converting the frame to FrameConverter::CODEC_NAME
+     * @param data Captured frame
+     * @param size Bytes of data
+     * @param geometry Layout of the captured frame
+     * @param pts Presentation time in microseconds
+     * @param duration Display duration in microseconds, 0 = unknown
+     * @param allocate Packet allocator of the add-on instance
+     * @return DEMUX_PACKET or nullptr if the frame does not match the geometry
+     */
+    static DEMUX_PACKET* CreateDemuxPacket(const uint8_t* data, size_t size, const FrameGeometry& geometry,
+                                           uint64_t pts, uint64_t duration, const DemuxPacketAllocator& allocate);
+
+    /**
+     * Get the demux stream list: codec, size, frame rate and aspect.
+     * PVRStreamProperties has no field for a pixel format or stride, so
+     * video is announced as FrameConverter::CODEC_NAME, which needs neither.
+     * @param properties Vector to fill, one entry per stream sent by DemuxRead
+     * @param lookup Codec resolver of the add-on instance
      * @return PVR_ERROR_NO_ERROR on success
      */
-    PVR_ERROR GetStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties);
+    PVR_ERROR GetDemuxStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties,
+                                       const CodecLookup& lookup) const;
+
+    /**
+     * Describe the video stream DemuxRead delivers for frames of a layout
+     * @param layout Layout of the captured frames
+     * @param frame_rate Frame rate of the stream
+     * @return Descriptor, invalid if the layout cannot be converted
+     */
+    static VideoStreamDescriptor DescribeVideoStream(const FrameGeometry& layout, const FrameRate& frame_rate);
+
+    /**
+     * Append the stream properties of a video descriptor
+     * @param video Descriptor of the delivered stream
+     * @param lookup Codec resolver of the add-on instance
+     * @param properties Vector to append to
+     * @return PVR_ERROR_NO_ERROR on success, PVR_ERROR_FAILED if Kodi lacks the codec
+     */
+    static PVR_ERROR AddVideoStreamProperties(const VideoStreamDescriptor& video, const CodecLookup& lookup,
+                                              std::vector<kodi::addon::PVRStreamProperties>& properties);
+
+    /**
+     * Describe a frame handed to a consumer, for recorders that keep the
+     * format with the frames
+     * @param frame Frame of this processor
+     * @param geometry Filled with the layout the frame was captured in
+     * @param frame_rate Filled with the stream frame rate
+     */
+    void GetFrameFormat(const Frame& frame, FrameGeometry& geometry, FrameRate& frame_rate) const;
+
+    static constexpr uint32_t VIDEO_STREAM_ID = 1;  ///< PID of the video stream in demux mode
+    static constexpr uint32_t AUDIO_STREAM_ID = 2;  ///< PID of the audio stream in demux mode
+
+    //
+    // Timeshift support
+    //
+
+    /**
+     * Configure the timeshift ring used by the next StartStreaming call
+     * @param path Ring file location (tmpfs or eMMC)
+     * @param size_bytes Ring size in bytes, 0 disables timeshift
+     */
+    void SetTimeshift(const std::string& path, size_t size_bytes);
+
+    /**
+     * Check if the live stream is served from the timeshift ring
+     * @return true if timeshift is active
+     */
+    bool IsTimeshiftActive() const { return m_timeshift.IsOpen(); }
+
+    /**
+     * Seek within the timeshift ring
+     * @param position Byte offset
+     * @param whence SEEK_SET, SEEK_CUR or SEEK_END
+     * @return New position, -1 if timeshift is not active
+     */
+    int64_t SeekLiveStream(int64_t position, int whence);
+
+    /**
+     * Get the total number of bytes written to the timeshift ring
+     * @return Stream length, -1 if timeshift is not active
+     */
+    int64_t LengthLiveStream() const;
+
+    /**
+     * Check if playback is at the live edge
+     * @return true when not timeshifted
+     */
+    bool IsRealTimeStream() const;
+
+    /**
+     * Get the time range available for timeshift, on the timeline of the
+     * demux packet PTS. Kodi takes the play position from the packets it
+     * plays, which come from the ring's read position.
+     * @param start_time Wall clock time corresponding to start_us
+     * @param start_us PTS of the first frame of the stream in microseconds
+     * @param begin_us Oldest available PTS in microseconds
+     * @param end_us Newest available PTS in microseconds
+     * @return true if timeshift is active and holds data
+     */
+    bool GetStreamTimes(time_t& start_time, uint64_t& start_us, uint64_t& begin_us, uint64_t& end_us) const;
+
+    /**
+     * Move the demux read position within the timeshift ring
+     * @param time_ms Target on the packet PTS timeline in milliseconds
+     * @param backwards true to land on the frame at or before the target
+     * @param start_pts PTS of the first packet read after the seek, in microseconds
+     * @return true if the read position moved
+     */
+    bool DemuxSeekTime(double time_ms, bool backwards, double& start_pts);
+
+    /**
+     * Hold or release the demux read position; the ring keeps filling
+     * while paused until it overruns the reader
+     * @param paused true to pause
+     */
+    void PauseDemuxStream(bool paused);
+
+    //
+    // Frame fan-out
+    //
+
+    /**
+     * Callback receiving every captured frame on the capture thread, or
+     * the owner's event loop with external capture.
+     * Consumers must not block; they may keep the reference as long as
+     * needed, the frame returns to the pool when the last one is dropped.
+     */
+    using FrameConsumer = std::function<void(const FrameRef& frame)>;
+
+    /**
+     * Register an additional frame consumer
+     * @param consumer Callback invoked for each captured frame
+     * @return Consumer id for RemoveFrameConsumer()
+     */
+    int AddFrameConsumer(FrameConsumer consumer);
+
+    /**
+     * Unregister a frame consumer. After return the callback is not running
+     * and will not be called again.
+     * @param consumer_id Id returned by AddFrameConsumer()
+     */
+    void RemoveFrameConsumer(int consumer_id);
+
+    //
+    // Raw capture
+    //
+
+    /**
+     * Record every frame as the source delivers it - before duplicate
+     * elimination - with driver timestamps, sequence numbers and format
+     * changes, for replay with ReplaySource. Ends with the stream.
+     * @param path Output file
+     * @return true if recording started (requires active streaming)
+     */
+    bool StartRawCapture(const std::string& path);
+
+    /**
+     * Finish the raw capture file
+     */
+    void StopRawCapture();
+
+    bool IsRawCapturing() const { return m_raw_capture.IsRecording(); }
+    RawCaptureStats GetRawCaptureStats() const { return m_raw_capture.GetStats(); }
 
     //
     // Demux operations for hardware acceleration
@@ -141,9 +349,10 @@ public:
 
     /**
      * Read demux packet (hardware-accelerated)
+     * @param allocate Packet allocator of the add-on instance
      * @return Pointer to DEMUX_PACKET or nullptr if no data/error
      */
-    DEMUX_PACKET* DemuxRead();
+    DEMUX_PACKET* DemuxRead(const DemuxPacketAllocator& allocate);
 
     /**
      * Abort demux operations
@@ -196,6 +405,62 @@ public:
      */
     bool SetBufferParameters(uint32_t buffer_count, uint32_t buffer_size);
 
+    /**
+     * Share the memory budget and statistics with other pipelines
+     * @param resources Shared resources, must not be null
+     * @return false while streaming
+     */
+    bool SetResources(std::shared_ptr<CaptureResources> resources);
+
+    /**
+     * Let the owner drive capture from its event loop instead of a capture
+     * thread of the processor's own. The owner then calls OnFramesReady()
+     * whenever the device has frames.
+     * @param enabled true for owner driven capture
+     * @return false while streaming
+     */
+    bool SetExternalCapture(bool enabled);
+
+    /**
+     * Capture every frame the device has ready without waiting. Only has an
+     * effect while streaming with external capture; one caller at a time.
+     */
+    void OnFramesReady();
+
+    /**
+     * Free the frame pool and return it to the memory budget. Only has an
+     * effect while not streaming; the next StartStreaming allocates again.
+     */
+    void ReleaseIdleBuffers();
+
+    /**
+     * Leave frames identical to the previous one out of the demux stream,
+     * extending that packet's duration instead. Raw reads, timeshift and
+     * frame consumers still get every frame.
+     * @param enabled true to skip duplicates
+     */
+    void SetDuplicateFrameSkipping(bool enabled);
+
+    /**
+     * Get the number of duplicate frames skipped
+     * @return Skipped frame count since the add-on started
+     */
+    uint64_t GetDuplicateFrameCount() const { return m_duplicate_frames.load(); }
+
+    /**
+     * Get the frames captured and dropped by the current stream
+     * @return Counts since the last StartStreaming call
+     */
+    uint64_t GetFramesProcessed() const { return m_total_frames_processed.load(); }
+    uint32_t GetDroppedFrames() const { return m_dropped_frames.load(); }
+
+    /**
+     * Detect letterbox bars and crop them in hardware, so only the active
+     * picture is captured. Takes effect with the next StartStreaming call.
+     * @param enabled true to enable automatic cropping
+     */
+    void SetLetterboxCrop(bool enabled) { m_letterbox_enabled.store(enabled); }
+
     /**
      * Get buffer statistics
      * @param total_buffers Total number of allocated buffers
@@ -209,61 +474,21 @@ private:
     // Internal data structures
     //
 
-    /**
-     * Stream buffer for internal processing
-     */
-    struct StreamBuffer {
-        std::unique_ptr<uint8_t[]> data;
-        size_t size = 0;
-        size_t capacity = 0;
-        uint64_t timestamp = 0;
-        bool in_use = false;
-        
-        StreamBuffer() = default;
-        explicit StreamBuffer(size_t buffer_size);
-        ~StreamBuffer() = default;
-        
-        // Move semantics for efficient buffer management
-        StreamBuffer(StreamBuffer&& other) noexcept;
-        StreamBuffer& operator=(StreamBuffer&& other) noexcept;
-        
-        // Disable copy
-        StreamBuffer(const StreamBuffer&) = delete;
-        StreamBuffer& operator=(const StreamBuffer&) = delete;
-        
-        bool Allocate(size_t buffer_size);
-        void Reset();
-    };
-
-    /**
-     * Buffer pool for efficient memory management
-     */
-    class BufferPool {
-    public:
-        explicit BufferPool(size_t buffer_count, size_t buffer_size);
-        ~BufferPool() = default;
-        
-        StreamBuffer* GetBuffer();
-        void ReturnBuffer(StreamBuffer* buffer);
-        void Clear();
-        
-        size_t GetTotalBuffers() const { return m_buffers.size(); }
-        size_t GetUsedBuffers() const;
-        
-    private:
-        std::vector<std::unique_ptr<StreamBuffer>> m_buffers;
-        std::queue<StreamBuffer*> m_available_buffers;
-        mutable std::mutex m_mutex;
+    struct ConsumerEntry {
+        int id = 0;
+        FrameConsumer callback;
     };
 
     //
     // Device and state management
     //
 
-    V4L2Device* m_v4l2_device = nullptr;  ///< V4L2 device for capture (not owned)
+    CaptureSource* m_source = nullptr;  ///< Frame source (not owned)
     std::atomic<bool> m_initialized{false};  ///< Initialization status
     std::atomic<bool> m_streaming{false};  ///< Streaming status
     std::atomic<bool> m_demux_open{false};  ///< Demux stream status
+    std::atomic<bool> m_standby{false};  ///< Capturing without a reader
+    std::atomic<uint32_t> m_standby_ring_frames{0};  ///< Frames kept while in standby
 
     //
     // Format and stream properties
@@ -272,20 +497,81 @@ private:
     mutable std::mutex m_format_mutex;
     VideoFormat m_current_video_format;  ///< Current video format
     AudioFormat m_current_audio_format;  ///< Current audio format
+    uint32_t m_current_stride = 0;  ///< Bytes per line of the delivered frames
+    std::vector<FrameGeometry> m_frame_layouts;  ///< Every layout of this stream, indexed by layout id
+    std::atomic<uint32_t> m_capture_layout{0};  ///< Layout id of the frames being captured
+    std::atomic<uint32_t> m_demux_layout{0};  ///< Layout id Kodi has the stream properties of
+    std::atomic<bool> m_stream_change{false};  ///< Demux must announce new stream properties
     std::atomic<uint64_t> m_stream_bitrate{0};  ///< Current stream bitrate
 
     //
     // Buffer management
     //
 
-    std::unique_ptr<BufferPool> m_buffer_pool;
-    std::queue<StreamBuffer*> m_ready_buffers;  ///< Buffers ready for reading
+    std::unique_ptr<FramePool> m_frame_pool;
+    std::deque<FrameRef> m_ready_frames;  ///< Frames ready for live reading
+    FrameRef m_read_frame;  ///< Frame partially consumed by ReadLiveStream
+    size_t m_read_offset = 0;  ///< Bytes of m_read_frame already returned
     mutable std::mutex m_buffer_mutex;
     std::condition_variable m_buffer_condition;
 
     uint32_t m_buffer_count = 8;  ///< Number of buffers to allocate
     uint32_t m_buffer_size = 1024 * 1024;  ///< Size of each buffer (1MB default)
     std::atomic<uint32_t> m_dropped_frames{0};  ///< Frame drop counter
+    std::shared_ptr<CaptureResources> m_resources;  ///< Budget and counters shared between pipelines
+    size_t m_pool_charge = 0;  ///< Bytes of the budget held by m_frame_pool
+    uint32_t m_pool_buffer_count = 0;  ///< m_buffer_count the pool was sized for
+
+    static constexpr uint32_t MIN_POOL_FRAMES = 3;  ///< Capture, consumer and one in flight
+    static constexpr uint32_t READY_QUEUE_FRAMES = 2;  ///< Frames queued ahead of ReadLiveStream
+
+    //
+    // Timeshift
+    //
+
+    TimeshiftBuffer m_timeshift;  ///< Ring serving ReadLiveStream when enabled
+    std::string m_timeshift_path;
+    size_t m_timeshift_size = 0;  ///< Ring size in bytes, 0 = disabled
+
+    //
+    // Frame consumers
+    //
+
+    std::vector<ConsumerEntry> m_consumers;
+    std::mutex m_consumer_mutex;
+    int m_next_consumer_id = 1;
+    uint64_t m_frame_sequence = 0;  ///< Capture thread only
+    PtsGenerator m_pts_generator;   ///< Capture thread only
+
+    //
+    // Raw capture
+    //
+
+    RawCaptureRecorder m_raw_capture;
+    std::atomic<bool> m_raw_format_pending{false};  ///< Write the format before the next frame
+    VideoFormat m_raw_format;           ///< Capture thread only
+    uint32_t m_raw_frame_size = 0;      ///< Capture thread only
+    uint32_t m_raw_bytes_per_line = 0;  ///< Capture thread only
+
+    //
+    // Duplicate frame elimination
+    //
+
+    FrameDeduplicator m_deduplicator;  ///< Capture thread only
+    std::atomic<bool> m_skip_duplicates{false};
+    std::atomic<uint64_t> m_duplicate_frames{0};
+
+    //
+    // Letterbox cropping
+    //
+
+    static constexpr uint32_t LETTERBOX_ANALYSIS_INTERVAL = 15;  ///< Unique frames between analyses
+
+    LetterboxDetector m_letterbox;  ///< Capture thread only
+    std::atomic<bool> m_letterbox_enabled{false};
+    bool m_letterbox_active = false;  ///< Device supports cropping for this stream
+    CropRect m_crop_bounds;  ///< Full capture area
+    uint32_t m_letterbox_counter = 0;
 
     //
     // Threading
@@ -294,15 +580,19 @@ private:
     std::unique_ptr<std::thread> m_capture_thread;
     std::atomic<bool> m_capture_thread_running{false};
     std::condition_variable m_capture_condition;
+    std::atomic<bool> m_external_capture{false};
+    std::mutex m_external_capture_mutex;  ///< Held while OnFramesReady() captures
+    VideoBuffer m_overflow_buffer;  ///< Capture thread only
 
     //
     // Demux support
     //
 
-    std::queue<std::unique_ptr<DEMUX_PACKET>> m_demux_packets;
+    std::deque<FrameRef> m_demux_frames;  ///< Packets are built when Kodi reads them
     mutable std::mutex m_demux_mutex;
     std::condition_variable m_demux_condition;
     std::atomic<bool> m_demux_abort{false};
+    std::atomic<bool> m_demux_paused{false};  ///< Timeshifted reader holds its position
 
     //
     // Statistics and monitoring
@@ -322,19 +612,103 @@ private:
     void CaptureThreadFunction();
 
     /**
-     * Process captured frame from V4L2
-     * @param v4l2_buffer V4L2 buffer containing frame data
-     * @param timestamp Frame timestamp
+     * Capture one frame into the pool, or drop it if the pool is exhausted
+     * @param timeout_ms Time to wait for the device
+     * @return true if the device delivered a frame
+     */
+    bool CaptureNextFrame(uint32_t timeout_ms);
+
+    /**
+     * Distribute a captured frame to all consumers
+     * @param frame Captured frame
      * @return true if frame processed successfully
      */
-    bool ProcessCapturedFrame(const VideoBuffer& v4l2_buffer, uint64_t timestamp);
+    bool ProcessCapturedFrame(const FrameRef& frame);
+
+    /**
+     * Hand a captured frame to the raw capture, preceded by a format
+     * record when the source format changed
+     * @param frame Captured frame
+     */
+    void RecordRawFrame(const FrameRef& frame);
+
+    /**
+     * Read the demux packet at the timeshift read position
+     * @param allocate Packet allocator of the add-on instance
+     * @return DEMUX_PACKET or nullptr if paused, no frame arrived or a stream change is due
+     */
+    DEMUX_PACKET* ReadTimeshiftPacket(const DemuxPacketAllocator& allocate);
+
+    /**
+     * Get a frame layout of the stream
+     * @param layout Layout id, see m_frame_layouts
+     */
+    FrameGeometry GetFrameGeometry(uint32_t layout) const;
+
+    /**
+     * Layout of the given id, the newest one for unknown ids
+     * @note Caller must hold m_format_mutex
+     */
+    FrameGeometry FindFrameLayout(uint32_t layout) const;
+
+    /**
+     * Make sure the frame pool can hold frames of the given size.
+     * An existing pool is kept when it is already large enough, so
+     * restarting with an unchanged format costs no allocations. The pool
+     * is charged to the shared budget and shrinks towards MIN_POOL_FRAMES
+     * when the budget is exhausted.
+     * @param frame_size Size of a captured frame in bytes
+     * @return true if a suitable pool is available
+     */
+    bool EnsureBufferPool(size_t frame_size);
+
+    /**
+     * Drop the frame pool and its budget charge
+     */
+    void FreeBufferPool();
+
+    /**
+     * Count a frame lost to buffer pressure
+     * @param reason For the trace
+     */
+    void CountDroppedFrame(const char* reason);
+
+    /**
+     * Drop all queued ready frames
+     */
+    void ReleaseReadyBuffers();
+
+    /**
+     * Drop the oldest ready frames until at most max_frames remain
+     * @param max_frames Number of newest frames to keep
+     * @note Caller must hold m_buffer_mutex
+     */
+    void TrimReadyBuffers(size_t max_frames);
+
+    /**
+     * Prepare letterbox detection for a new stream and clear any crop
+     * left from the previous one
+     */
+    void StartLetterboxDetection();
+
+    /**
+     * Remove the crop so the device is back at its configured format
+     */
+    void StopLetterboxDetection();
+
+    /**
+     * Run letterbox analysis on a frame and apply a crop change
+     * @param frame Captured frame
+     */
+    void AnalyzeLetterbox(const Frame& frame);
 
     /**
-     * Create demux packet from stream buffer
-     * @param stream_buffer Source stream buffer
-     * @return Unique pointer to DEMUX_PACKET or nullptr on error
+     * Program a crop rectangle, restarting V4L2 streaming if the driver
+     * refuses to change it on the fly
+     * @param crop Crop in full capture coordinates
+     * @return true if the crop is active
      */
-    std::unique_ptr<DEMUX_PACKET> CreateDemuxPacket(const StreamBuffer& stream_buffer);
+    bool ApplyCrop(CropRect crop);
 
     /**
      * Update stream bitrate calculation
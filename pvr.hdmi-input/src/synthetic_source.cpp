@@ -0,0 +1,297 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Synthetic Capture Source Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "synthetic_source.h"
+#include "format_negotiator.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <linux/videodev2.h>
+
+namespace hdmi_pvr {
+
+namespace {
+
+// Luma of the eight bars, white to black
+constexpr uint8_t BAR_LEVELS[8] = {235, 210, 180, 150, 120, 90, 60, 16};
+
+uint64_t MonotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+} // namespace
+
+SyntheticSource::SyntheticSource(const SyntheticSourceConfig& config) {
+    if (!Configure(config)) {
+        Configure(SyntheticSourceConfig());
+    }
+}
+
+SyntheticSource::~SyntheticSource() {
+    StopStreaming();
+}
+
+bool SyntheticSource::Configure(const SyntheticSourceConfig& config) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_streaming) {
+        Log(LogLevel::Error, "Cannot reconfigure the synthetic source while streaming");
+        return false;
+    }
+
+    SyntheticSourceConfig applied = config;
+    if (applied.format.width == 0 || applied.format.height == 0) {
+        applied.format.width = 1920;
+        applied.format.height = 1080;
+    }
+    if (!applied.format.frame_rate.is_valid()) {
+        applied.format.frame_rate = {60, 1};
+    }
+    if (applied.format.fourcc == 0) {
+        applied.format.fourcc = V4L2_PIX_FMT_YUYV;
+    }
+
+    FormatCandidate candidate;
+    if (!FormatNegotiator::Evaluate(applied.format.fourcc, applied.format, candidate)) {
+        Log(LogLevel::Error, "Synthetic source cannot generate %s",
+            FormatNegotiator::FourCCToString(applied.format.fourcc).c_str());
+        return false;
+    }
+
+    // A frame must complete before the next one, or the order would change
+    const FrameRate& rate = applied.format.frame_rate;
+    uint64_t period_us = 1000000ULL * rate.den / rate.num;
+    applied.jitter_us = static_cast<uint32_t>(std::min<uint64_t>(applied.jitter_us, period_us > 0 ? period_us - 1 : 0));
+    applied.drop_rate = std::min(std::max(applied.drop_rate, 0.0), 1.0);
+    applied.repeat = std::max<uint32_t>(applied.repeat, 1);
+    applied.buffer_count = std::max<uint32_t>(applied.buffer_count, 1);
+
+    m_config = applied;
+    m_frame_size = static_cast<uint32_t>(candidate.bytes_per_frame);
+    m_bytes_per_line = applied.format.width * std::max<uint32_t>(candidate.bits_per_pixel / 8, 1);
+    RenderPattern();
+
+    Log(LogLevel::Debug, "Synthetic source: %s %s, jitter %u us, drop rate %.3f",
+        m_config.format.to_string().c_str(), FormatNegotiator::FourCCToString(m_config.format.fourcc).c_str(),
+        m_config.jitter_us, m_config.drop_rate);
+    return true;
+}
+
+void SyntheticSource::SetSignalPresent(bool present) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_signal_present = present;
+    m_condition.notify_all();
+}
+
+bool SyntheticSource::StartStreaming() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_streaming) {
+        return true;
+    }
+
+    m_random.seed(m_config.seed);
+    m_start_us = MonotonicMicros();
+    m_next_index = 0;
+    m_filled.clear();
+    m_last_sequence = 0;
+    m_delivered = 0;
+    m_dropped = 0;
+    m_overrun = 0;
+    ScheduleNext();
+
+    m_streaming = true;
+    return true;
+}
+
+bool SyntheticSource::StopStreaming() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_streaming = false;
+    m_filled.clear();
+    m_condition.notify_all();
+    return true;
+}
+
+bool SyntheticSource::CaptureFrame(VideoBuffer& buffer, uint32_t timeout_ms) {
+    PendingFrame frame;
+    if (!NextFrame(timeout_ms, frame)) {
+        return false;
+    }
+
+    if (buffer.size < m_frame_size) {
+        free(buffer.data);
+        buffer.data = aligned_alloc(4096, m_frame_size);
+        buffer.size = buffer.data ? m_frame_size : 0;
+    }
+    if (!buffer.data) {
+        return false;
+    }
+
+    memcpy(buffer.data, m_pattern.data(), m_frame_size);
+    Stamp(static_cast<uint8_t*>(buffer.data), m_frame_size, frame.index);
+    buffer.timestamp = frame.timestamp;
+    buffer.in_use = true;
+    return true;
+}
+
+bool SyntheticSource::CaptureFrameInto(uint8_t* dest, size_t capacity, size_t& frame_size,
+                                       uint64_t& timestamp, uint32_t timeout_ms) {
+    if (!dest) {
+        return false;
+    }
+
+    PendingFrame frame;
+    if (!NextFrame(timeout_ms, frame) || capacity < m_frame_size) {
+        return false;
+    }
+
+    // The pattern does not change while streaming, no lock needed
+    memcpy(dest, m_pattern.data(), m_frame_size);
+    Stamp(dest, m_frame_size, frame.index);
+    frame_size = m_frame_size;
+    timestamp = frame.timestamp;
+    return true;
+}
+
+bool SyntheticSource::CheckSignalPresent() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_signal_present;
+}
+
+SignalStatus SyntheticSource::GetSignalStatus() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SignalStatus status;
+    status.connected = m_signal_present;
+    status.signal_locked = m_signal_present;
+    status.signal_strength = m_signal_present ? 100 : 0;
+    status.signal_quality = m_signal_present ? 100 : 0;
+    if (m_signal_present) {
+        status.video_format = m_config.format;
+    }
+    status.device_name = "Synthetic";
+    status.last_update = std::chrono::steady_clock::now();
+    return status;
+}
+
+bool SyntheticSource::NextFrame(uint32_t timeout_ms, PendingFrame& frame) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (!m_config.paced) {
+        // Virtual clock - the next frame completes as soon as it is asked for
+        while (m_streaming && m_signal_present && m_config.drop_rate < 1.0 && m_filled.empty()) {
+            CollectDueFrames(m_next_time);
+        }
+        if (m_filled.empty()) {
+            if (m_streaming) {
+                m_condition.wait_for(lock, std::chrono::milliseconds(timeout_ms));
+            }
+            return false;
+        }
+    } else {
+        uint64_t deadline = MonotonicMicros() + static_cast<uint64_t>(timeout_ms) * 1000;
+        while (true) {
+            uint64_t now = MonotonicMicros();
+            CollectDueFrames(now);
+            if (!m_filled.empty()) {
+                break;
+            }
+            if (!m_streaming || now >= deadline) {
+                return false;
+            }
+            uint64_t wake = std::min(deadline, m_next_time);
+            m_condition.wait_for(lock, std::chrono::microseconds(wake > now ? wake - now : 1));
+        }
+    }
+
+    frame = m_filled.front();
+    m_filled.pop_front();
+    m_last_sequence = frame.index;
+    m_delivered.fetch_add(1);
+    return true;
+}
+
+void SyntheticSource::CollectDueFrames(uint64_t now) {
+    if (!m_streaming) {
+        return;
+    }
+
+    // Like a driver: completed frames wait in the buffers until dequeued,
+    // with every buffer full the newest frames are lost
+    while (m_next_time <= now) {
+        if (m_next_dropped) {
+            m_dropped.fetch_add(1);
+        } else if (!m_signal_present) {
+            // Nothing to capture
+        } else if (m_filled.size() >= m_config.buffer_count) {
+            m_overrun.fetch_add(1);
+        } else {
+            m_filled.push_back({m_next_index, m_next_time});
+        }
+        ++m_next_index;
+        ScheduleNext();
+    }
+}
+
+void SyntheticSource::ScheduleNext() {
+    // Raw generator output, distributions differ between standard libraries
+    uint64_t jitter = m_config.jitter_us > 0 ? m_random() % (m_config.jitter_us + 1ULL) : 0;
+    m_next_dropped = m_config.drop_rate > 0.0 && m_random() / 4294967296.0 < m_config.drop_rate;
+    m_next_time = SlotTime(m_next_index) + jitter;
+}
+
+uint64_t SyntheticSource::SlotTime(uint64_t index) const {
+    // From the start every time, so rounding does not accumulate
+    const FrameRate& rate = m_config.format.frame_rate;
+    return m_start_us + index * 1000000ULL * rate.den / rate.num;
+}
+
+void SyntheticSource::RenderPattern() {
+    // Eight vertical grey bars; colour does not matter to the pipeline,
+    // only the layout and that the picture is not flat
+    const VideoFormat& format = m_config.format;
+    m_pattern.assign(m_frame_size, 128);
+
+    auto level = [&format](uint32_t x) { return BAR_LEVELS[x * 8 / format.width]; };
+
+    uint32_t fourcc = format.fourcc;
+    if (fourcc == V4L2_PIX_FMT_YUYV || fourcc == V4L2_PIX_FMT_UYVY) {
+        size_t luma = fourcc == V4L2_PIX_FMT_YUYV ? 0 : 1;
+        for (uint32_t y = 0; y < format.height; ++y) {
+            uint8_t* line = m_pattern.data() + static_cast<size_t>(y) * m_bytes_per_line;
+            for (uint32_t x = 0; x < format.width; ++x) {
+                line[x * 2 + luma] = level(x);
+            }
+        }
+    } else if (fourcc == V4L2_PIX_FMT_RGB24 || fourcc == V4L2_PIX_FMT_BGR24) {
+        for (uint32_t y = 0; y < format.height; ++y) {
+            uint8_t* line = m_pattern.data() + static_cast<size_t>(y) * m_bytes_per_line;
+            for (uint32_t x = 0; x < format.width; ++x) {
+                memset(line + x * 3, level(x), 3);
+            }
+        }
+    } else {
+        // Planar 4:2:0 - the luma plane comes first, chroma stays neutral
+        for (uint32_t y = 0; y < format.height; ++y) {
+            uint8_t* line = m_pattern.data() + static_cast<size_t>(y) * m_bytes_per_line;
+            for (uint32_t x = 0; x < format.width; ++x) {
+                line[x] = level(x);
+            }
+        }
+    }
+}
+
+void SyntheticSource::Stamp(uint8_t* data, size_t size, uint64_t index) const {
+    // Frames of one repeat group are identical
+    uint64_t stamp = index / m_config.repeat;
+    memcpy(data, &stamp, std::min(size, sizeof(stamp)));
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,121 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "capture_source.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace hdmi_pvr {
+
+/**
+ * Unset format fields default to 1920x1080p60 YUYV
+ */
+struct SyntheticSourceConfig {
+    VideoFormat format;             ///< Resolution, frame rate and V4L2 pixel format
+    uint32_t jitter_us = 0;         ///< Frames complete up to this much after their slot (< one period)
+    double drop_rate = 0.0;         ///< Share of frames the "driver" loses, 0..1
+    uint32_t repeat = 1;            ///< Identical frames in a row (static picture, pulldown)
+    uint32_t buffer_count = 4;      ///< Driver buffers - more frames waiting than this overrun
+    uint32_t seed = 1;              ///< Jitter and drops repeat for the same seed
+    bool paced = true;              ///< false: no waiting, frames follow a virtual clock
+};
+
+/**
+ * SyntheticSource generates a test pattern in place of HDMI capture.
+ *
+ * Frames become due on the configured frame rate like a driver completing
+ * buffers: each one late by a random jitter, some lost, and the ones the
+ * consumer does not collect in time are lost once all buffers are full.
+ * The random parts come from a seeded generator, so a run is repeatable.
+ * Unpaced, frames are handed out as fast as they are pulled, with
+ * timestamps on the nominal timeline - for throughput tests that must not
+ * depend on the machine's clock.
+ *
+ * Each frame is the pre-rendered pattern with a stamp in its first bytes,
+ * so consecutive frames differ unless a repeat is configured.
+ */
+class SyntheticSource : public CaptureSource {
+public:
+    explicit SyntheticSource(const SyntheticSourceConfig& config = SyntheticSourceConfig());
+    ~SyntheticSource() override;
+
+    /**
+     * Change the configuration, only while not streaming
+     * @return false if streaming or the pixel format is unknown
+     */
+    bool Configure(const SyntheticSourceConfig& config);
+    const SyntheticSourceConfig& GetConfig() const { return m_config; }
+
+    /**
+     * Simulate a signal loss: while absent no frames are produced
+     */
+    void SetSignalPresent(bool present);
+
+    // CaptureSource
+    bool StartStreaming() override;
+    bool StopStreaming() override;
+    VideoFormat GetConfiguredFormat() const override { return m_config.format; }
+    uint32_t GetFrameSize() const override { return m_frame_size; }
+    uint32_t GetBytesPerLine() const override { return m_bytes_per_line; }
+    uint32_t GetBufferCount() const override { return m_config.buffer_count; }
+    bool CaptureFrame(VideoBuffer& buffer, uint32_t timeout_ms = 1000) override;
+    bool CaptureFrameInto(uint8_t* dest, size_t capacity, size_t& frame_size,
+                          uint64_t& timestamp, uint32_t timeout_ms = 1000) override;
+    uint64_t GetLastSequence() const override { return m_last_sequence; }
+    bool CheckSignalPresent() override;
+    SignalStatus GetSignalStatus() override;
+
+    // Counters of the current stream
+    uint64_t GetFramesDelivered() const { return m_delivered.load(); }
+    uint64_t GetFramesDropped() const { return m_dropped.load(); }    ///< Injected drops
+    uint64_t GetFramesOverrun() const { return m_overrun.load(); }    ///< Lost to full buffers
+
+private:
+    struct PendingFrame {
+        uint64_t index = 0;
+        uint64_t timestamp = 0;
+    };
+
+    bool NextFrame(uint32_t timeout_ms, PendingFrame& frame);
+    void CollectDueFrames(uint64_t now);
+    void ScheduleNext();
+    void RenderPattern();
+    void Stamp(uint8_t* data, size_t size, uint64_t index) const;
+    uint64_t SlotTime(uint64_t index) const;
+
+    SyntheticSourceConfig m_config;
+    uint32_t m_frame_size = 0;
+    uint32_t m_bytes_per_line = 0;
+    std::vector<uint8_t> m_pattern;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_streaming = false;
+    bool m_signal_present = true;
+    std::mt19937 m_random;
+
+    // Timeline of the current stream
+    uint64_t m_start_us = 0;
+    uint64_t m_next_index = 0;      ///< Next frame to complete
+    uint64_t m_next_time = 0;       ///< When it completes, jitter included
+    bool m_next_dropped = false;
+    std::deque<PendingFrame> m_filled;  ///< Completed, not yet collected
+    uint64_t m_last_sequence = 0;       ///< Index of the frame collected last
+
+    std::atomic<uint64_t> m_delivered{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_overrun{0};
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,322 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Timeshift Ring Buffer Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "timeshift_buffer.h"
+#include "log.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace hdmi_pvr {
+
+TimeshiftBuffer::~TimeshiftBuffer() {
+    Close();
+}
+
+bool TimeshiftBuffer::Open(const std::string& path, size_t capacity) {
+    Close();
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0) {
+        page_size = 4096;
+    }
+    capacity = (capacity + page_size - 1) / page_size * page_size;
+    if (capacity == 0) {
+        Log(LogLevel::Error, "Invalid timeshift buffer size");
+        return false;
+    }
+
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (m_fd < 0) {
+        Log(LogLevel::Error, "Failed to create timeshift file %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    // Reserve the blocks up front so a full disk fails here, not mid-stream
+    if (posix_fallocate(m_fd, 0, static_cast<off_t>(capacity)) != 0 &&
+        ftruncate(m_fd, static_cast<off_t>(capacity)) != 0) {
+        Log(LogLevel::Error, "Failed to size timeshift file to %zu bytes", capacity);
+        close(m_fd);
+        m_fd = -1;
+        unlink(path.c_str());
+        return false;
+    }
+
+    // Map the file twice back to back, so frames wrapping around the end of
+    // the ring read and write as one block
+    void* data = mmap(nullptr, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uint8_t* base = static_cast<uint8_t*>(data);
+    if (data == MAP_FAILED ||
+        mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, m_fd, 0) == MAP_FAILED ||
+        mmap(base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, m_fd, 0) == MAP_FAILED) {
+        Log(LogLevel::Error, "Failed to map timeshift file: %s", strerror(errno));
+        if (data != MAP_FAILED) {
+            munmap(data, capacity * 2);
+        }
+        close(m_fd);
+        m_fd = -1;
+        unlink(path.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_path = path;
+    m_data = base;
+    m_capacity = capacity;
+    m_index.clear();
+    m_write_pos = 0;
+    m_read_pos = 0;
+    m_first_timestamp = 0;
+    m_start_time = 0;
+    m_abort = false;
+
+    Log(LogLevel::Info, "Timeshift buffer opened: %s (%zu MB)", path.c_str(), capacity / (1024 * 1024));
+    return true;
+}
+
+void TimeshiftBuffer::Close() {
+    Abort();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_data) {
+        munmap(m_data, m_capacity * 2);
+        m_data = nullptr;
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+        unlink(m_path.c_str());
+    }
+    m_capacity = 0;
+    m_index.clear();
+    m_write_pos = 0;
+    m_read_pos = 0;
+}
+
+bool TimeshiftBuffer::WriteFrame(const void* data, size_t size, uint64_t timestamp, uint32_t format) {
+    if (!data || size == 0) {
+        return false;
+    }
+
+    uint64_t position;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_data || size > m_capacity) {
+            return false;
+        }
+        // Evict first so no reader touches the region while it is rewritten
+        EvictFor(size);
+        position = m_write_pos;
+    }
+
+    std::memcpy(At(position), data, size);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_index.empty() && m_write_pos == 0) {
+            m_first_timestamp = timestamp;
+            m_start_time = time(nullptr);
+        }
+        m_index.push_back({position, static_cast<uint32_t>(size), timestamp, format});
+        m_write_pos = position + size;
+    }
+    m_data_condition.notify_all();
+
+    return true;
+}
+
+int TimeshiftBuffer::Read(uint8_t* buffer, size_t size, uint32_t timeout_ms) {
+    if (!buffer || size == 0) {
+        return -1;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_data) {
+        return -1;
+    }
+
+    if (m_read_pos >= m_write_pos) {
+        m_data_condition.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+            return m_abort || !m_data || m_read_pos < m_write_pos;
+        });
+    }
+
+    if (m_abort || !m_data) {
+        return -1;
+    }
+
+    if (m_read_pos >= m_write_pos) {
+        return 0;
+    }
+
+    // The writer overran a paused reader - continue from the oldest frame
+    if (!m_index.empty() && m_read_pos < m_index.front().offset) {
+        m_read_pos = m_index.front().offset;
+    }
+
+    size_t to_copy = static_cast<size_t>(std::min<uint64_t>(size, m_write_pos - m_read_pos));
+    std::memcpy(buffer, At(m_read_pos), to_copy);
+    m_read_pos += to_copy;
+
+    return static_cast<int>(to_copy);
+}
+
+int TimeshiftBuffer::ReadFrame(const FrameSink& sink, uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_data) {
+        return -1;
+    }
+
+    auto frame = FindReadFrame();
+    if (frame == m_index.end()) {
+        m_data_condition.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, &frame]() {
+            if (m_abort || !m_data) {
+                return true;
+            }
+            frame = FindReadFrame();
+            return frame != m_index.end();
+        });
+    }
+
+    if (m_abort || !m_data) {
+        return -1;
+    }
+
+    if (frame == m_index.end()) {
+        return 0;
+    }
+
+    // Eviction needs the lock, so the frame stays intact while the sink runs
+    if (!sink(At(frame->offset), frame->size, frame->timestamp, frame->format)) {
+        return 0;
+    }
+    m_read_pos = frame->offset + frame->size;
+    return 1;
+}
+
+int64_t TimeshiftBuffer::Seek(int64_t position, int whence) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_data) {
+        return -1;
+    }
+
+    int64_t target;
+    switch (whence) {
+        case SEEK_SET:
+            target = position;
+            break;
+        case SEEK_CUR:
+            target = static_cast<int64_t>(m_read_pos) + position;
+            break;
+        case SEEK_END:
+            target = static_cast<int64_t>(m_write_pos) + position;
+            break;
+        default:
+            return -1;
+    }
+
+    if (m_index.empty()) {
+        return static_cast<int64_t>(m_read_pos);
+    }
+
+    uint64_t oldest = m_index.front().offset;
+    uint64_t clamped = static_cast<uint64_t>(std::max<int64_t>(target, static_cast<int64_t>(oldest)));
+    clamped = std::min(clamped, m_write_pos);
+
+    m_read_pos = SnapToFrame(clamped);
+    return static_cast<int64_t>(m_read_pos);
+}
+
+bool TimeshiftBuffer::SeekTime(uint64_t timestamp, bool backwards, uint64_t& frame_timestamp) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_data || m_index.empty()) {
+        return false;
+    }
+
+    // Index is ordered by time as well as by offset
+    auto it = std::lower_bound(m_index.begin(), m_index.end(), timestamp,
+        [](const IndexEntry& entry, uint64_t time) { return entry.timestamp < time; });
+    if (it == m_index.end()) {
+        it = std::prev(it);
+    } else if (backwards && it->timestamp > timestamp && it != m_index.begin()) {
+        it = std::prev(it);
+    }
+
+    m_read_pos = it->offset;
+    frame_timestamp = it->timestamp;
+    return true;
+}
+
+void TimeshiftBuffer::Abort() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_abort = true;
+    }
+    m_data_condition.notify_all();
+}
+
+int64_t TimeshiftBuffer::GetLength() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int64_t>(m_write_pos);
+}
+
+bool TimeshiftBuffer::IsAtLiveEdge() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.empty() || m_read_pos >= m_index.back().offset;
+}
+
+bool TimeshiftBuffer::GetTimes(time_t& start_time, uint64_t& start_us, uint64_t& begin_us,
+                               uint64_t& end_us) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_index.empty()) {
+        return false;
+    }
+
+    start_time = m_start_time;
+    start_us = m_first_timestamp;
+    begin_us = m_index.front().timestamp;
+    end_us = m_index.back().timestamp;
+    return true;
+}
+
+//
+// Private methods
+//
+
+void TimeshiftBuffer::EvictFor(size_t size) {
+    uint64_t new_end = m_write_pos + size;
+    uint64_t lowest_valid = new_end > m_capacity ? new_end - m_capacity : 0;
+
+    while (!m_index.empty() && m_index.front().offset < lowest_valid) {
+        m_index.pop_front();
+    }
+
+    if (m_read_pos < lowest_valid) {
+        m_read_pos = m_index.empty() ? m_write_pos : m_index.front().offset;
+    }
+}
+
+uint64_t TimeshiftBuffer::SnapToFrame(uint64_t position) const {
+    if (position >= m_write_pos) {
+        return m_index.empty() ? m_write_pos : m_index.back().offset;
+    }
+
+    auto it = std::upper_bound(m_index.begin(), m_index.end(), position,
+        [](uint64_t pos, const IndexEntry& entry) { return pos < entry.offset; });
+    return (it == m_index.begin()) ? m_index.front().offset : std::prev(it)->offset;
+}
+
+std::deque<TimeshiftBuffer::IndexEntry>::const_iterator TimeshiftBuffer::FindReadFrame() const {
+    return std::lower_bound(m_index.begin(), m_index.end(), m_read_pos,
+        [](const IndexEntry& entry, uint64_t pos) { return entry.offset < pos; });
+}
+
+} // namespace hdmi_pvr
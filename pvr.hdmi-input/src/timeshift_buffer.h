@@ -0,0 +1,189 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+
+namespace hdmi_pvr {
+
+/**
+ * TimeshiftBuffer keeps the most recent part of the live stream in a
+ * fixed-size memory-mapped ring file so playback can be paused and moved
+ * back in time.
+ *
+ * The ring is addressed with logical byte positions that grow for the
+ * lifetime of the stream; the oldest frames are evicted as the writer wraps
+ * around. A small index of frame offsets and timestamps lets seeks land on
+ * frame boundaries and provides the time range reported to Kodi.
+ *
+ * The file is mapped twice back to back, so a frame wrapping around the end
+ * of the ring is still contiguous in memory and can be handed out in place.
+ *
+ * Placing the file on tmpfs (/dev/shm) keeps it in RAM, placing it on eMMC
+ * trades write bandwidth for a longer window.
+ */
+class TimeshiftBuffer {
+public:
+    TimeshiftBuffer() = default;
+    ~TimeshiftBuffer();
+
+    TimeshiftBuffer(const TimeshiftBuffer&) = delete;
+    TimeshiftBuffer& operator=(const TimeshiftBuffer&) = delete;
+
+    /**
+     * Create and map the ring file
+     * @param path Location of the ring file (created or truncated)
+     * @param capacity Ring size in bytes, rounded up to the page size
+     * @return true if the ring is ready for writing
+     */
+    bool Open(const std::string& path, size_t capacity);
+
+    /**
+     * Unmap and remove the ring file
+     */
+    void Close();
+
+    /**
+     * Check if the ring is mapped
+     * @return true if open
+     */
+    bool IsOpen() const { return m_data != nullptr; }
+
+    /**
+     * Append a frame to the ring, evicting the oldest frames as needed
+     * @param data Frame data
+     * @param size Frame size in bytes (must not exceed the ring capacity)
+     * @param timestamp Frame timestamp in microseconds
+     * @param format Caller's id of the frame layout, handed back by ReadFrame
+     * @return true if the frame was written
+     */
+    bool WriteFrame(const void* data, size_t size, uint64_t timestamp, uint32_t format = 0);
+
+    /**
+     * Receives a buffered frame in place
+     * @return true to move the read position past the frame
+     */
+    using FrameSink = std::function<bool(const uint8_t* data, size_t size, uint64_t timestamp, uint32_t format)>;
+
+    /**
+     * Hand the frame at the read position to a sink. The sink runs under
+     * the ring lock, which keeps the writer from evicting the frame, so it
+     * should do no more than copy it out.
+     * @param sink Receiver of the frame
+     * @param timeout_ms Time to wait for a new frame at the live edge
+     * @return 1 if the sink took the frame, 0 on timeout or when it did not, -1 on error
+     */
+    int ReadFrame(const FrameSink& sink, uint32_t timeout_ms);
+
+    /**
+     * Read stream data from the current read position
+     * @param buffer Destination buffer
+     * @param size Maximum number of bytes to read
+     * @param timeout_ms Time to wait for new data at the live edge
+     * @return Number of bytes read, 0 on timeout, -1 on error
+     */
+    int Read(uint8_t* buffer, size_t size, uint32_t timeout_ms);
+
+    /**
+     * Move the read position, snapping to the start of a buffered frame
+     * @param position Byte offset
+     * @param whence SEEK_SET, SEEK_CUR or SEEK_END
+     * @return New read position, -1 on error
+     */
+    int64_t Seek(int64_t position, int whence);
+
+    /**
+     * Move the read position to the frame shown at a given time
+     * @param timestamp Target time in microseconds, clamped to the buffered range
+     * @param backwards true for the last frame at or before the target, false for the first at or after it
+     * @param frame_timestamp Timestamp of the frame the read position is now at
+     * @return true if a frame is buffered
+     */
+    bool SeekTime(uint64_t timestamp, bool backwards, uint64_t& frame_timestamp);
+
+    /**
+     * Abort any blocked Read() call
+     */
+    void Abort();
+
+    /**
+     * Get the logical stream length (total bytes written)
+     * @return Write position in bytes
+     */
+    int64_t GetLength() const;
+
+    /**
+     * Check if the reader is at the newest frame
+     * @return true if reading at the live edge
+     */
+    bool IsAtLiveEdge() const;
+
+    /**
+     * Get the buffered time range, in frame timestamps
+     * @param start_time Wall clock time of the first written frame
+     * @param start_us Timestamp of the first written frame
+     * @param begin_us Timestamp of the oldest buffered frame
+     * @param end_us Timestamp of the newest buffered frame
+     * @return true if at least one frame is buffered
+     */
+    bool GetTimes(time_t& start_time, uint64_t& start_us, uint64_t& begin_us, uint64_t& end_us) const;
+
+private:
+    struct IndexEntry {
+        uint64_t offset = 0;     ///< Logical byte position of the frame
+        uint32_t size = 0;       ///< Frame size in bytes
+        uint64_t timestamp = 0;  ///< Capture timestamp in microseconds
+        uint32_t format = 0;     ///< Layout id given to WriteFrame
+    };
+
+    std::string m_path;
+    int m_fd = -1;
+    uint8_t* m_data = nullptr;  ///< Two mappings of the file, 2 * m_capacity bytes
+    size_t m_capacity = 0;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_data_condition;
+    std::deque<IndexEntry> m_index;
+    uint64_t m_write_pos = 0;
+    uint64_t m_read_pos = 0;
+    uint64_t m_first_timestamp = 0;
+    time_t m_start_time = 0;
+    bool m_abort = false;
+
+    /**
+     * Drop index entries whose data is overwritten by a write of size bytes
+     * @note Caller must hold m_mutex
+     */
+    void EvictFor(size_t size);
+
+    /**
+     * Start offset of the buffered frame containing position
+     * @note Caller must hold m_mutex
+     */
+    uint64_t SnapToFrame(uint64_t position) const;
+
+    /**
+     * Frame at or after the read position
+     * @note Caller must hold m_mutex
+     */
+    std::deque<IndexEntry>::const_iterator FindReadFrame() const;
+
+    /**
+     * Address of a logical position; up to m_capacity bytes from there are contiguous
+     */
+    uint8_t* At(uint64_t position) const { return m_data + position % m_capacity; }
+};
+
+} // namespace hdmi_pvr
@@ -0,0 +1,116 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Trace Point Implementation
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "trace.h"
+#include "log.h"
+#include <cstdarg>
+#include <cstdio>
+#include <fcntl.h>
+#include <mutex>
+#include <unistd.h>
+
+namespace hdmi_pvr {
+
+namespace trace_detail {
+std::atomic<bool> g_enabled{false};
+} // namespace trace_detail
+
+namespace {
+
+const char* const MARKER_PATHS[] = {
+    "/sys/kernel/tracing/trace_marker",
+    "/sys/kernel/debug/tracing/trace_marker",
+};
+
+// The marker stays open once opened: a trace point racing DisableTracing()
+// must never write to a descriptor that was closed and reused
+std::atomic<int> g_marker_fd{-1};
+std::mutex g_enable_mutex;
+std::atomic<int> g_pid{0};
+
+void WriteMarker(const char* event, int length) {
+    int fd = g_marker_fd.load(std::memory_order_relaxed);
+    if (fd < 0 || length <= 0) {
+        return;
+    }
+    // One write is one event; a full trace buffer loses it, nothing to do about that
+    ssize_t written = write(fd, event, static_cast<size_t>(length));
+    (void)written;
+}
+
+// Longer events are truncated, like the kernel does past its marker limit
+constexpr int MAX_EVENT = 256;
+
+int Clamp(int length) {
+    return length < MAX_EVENT ? length : MAX_EVENT - 1;
+}
+
+} // namespace
+
+bool EnableTracing(const std::string& marker_path) {
+    std::lock_guard<std::mutex> lock(g_enable_mutex);
+    if (g_marker_fd.load() < 0) {
+        int fd = -1;
+        if (!marker_path.empty()) {
+            fd = open(marker_path.c_str(), O_WRONLY | O_CLOEXEC);
+        } else {
+            for (const char* path : MARKER_PATHS) {
+                fd = open(path, O_WRONLY | O_CLOEXEC);
+                if (fd >= 0) {
+                    break;
+                }
+            }
+        }
+        if (fd < 0) {
+            Log(LogLevel::Warning, "Cannot open the ftrace trace_marker %s - tracing stays off",
+                marker_path.empty() ? "(is tracefs mounted?)" : marker_path.c_str());
+            return false;
+        }
+        g_pid.store(getpid());
+        g_marker_fd.store(fd);
+    }
+
+    if (!trace_detail::g_enabled.exchange(true)) {
+        Log(LogLevel::Info, "Pipeline tracing enabled");
+    }
+    return true;
+}
+
+void DisableTracing() {
+    if (trace_detail::g_enabled.exchange(false)) {
+        Log(LogLevel::Info, "Pipeline tracing disabled");
+    }
+}
+
+void TraceBegin(const char* name) {
+    char event[MAX_EVENT];
+    WriteMarker(event, Clamp(snprintf(event, sizeof(event), "B|%d|%s", g_pid.load(), name)));
+}
+
+void TraceEnd() {
+    char event[32];
+    WriteMarker(event, snprintf(event, sizeof(event), "E|%d", g_pid.load()));
+}
+
+void TraceInstant(const char* format, ...) {
+    char event[MAX_EVENT];
+    int prefix = snprintf(event, sizeof(event), "I|%d|", g_pid.load());
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(event + prefix, sizeof(event) - static_cast<size_t>(prefix), format, args);
+    va_end(args);
+    WriteMarker(event, Clamp(prefix + length));
+}
+
+void TraceCounter(const char* name, int64_t value) {
+    char event[MAX_EVENT];
+    WriteMarker(event, Clamp(snprintf(event, sizeof(event), "C|%d|%s|%lld", g_pid.load(), name,
+                                      static_cast<long long>(value))));
+}
+
+} // namespace hdmi_pvr
@@ -0,0 +1,82 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace hdmi_pvr {
+
+/**
+ * Trace points of the capture pipeline.
+ *
+ * Events go to the ftrace trace_marker in the atrace text format
+ * ("B|pid|name", "E|pid", "I|pid|name", "C|pid|name|value"), so Perfetto
+ * and trace-cmd show them on one timeline with the tvcap interrupts and
+ * vb2 buffer events recorded in the same session. Slices belong to the
+ * thread that wrote them.
+ *
+ * Tracing is off by default and can be switched at any time; while off a
+ * trace point costs one relaxed atomic load.
+ */
+
+/**
+ * Start writing events
+ * @param marker_path trace_marker to write to, empty to look in the usual
+ *                    tracefs mount points
+ * @return false if no marker could be opened (no tracefs, no permission)
+ */
+bool EnableTracing(const std::string& marker_path = "");
+
+/**
+ * Stop writing events - trace points already running finish their write
+ */
+void DisableTracing();
+
+namespace trace_detail {
+extern std::atomic<bool> g_enabled;
+} // namespace trace_detail
+
+inline bool IsTracing() {
+    return trace_detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+// Events; call sites check IsTracing() first so arguments are only
+// gathered while tracing
+void TraceBegin(const char* name);
+void TraceEnd();
+void TraceInstant(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void TraceCounter(const char* name, int64_t value);
+
+/**
+ * Slice from construction to destruction, on the current thread
+ */
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : m_active(IsTracing()) {
+        if (m_active) {
+            TraceBegin(name);
+        }
+    }
+
+    ~TraceScope() {
+        if (m_active) {
+            TraceEnd();
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    bool m_active;  ///< Ends what it began, even if tracing was switched meanwhile
+};
+
+} // namespace hdmi_pvr
+
@@ -1,27 +1,118 @@
 #pragma once
 
 #include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <numeric>
 #include <string>
 #include <vector>
 #include <chrono>
 
 namespace hdmi_pvr {
 
+// Rational frame rate, e.g. 60000/1001 for 59.94 Hz
+struct FrameRate {
+    uint32_t num = 0;
+    uint32_t den = 1;
+    
+    FrameRate() = default;
+    constexpr FrameRate(uint32_t numerator, uint32_t denominator = 1)
+        : num(numerator), den(denominator) {}
+    
+    /**
+     * Build a reduced frame rate from an arbitrary fraction
+     */
+    static FrameRate from_ratio(uint64_t numerator, uint64_t denominator) {
+        if (numerator == 0 || denominator == 0) {
+            return {};
+        }
+        uint64_t divisor = std::gcd(numerator, denominator);
+        numerator /= divisor;
+        denominator /= divisor;
+        // Keep within 32 bits, precision beyond that is meaningless
+        while (numerator > UINT32_MAX || denominator > UINT32_MAX) {
+            numerator >>= 1;
+            denominator >>= 1;
+        }
+        return {static_cast<uint32_t>(numerator), static_cast<uint32_t>(std::max<uint64_t>(denominator, 1))};
+    }
+    
+    bool is_valid() const {
+        return num > 0 && den > 0;
+    }
+    
+    double to_double() const {
+        return is_valid() ? static_cast<double>(num) / den : 0.0;
+    }
+    
+    bool operator==(const FrameRate& other) const {
+        return static_cast<uint64_t>(num) * other.den == static_cast<uint64_t>(other.num) * den;
+    }
+    
+    bool operator!=(const FrameRate& other) const {
+        return !(*this == other);
+    }
+    
+    std::string to_string() const {
+        if (!is_valid() || num % den == 0) {
+            return std::to_string(is_valid() ? num / den : 0);
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.2f", to_double());
+        return text;
+    }
+};
+
 // Video format structure
 struct VideoFormat {
     uint32_t width = 0;
     uint32_t height = 0;
-    uint32_t fps = 0;
+    FrameRate frame_rate;
     uint32_t fourcc = 0;
     bool interlaced = false;
     
     bool is_valid() const {
-        return width > 0 && height > 0 && fps > 0;
+        return width > 0 && height > 0 && frame_rate.is_valid();
+    }
+    
+    bool operator==(const VideoFormat& other) const {
+        return width == other.width && height == other.height && frame_rate == other.frame_rate &&
+               fourcc == other.fourcc && interlaced == other.interlaced;
+    }
+    
+    bool operator!=(const VideoFormat& other) const {
+        return !(*this == other);
     }
     
     std::string to_string() const {
         return std::to_string(width) + "x" + std::to_string(height) + 
-               (interlaced ? "i" : "p") + "@" + std::to_string(fps);
+               (interlaced ? "i" : "p") + "@" + frame_rate.to_string();
+    }
+};
+
+// Crop rectangle in capture pixels
+struct CropRect {
+    uint32_t left = 0;
+    uint32_t top = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    
+    bool is_valid() const {
+        return width > 0 && height > 0;
+    }
+    
+    bool operator==(const CropRect& other) const {
+        return left == other.left && top == other.top &&
+               width == other.width && height == other.height;
+    }
+    
+    bool operator!=(const CropRect& other) const {
+        return !(*this == other);
+    }
+    
+    std::string to_string() const {
+        return std::to_string(width) + "x" + std::to_string(height) + "+" +
+               std::to_string(left) + "+" + std::to_string(top);
     }
 };
 
@@ -35,6 +126,15 @@ struct AudioFormat {
     bool is_valid() const {
         return sample_rate > 0 && channels > 0 && bit_depth > 0;
     }
+    
+    bool operator==(const AudioFormat& other) const {
+        return sample_rate == other.sample_rate && channels == other.channels &&
+               bit_depth == other.bit_depth && compressed == other.compressed;
+    }
+    
+    bool operator!=(const AudioFormat& other) const {
+        return !(*this == other);
+    }
 };
 
 // HDMI signal status
@@ -178,24 +278,53 @@ struct EpgEntry {
     }
 };
 
-// Stream properties
-struct StreamProperties {
+// Memory layout of a captured frame
+struct FrameGeometry {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bytes_per_line = 0;  // Of the first plane
+    uint32_t fourcc = 0;          // V4L2 pixel format
+};
+
+// Exact description of the video stream handed to Kodi
+struct VideoStreamDescriptor {
     uint32_t stream_id = 0;
-    std::string codec_name;
-    std::string language = "und";
-    uint32_t identifier = 0;
-    uint32_t bandwidth = 0;
-    
-    // Video properties
+    std::string codec_name;       // FFmpeg codec name, e.g. "yuv4"
+    std::string pixel_format;     // FFmpeg pixel format it decodes to, e.g. "yuv420p"
+    uint32_t fourcc = 0;          // V4L2 pixel format of the capture
     uint32_t width = 0;
     uint32_t height = 0;
-    double fps = 0.0;
-    uint32_t bitrate = 0;
+    uint32_t stride = 0;          // Bytes per line of the captured frames
+    uint32_t frame_size = 0;      // Bytes per delivered packet
+    FrameRate frame_rate;
+    float aspect = 0.0f;          // Display aspect ratio
+    uint64_t bitrate = 0;         // Bits per second
     
-    // Audio properties
+    bool is_valid() const {
+        return !codec_name.empty() && width > 0 && height > 0 && frame_rate.is_valid();
+    }
+};
+
+// Exact description of the audio stream handed to Kodi
+struct AudioStreamDescriptor {
+    uint32_t stream_id = 0;
+    std::string codec_name;       // FFmpeg codec name, e.g. "pcm_s16le"
+    std::string channel_layout;   // FFmpeg layout name, e.g. "stereo"
     uint32_t channels = 0;
     uint32_t sample_rate = 0;
     uint32_t bits_per_sample = 0;
+    uint32_t block_align = 0;     // Bytes per sample frame across all channels
+    uint64_t bitrate = 0;         // Bits per second
+    
+    bool is_valid() const {
+        return !codec_name.empty() && channels > 0 && sample_rate > 0;
+    }
+};
+
+// Streams of the current live session
+struct StreamDescriptors {
+    VideoStreamDescriptor video;
+    AudioStreamDescriptor audio;
 };
 
 } // namespace hdmi_pvr
\ No newline at end of file
@@ -13,12 +13,35 @@
 #include <errno.h>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
 #include <chrono>
 #include <thread>
 #include <sys/select.h>
+#include <poll.h>
 
 namespace hdmi_pvr {
 
+namespace {
+
+// Pixel clocks are reported in whole Hz, so rates measured from DV timings
+// land next to, not on, the broadcast rates
+FrameRate SnapFrameRate(const FrameRate& measured) {
+    static constexpr FrameRate STANDARD_RATES[] = {
+        {24000, 1001}, {24, 1}, {25, 1}, {30000, 1001}, {30, 1}, {48, 1},
+        {50, 1}, {60000, 1001}, {60, 1}, {100, 1}, {120000, 1001}, {120, 1}
+    };
+
+    double value = measured.to_double();
+    for (const auto& rate : STANDARD_RATES) {
+        if (std::abs(value - rate.to_double()) < rate.to_double() * 0.0002) {
+            return rate;
+        }
+    }
+    return measured;
+}
+
+} // namespace
+
 V4L2Device::V4L2Device(const std::string& device_path)
     : m_device_path(device_path)
     , m_signal_status{}
@@ -55,6 +78,17 @@ bool V4L2Device::Open() {
         return false;
     }
 
+    // Source change events are optional - fall back to polling without them
+    m_events_subscribed = SubscribeSourceChangeEvents();
+
+    return true;
+}
+
+bool V4L2Device::SetDevicePath(const std::string& device_path) {
+    if (IsOpen()) {
+        return false;
+    }
+    m_device_path = device_path;
     return true;
 }
 
@@ -82,7 +116,10 @@ void V4L2Device::Close() {
     m_card_name.clear();
     m_driver_version = 0;
     m_current_format = {};
+    m_frame_size = 0;
     m_supported_formats.clear();
+    m_pixel_formats.clear();
+    m_events_subscribed = false;
 }
 
 bool V4L2Device::QueryCapabilities() {
@@ -129,17 +166,19 @@ bool V4L2Device::SetFormat(const VideoFormat& format) {
     actual_format.height = fmt.fmt.pix.height;
     actual_format.fourcc = V4L2PixelFormatToFourCC(fmt.fmt.pix.pixelformat);
     actual_format.interlaced = (fmt.fmt.pix.field == V4L2_FIELD_INTERLACED);
-    actual_format.fps = format.fps; // FPS is set separately
+    actual_format.frame_rate = format.frame_rate; // Frame rate is set separately
+    m_frame_size = fmt.fmt.pix.sizeimage;
+    m_bytes_per_line = fmt.fmt.pix.bytesperline;
 
-    // Set frame rate
+    // Set frame rate - timeperframe is the frame period, the inverse of the rate
     struct v4l2_streamparm param = {};
     param.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    param.parm.capture.timeperframe.numerator = 1;
-    param.parm.capture.timeperframe.denominator = format.fps;
+    param.parm.capture.timeperframe.numerator = format.frame_rate.den;
+    param.parm.capture.timeperframe.denominator = format.frame_rate.num;
 
-    if (ioctl(m_fd, VIDIOC_S_PARM, &param) == 0) {
-        actual_format.fps = param.parm.capture.timeperframe.denominator / 
-                           param.parm.capture.timeperframe.numerator;
+    if (ioctl(m_fd, VIDIOC_S_PARM, &param) == 0 && param.parm.capture.timeperframe.numerator > 0) {
+        actual_format.frame_rate = FrameRate::from_ratio(param.parm.capture.timeperframe.denominator,
+                                                         param.parm.capture.timeperframe.numerator);
     }
 
     m_current_format = actual_format;
@@ -169,8 +208,8 @@ VideoFormat V4L2Device::GetFormat() const {
     param.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     if (ioctl(m_fd, VIDIOC_G_PARM, &param) == 0) {
         if (param.parm.capture.timeperframe.numerator > 0) {
-            format.fps = param.parm.capture.timeperframe.denominator / 
-                        param.parm.capture.timeperframe.numerator;
+            format.frame_rate = FrameRate::from_ratio(param.parm.capture.timeperframe.denominator,
+                                                      param.parm.capture.timeperframe.numerator);
         }
     }
 
@@ -205,6 +244,24 @@ std::vector<VideoFormat> V4L2Device::GetSupportedFormats() {
     return m_supported_formats;
 }
 
+std::vector<uint32_t> V4L2Device::GetPixelFormats() {
+    if (!IsOpen()) {
+        return {};
+    }
+
+    if (!m_pixel_formats.empty()) {
+        return m_pixel_formats;
+    }
+
+    struct v4l2_fmtdesc desc = {};
+    desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    for (desc.index = 0; ioctl(m_fd, VIDIOC_ENUM_FMT, &desc) == 0; ++desc.index) {
+        m_pixel_formats.push_back(V4L2PixelFormatToFourCC(desc.pixelformat));
+    }
+
+    return m_pixel_formats;
+}
+
 bool V4L2Device::DetectInputFormat(VideoFormat& format) {
     if (!IsOpen()) {
         return false;
@@ -215,16 +272,16 @@ bool V4L2Device::DetectInputFormat(VideoFormat& format) {
     if (ioctl(m_fd, VIDIOC_G_STD, &std_id) == 0) {
         // Standard video format detected - use common HD standards
         if (std_id & V4L2_STD_525_60) {
-            // NTSC-style 480p60
+            // NTSC-style 480p59.94
             format.width = 720;
             format.height = 480;
-            format.fps = 60;
+            format.frame_rate = {60000, 1001};
             format.interlaced = false;
         } else if (std_id & V4L2_STD_625_50) {
             // PAL-style 576p50
             format.width = 720;
             format.height = 576;
-            format.fps = 50;
+            format.frame_rate = {50, 1};
             format.interlaced = false;
         }
     }
@@ -238,12 +295,18 @@ bool V4L2Device::DetectInputFormat(VideoFormat& format) {
             format.height = bt.height;
             format.interlaced = (bt.interlaced == V4L2_DV_INTERLACED);
             
-            // Calculate frame rate
-            uint64_t pixclk = bt.pixelclock;
-            uint32_t htotal = bt.width + bt.hfrontporch + bt.hsync + bt.hbackporch;
-            uint32_t vtotal = bt.height + bt.vfrontporch + bt.vsync + bt.vbackporch;
-            if (htotal > 0 && vtotal > 0) {
-                format.fps = static_cast<uint32_t>(pixclk / (htotal * vtotal));
+            // Frame rate is the pixel clock over the total frame size, kept
+            // as a fraction so 59.94 and 23.976 survive
+            uint64_t htotal = V4L2_DV_BT_FRAME_WIDTH(&bt);
+            uint64_t vtotal = V4L2_DV_BT_FRAME_HEIGHT(&bt);
+            if (bt.pixelclock > 0 && htotal > 0 && vtotal > 0) {
+                uint64_t numerator = bt.pixelclock;
+                uint64_t denominator = htotal * vtotal;
+                if ((bt.flags & V4L2_DV_FL_CAN_REDUCE_FPS) && (bt.flags & V4L2_DV_FL_REDUCED_FPS)) {
+                    numerator *= 1000;
+                    denominator *= 1001;
+                }
+                format.frame_rate = SnapFrameRate(FrameRate::from_ratio(numerator, denominator));
             }
         }
     }
@@ -254,12 +317,76 @@ bool V4L2Device::DetectInputFormat(VideoFormat& format) {
         format.fourcc = current.fourcc;
         if (format.width == 0) format.width = current.width;
         if (format.height == 0) format.height = current.height;
-        if (format.fps == 0) format.fps = current.fps;
+        if (!format.frame_rate.is_valid()) format.frame_rate = current.frame_rate;
     }
 
     return format.is_valid();
 }
 
+bool V4L2Device::GetCropBounds(CropRect& bounds) {
+    return GetSelection(V4L2_SEL_TGT_CROP_BOUNDS, bounds);
+}
+
+bool V4L2Device::GetCropRect(CropRect& rect) {
+    return GetSelection(V4L2_SEL_TGT_CROP, rect);
+}
+
+bool V4L2Device::SetCropRect(CropRect& rect) {
+    if (!IsOpen() || !rect.is_valid()) {
+        return false;
+    }
+
+    struct v4l2_selection sel = {};
+    sel.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    sel.target = V4L2_SEL_TGT_CROP;
+    sel.r.left = static_cast<int32_t>(rect.left);
+    sel.r.top = static_cast<int32_t>(rect.top);
+    sel.r.width = rect.width;
+    sel.r.height = rect.height;
+
+    if (ioctl(m_fd, VIDIOC_S_SELECTION, &sel) < 0) {
+        return false;
+    }
+
+    // The driver may adjust the rectangle and, without a scaler, the
+    // output format follows the crop
+    rect.left = static_cast<uint32_t>(sel.r.left);
+    rect.top = static_cast<uint32_t>(sel.r.top);
+    rect.width = sel.r.width;
+    rect.height = sel.r.height;
+
+    struct v4l2_format fmt = {};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(m_fd, VIDIOC_G_FMT, &fmt) == 0) {
+        m_current_format.width = fmt.fmt.pix.width;
+        m_current_format.height = fmt.fmt.pix.height;
+        m_frame_size = fmt.fmt.pix.sizeimage;
+        m_bytes_per_line = fmt.fmt.pix.bytesperline;
+    }
+
+    return true;
+}
+
+bool V4L2Device::GetSelection(uint32_t target, CropRect& rect) {
+    if (!IsOpen()) {
+        return false;
+    }
+
+    struct v4l2_selection sel = {};
+    sel.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    sel.target = target;
+
+    if (ioctl(m_fd, VIDIOC_G_SELECTION, &sel) < 0) {
+        return false;
+    }
+
+    rect.left = static_cast<uint32_t>(sel.r.left);
+    rect.top = static_cast<uint32_t>(sel.r.top);
+    rect.width = sel.r.width;
+    rect.height = sel.r.height;
+    return true;
+}
+
 bool V4L2Device::AllocateBuffers(uint32_t buffer_count) {
     if (!IsOpen() || buffer_count == 0) {
         return false;
@@ -349,20 +476,13 @@ bool V4L2Device::StopStreaming() {
     return true;
 }
 
-bool V4L2Device::CaptureFrame(VideoBuffer& buffer) {
+bool V4L2Device::CaptureFrame(VideoBuffer& buffer, uint32_t timeout_ms) {
     if (!IsOpen() || !m_streaming) {
         return false;
     }
 
     // Wait for frame with timeout
-    fd_set fds;
-    FD_ZERO(&fds);
-    FD_SET(m_fd, &fds);
-
-    struct timeval timeout = {1, 0}; // 1 second timeout
-    int ret = select(m_fd + 1, &fds, nullptr, nullptr, &timeout);
-    
-    if (ret <= 0) {
+    if (!WaitForFrame(timeout_ms)) {
         return false; // Timeout or error
     }
 
@@ -399,6 +519,39 @@ bool V4L2Device::CaptureFrame(VideoBuffer& buffer) {
     return buffer.data != nullptr;
 }
 
+bool V4L2Device::CaptureFrameInto(uint8_t* dest, size_t capacity, size_t& frame_size,
+                                  uint64_t& timestamp, uint32_t timeout_ms) {
+    if (!IsOpen() || !m_streaming || !dest) {
+        return false;
+    }
+
+    if (!WaitForFrame(timeout_ms)) {
+        return false;
+    }
+
+    uint32_t index;
+    if (!DequeueBuffer(index, timestamp)) {
+        return false;
+    }
+
+    // Copy straight from the mapped buffer into the caller's frame. A crop
+    // smaller than the allocation only fills the start of each buffer.
+    bool copied = false;
+    size_t payload = index < m_buffers.size() ? m_buffers[index].length : 0;
+    if (m_frame_size > 0 && m_frame_size < payload) {
+        payload = m_frame_size;
+    }
+    if (index < m_buffers.size() && m_buffers[index].mapped && payload <= capacity) {
+        frame_size = payload;
+        memcpy(dest, m_buffers[index].start, frame_size);
+        copied = true;
+    }
+
+    QueueBuffer(index);
+
+    return copied;
+}
+
 bool V4L2Device::QueueBuffer(uint32_t index) {
     if (!IsOpen() || index >= m_buffer_count) {
         return false;
@@ -427,6 +580,7 @@ bool V4L2Device::DequeueBuffer(uint32_t& index, uint64_t& timestamp) {
 
     index = buf.index;
     timestamp = buf.timestamp.tv_sec * 1000000ULL + buf.timestamp.tv_usec;
+    m_last_sequence = buf.sequence;
     
     return true;
 }
@@ -452,6 +606,49 @@ SignalStatus V4L2Device::GetSignalStatus() {
     return m_signal_status;
 }
 
+bool V4L2Device::WaitForSignalLock(uint32_t timeout_ms) {
+    if (!IsOpen()) {
+        return false;
+    }
+
+    // Re-check interval when the driver does not report source changes,
+    // and a safety net for drivers that lock without raising an event
+    constexpr int POLL_INTERVAL_MS = 20;
+    constexpr int EVENT_RECHECK_MS = 100;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (true) {
+        uint32_t status = 0;
+        if (QueryInputStatus(GetInput(), status) &&
+            (status & (V4L2_IN_ST_NO_SIGNAL | V4L2_IN_ST_NO_SYNC)) == 0) {
+            return true;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+
+        int wait_ms = std::min<int>(remaining, m_events_subscribed ? EVENT_RECHECK_MS : POLL_INTERVAL_MS);
+        struct pollfd pfd = {m_fd, POLLPRI, 0};
+        if (poll(&pfd, 1, wait_ms) > 0 && (pfd.revents & POLLPRI)) {
+            DrainEvents();
+        }
+    }
+}
+
+bool V4L2Device::QueryInputSignal(uint32_t input, bool& present) const {
+    uint32_t status = 0;
+    if (!QueryInputStatus(input, status)) {
+        return false;
+    }
+
+    present = (status & (V4L2_IN_ST_NO_SIGNAL | V4L2_IN_ST_NO_SYNC)) == 0;
+    return true;
+}
+
 bool V4L2Device::SetInput(uint32_t input) {
     if (!IsOpen()) {
         return false;
@@ -517,7 +714,7 @@ bool V4L2Device::QueryFormat(uint32_t pixel_format, std::vector<VideoFormat>& fo
             VideoFormat format;
             format.width = res.first;
             format.height = res.second;
-            format.fps = fps;
+            format.frame_rate = {fps, 1};
             format.fourcc = V4L2PixelFormatToFourCC(pixel_format);
             format.interlaced = false;
 
@@ -554,6 +751,16 @@ bool V4L2Device::TestFormat(const VideoFormat& format) {
     return ioctl(m_fd, VIDIOC_TRY_FMT, &fmt) >= 0;
 }
 
+bool V4L2Device::WaitForFrame(uint32_t timeout_ms) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(m_fd, &fds);
+
+    struct timeval timeout = {static_cast<time_t>(timeout_ms / 1000),
+                              static_cast<suseconds_t>((timeout_ms % 1000) * 1000)};
+    return select(m_fd + 1, &fds, nullptr, nullptr, &timeout) > 0;
+}
+
 bool V4L2Device::MapBuffers() {
     if (!IsOpen() || m_buffer_count == 0) {
         return false;
@@ -603,20 +810,17 @@ bool V4L2Device::UpdateSignalStatus() {
     m_signal_status.last_update = now;
 
     // Check input status
-    uint32_t current_input = GetInput();
-    struct v4l2_input input = {};
-    input.index = current_input;
-
-    if (ioctl(m_fd, VIDIOC_ENUMINPUT, &input) >= 0) {
-        m_signal_status.connected = (input.status & V4L2_IN_ST_NO_SIGNAL) == 0;
-        m_signal_status.signal_locked = (input.status & V4L2_IN_ST_NO_SYNC) == 0;
+    uint32_t input_status = 0;
+    if (QueryInputStatus(GetInput(), input_status)) {
+        m_signal_status.connected = (input_status & V4L2_IN_ST_NO_SIGNAL) == 0;
+        m_signal_status.signal_locked = (input_status & V4L2_IN_ST_NO_SYNC) == 0;
         
         // Estimate signal quality based on status flags
         uint8_t quality = 100;
-        if (input.status & V4L2_IN_ST_NO_H_LOCK) quality -= 25;
-        if (input.status & V4L2_IN_ST_NO_V_LOCK) quality -= 25;
-        if (input.status & V4L2_IN_ST_NO_STD_LOCK) quality -= 25;
-        if (input.status & V4L2_IN_ST_NO_SYNC) quality -= 25;
+        if (input_status & V4L2_IN_ST_NO_H_LOCK) quality -= 25;
+        if (input_status & V4L2_IN_ST_NO_V_LOCK) quality -= 25;
+        if (input_status & V4L2_IN_ST_NO_STD_LOCK) quality -= 25;
+        if (input_status & V4L2_IN_ST_NO_SYNC) quality -= 25;
         
         m_signal_status.signal_quality = m_signal_status.connected ? quality : 0;
         m_signal_status.signal_strength = m_signal_status.connected ? 85 : 0; // Estimate
@@ -640,6 +844,58 @@ bool V4L2Device::UpdateSignalStatus() {
     return true;
 }
 
+bool V4L2Device::QueryInputStatus(uint32_t input, uint32_t& status) const {
+    if (!IsOpen()) {
+        return false;
+    }
+
+    struct v4l2_input info = {};
+    info.index = input;
+    if (ioctl(m_fd, VIDIOC_ENUMINPUT, &info) < 0) {
+        return false;
+    }
+
+    status = info.status;
+    return true;
+}
+
+bool V4L2Device::SubscribeSourceChangeEvents() {
+    if (!IsOpen()) {
+        return false;
+    }
+
+    // Source change events are reported per input index
+    bool subscribed = false;
+    for (uint32_t i = 0; i < 16; ++i) {
+        struct v4l2_input input = {};
+        input.index = i;
+        if (ioctl(m_fd, VIDIOC_ENUMINPUT, &input) < 0) {
+            break;
+        }
+
+        struct v4l2_event_subscription sub = {};
+        sub.type = V4L2_EVENT_SOURCE_CHANGE;
+        sub.id = i;
+        if (ioctl(m_fd, VIDIOC_SUBSCRIBE_EVENT, &sub) == 0) {
+            subscribed = true;
+        }
+    }
+
+    return subscribed;
+}
+
+bool V4L2Device::DrainEvents() {
+    bool source_changed = false;
+    struct v4l2_event event = {};
+    while (IsOpen() && ioctl(m_fd, VIDIOC_DQEVENT, &event) == 0) {
+        source_changed |= event.type == V4L2_EVENT_SOURCE_CHANGE;
+        if (event.pending == 0) {
+            break;
+        }
+    }
+    return source_changed;
+}
+
 uint32_t V4L2Device::V4L2PixelFormatToFourCC(uint32_t v4l2_format) const {
     // V4L2 pixel formats are already FourCC values in most cases
     return v4l2_format;
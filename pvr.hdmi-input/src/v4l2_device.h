@@ -1,5 +1,6 @@
 #pragma once
 
+#include "capture_source.h"
 #include "types.h"
 #include <linux/videodev2.h>
 #include <string>
@@ -10,15 +11,18 @@
 
 namespace hdmi_pvr {
 
-class V4L2Device {
+class V4L2Device : public CaptureSource {
 public:
     explicit V4L2Device(const std::string& device_path = "/dev/video0");
-    ~V4L2Device();
+    ~V4L2Device() override;
 
     // Device management
     bool Open();
     void Close();
-    bool IsOpen() const { return m_fd >= 0; }
+    bool IsOpen() const override { return m_fd >= 0; }
+    int GetFd() const override { return m_fd; }  // For event loops; stays owned by the device
+    const std::string& GetDevicePath() const { return m_device_path; }
+    bool SetDevicePath(const std::string& device_path);  // Only while closed
 
     // Device capabilities
     bool QueryCapabilities();
@@ -30,27 +34,43 @@ public:
     // Format management
     bool SetFormat(const VideoFormat& format);
     VideoFormat GetFormat() const;
+    VideoFormat GetConfiguredFormat() const override { return m_current_format; }
+    uint32_t GetFrameSize() const override { return m_frame_size; }
+    uint32_t GetBytesPerLine() const override { return m_bytes_per_line; }
     std::vector<VideoFormat> GetSupportedFormats();
-    bool DetectInputFormat(VideoFormat& format);
+    std::vector<uint32_t> GetPixelFormats();
+    bool DetectInputFormat(VideoFormat& format) override;
+
+    // Cropping (VIDIOC_G/S_SELECTION)
+    bool GetCropBounds(CropRect& bounds) override;
+    bool GetCropRect(CropRect& rect) override;
+    bool SetCropRect(CropRect& rect) override;
 
     // Buffer management
     bool AllocateBuffers(uint32_t buffer_count);
     void DeallocateBuffers();
-    uint32_t GetBufferCount() const { return m_buffer_count; }
+    uint32_t GetBufferCount() const override { return m_buffer_count; }
 
     // Streaming control
-    bool StartStreaming();
-    bool StopStreaming();
+    bool StartStreaming() override;
+    bool StopStreaming() override;
     bool IsStreaming() const { return m_streaming; }
 
     // Frame capture
-    bool CaptureFrame(VideoBuffer& buffer);
+    bool CaptureFrame(VideoBuffer& buffer, uint32_t timeout_ms = 1000) override;
+    bool CaptureFrameInto(uint8_t* dest, size_t capacity, size_t& frame_size,
+                          uint64_t& timestamp, uint32_t timeout_ms = 1000) override;
     bool QueueBuffer(uint32_t index);
     bool DequeueBuffer(uint32_t& index, uint64_t& timestamp);
+    uint64_t GetLastSequence() const override { return m_last_sequence; }
 
     // Signal detection
-    bool CheckSignalPresent();
-    SignalStatus GetSignalStatus();
+    bool CheckSignalPresent() override;
+    SignalStatus GetSignalStatus() override;
+    bool WaitForSignalLock(uint32_t timeout_ms);
+    bool QueryInputSignal(uint32_t input, bool& present) const;  // Any input, without switching to it
+    bool HasSourceChangeEvents() const { return m_events_subscribed; }
+    bool DrainEvents();  // Dequeue pending events, true if one was a source change
 
     // Settings
     bool SetInput(uint32_t input);
@@ -75,24 +95,33 @@ private:
 
     // Format state
     VideoFormat m_current_format;
+    uint32_t m_frame_size = 0;
+    uint32_t m_bytes_per_line = 0;
     std::vector<VideoFormat> m_supported_formats;
+    std::vector<uint32_t> m_pixel_formats;
 
     // Buffer state
     std::vector<Buffer> m_buffers;
     uint32_t m_buffer_count = 0;
     std::atomic<bool> m_streaming{false};
+    uint64_t m_last_sequence = 0;  ///< Of the last dequeued buffer
 
     // Signal status
     mutable std::mutex m_signal_mutex;
     SignalStatus m_signal_status;
     std::chrono::steady_clock::time_point m_last_signal_check;
+    bool m_events_subscribed = false;
 
     // Internal helpers
     bool QueryFormat(uint32_t pixel_format, std::vector<VideoFormat>& formats);
     bool TestFormat(const VideoFormat& format);
+    bool GetSelection(uint32_t target, CropRect& rect);
     bool MapBuffers();
+    bool WaitForFrame(uint32_t timeout_ms);
     void UnmapBuffers();
     bool UpdateSignalStatus();
+    bool QueryInputStatus(uint32_t input, uint32_t& status) const;
+    bool SubscribeSourceChangeEvents();
     uint32_t V4L2PixelFormatToFourCC(uint32_t v4l2_format) const;
     uint32_t FourCCToV4L2PixelFormat(uint32_t fourcc) const;
 };
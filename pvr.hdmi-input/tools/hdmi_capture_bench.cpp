@@ -0,0 +1,383 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Capture Benchmark
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+// Drives StreamProcessor without Kodi - from a V4L2 node, the synthetic
+// pattern generator or a raw capture replay - and reports throughput,
+// capture latency, CPU load and copies per frame.
+//
+//   hdmi-capture-bench -d /dev/video0 -s 10
+//   hdmi-capture-bench -d /dev/video2 -W 1280 -H 720 -f YUYV -r   (vivid, reactor capture)
+//   hdmi-capture-bench -S -W 3840 -H 2160 -F 30 -j 2000 -D 0.01   (no hardware)
+//   hdmi-capture-bench -d /dev/video0 -s 60 -w console-stutter.hyraw  (record it)
+//   hdmi-capture-bench -P console-stutter.hyraw                   (replay it)
+//   hdmi-capture-bench -d /dev/video0 -T    (trace points, inside trace-cmd record / perfetto)
+
+#include "capture_resources.h"
+#include "format_negotiator.h"
+#include "frame.h"
+#include "log.h"
+#include "reactor.h"
+#include "replay_source.h"
+#include "stream_processor.h"
+#include "synthetic_source.h"
+#include "trace.h"
+#include "v4l2_device.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <getopt.h>
+#include <memory>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+using namespace hdmi_pvr;
+
+namespace {
+
+struct Options {
+    std::string device = "/dev/video0";
+    uint32_t seconds = 10;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t fourcc = 0;
+    uint32_t fps = 0;
+    int input = -1;
+    uint32_t buffers = 4;
+    bool reactor = false;
+    bool read = true;
+    bool verbose = false;
+    bool synthetic = false;
+    uint32_t jitter_us = 0;
+    double drop_rate = 0.0;
+    bool paced = true;
+    std::string replay;
+    std::string raw_capture;
+    bool trace = false;
+};
+
+void Usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -d PATH   V4L2 device (default /dev/video0)\n"
+            "  -s SEC    Capture duration in seconds (default 10)\n"
+            "  -W W -H H Capture size (default: detected input format)\n"
+            "  -f FOURCC Pixel format, e.g. YUYV or NV12\n"
+            "  -i N      Select input N first\n"
+            "  -b N      V4L2 buffers (default 4)\n"
+            "  -r        Capture from an epoll reactor instead of a capture thread\n"
+            "  -n        Do not read the stream - consumers only\n"
+            "  -v        Log debug messages\n"
+            "  -S        Synthetic pattern instead of a device (-W -H -f -F)\n"
+            "  -F FPS    Synthetic frame rate (default 60)\n"
+            "  -j US     Synthetic completion jitter in microseconds\n"
+            "  -D RATE   Synthetic share of dropped frames, 0..1\n"
+            "  -P FILE   Replay a raw capture file instead of a device\n"
+            "  -u        Synthetic/replay frames as fast as they are read\n"
+            "  -w FILE   Write a raw capture of the session\n"
+            "  -T        Write pipeline trace points to the ftrace trace_marker\n",
+            name);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    int opt;
+    while ((opt = getopt(argc, argv, "d:s:W:H:f:i:b:rnvSF:j:D:P:uw:Th")) != -1) {
+        switch (opt) {
+            case 'd': options.device = optarg; break;
+            case 's': options.seconds = static_cast<uint32_t>(std::max(1, atoi(optarg))); break;
+            case 'W': options.width = static_cast<uint32_t>(atoi(optarg)); break;
+            case 'H': options.height = static_cast<uint32_t>(atoi(optarg)); break;
+            case 'f':
+                if (strlen(optarg) != 4) {
+                    fprintf(stderr, "FOURCC must have four characters\n");
+                    return false;
+                }
+                options.fourcc = v4l2_fourcc(optarg[0], optarg[1], optarg[2], optarg[3]);
+                break;
+            case 'i': options.input = atoi(optarg); break;
+            case 'b': options.buffers = static_cast<uint32_t>(std::max(2, atoi(optarg))); break;
+            case 'r': options.reactor = true; break;
+            case 'n': options.read = false; break;
+            case 'v': options.verbose = true; break;
+            case 'S': options.synthetic = true; break;
+            case 'F': options.fps = static_cast<uint32_t>(atoi(optarg)); break;
+            case 'j': options.jitter_us = static_cast<uint32_t>(atoi(optarg)); break;
+            case 'D': options.drop_rate = atof(optarg); break;
+            case 'P': options.replay = optarg; break;
+            case 'u': options.paced = false; break;
+            case 'w': options.raw_capture = optarg; break;
+            case 'T': options.trace = true; break;
+            default: return false;
+        }
+    }
+    if (options.synthetic && !options.replay.empty()) {
+        fprintf(stderr, "-S and -P are exclusive\n");
+        return false;
+    }
+    return true;
+}
+
+uint64_t MonotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+double CpuSeconds() {
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+uint64_t Percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+bool ConfigureDevice(V4L2Device& device, const Options& options, VideoFormat& format) {
+    if (!device.Open() || !device.QueryCapabilities()) {
+        fprintf(stderr, "Cannot use %s as a capture device\n", options.device.c_str());
+        return false;
+    }
+    if (options.input >= 0 && !device.SetInput(static_cast<uint32_t>(options.input))) {
+        fprintf(stderr, "Cannot select input %d\n", options.input);
+        return false;
+    }
+
+    if (!device.DetectInputFormat(format)) {
+        format = device.GetFormat();
+    }
+    if (options.width > 0 && options.height > 0) {
+        format.width = options.width;
+        format.height = options.height;
+    }
+    if (options.fourcc != 0) {
+        format.fourcc = options.fourcc;
+    }
+    if (!format.frame_rate.is_valid()) {
+        format.frame_rate = {60, 1};
+    }
+
+    if (!device.SetFormat(format) || !device.AllocateBuffers(options.buffers)) {
+        fprintf(stderr, "Cannot configure %s\n", format.to_string().c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<SyntheticSource> CreateSynthetic(const Options& options) {
+    SyntheticSourceConfig config;
+    config.format.width = options.width;
+    config.format.height = options.height;
+    config.format.fourcc = options.fourcc;
+    config.format.frame_rate = {options.fps, 1};
+    config.jitter_us = options.jitter_us;
+    config.drop_rate = options.drop_rate;
+    config.buffer_count = options.buffers;
+    config.paced = options.paced;
+
+    auto source = std::make_unique<SyntheticSource>();
+    if (!source->Configure(config)) {
+        fprintf(stderr, "Cannot generate that format\n");
+        return nullptr;
+    }
+    return source;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        Usage(argv[0]);
+        return 2;
+    }
+    SetLogLevel(options.verbose ? LogLevel::Debug : LogLevel::Warning);
+    if (options.trace && !EnableTracing()) {
+        return 1;
+    }
+
+    V4L2Device device(options.device);
+    std::unique_ptr<SyntheticSource> synthetic;
+    ReplaySource replay;
+    CaptureSource* source = &device;
+    std::string source_name = options.device;
+    VideoFormat format;
+    if (options.synthetic) {
+        synthetic = CreateSynthetic(options);
+        if (!synthetic) {
+            return 1;
+        }
+        source = synthetic.get();
+        source_name = "synthetic";
+        format = synthetic->GetConfiguredFormat();
+    } else if (!options.replay.empty()) {
+        if (!replay.Open(options.replay)) {
+            return 1;
+        }
+        replay.SetPaced(options.paced);
+        source = &replay;
+        source_name = options.replay;
+        format = replay.GetConfiguredFormat();
+    } else {
+        if (!ConfigureDevice(device, options, format)) {
+            return 1;
+        }
+        source_name += " (" + device.GetCardName() + ")";
+    }
+    if (options.reactor && source->GetFd() < 0) {
+        fprintf(stderr, "Reactor capture needs a V4L2 device\n");
+        return 2;
+    }
+
+    auto resources = std::make_shared<CaptureResources>();
+    StreamProcessor processor(source);
+    processor.SetResources(resources);
+    processor.SetExternalCapture(options.reactor);
+    if (!processor.Initialize()) {
+        return 1;
+    }
+
+    // Consumers run on the capture thread (or the reactor) - only it touches
+    // the samples until streaming has stopped
+    std::vector<uint64_t> latencies;
+    latencies.reserve(static_cast<size_t>(options.seconds) * 240);
+    uint64_t first_frame_us = 0;
+    uint64_t last_frame_us = 0;
+    uint64_t consumed = 0;
+    processor.AddFrameConsumer([&](const FrameRef& frame) {
+        uint64_t now = MonotonicMicros();
+        if (first_frame_us == 0) {
+            first_frame_us = now;
+        }
+        last_frame_us = now;
+        ++consumed;
+
+        // V4L2 timestamps are CLOCK_MONOTONIC - anything else is not comparable
+        if (frame->device_timestamp > 0 && frame->device_timestamp <= now &&
+            now - frame->device_timestamp < 10000000ULL) {
+            latencies.push_back(now - frame->device_timestamp);
+        }
+    });
+
+    Reactor reactor;
+    if (options.reactor) {
+        if (!reactor.Start() ||
+            reactor.AddFd(source->GetFd(), EPOLLIN | EPOLLET, [&](uint32_t) { processor.OnFramesReady(); }) == 0) {
+            fprintf(stderr, "Cannot start the reactor\n");
+            return 1;
+        }
+    }
+
+    AudioFormat audio_format;
+    double cpu_start = CpuSeconds();
+    auto wall_start = std::chrono::steady_clock::now();
+    if (!processor.StartStreaming(format, audio_format)) {
+        fprintf(stderr, "Cannot start streaming\n");
+        return 1;
+    }
+
+    if (!options.raw_capture.empty() && !processor.StartRawCapture(options.raw_capture)) {
+        fprintf(stderr, "Cannot write %s\n", options.raw_capture.c_str());
+        return 1;
+    }
+
+    // Without a reader the ready queue only keeps the newest frame
+    if (!options.read) {
+        processor.EnterStandby(1);
+    }
+
+    // Stand in for Kodi pulling the live stream
+    std::atomic<bool> reading{options.read};
+    uint64_t bytes_read = 0;
+    std::thread reader;
+    if (options.read) {
+        reader = std::thread([&]() {
+            std::vector<unsigned char> buffer(256 * 1024);
+            while (reading.load()) {
+                int bytes = processor.ReadLiveStream(buffer.data(), static_cast<unsigned int>(buffer.size()));
+                if (bytes > 0) {
+                    bytes_read += static_cast<uint64_t>(bytes);
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+
+    reading = false;
+    if (reader.joinable()) {
+        reader.join();
+    }
+    processor.StopStreaming();
+    RawCaptureStats raw_stats = processor.GetRawCaptureStats();
+    reactor.Stop();
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    double cpu = CpuSeconds() - cpu_start;
+
+    const CaptureStatistics& stats = resources->stats;
+    uint64_t captured = stats.frames_captured.load();
+    uint64_t dropped = stats.frames_dropped.load();
+    uint64_t bytes_captured = stats.bytes_captured.load();
+    double delivered_span = last_frame_us > first_frame_us ? (last_frame_us - first_frame_us) / 1e6 : 0.0;
+
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("source          %s\n", source_name.c_str());
+    printf("format          %s %s, %u bytes/frame\n", format.to_string().c_str(),
+           FormatNegotiator::FourCCToString(source->GetConfiguredFormat().fourcc).c_str(), source->GetFrameSize());
+    printf("capture         %s, %u buffers, %s\n", options.reactor ? "reactor" : "thread", options.buffers,
+           options.read ? "live read" : "consumers only");
+    printf("frames          %llu captured, %llu dropped\n", static_cast<unsigned long long>(captured),
+           static_cast<unsigned long long>(dropped));
+    if (synthetic) {
+        printf("synthetic       %llu delivered, %llu dropped, %llu overrun\n",
+               static_cast<unsigned long long>(synthetic->GetFramesDelivered()),
+               static_cast<unsigned long long>(synthetic->GetFramesDropped()),
+               static_cast<unsigned long long>(synthetic->GetFramesOverrun()));
+    } else if (!options.replay.empty()) {
+        printf("replay          %llu delivered, %llu lost while recording%s\n",
+               static_cast<unsigned long long>(replay.GetFramesDelivered()),
+               static_cast<unsigned long long>(replay.GetSequenceGaps()), replay.IsFinished() ? ", finished" : "");
+    }
+    if (!options.raw_capture.empty()) {
+        printf("raw capture     %llu frames, %llu skipped, %.1f MB\n",
+               static_cast<unsigned long long>(raw_stats.frames_recorded),
+               static_cast<unsigned long long>(raw_stats.frames_dropped), raw_stats.bytes_written / 1e6);
+    }
+    printf("fps             %.2f\n", consumed > 1 && delivered_span > 0 ? (consumed - 1) / delivered_span : 0.0);
+    if (latencies.empty()) {
+        printf("latency         n/a (no monotonic driver timestamps)\n");
+    } else {
+        printf("latency us      p50 %llu  p90 %llu  p99 %llu  max %llu\n",
+               static_cast<unsigned long long>(Percentile(latencies, 0.50)),
+               static_cast<unsigned long long>(Percentile(latencies, 0.90)),
+               static_cast<unsigned long long>(Percentile(latencies, 0.99)),
+               static_cast<unsigned long long>(latencies.back()));
+    }
+    printf("cpu             %.1f%% of one core\n", wall > 0 ? 100.0 * cpu / wall : 0.0);
+    if (bytes_captured > 0) {
+        printf("copies/frame    %.2f capture, %.2f read\n",
+               static_cast<double>(stats.bytes_copied.load()) / bytes_captured,
+               static_cast<double>(bytes_read) / bytes_captured);
+    }
+
+    processor.Shutdown();
+    device.Close();
+    return captured > 0 ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+/*
+ *  HDMI Input PVR Client for HY300 Projector
+ *  Stream Microbenchmarks
+ *  Copyright (C) 2025 HY300 Project
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+// Microbenchmarks of the per-frame hot path, fed by the unpaced synthetic
+// source so they run anywhere and measure the pipeline rather than the
+// input. Results go to JSON for comparing builds:
+//
+//   hdmi-pvr-microbench --benchmark_out=microbench.json --benchmark_out_format=json
+//   hdmi-pvr-microbench --benchmark_filter=ReadLiveStream
+
+#include "frame.h"
+#include "log.h"
+#include "signal_monitor.h"
+#include "stream_processor.h"
+#include "synthetic_source.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+using namespace hdmi_pvr;
+
+namespace {
+
+constexpr size_t DEMUX_PACKET_PADDING = 64;  ///< AV_INPUT_BUFFER_PADDING_SIZE
+
+/**
+ * StreamProcessor driven by hand from a synthetic source - every
+ * Capture() pushes frames through the whole per-frame path on the
+ * calling thread, the way the reactor does
+ */
+class Pipeline {
+public:
+    Pipeline(uint32_t width, uint32_t height)
+        : m_source(MakeConfig(width, height)), m_processor(&m_source) {
+        m_processor.SetExternalCapture(true);
+        m_ready = m_processor.Initialize() &&
+                  m_processor.StartStreaming(m_source.GetConfiguredFormat(), AudioFormat());
+    }
+
+    ~Pipeline() { m_processor.Shutdown(); }
+
+    bool IsReady() const { return m_ready; }
+    StreamProcessor& Processor() { return m_processor; }
+    uint32_t FrameSize() const { return m_source.GetFrameSize(); }
+
+    /**
+     * Capture what the source has ready
+     * @return Frames that went through the processor
+     */
+    uint64_t Capture() {
+        uint64_t before = m_processor.GetFramesProcessed();
+        m_processor.OnFramesReady();
+        return m_processor.GetFramesProcessed() - before;
+    }
+
+private:
+    static SyntheticSourceConfig MakeConfig(uint32_t width, uint32_t height) {
+        SyntheticSourceConfig config;
+        config.format.width = width;
+        config.format.height = height;
+        config.paced = false;
+        config.buffer_count = 1;
+        return config;
+    }
+
+    SyntheticSource m_source;
+    StreamProcessor m_processor;
+    bool m_ready = false;
+};
+
+// Frame pool shared by the threads of one run
+FramePool* g_pool = nullptr;
+
+void BM_FramePoolAcquireRelease(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        g_pool = new FramePool(8, 4096);
+    }
+
+    // The loop starts and ends on a barrier, the pool outlives every thread's use
+    for (auto _ : state) {
+        FrameRef frame = g_pool->Acquire();
+        benchmark::DoNotOptimize(frame.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        delete g_pool;
+        g_pool = nullptr;
+    }
+}
+BENCHMARK(BM_FramePoolAcquireRelease)->ThreadRange(1, 4)->UseRealTime();
+
+// Capture copy, consumers, deduplication and queueing, without a reader
+void BM_ProcessCapturedFrame(benchmark::State& state) {
+    Pipeline pipeline(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1)));
+    if (!pipeline.IsReady() || !pipeline.Processor().EnterStandby(1)) {
+        state.SkipWithError("Cannot start the pipeline");
+        return;
+    }
+
+    uint64_t frames = 0;
+    for (auto _ : state) {
+        frames += pipeline.Capture();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(frames));
+    state.SetBytesProcessed(static_cast<int64_t>(frames * pipeline.FrameSize()));
+    state.counters["per_frame"] = benchmark::Counter(static_cast<double>(frames),
+                                                     benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_ProcessCapturedFrame)
+    ->Args({1280, 720})
+    ->Args({1920, 1080})
+    ->Args({3840, 2160})
+    ->Unit(benchmark::kMicrosecond);
+
+// Live stream reads of one size; frames are produced outside the timing
+void BM_ReadLiveStream(benchmark::State& state) {
+    Pipeline pipeline(1920, 1080);
+    if (!pipeline.IsReady()) {
+        state.SkipWithError("Cannot start the pipeline");
+        return;
+    }
+
+    std::vector<unsigned char> buffer(static_cast<size_t>(state.range(0)));
+    unsigned int size = static_cast<unsigned int>(buffer.size());
+    uint64_t available = 0;
+    uint64_t bytes_read = 0;
+    for (auto _ : state) {
+        // Never let a read wait for data
+        if (available == 0) {
+            state.PauseTiming();
+            available = pipeline.Capture() * pipeline.FrameSize();
+            state.ResumeTiming();
+        }
+
+        int bytes = pipeline.Processor().ReadLiveStream(buffer.data(), size);
+        if (bytes <= 0) {
+            available = 0;
+            continue;
+        }
+        available -= std::min<uint64_t>(available, static_cast<uint64_t>(bytes));
+        bytes_read += static_cast<uint64_t>(bytes);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes_read));
+}
+BENCHMARK(BM_ReadLiveStream)->Arg(4096)->Arg(65536)->Arg(262144)->Arg(1 << 20);
+
+// Packet allocation and frame copy for the demuxer
+void BM_CreateDemuxPacket(benchmark::State& state) {
+    Pipeline pipeline(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1)));
+    StreamProcessor& processor = pipeline.Processor();
+    if (!pipeline.IsReady() || !processor.OpenDemuxStream()) {
+        state.SkipWithError("Cannot open the demux stream");
+        return;
+    }
+    // Stand-in for Kodi's allocator: packet plus padded payload
+    auto allocate = [](int size) {
+        auto* packet = new DEMUX_PACKET();
+        if (size > 0) {
+            packet->pData = new uint8_t[static_cast<size_t>(size) + DEMUX_PACKET_PADDING];
+        }
+        return packet;
+    };
+
+    uint64_t pending = 0;
+    uint64_t packets = 0;
+    for (auto _ : state) {
+        if (pending == 0) {
+            state.PauseTiming();
+            pending = pipeline.Capture();
+            state.ResumeTiming();
+        }
+
+        DEMUX_PACKET* packet = processor.DemuxRead(allocate);
+        if (!packet) {
+            pending = 0;
+            continue;
+        }
+        --pending;
+        ++packets;
+        benchmark::DoNotOptimize(packet->pData);
+
+        state.PauseTiming();
+        delete[] packet->pData;
+        delete packet;
+        state.ResumeTiming();
+    }
+    processor.CloseDemuxStream();
+    state.SetItemsProcessed(static_cast<int64_t>(packets));
+}
+BENCHMARK(BM_CreateDemuxPacket)
+    ->Args({1280, 720})
+    ->Args({1920, 1080})
+    ->Args({3840, 2160})
+    ->Unit(benchmark::kMicrosecond);
+
+// One signal poll: status query, telemetry and change detection
+void BM_CheckSignalStatus(benchmark::State& state) {
+    auto source = std::make_shared<SyntheticSource>();
+    SignalMonitor monitor(source);
+    if (!monitor.Initialize(false)) {
+        state.SkipWithError("Cannot initialize the signal monitor");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(monitor.UpdateSignalStatus());
+    }
+    monitor.Shutdown();
+}
+BENCHMARK(BM_CheckSignalStatus);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Warnings only - per-frame debug logging would be measured along
+    SetLogLevel(LogLevel::Warning);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}